@@ -0,0 +1,58 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Incremental parser for SIM800 responses.
+// Bytes from the modem are fed one at a time into a fixed line buffer; at
+// the end of each line a short matcher checks for a final result code (OK,
+// ERROR, +CMS ERROR, +CME ERROR) and otherwise looks the line up in a table
+// of unsolicited result codes supplied by the application, the same way
+// console commands are. Handlers get a pointer into the line buffer, which
+// is only valid during the call. The AT+CMGS prompt '>' is recognised as
+// soon as it arrives, since the modem sends no line end after it.
+//
+// Nothing here waits: atCommand() starts a command and atResult() reports
+// how it went, so the caller decides whether to poll from loop() or spin.
+
+enum AtResult : uint8_t
+{
+    AT_IDLE, // No command sent yet
+    AT_PENDING,
+    AT_OK,
+    AT_ERROR,
+    AT_CMS_ERROR, // +CMS ERROR or +CME ERROR, code in atErrorCode()
+    AT_PROMPT,    // '>' after AT+CMGS, ready for the message body
+    AT_TIMEOUT
+};
+
+struct AtUrc
+{
+    const char *prefix;
+    uint8_t bodyLines; // Lines after the URC that belong to it, 1 for +CMT
+    void (*handler)(const char *line, uint8_t length, uint8_t part); // part 0 is the URC itself
+};
+
+struct AtStats
+{
+    uint32_t lines;
+    uint16_t urcs;
+    uint16_t truncated; // Lines longer than the buffer, cut short
+    uint16_t errors;
+    uint16_t timeouts;
+};
+
+const uint8_t AT_LINE_LENGTH = 164;   // A +CMT body of 160 characters
+const uint8_t AT_BYTES_PER_POLL = 64; // Bound the work done per poll
+
+void atBegin(Stream &link, const AtUrc *urcs, uint8_t urcCount);
+void atPoll();
+void atFeed(uint8_t byte);
+
+// Write the command to the returned link, then end it with atEnd();
+// the message body after AT_PROMPT ends with 0x1A instead of '\r'
+Print &atCommand(unsigned long timeoutMs);
+void atEnd(uint8_t terminator = '\r');
+AtResult atResult();
+int16_t atErrorCode();
+
+const AtStats &atStats();
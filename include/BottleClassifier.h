@@ -0,0 +1,80 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Integer scoring classifier for deposited objects.
+// Samples from all four sensors are folded in as they arrive; once enough
+// of each are in, classifierDecide() scores them without any float maths.
+//
+// Each sensor is mapped to a 0..256 feature by a ramp between a low and a
+// high point (weight uses a plateau with ramps on both sides). The score is
+// the weighted sum of the features divided by 256, and the object is
+// accepted when it reaches CLASSIFIER_ACCEPT_SCORE. The defaults make every
+// sensor a near-hard gate, as the old checks were, but leave room for
+// partial credit once the weights are trained on recorded traces.
+
+enum ClassifierParam : uint8_t
+{
+    CLASSIFIER_CAPACITIVE_LOW,  // ADC counts scoring 0
+    CLASSIFIER_CAPACITIVE_HIGH, // ADC counts scoring 256
+    CLASSIFIER_WEIGHT_MIN,      // Full score from here (decigrams)...
+    CLASSIFIER_WEIGHT_MAX,      // ...to here
+    CLASSIFIER_WEIGHT_RAMP,     // Decigrams outside the range to reach 0
+    CLASSIFIER_INDUCTIVE_LOW,   // Share of HIGH inductive readings, /256
+    CLASSIFIER_INDUCTIVE_HIGH,
+    CLASSIFIER_LDR_LOW,         // Share of clear LDR readings, /256
+    CLASSIFIER_LDR_HIGH,
+    CLASSIFIER_CAPACITIVE_WEIGHT,
+    CLASSIFIER_WEIGHT_WEIGHT,
+    CLASSIFIER_INDUCTIVE_WEIGHT,
+    CLASSIFIER_LDR_WEIGHT,
+    CLASSIFIER_ACCEPT_SCORE,
+    CLASSIFIER_PARAM_COUNT
+};
+
+enum ClassifierReason : uint8_t
+{
+    CLASSIFIER_OK,
+    CLASSIFIER_NO_OBJECT, // Capacitive level too low
+    CLASSIFIER_WEIGHT,    // Too light or too heavy
+    CLASSIFIER_METAL,     // Inductive sensor
+    CLASSIFIER_OPAQUE,    // LDR blocked
+    CLASSIFIER_REASON_COUNT
+};
+
+struct ClassifierResult
+{
+    bool accepted;
+    int16_t score;
+    int8_t confidence; // -100 (sure reject) .. 100 (sure accept)
+    uint8_t reason;    // ClassifierReason of the weakest feature
+    int16_t weightDg;  // Mean weight in decigrams, for display and logs
+    int16_t spreadDg;  // Max - min weight sample
+    // Inputs the features were computed from, for logs and training
+    int16_t capacitive;     // Filtered ADC counts
+    int16_t inductiveShare; // HIGH readings, /256
+    int16_t ldrShare;       // Clear readings, /256
+};
+
+// Samples needed from each sensor before a decision
+const uint8_t CLASSIFIER_MIN_CAPACITIVE = 4;
+const uint8_t CLASSIFIER_MIN_WEIGHT = 8;
+const uint8_t CLASSIFIER_MIN_INDUCTIVE = 4;
+const uint8_t CLASSIFIER_MIN_LDR = 5;
+
+void classifierBegin();              // After loadCellBegin()
+void classifierCalibrationChanged(); // Reconverts the weight limits to counts
+void classifierReset();
+void classifierAddCapacitive(int adc); // Less capBaselineShift()
+void classifierAddWeight(int32_t net); // loadCellNet() counts
+void classifierAddInductive(uint8_t level); // 1 = non-metal
+void classifierAddLdr(uint8_t level);       // 0 = light passes
+bool classifierReady();
+void classifierDecide(ClassifierResult &result);
+
+// Tuning from the console and host tools; the defaults live in PROGMEM and
+// come from ClassifierModel.h, generated by tools/trainmodel.py
+int16_t classifierGet(uint8_t param);
+void classifierSet(uint8_t param, int16_t value);
+const __FlashStringHelper *classifierParamName(uint8_t param);
+const __FlashStringHelper *classifierReasonName(uint8_t reason);
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Button input.
+// The three buttons sit on port K, and its pin-change interrupt stays on:
+// the ISR only queues the new button levels with the time of the edge.
+// buttonNext() turns queued edges into debounced events, so holding a key
+// never stops the loop and a press is seen however busy the kiosk was when
+// it happened.
+//
+// A press or release is reported on its first edge, time stamped by the
+// ISR; edges in the BUTTON_DEBOUNCE_MS after it are contact bounce and only
+// counted, and the level is settled again once that window has passed.
+// A held button repeats after BUTTON_REPEAT_DELAY_MS, every
+// BUTTON_REPEAT_START_MS at first and BUTTON_REPEAT_STEP_MS faster with each
+// repeat, down to BUTTON_REPEAT_MIN_MS, and reports BUTTON_LONG_PRESS once
+// after BUTTON_LONG_PRESS_MS. Screens take the events they need and drop
+// the rest.
+//
+// buttonsFlush() drops waiting events and silences buttons still held until
+// they are let go, for a screen that must not act on presses meant for the
+// one before it. On the native build the simulation harness reports pin
+// changes in place of the interrupt.
+
+enum Button : uint8_t
+{
+    BUTTON_UP,
+    BUTTON_DOWN,
+    BUTTON_SELECT,
+    BUTTON_COUNT
+};
+
+enum ButtonEventType : uint8_t
+{
+    BUTTON_PRESS,
+    BUTTON_RELEASE,
+    BUTTON_REPEAT,
+    BUTTON_LONG_PRESS
+};
+
+struct ButtonEvent
+{
+    uint8_t type;
+    uint8_t button;
+    uint16_t value; // Release: ms held; repeat: repeats so far
+};
+
+const uint8_t BUTTON_DEBOUNCE_MS = 20;
+const uint16_t BUTTON_REPEAT_DELAY_MS = 500;
+const uint16_t BUTTON_REPEAT_START_MS = 250;
+const uint8_t BUTTON_REPEAT_STEP_MS = 25;
+const uint8_t BUTTON_REPEAT_MIN_MS = 50;
+const uint16_t BUTTON_LONG_PRESS_MS = 2000;
+const uint8_t BUTTON_EDGE_QUEUE = 16;
+const uint8_t BUTTON_EVENT_QUEUE = 8;
+
+struct ButtonStats
+{
+    uint16_t edges;
+    uint16_t bounces;      // Edges inside the debounce window
+    uint16_t overflows;    // Edge queue full; levels read again from the pins
+    uint16_t dropped;      // Events nobody took in time
+    uint16_t maxLatencyMs; // Longest wait from an edge to its event
+};
+
+void buttonsBegin();
+bool buttonNext(ButtonEvent &event); // False when no event is waiting
+bool buttonHeld(uint8_t button);     // Debounced level
+bool buttonsPending();               // Edges or events waiting, or a button held
+void buttonsFlush();
+const ButtonStats &buttonStats();
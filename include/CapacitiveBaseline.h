@@ -0,0 +1,33 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Adaptive baseline for the capacitive presence sensor.
+// Readings taken with no object present feed a slow EWMA of the level and
+// a faster one of its variance. The fixed thresholds and the classifier
+// model were tuned at CAPACITIVE_NOMINAL_BASELINE; once the estimate has
+// settled they move with the measured baseline, so detection follows
+// humidity and temperature, and never sit within a few standard deviations
+// of the noise. Until then, or if the estimate is too noisy or too far off
+// to trust, the fixed thresholds apply unchanged.
+
+struct CapacitiveBaselineStats
+{
+    int16_t baseline;  // ADC counts
+    int16_t shift;     // Applied to thresholds and classifier input
+    int16_t sigmaX16;  // Standard deviation, counts x16
+    int16_t detect;    // Effective thresholds
+    int16_t clear;
+    bool adaptive;     // false while the fixed thresholds are in use
+    uint16_t samples;  // Idle readings folded in (saturates)
+    uint16_t outliers; // Readings clipped before folding in
+};
+
+void capBaselineBegin(int fixedDetect, int fixedClear);
+void capBaselineSetFixed(int fixedDetect, int fixedClear); // Console overrides
+void capBaselineEnable(bool enabled);
+void capBaselineUpdate(int value); // Only with no object present
+int capBaselineShift(); // Baseline minus nominal, 0 while not adaptive
+int capBaselineDetect();
+int capBaselineClear();
+void capBaselineStats(CapacitiveBaselineStats &stats);
@@ -0,0 +1,33 @@
+#pragma once
+
+// Bottle classifier model, loaded into the BottleClassifier at boot.
+// Generated by tools/trainmodel.py; retrain and rebuild instead of editing.
+//
+// Trained on: hand-tuned defaults matching the original acceptance gates
+// Training result: not trained
+
+#include <stdint.h>
+
+// Capacitive presence thresholds used while waiting for an object, and the
+// empty-platform level they and the model were tuned at
+constexpr int DETECTION_THRESHOLD = 650;
+constexpr int NO_BOTTLE_THRESHOLD = 500;
+constexpr int CAPACITIVE_NOMINAL_BASELINE = 320;
+
+// Feature ramps
+constexpr int16_t MODEL_CAPACITIVE_LOW = 600;  // ADC counts
+constexpr int16_t MODEL_CAPACITIVE_HIGH = 650;
+constexpr int16_t MODEL_WEIGHT_MIN = 100; // Decigrams
+constexpr int16_t MODEL_WEIGHT_MAX = 650;
+constexpr int16_t MODEL_WEIGHT_RAMP = 27;
+constexpr int16_t MODEL_INDUCTIVE_LOW = 128; // Share of readings, /256
+constexpr int16_t MODEL_INDUCTIVE_HIGH = 192;
+constexpr int16_t MODEL_LDR_LOW = 102;
+constexpr int16_t MODEL_LDR_HIGH = 154;
+
+// Feature weights and the score needed to accept
+constexpr int16_t MODEL_CAPACITIVE_WEIGHT = 64;
+constexpr int16_t MODEL_WEIGHT_WEIGHT = 64;
+constexpr int16_t MODEL_INDUCTIVE_WEIGHT = 96;
+constexpr int16_t MODEL_LDR_WEIGHT = 64;
+constexpr int16_t MODEL_ACCEPT_SCORE = 240;
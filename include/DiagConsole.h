@@ -0,0 +1,29 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Non-blocking diagnostics console on a serial port.
+// Input is parsed one byte at a time into a fixed line buffer; commands are
+// looked up in a table supplied by the application, the same way menus are.
+
+struct ConsoleCommand
+{
+    const char *name;
+    void (*handler)(Print &out, char *args); // args points past the command word
+};
+
+// Streamed responses emit one chunk per call and return false when finished
+typedef bool (*ConsoleStreamStep)(Print &out, uint16_t index);
+
+const uint8_t CONSOLE_LINE_LENGTH = 48;
+const uint8_t CONSOLE_BYTES_PER_POLL = 16; // Bound the work done per poll
+const uint8_t CONSOLE_STREAM_CHUNK = 40;   // TX space needed before the next chunk
+
+void consoleBegin(Stream &port, const ConsoleCommand *commands, uint8_t commandCount);
+void consolePoll();
+void consoleStream(ConsoleStreamStep step);
+bool consoleStreaming();
+
+// Argument helpers for command handlers
+char *consoleNextToken(char *&args);
+bool consoleParseInt(const char *token, long &value);
@@ -0,0 +1,8 @@
+#pragma once
+
+// EEPROM address map. Every persisted record starts with its own magic byte
+// and ends with a checksum, so a record that was never written (0xFF) or was
+// interrupted mid-write is detected and replaced by defaults.
+
+const int EEPROM_CALIBRATION_ADDR = 0; // LoadCellCalibration, 64 bytes reserved
+const int EEPROM_LAST_STATE_ADDR = 64;  // LastStateSlot ring, 160 bytes reserved
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Compile-time pins for the Arduino Mega 2560.
+// Pin<N> carries the pin number in its type, so read() and write() resolve
+// to the port register and bit at compile time. On ports A-G that is a
+// single SBIS, SBI or CBI instead of the ~50 cycle table lookups behind
+// digitalRead() and digitalWrite(). Ports H-L sit outside the bit-addressable
+// I/O range; writes there are a read-modify-write done with interrupts off,
+// as digitalWrite() does.
+//
+// A Pin converts to its number, so it still works anywhere a pin number is
+// expected (pinMode, analogRead, library constructors). Unlike
+// digitalWrite(), write() does not turn off PWM on the pin, so pins that are
+// also driven by analogWrite() should keep using digitalWrite().
+//
+// The native build forwards every call to the simulated Arduino core.
+
+namespace fastpin
+{
+enum Port : uint8_t
+{
+    PORT_A,
+    PORT_B,
+    PORT_C,
+    PORT_D,
+    PORT_E,
+    PORT_F,
+    PORT_G,
+    PORT_H,
+    PORT_J,
+    PORT_K,
+    PORT_L
+};
+
+const uint8_t PIN_COUNT = 70;
+
+// Port and bit of each pin, as in the core's variants/mega/pins_arduino.h
+constexpr uint8_t PIN_PORTS[PIN_COUNT] = {
+    PORT_E, PORT_E, PORT_E, PORT_E, PORT_G, PORT_E, PORT_H, PORT_H, // 0-7
+    PORT_H, PORT_H, PORT_B, PORT_B, PORT_B, PORT_B, PORT_J, PORT_J, // 8-15
+    PORT_H, PORT_H, PORT_D, PORT_D, PORT_D, PORT_D, PORT_A, PORT_A, // 16-23
+    PORT_A, PORT_A, PORT_A, PORT_A, PORT_A, PORT_A, PORT_C, PORT_C, // 24-31
+    PORT_C, PORT_C, PORT_C, PORT_C, PORT_C, PORT_C, PORT_D, PORT_G, // 32-39
+    PORT_G, PORT_G, PORT_L, PORT_L, PORT_L, PORT_L, PORT_L, PORT_L, // 40-47
+    PORT_L, PORT_L, PORT_B, PORT_B, PORT_B, PORT_B, PORT_F, PORT_F, // 48-55
+    PORT_F, PORT_F, PORT_F, PORT_F, PORT_F, PORT_F, PORT_K, PORT_K, // 56-63
+    PORT_K, PORT_K, PORT_K, PORT_K, PORT_K, PORT_K};                // 64-69
+
+constexpr uint8_t PIN_BITS[PIN_COUNT] = {
+    0, 1, 4, 5, 5, 3, 3, 4, // 0-7
+    5, 6, 4, 5, 6, 7, 1, 0, // 8-15
+    1, 0, 3, 2, 1, 0, 0, 1, // 16-23
+    2, 3, 4, 5, 6, 7, 7, 6, // 24-31
+    5, 4, 3, 2, 1, 0, 7, 2, // 32-39
+    1, 0, 7, 6, 5, 4, 3, 2, // 40-47
+    1, 0, 3, 2, 1, 0, 0, 1, // 48-55
+    2, 3, 4, 5, 6, 7, 0, 1, // 56-63
+    2, 3, 4, 5, 6, 7};      // 64-69
+
+// Data space address of each port's PINx register; DDRx and PORTx follow it
+constexpr uint16_t PORT_PIN_REGISTERS[] = {
+    0x20, 0x23, 0x26, 0x29, 0x2C, 0x2F, 0x32, 0x100, 0x103, 0x106, 0x109};
+
+const uint8_t PIN_REGISTER = 0;
+const uint8_t DDR_REGISTER = 1;
+const uint8_t PORT_REGISTER = 2;
+
+constexpr uint16_t registerAddress(uint8_t pin, uint8_t offset)
+{
+    return PORT_PIN_REGISTERS[PIN_PORTS[pin]] + offset;
+}
+
+// SBI, CBI and SBIS reach data addresses 0x20-0x3F
+constexpr bool bitAddressable(uint8_t pin)
+{
+    return registerAddress(pin, PORT_REGISTER) < 0x40;
+}
+
+// Port B, port K, PJ0-PJ1 and PE0 have pin-change interrupts
+constexpr bool pinChangeCapable(uint8_t pin)
+{
+    return PIN_PORTS[pin] == PORT_B || PIN_PORTS[pin] == PORT_K ||
+           PIN_PORTS[pin] == PORT_J || pin == 0;
+}
+
+const uint8_t NO_PIN = 0xFF;
+
+// First pin in the list that appears again later in it, NO_PIN if none.
+// Recursion rather than loops so it stays a C++11 constexpr.
+constexpr bool pinListed(const uint8_t *pins, uint8_t count, uint8_t pin)
+{
+    return count > 0 && (pins[0] == pin || pinListed(pins + 1, count - 1, pin));
+}
+
+constexpr uint8_t duplicatePin(const uint8_t *pins, uint8_t count)
+{
+    return count < 2 ? NO_PIN
+           : pinListed(pins + 1, count - 1, pins[0]) ? pins[0]
+                                                     : duplicatePin(pins + 1, count - 1);
+}
+} // namespace fastpin
+
+template <uint8_t N>
+class Pin
+{
+    static_assert(N < fastpin::PIN_COUNT, "No such pin on the Mega 2560");
+
+public:
+    constexpr Pin() {}
+    constexpr operator uint8_t() const { return N; }
+
+#ifdef __AVR__
+    static uint8_t read()
+    {
+        return (reg(fastpin::PIN_REGISTER) & MASK) ? HIGH : LOW;
+    }
+    static void high() { setBit(fastpin::PORT_REGISTER, true); }
+    static void low() { setBit(fastpin::PORT_REGISTER, false); }
+    static void write(bool value) { setBit(fastpin::PORT_REGISTER, value); }
+    static void output() { setBit(fastpin::DDR_REGISTER, true); }
+    static void input()
+    {
+        setBit(fastpin::DDR_REGISTER, false);
+        setBit(fastpin::PORT_REGISTER, false);
+    }
+    static void inputPullup()
+    {
+        setBit(fastpin::DDR_REGISTER, false);
+        setBit(fastpin::PORT_REGISTER, true);
+    }
+
+private:
+    static const uint8_t MASK = 1 << fastpin::PIN_BITS[N];
+
+    static volatile uint8_t &reg(uint8_t offset)
+    {
+        return *(volatile uint8_t *)fastpin::registerAddress(N, offset);
+    }
+
+    static void setBit(uint8_t offset, bool on)
+    {
+        if (fastpin::bitAddressable(N))
+        {
+            if (on)
+            {
+                reg(offset) |= MASK;
+            }
+            else
+            {
+                reg(offset) &= ~MASK;
+            }
+            return;
+        }
+        uint8_t sreg = SREG;
+        cli();
+        if (on)
+        {
+            reg(offset) |= MASK;
+        }
+        else
+        {
+            reg(offset) &= ~MASK;
+        }
+        SREG = sreg;
+    }
+#else
+    static uint8_t read() { return digitalRead(N); }
+    static void high() { digitalWrite(N, HIGH); }
+    static void low() { digitalWrite(N, LOW); }
+    static void write(bool value) { digitalWrite(N, value ? HIGH : LOW); }
+    static void output() { pinMode(N, OUTPUT); }
+    static void input() { pinMode(N, INPUT); }
+    static void inputPullup() { pinMode(N, INPUT_PULLUP); }
+#endif
+};
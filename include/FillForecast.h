@@ -0,0 +1,62 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Bin fill level history and time-to-full forecast.
+// The application pings the bin once a minute over its full depth and feeds
+// the distance together with its running count of accepted bottles. Samples
+// are averaged into FILL_BUCKET_MS buckets kept in a ring, FILL_HISTORY of
+// them, 3 bytes each.
+//
+// The forecast has two parts. Fill per bottle comes from an online least
+// squares fit of level against bottles accepted since the bin was last
+// emptied; it is fed only when the count has moved, so idle hours do not
+// weigh it down. Bottles per hour come from the last FILL_RATE_BUCKETS of
+// history. Together they give the time until the bin reaches the full mark,
+// isBinFull()'s 10 cm. fillPickupDue() fires once per emptying, as soon as
+// that time drops under the pickup lead time (set pickup <hours>) or the bin
+// passes FILL_PICKUP_LEVEL, so the crew can come before the kiosk stops.
+//
+// A level drop of FILL_EMPTIED_DROP points below the highest level since
+// the last emptying counts as emptied; fillEmptied() says so directly.
+
+const uint8_t BIN_EMPTY_CM = 45; // Sonar to the floor of an empty bin
+const uint8_t BIN_FULL_CM = 10;  // isBinFull() limit
+const uint8_t BIN_RANGE_CM = BIN_EMPTY_CM + 10;
+
+const uint32_t FILL_SAMPLE_INTERVAL_MS = 60000;
+const uint32_t FILL_BUCKET_MS = 1800000;   // 30 minutes
+const uint8_t FILL_HISTORY = 48;           // 24 hours
+const uint8_t FILL_RATE_BUCKETS = 12;      // Deposit rate over the last 6 hours
+const uint8_t FILL_PICKUP_AHEAD_HOURS = 3; // Default lead time for the crew
+const uint8_t FILL_PICKUP_LEVEL = 85;      // Percent, when no forecast is possible
+const uint8_t FILL_EMPTIED_DROP = 30;      // Percent
+const uint8_t FILL_MIN_POINTS = 5;         // Fit points before forecasting
+const uint8_t FILL_MIN_SPAN = 20;          // Bottles the fit must cover
+const uint16_t FILL_UNKNOWN = 0xFFFF;
+
+struct FillBucket
+{
+    uint16_t distanceMm; // Mean distance, 0 for no samples
+    uint8_t deposits;    // Bottles accepted in the bucket, saturating
+};
+
+struct FillForecast
+{
+    uint8_t level;          // Percent of the way from empty to full
+    uint16_t distanceMm;    // Last sample
+    float percentPerBottle; // Fitted slope, 0 until known
+    float bottlesPerHour;
+    uint16_t bottlesToFull; // FILL_UNKNOWN until known
+    uint16_t minutesToFull; // FILL_UNKNOWN until known
+    uint16_t fitPoints;
+    uint16_t emptied;       // Emptyings seen since boot
+};
+
+void fillSample(float distanceCm, uint32_t acceptedTotal);
+void fillEmptied();
+bool fillPickupDue(); // True once per emptying when a pickup should be sent
+void fillSetPickupAhead(uint8_t hours);
+const FillForecast &fillForecast();
+uint8_t fillHistory(FillBucket *buckets, uint8_t max); // Newest first, returns the count
+bool fillReport(Print &out, uint16_t line); // One line or history chunk per call, false after the last
@@ -0,0 +1,32 @@
+#pragma once
+
+// Hardware abstraction boundary for the firmware.
+// Application code reaches the hardware only through these interfaces:
+//   clock, GPIO, ADC  - Arduino core (millis, delay, digitalRead, analogRead...)
+//   hot GPIO paths    - Pin<N> from FastPin.h, backed by the core on native
+//   load cell         - HX711
+//   sonar             - NewPing
+//   RFID              - MFRC522
+//   modem             - ModemTransport (ModemUart on USART2)
+//   displays          - LiquidCrystal_I2C, Adafruit_PCD8544
+//   servos            - Servo
+//   persistent data   - EEPROM
+// The megaatmega2560 environment resolves them to the real libraries at no
+// cost. The native environment resolves the same headers to lib/NativeSim,
+// which implements them against simulated peripherals and an injectable
+// clock (see SimHarness.h), so the same application code runs on Linux.
+
+#include <Arduino.h>
+#include <LiquidCrystal_I2C.h>
+#include <Servo.h>
+#include <MFRC522.h>
+#include <NewPing.h>
+#include <HX711.h>
+#include <Adafruit_GFX.h>
+#include <Adafruit_PCD8544.h>
+#include <SPI.h>
+#include <EEPROM.h>
+
+#ifndef ARDUINO
+#include <SimHarness.h>
+#endif
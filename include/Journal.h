@@ -0,0 +1,36 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Small RAM journal of kiosk events, oldest entries are overwritten first
+
+enum JournalEvent : uint8_t
+{
+    JOURNAL_BOOT,
+    JOURNAL_DEPOSIT_ACCEPTED,
+    JOURNAL_DEPOSIT_REJECTED,
+    JOURNAL_POINTS_STORED,
+    JOURNAL_COINS_DISPENSED,
+    JOURNAL_DISPENSE_FAULT,
+    JOURNAL_BIN_FULL,
+    JOURNAL_TARE,
+    JOURNAL_SETTING_CHANGED,
+    JOURNAL_RECOVERED,  // Interrupted deposit or payout resumed at boot
+    JOURNAL_PICKUP_DUE, // Fill forecast alert, value is the level in percent
+    JOURNAL_EVENT_COUNT
+};
+
+struct JournalEntry
+{
+    uint32_t timeMs;
+    uint8_t event;
+    int16_t value;
+};
+
+const uint8_t JOURNAL_CAPACITY = 32;
+
+void journalRecord(JournalEvent event, int16_t value = 0);
+uint8_t journalCount();
+bool journalGet(uint8_t index, JournalEntry &entry); // index 0 is the oldest entry
+void journalClear();
+const __FlashStringHelper *journalEventName(uint8_t event);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Persisted record of what the kiosk owes its current customer.
+// Credit that only lives in RAM and coins still to come out of the hopper
+// are written to EEPROM as they change, so a reset or power cut in the
+// middle of a deposit or payout can be resumed on the next boot. Records
+// rotate through a ring of slots to spread the EEPROM wear; each slot has
+// its own sequence number and checksum, so an interrupted write leaves the
+// previous record in force.
+
+enum LastStateKind : uint8_t
+{
+    LAST_STATE_IDLE,
+    LAST_STATE_CREDIT,        // points owed, not on a card or paid out yet
+    LAST_STATE_PAYOUT,        // points coins requested, done of them counted out
+    LAST_STATE_PAYOUT_RESUMED // As PAYOUT, already resumed once after a reset
+};
+
+struct LastState
+{
+    uint8_t kind;
+    int16_t points;
+    int16_t done;
+    int32_t tareOffset; // Lets a restart weigh the platform without a tare
+};
+
+const uint8_t LAST_STATE_SLOTS = 8;
+
+void lastStateBegin();                 // Finds the newest valid slot
+bool lastStateGet(LastState &state);   // False if no valid record exists
+void lastStateSave(const LastState &state); // Skipped if nothing changed
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Integer load cell pipeline.
+// Samples stay in raw HX711 counts. Net counts are counts from tare oriented
+// so that load is positive, and the per-unit calibration table maps them to
+// decigrams by piecewise-linear interpolation through the tare point. Limits
+// are converted to counts once, so per-sample work is a subtract and a
+// compare; grams are only produced for display.
+
+const uint8_t LOADCELL_MAX_POINTS = 6;
+
+struct LoadCellPoint
+{
+    int32_t counts; // From tare, as read
+    int16_t decigrams;
+};
+
+void loadCellBegin(); // Loads the table from EEPROM, or the default slope
+int32_t loadCellNet(int32_t countsFromTare);
+int16_t loadCellDecigrams(int32_t net);
+int32_t loadCellNetFor(int16_t decigrams);
+
+// Calibration table, saved to EEPROM on every change
+bool loadCellCalibrate(int32_t countsFromTare, int16_t decigrams); // Adds or replaces a point
+void loadCellResetCalibration();
+uint8_t loadCellPointCount();
+bool loadCellPoint(uint8_t index, LoadCellPoint &point);
+
+void loadCellPrintGrams(Print &out, int16_t decigrams); // "12.3g"
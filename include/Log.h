@@ -0,0 +1,53 @@
+#pragma once
+
+#include <Arduino.h>
+#include "LogEvents.h"
+
+// Compact binary logging.
+// Records are queued in a RAM ring and copied to the serial TX buffer only
+// when it has room for a whole record, so logging never waits on the UART.
+// Levels above LOG_LEVEL compile to nothing, arguments included.
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+// Wire format: sync, id, time (ms, low 16 bits), arg a, arg b, checksum
+const uint8_t LOG_SYNC_BYTE = 0xA5;
+const uint8_t LOG_RECORD_SIZE = 13;
+const uint8_t LOG_RING_RECORDS = 16;
+
+void logBegin(Print &port);
+void logWrite(uint8_t id, int32_t a = 0, int32_t b = 0);
+void logFlush();
+uint32_t logDroppedCount();
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) logWrite(__VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) logWrite(__VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) logWrite(__VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) logWrite(__VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
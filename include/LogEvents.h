@@ -0,0 +1,44 @@
+#pragma once
+
+// Binary log record ids.
+// This list is the wire schema: tools/logdecode.py parses it to decode
+// records, so append new entries at the end and keep one entry per line.
+// Each entry is an id and a printf-style format for the two int32 arguments.
+#define LOG_EVENTS(X)                                          \
+    X(LOG_DROPPED, "log overflow, %ld records dropped")        \
+    X(LOG_BOOT, "boot")                                        \
+    X(LOG_CARD_UID, "card uid %08lx size %ld")                 \
+    X(LOG_CARD_TYPE, "card sak 0x%02lx type %ld")              \
+    X(LOG_RFID_AUTH_FAILED, "rfid auth failed block %ld status %ld") \
+    X(LOG_RFID_READ_FAILED, "rfid read failed block %ld status %ld") \
+    X(LOG_RFID_WRITE_FAILED, "rfid write failed block %ld status %ld") \
+    X(LOG_POINTS_READ, "points read %ld")                      \
+    X(LOG_POINTS_WRITTEN, "points written %ld")                \
+    X(LOG_VERIFY_SENSORS, "verify capacitive %ld inductive %ld") \
+    X(LOG_WEIGHT, "weight avg %ld cg spread %ld cg")           \
+    X(LOG_BOTTLE_DETECTED, "bottle detected raw %ld")          \
+    X(LOG_DISPENSE_START, "dispense start %ld coins")          \
+    X(LOG_COIN_COUNTED, "coin %ld of %ld")                     \
+    X(LOG_DISPENSE_DONE, "dispense done %ld of %ld")           \
+    X(LOG_DISPENSE_TIMEOUT, "dispense timeout %ld of %ld")    \
+    X(LOG_CLASSIFIED, "classified score %ld confidence %ld%%") \
+    X(LOG_REJECT_REASON, "reject reason %ld weight %ld dg")    \
+    X(LOG_ZERO_ADJUST, "zero adjust %ld counts drift %ld counts") \
+    X(LOG_RESET_CAUSE, "reset cause %ld expired task %ld")     \
+    X(LOG_WATCHDOG_LATE, "watchdog task %ld heartbeat gap %ld ms") \
+    X(LOG_RECOVERY, "recovering state %ld points %ld")        \
+    X(LOG_MEMORY_LOW, "memory headroom %ld bytes largest free block %ld") \
+    X(LOG_SMS_RECEIVED, "sms received %ld chars")             \
+    X(LOG_MODEM_REGISTRATION, "modem registration %ld")        \
+    X(LOG_MODEM_RING, "modem ring")                            \
+    X(LOG_PICKUP_DUE, "pickup due level %ld%% minutes to full %ld")
+
+#define LOG_EVENT_ENUM(id, format) id,
+
+enum LogEventId : uint8_t
+{
+    LOG_EVENTS(LOG_EVENT_ENUM)
+    LOG_EVENT_COUNT
+};
+
+#undef LOG_EVENT_ENUM
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <Arduino.h>
+
+// SRAM usage instrumentation.
+// Before the C runtime starts, everything between the end of the static
+// data and the stack pointer is painted with a canary byte. The deepest the
+// stack has ever reached is found by scanning up from the top of the heap
+// for the first long run of canary bytes; the stack begins where it ends.
+// The heap side walks the malloc free list, so fragmentation left behind by
+// String temporaries shows up as free bytes that no single allocation can
+// use.
+//
+// Headroom is the gap between the highest the heap has reached and the
+// deepest stack; when it closes the two overwrite each other and the MCU
+// misbehaves or resets. The native build has no fixed memory map and
+// reports nothing.
+
+struct MemoryStats
+{
+    // Static RAM, fixed per build
+    uint16_t dataBytes;   // Initialised globals
+    uint16_t bssBytes;    // Zeroed globals
+    uint16_t noinitBytes; // Kept across resets
+    // Heap
+    uint16_t heapBytes;      // Current break above the heap start
+    uint16_t heapPeakBytes;  // Highest break seen
+    uint16_t freeListBytes;  // Freed blocks below the break
+    uint16_t freeBlocks;
+    uint16_t largestFreeBlock;
+    // Stack
+    uint16_t stackBytes;     // In use now
+    uint16_t stackPeakBytes; // Deepest, from the paint
+    uint16_t headroom;       // Never touched between heap peak and stack peak
+    uint16_t totalBytes;     // SRAM size
+};
+
+// Below this the loop logs LOG_MEMORY_LOW, once per new low
+const uint16_t MEMORY_LOW_HEADROOM = 256;
+
+bool memoryStats(MemoryStats &stats); // false on the native build
+void memoryPoll();                    // From the loop; samples the heap, scans now and then
+bool memoryReport(Print &out, uint16_t line); // One line per call, false after the last
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Byte link to the SIM800.
+// The firmware reaches the modem only through this interface, so the link
+// can be swapped: ModemUart on the Mega (and its simulated twin on the
+// native build), or the native runner's ModemPty, which puts a host
+// pseudo-terminal on the far end.
+
+struct ModemLinkStats
+{
+    uint32_t rxBytes;
+    uint32_t txBytes;
+    uint16_t rxOverruns;  // Bytes lost to a full receive buffer
+    uint16_t rxHighWater; // Most bytes waiting to be read
+    uint16_t ctsStalls;   // Times the modem held off transmission
+    uint16_t txDiscarded; // Bytes thrown away while CTS stayed off
+};
+
+class ModemTransport : public Stream
+{
+public:
+    virtual void begin(unsigned long baud) = 0;
+    // While held the modem keeps its output (RTS off), for stretches when
+    // the receiver cannot run, such as a power-down sleep
+    virtual void holdReceive(bool hold) = 0;
+    virtual void stats(ModemLinkStats &stats) = 0;
+    using Print::write;
+};
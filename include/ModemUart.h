@@ -0,0 +1,67 @@
+#pragma once
+
+#include "ModemTransport.h"
+
+// SIM800 on USART2 (Serial2 pins) with interrupt-driven ring buffers and
+// RTS/CTS hardware flow control (AT+IFC=2,2).
+// SoftwareSerial kept interrupts off for a whole character, about 1 ms at
+// 9600 baud, for every byte in either direction. Here a byte costs one
+// short ISR. The receive buffer holds a whole +CMT unsolicited result with
+// a 160 character body; past MODEM_RX_HOLD_LEVEL, RTS asks the modem to
+// pause instead of letting bytes drop. The transmitter stops while the
+// modem holds CTS off and resumes on the next write, flush or poll. A
+// write or flush waits at most MODEM_CTS_TIMEOUT_MS for CTS; after that the
+// queued bytes are discarded and writes dropped until CTS comes back, so a
+// wedged modem cannot hang the kiosk.
+//
+// The core's Serial2 must not be used as well; both claim the USART2
+// vectors. The native build implements this class in lib/NativeSim against
+// the simulated SIM800.
+
+const uint16_t MODEM_RX_BUFFER_SIZE = 256;
+const uint8_t MODEM_TX_BUFFER_SIZE = 64;
+const uint8_t MODEM_RX_HOLD_LEVEL = 192;   // RTS off once this many bytes wait
+const uint8_t MODEM_RX_RESUME_LEVEL = 128; // And back on below this
+const uint16_t MODEM_CTS_TIMEOUT_MS = 1000;
+
+class ModemUart : public ModemTransport
+{
+public:
+    void begin(unsigned long baud) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t byte) override;
+    int availableForWrite() override;
+    void flush() override;
+    void holdReceive(bool hold) override;
+    void stats(ModemLinkStats &stats) override;
+    bool stalled() const { return txStalled; } // CTS is holding back queued bytes
+    using Print::write;
+
+    // Interrupt handlers
+    void rxInterrupt(uint8_t byte);
+    void txInterrupt();
+
+private:
+    // 256 entries, so the 8-bit indexes wrap on their own
+    volatile uint8_t rxBuffer[MODEM_RX_BUFFER_SIZE];
+    volatile uint8_t rxHead = 0;
+    volatile uint8_t rxTail = 0;
+    volatile uint8_t txBuffer[MODEM_TX_BUFFER_SIZE];
+    volatile uint8_t txHead = 0;
+    volatile uint8_t txTail = 0;
+    volatile bool txStalled = false; // CTS was off when a byte was due
+    bool txDiscarding = false;       // CTS stayed off; writes are dropped
+    bool held = false;
+    bool written = false;
+    ModemLinkStats linkStats = {};
+
+    uint8_t rxCount() const { return (uint8_t)(rxHead - rxTail); }
+    void updateRts();
+    void resumeTx();
+    bool waitCts(uint16_t &waitedSteps);
+    void discardTx();
+};
+
+extern ModemUart modemUart;
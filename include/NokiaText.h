@@ -0,0 +1,48 @@
+#pragma once
+
+#include <Arduino.h>
+#include <Adafruit_PCD8544.h>
+
+// Fast text and icons for the Nokia 5110.
+// The PCD8544 framebuffer holds 8 vertical pixels per byte, so a 5x8 glyph
+// column or an 8x8 icon column is one byte. Glyphs and icons are stored in
+// PROGMEM already rotated for the panel mounting (setRotation(2)) and are
+// ORed into the framebuffer a byte at a time: one write per column when y
+// is a multiple of 8, two shifted writes when it is not. Adafruit GFX
+// instead draws them a pixel at a time through drawPixel().
+//
+// Drawing goes straight into the framebuffer, so it must follow
+// clearDisplay(), which also marks the whole panel for the next display().
+// Only black on a clear background is supported. At any other rotation the
+// same data is drawn through drawPixel().
+
+const uint8_t NOKIA_PANEL_ROTATION = 2;
+const uint8_t NOKIA_CHAR_WIDTH = 6; // 5 pixel glyph and a gap
+const uint8_t NOKIA_LINE_HEIGHT = 8;
+const uint8_t NOKIA_ICON_SIZE = 8;
+
+// Lays out like Print on Adafruit GFX: '\n' and wrapping at the right edge
+// return to x = 0 on the next line. Leaves the GFX cursor after the text.
+void nokiaText(Adafruit_PCD8544 &display, int16_t x, int16_t y, const char *text, size_t length = (size_t)-1);
+void nokiaText(Adafruit_PCD8544 &display, int16_t x, int16_t y, const __FlashStringHelper *text);
+void nokiaIcon(Adafruit_PCD8544 &display, int16_t x, int16_t y, const uint8_t *icon);
+
+// Icons are written as eight rows, MSB on the left, like drawBitmap()
+// input; NOKIA_ICON() turns them into rotated columns at compile time
+constexpr uint8_t nokiaIconColumn(uint8_t r0, uint8_t r1, uint8_t r2, uint8_t r3,
+                                  uint8_t r4, uint8_t r5, uint8_t r6, uint8_t r7, uint8_t column)
+{
+    return ((r7 >> column) & 1) | ((r6 >> column) & 1) << 1 | ((r5 >> column) & 1) << 2 |
+           ((r4 >> column) & 1) << 3 | ((r3 >> column) & 1) << 4 | ((r2 >> column) & 1) << 5 |
+           ((r1 >> column) & 1) << 6 | ((r0 >> column) & 1) << 7;
+}
+
+#define NOKIA_ICON(r0, r1, r2, r3, r4, r5, r6, r7)              \
+    nokiaIconColumn(r0, r1, r2, r3, r4, r5, r6, r7, 0),         \
+        nokiaIconColumn(r0, r1, r2, r3, r4, r5, r6, r7, 1),     \
+        nokiaIconColumn(r0, r1, r2, r3, r4, r5, r6, r7, 2),     \
+        nokiaIconColumn(r0, r1, r2, r3, r4, r5, r6, r7, 3),     \
+        nokiaIconColumn(r0, r1, r2, r3, r4, r5, r6, r7, 4),     \
+        nokiaIconColumn(r0, r1, r2, r3, r4, r5, r6, r7, 5),     \
+        nokiaIconColumn(r0, r1, r2, r3, r4, r5, r6, r7, 6),     \
+        nokiaIconColumn(r0, r1, r2, r3, r4, r5, r6, r7, 7)
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <Arduino.h>
+#include "FastPin.h"
+
+// Kiosk wiring on the Arduino Mega 2560.
+// Shared by the firmware and the host-side simulation tools. Each pin is a
+// Pin<N> (see FastPin.h); the checks at the end reject a miswired map at
+// build time.
+
+// Buttons, on port K so pin-change interrupts can wake the MCU
+constexpr Pin<A8> upButton;
+constexpr Pin<A9> downButton;
+constexpr Pin<A10> selectButton;
+// Servo
+constexpr Pin<36> servoPin1;
+constexpr Pin<37> servoPin2;
+// Sensors
+constexpr Pin<A0> CAPACITIVE_SENSOR_PIN; // Analog pin for capacitive sensor
+constexpr Pin<15> inductiveSensorPin;
+// Ultasonic Sensor
+constexpr Pin<22> TRIGGER_PIN;
+constexpr Pin<23> ECHO_PIN;
+// RGB LED
+constexpr Pin<32> PIN_RED;
+constexpr Pin<33> PIN_GREEN;
+constexpr Pin<34> PIN_BLUE;
+// RFID
+constexpr Pin<53> SS_PIN;
+constexpr Pin<49> RST_PIN;
+// SIM Module on USART2, with RTS/CTS flow control
+constexpr Pin<17> SIM_RX; // RXD2, from the modem's TXD
+constexpr Pin<16> SIM_TX; // TXD2, to the modem's RXD
+constexpr Pin<24> SIM_RTS;
+constexpr Pin<25> SIM_CTS;
+// Load Cell
+constexpr Pin<44> LOADCELL_DOUT_PIN;
+constexpr Pin<45> LOADCELL_SCK_PIN;
+// LDR & LED
+constexpr Pin<46> LDR_PIN;
+constexpr Pin<47> LED_INLET_PIN;
+// Coin Hopper
+constexpr Pin<28> coinHopperSensor_PIN;
+constexpr Pin<30> relayPin;
+
+// Nokia 5110 LCD
+constexpr Pin<3> PIN_RST; // RST (with 10kΩ resistor)    YELLOW
+constexpr Pin<4> PIN_CE;  // CE (with 1kΩ resistor)      ORANGE
+constexpr Pin<5> PIN_DC;  // DC (with 10kΩ resistor)     GREEN
+constexpr Pin<6> PIN_DIN; // DIN (with 10kΩ resistor)    BLUE
+constexpr Pin<7> PIN_CLK; // CLK (with 10kΩ resistor)    PURPLE
+constexpr Pin<13> PIN_BL; // Backlight with 330Ω resistor   WHITE
+
+// Pins the on-chip peripherals claim
+const uint8_t SERIAL_RX_PIN = 0;
+const uint8_t SERIAL_TX_PIN = 1;
+const uint8_t I2C_SDA_PIN = 20; // LiquidCrystal_I2C
+const uint8_t I2C_SCL_PIN = 21;
+const uint8_t SPI_MISO_PIN = 50; // MFRC522
+const uint8_t SPI_MOSI_PIN = 51;
+const uint8_t SPI_SCK_PIN = 52;
+
+constexpr uint8_t KIOSK_PINS[] = {
+    upButton, downButton, selectButton,
+    servoPin1, servoPin2,
+    CAPACITIVE_SENSOR_PIN, inductiveSensorPin,
+    TRIGGER_PIN, ECHO_PIN,
+    PIN_RED, PIN_GREEN, PIN_BLUE,
+    SS_PIN, RST_PIN,
+    SIM_RX, SIM_TX, SIM_RTS, SIM_CTS,
+    LOADCELL_DOUT_PIN, LOADCELL_SCK_PIN,
+    LDR_PIN, LED_INLET_PIN,
+    coinHopperSensor_PIN, relayPin,
+    PIN_RST, PIN_CE, PIN_DC, PIN_DIN, PIN_CLK, PIN_BL,
+    SERIAL_RX_PIN, SERIAL_TX_PIN, I2C_SDA_PIN, I2C_SCL_PIN,
+    SPI_MISO_PIN, SPI_MOSI_PIN, SPI_SCK_PIN};
+
+static_assert(fastpin::duplicatePin(KIOSK_PINS, sizeof(KIOSK_PINS)) == fastpin::NO_PIN,
+              "Two signals share a pin");
+static_assert(SIM_RX == 17 && SIM_TX == 16, "ModemUart drives USART2");
+static_assert(fastpin::pinChangeCapable(upButton) && fastpin::pinChangeCapable(downButton) &&
+                  fastpin::pinChangeCapable(selectButton),
+              "Buttons wake the MCU by pin-change interrupt");
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Idle power management.
+// With nobody at the kiosk the loop steps down: after POWER_DIM_AFTER_MS the
+// LCD backlight and status LED go off and the Nokia backlight is dimmed;
+// after POWER_DEEP_AFTER_MS both displays go dark, the servos are detached
+// and the load cell and RFID antenna are powered down. The application
+// applies each level; this module tracks inactivity and sleeps the MCU
+// between loop ticks.
+//
+// Active and dim ticks sleep in SLEEP_MODE_IDLE, so timers and the UARTs
+// keep running. Deep ticks use SLEEP_MODE_PWR_DOWN, woken by the watchdog
+// interrupt once per WATCHDOG_PERIOD_MS or by a pin change on a button;
+// millis() is carried across the sleep from the watchdog period, so it is
+// only as accurate as the watchdog oscillator while dark. The console cannot
+// receive in power-down, so powerSetDeepSleep(false) keeps deep ticks in
+// idle mode for a connected laptop.
+
+enum PowerLevel : uint8_t
+{
+    POWER_ACTIVE,
+    POWER_DIM,
+    POWER_DEEP,
+    POWER_LEVEL_COUNT
+};
+
+const uint32_t POWER_DIM_AFTER_MS = 30000;
+const uint32_t POWER_DEEP_AFTER_MS = 120000;
+
+struct PowerStats
+{
+    uint32_t levelMs[POWER_LEVEL_COUNT]; // Time spent in loop ticks per level
+    uint16_t buttonWakes;                // Ticks cut short by a button
+};
+
+void powerActivity();    // Someone is using the kiosk, back to POWER_ACTIVE
+uint8_t powerLevel();    // Level for the time since the last activity
+void powerSleep();       // One loop tick at the current level; a button ends it early
+void powerSetDeepSleep(bool enabled);
+bool powerDeepSleepEnabled();
+const PowerStats &powerStats();
+const __FlashStringHelper *powerLevelName(uint8_t level);
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Cycle-level profiler.
+// Build with -D PISO_PROFILE to enable it. When the flag is not set every
+// probe expands to nothing and no timer or ISR is pulled into the image.
+// -D PISO_BENCH instead turns every probe into a marker write for the
+// simavr benchmark harness in tools/avrbench.
+
+// Probe ids - one slot per instrumented function
+enum ProfileProbeId : uint8_t
+{
+    PROF_DUAL_DISPLAY,    // updateDualDisplayStatus()
+    PROF_CAPACITIVE_READ, // getCapacitiveSensorValue()
+    PROF_READ_POINTS,     // readPoints()
+    PROF_NOKIA_DISPLAY,   // nokia.display()
+    PROF_SONAR_PING,      // sonar.ping_median()
+    PROF_WRITE_POINTS,    // writePoints()
+    PROF_DEPOSIT,         // depositAction()
+    PROF_PROBE_COUNT
+};
+
+// Timer1 runs with prescaler 8, so one tick is 0.5us at 16 MHz
+const uint8_t PROFILE_TICKS_PER_US = 2;
+
+// Bench markers, shared with the harness: probes write their id to GPIOR0
+// on entry and id | BENCH_EXIT on exit, and loop() writes BENCH_LOOP
+const uint8_t BENCH_EXIT = 0x80;
+const uint8_t BENCH_LOOP = 0x7F;
+
+#if defined(PISO_BENCH) && defined(__AVR__)
+
+// The harness hooks GPIOR0 and stamps each write with the cycle counter,
+// so the markers cost one OUT instruction and need no timer.
+
+inline void benchMark(uint8_t code)
+{
+    GPIOR0 = code;
+}
+
+class ProfileProbe
+{
+public:
+    explicit ProfileProbe(uint8_t id) : id(id) { benchMark(id); }
+    ~ProfileProbe() { benchMark(id | BENCH_EXIT); }
+
+private:
+    uint8_t id;
+};
+
+inline void profilerBegin() {}
+inline void profilerLoopMark() { benchMark(BENCH_LOOP); }
+inline void profilerReset() {}
+inline bool profilerReport(Print &, uint16_t) { return false; }
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(id) ProfileProbe PROFILE_CONCAT(profileProbe_, __LINE__)(id)
+
+#elif defined(PISO_PROFILE)
+
+struct ProfileSlot
+{
+    uint32_t calls;
+    uint32_t totalTicks;
+    uint32_t minTicks;
+    uint32_t maxTicks;
+};
+
+void profilerBegin();
+uint32_t profilerTicks();
+void profilerRecord(uint8_t id, uint32_t ticks);
+void profilerLoopMark();
+void profilerReset();
+bool profilerReport(Print &out, uint16_t line); // One line per call, false after the last
+
+// Scoped probe: records the ticks between construction and destruction
+class ProfileProbe
+{
+public:
+    explicit ProfileProbe(uint8_t id) : id(id), start(profilerTicks()) {}
+    ~ProfileProbe() { profilerRecord(id, profilerTicks() - start); }
+
+private:
+    uint8_t id;
+    uint32_t start;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_SCOPE(id) ProfileProbe PROFILE_CONCAT(profileProbe_, __LINE__)(id)
+
+#else
+
+inline void profilerBegin() {}
+inline void profilerLoopMark() {}
+inline void profilerReset() {}
+inline bool profilerReport(Print &, uint16_t) { return false; }
+
+#define PROFILE_SCOPE(id) ((void)0)
+
+#endif
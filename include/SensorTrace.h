@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Raw sensor trace capture for tuning the verification thresholds offline.
+// While capture is on, every raw sample the verification logic reads is
+// delta-encoded into small checksummed packets that share the serial port
+// with the binary log. tools/logdecode.py --trace extracts the packets and
+// tools/tracereplay feeds them back through the firmware on the host.
+
+enum TraceChannel : uint8_t
+{
+    TRACE_CAPACITIVE, // ADC counts, mean of one getCapacitiveSensorValue()
+    TRACE_LOADCELL,   // HX711 raw counts
+    TRACE_INDUCTIVE,  // Digital level
+    TRACE_LDR,        // Digital level
+    TRACE_TARE,       // HX711 offset in counts
+    TRACE_SCALE,      // HX711 counts per gram x1000
+    TRACE_MARK,       // Flow marker, see TraceMark
+    TRACE_CHANNEL_COUNT
+};
+
+enum TraceMark : uint8_t
+{
+    TRACE_MARK_DEPOSIT,   // depositAction() started
+    TRACE_MARK_ACCEPTED,
+    TRACE_MARK_REJECTED,
+    TRACE_MARK_NO_OBJECT  // Nothing was inserted before the timeout
+};
+
+// Wire format:
+//   packet  sync, payload length, sequence, start time (ms, u32 LE),
+//           payload, checksum (sum of every byte after sync)
+//   sample  tag = channel << 5 | ms since the previous sample (31: u16 follows),
+//           then the change from the channel's previous value in this packet
+//           as a zigzag varint. Every packet starts from zero, so a lost
+//           packet only loses its own samples.
+const uint8_t TRACE_SYNC_BYTE = 0xB6;
+const uint8_t TRACE_HEADER_SIZE = 7;
+const uint8_t TRACE_PAYLOAD_SIZE = 40;
+const uint8_t TRACE_PACKET_SIZE = TRACE_HEADER_SIZE + TRACE_PAYLOAD_SIZE + 1;
+const uint8_t TRACE_DT_ESCAPE = 31;
+
+extern bool traceEnabled;
+
+void traceBegin(Print &port);
+void traceStart();
+void traceStop();
+void traceRecord(uint8_t channel, int32_t value);
+void traceFlush();
+uint16_t traceDroppedPackets();
+
+// Cheap enough to leave in the sensor paths when capture is off
+inline void traceSample(TraceChannel channel, int32_t value)
+{
+    if (traceEnabled)
+    {
+        traceRecord(channel, value);
+    }
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Telemetry digest, one SMS per report.
+// A digest is a fixed set of counters, each cumulative since boot so a lost
+// message costs nothing but resolution; the receiver takes differences and
+// sees a reboot as the uptime going back. The fields are packed
+// little-endian at the widths below, saturating, followed by a CRC-16
+// (CCITT) of the packed bytes, and written as base64 after a "PB<version> "
+// tag. Base64 stays inside the GSM 7-bit default alphabet, so the text is
+// always one single-part SMS of TELEMETRY_TEXT_LENGTH characters, however
+// busy the kiosk was.
+//
+// This list is the wire schema, shared with the host tools: append new
+// fields at the end and raise TELEMETRY_VERSION. Each entry is an id, its
+// width in bytes and a short column name.
+#define TELEMETRY_FIELDS(X)                             \
+    X(TELEMETRY_UNIT, 2, "unit")                        \
+    X(TELEMETRY_SEQUENCE, 2, "sequence")                \
+    X(TELEMETRY_UPTIME_MIN, 3, "uptime_min")            \
+    X(TELEMETRY_RESET_CAUSE, 1, "reset_cause")          \
+    X(TELEMETRY_EXPIRED_TASK, 1, "expired_task")        \
+    X(TELEMETRY_ACCEPTED, 3, "accepted")                \
+    X(TELEMETRY_REJECTED, 3, "rejected")                \
+    X(TELEMETRY_REJECT_NO_OBJECT, 2, "reject_no_object") \
+    X(TELEMETRY_REJECT_WEIGHT, 2, "reject_weight")      \
+    X(TELEMETRY_REJECT_METAL, 2, "reject_metal")        \
+    X(TELEMETRY_REJECT_OPAQUE, 2, "reject_opaque")      \
+    X(TELEMETRY_COINS, 3, "coins")                      \
+    X(TELEMETRY_CARD_TAPS, 2, "card_taps")              \
+    X(TELEMETRY_DISPENSE_FAULTS, 2, "dispense_faults")  \
+    X(TELEMETRY_FILL_LEVEL, 1, "fill_level")            \
+    X(TELEMETRY_MINUTES_TO_FULL, 2, "minutes_to_full")  \
+    X(TELEMETRY_BIN_FULL, 2, "bin_full")                \
+    X(TELEMETRY_BIN_EMPTIED, 2, "bin_emptied")          \
+    X(TELEMETRY_WATCHDOG_LATE, 2, "watchdog_late")      \
+    X(TELEMETRY_MODEM_ERRORS, 2, "modem_errors")        \
+    X(TELEMETRY_RFID_ERRORS, 2, "rfid_errors")          \
+    X(TELEMETRY_LOG_DROPPED, 2, "log_dropped")          \
+    X(TELEMETRY_MEMORY_HEADROOM, 2, "memory_headroom")
+
+#define TELEMETRY_FIELD_ENUM(id, bytes, name) id,
+#define TELEMETRY_FIELD_BYTES(id, bytes, name) +bytes
+
+enum TelemetryField : uint8_t
+{
+    TELEMETRY_FIELDS(TELEMETRY_FIELD_ENUM)
+    TELEMETRY_FIELD_COUNT
+};
+
+const uint8_t TELEMETRY_VERSION = 1;
+const uint8_t TELEMETRY_PACKED_SIZE = 0 TELEMETRY_FIELDS(TELEMETRY_FIELD_BYTES) + 2; // With the CRC
+const uint8_t TELEMETRY_TAG_LENGTH = 4;                                               // "PB1 "
+const uint8_t TELEMETRY_TEXT_LENGTH = TELEMETRY_TAG_LENGTH + (TELEMETRY_PACKED_SIZE * 4 + 2) / 3;
+
+#undef TELEMETRY_FIELD_ENUM
+#undef TELEMETRY_FIELD_BYTES
+
+static_assert(TELEMETRY_TEXT_LENGTH <= 160, "The digest must fit one SMS");
+
+struct TelemetryDigest
+{
+    uint32_t values[TELEMETRY_FIELD_COUNT];
+};
+
+// text needs TELEMETRY_TEXT_LENGTH + 1 bytes; returns the length
+uint8_t telemetryEncode(const TelemetryDigest &digest, char *text);
+// False for a wrong tag, length or CRC
+bool telemetryDecode(const char *text, size_t length, TelemetryDigest &digest);
+uint8_t telemetryFieldBytes(uint8_t field);
+const __FlashStringHelper *telemetryFieldName(uint8_t field);
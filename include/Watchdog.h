@@ -0,0 +1,68 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Hardware watchdog supervision.
+// The AVR watchdog runs in interrupt-then-reset mode with a 1 s period. Its
+// interrupt is the supervisor: while the innermost running task has checked
+// in within its budget the interrupt re-arms itself, otherwise it notes the
+// task in RAM that survives the reset and lets the next period reset the
+// MCU. A hang anywhere - a busy-wait, a blocking library call, a lost
+// interrupt - therefore ends in a reset after at most budget + 2 s.
+//
+// Tasks nest: entering one suspends the task it was started from, and
+// leaving it restarts the outer task's budget. Heartbeats that arrive later
+// than their budget are counted; on the Mega the supervisor normally resets
+// first, so the count there also carries the trips since power-on across
+// the resets. The native build has no reset and only counts.
+
+enum WatchdogTask : uint8_t
+{
+    WATCHDOG_BOOT,   // setup()
+    WATCHDOG_LOOP,   // Idle loop and menu navigation
+    WATCHDOG_ACTION, // A menu action waiting on the customer
+    WATCHDOG_INTAKE, // Detecting, verifying and dropping bottles
+    WATCHDOG_PAYOUT, // Coin hopper running
+    WATCHDOG_MODEM,  // SMS exchange with the SIM800
+    WATCHDOG_TASK_COUNT
+};
+
+enum ResetCause : uint8_t
+{
+    RESET_POWER_ON,
+    RESET_EXTERNAL,
+    RESET_BROWN_OUT,
+    RESET_WATCHDOG,
+    RESET_UNKNOWN // Jump to 0 or a bootloader that cleared MCUSR
+};
+
+// Supervisor interrupt period; in deep idle it is also the loop tick
+const uint16_t WATCHDOG_PERIOD_MS = 1000;
+
+struct WatchdogStats
+{
+    uint8_t resetCause;
+    uint8_t expiredTask;                      // Task that starved before a watchdog reset
+    uint16_t lateKicks;                       // Heartbeats past their budget, trips included
+    uint32_t worstGapMs[WATCHDOG_TASK_COUNT]; // Longest time between heartbeats
+};
+
+void watchdogBegin(); // First thing in setup(), enters WATCHDOG_BOOT
+void watchdogEnter(uint8_t task);
+void watchdogLeave(uint8_t task);
+void watchdogKick(uint8_t task); // Ignored unless the task is the innermost one
+uint8_t watchdogCurrentTask();
+const WatchdogStats &watchdogStats();
+const __FlashStringHelper *watchdogTaskName(uint8_t task);
+const __FlashStringHelper *resetCauseName(uint8_t cause);
+
+// Runs a task for the rest of the enclosing block
+class WatchdogScope
+{
+public:
+    explicit WatchdogScope(uint8_t task) : task(task) { watchdogEnter(task); }
+    ~WatchdogScope() { watchdogLeave(task); }
+
+private:
+    uint8_t task;
+};
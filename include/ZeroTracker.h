@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Load cell zero tracking.
+// While the kiosk is idle with an empty platform, raw samples are collected
+// in windows. A window that is steady and close to zero moves the tare
+// offset towards its mean by at most a small step, so drift and residue are
+// followed slowly while a bottle or a hand is never tared away.
+
+struct ZeroTrackStats
+{
+    int32_t drift;            // Offset moved since the last full tare, counts
+    int32_t lastError;        // Mean of the last steady window, counts
+    uint16_t adjustments;     // Windows that moved the offset
+    uint16_t unsteadyWindows; // Windows rejected as moving
+    uint16_t outOfRange;      // Steady windows too far from zero to track
+    uint32_t lastAdjustMs;
+};
+
+void zeroTrackBegin();  // After loadCellBegin(), converts the limits to counts
+void zeroTrackCalibrationChanged(); // Reconverts the limits to counts
+void zeroTrackRebase(); // After a full tare, clears the drift
+void zeroTrackHold();   // Platform disturbed, discard the window and settle again
+// Feeds one idle sample; returns the offset correction to apply, 0 for none
+int32_t zeroTrackSample(int32_t countsFromTare);
+const ZeroTrackStats &zeroTrackStats();
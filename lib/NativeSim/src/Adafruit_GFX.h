@@ -0,0 +1,50 @@
+#pragma once
+
+#include "Arduino.h"
+
+// Minimal GFX base: primitives used by the firmware, drawn through drawPixel().
+// Text uses a placeholder 5x7 cell instead of the Adafruit glcdfont glyphs;
+// layout, cursor movement and timing match, pixel art does not.
+class Adafruit_GFX : public Print
+{
+public:
+    Adafruit_GFX(int16_t w, int16_t h);
+
+    virtual void drawPixel(int16_t x, int16_t y, uint16_t color) = 0;
+
+    void drawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint16_t color);
+    void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color);
+    void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color);
+    void drawRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+    void drawBitmap(int16_t x, int16_t y, const uint8_t *bitmap, int16_t w, int16_t h, uint16_t color);
+    void drawChar(int16_t x, int16_t y, unsigned char c, uint16_t color, uint16_t bg, uint8_t size);
+
+    void setCursor(int16_t x, int16_t y)
+    {
+        cursorX = x;
+        cursorY = y;
+    }
+    void setTextSize(uint8_t size) { textSize = size > 0 ? size : 1; }
+    void setTextColor(uint16_t color) { textColor = color; }
+    void setTextWrap(bool wrap) { textWrap = wrap; }
+    void setRotation(uint8_t r) { rotation = r & 3; }
+    uint8_t getRotation() const { return rotation; }
+    int16_t getCursorX() const { return cursorX; }
+    int16_t getCursorY() const { return cursorY; }
+    int16_t width() const { return (rotation & 1) ? rawHeight : rawWidth; }
+    int16_t height() const { return (rotation & 1) ? rawWidth : rawHeight; }
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+protected:
+    const int16_t rawWidth;
+    const int16_t rawHeight;
+    int16_t cursorX = 0;
+    int16_t cursorY = 0;
+    uint16_t textColor = 1;
+    uint8_t textSize = 1;
+    uint8_t rotation = 0;
+    bool textWrap = true;
+};
@@ -0,0 +1,91 @@
+#include "Adafruit_PCD8544.h"
+
+#include "SimHarness.h"
+
+static Adafruit_PCD8544 *activeNokia = nullptr;
+
+Adafruit_PCD8544::Adafruit_PCD8544(int8_t sclkPin, int8_t dinPin, int8_t dcPin, int8_t csPin, int8_t rstPin)
+    : Adafruit_GFX(LCDWIDTH, LCDHEIGHT)
+{
+    memset(buffer, 0, sizeof(buffer));
+    activeNokia = this;
+}
+
+bool Adafruit_PCD8544::begin(uint8_t contrast, uint8_t bias)
+{
+    this->contrast = contrast;
+    clearDisplay();
+    return true;
+}
+
+void Adafruit_PCD8544::clearDisplay()
+{
+    memset(buffer, 0, sizeof(buffer));
+    cursorX = 0;
+    cursorY = 0;
+}
+
+void Adafruit_PCD8544::display()
+{
+    sim::advanceMicros(sim::costs().nokiaFrame);
+    frames++;
+}
+
+void Adafruit_PCD8544::drawPixel(int16_t x, int16_t y, uint16_t color)
+{
+    if (x < 0 || x >= width() || y < 0 || y >= height())
+    {
+        return;
+    }
+
+    // Map through the rotation onto the native panel orientation
+    switch (rotation)
+    {
+    case 1:
+    {
+        int16_t t = x;
+        x = LCDWIDTH - 1 - y;
+        y = t;
+        break;
+    }
+    case 2:
+        x = LCDWIDTH - 1 - x;
+        y = LCDHEIGHT - 1 - y;
+        break;
+    case 3:
+    {
+        int16_t t = x;
+        x = y;
+        y = LCDHEIGHT - 1 - t;
+        break;
+    }
+    }
+
+    if (color)
+    {
+        buffer[x + (y / 8) * LCDWIDTH] |= 1 << (y % 8);
+    }
+    else
+    {
+        buffer[x + (y / 8) * LCDWIDTH] &= ~(1 << (y % 8));
+    }
+}
+
+bool Adafruit_PCD8544::getPixel(int8_t x, int8_t y)
+{
+    if (x < 0 || x >= LCDWIDTH || y < 0 || y >= LCDHEIGHT)
+    {
+        return false;
+    }
+    return (buffer[x + (y / 8) * LCDWIDTH] >> (y % 8)) & 0x1;
+}
+
+uint32_t sim::nokiaFrameCount()
+{
+    return activeNokia != nullptr ? activeNokia->frameCount() : 0;
+}
+
+const uint8_t *sim::nokiaFramebuffer()
+{
+    return activeNokia != nullptr ? activeNokia->getBuffer() : nullptr;
+}
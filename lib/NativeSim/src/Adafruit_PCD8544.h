@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Adafruit_GFX.h"
+
+#define BLACK 1
+#define WHITE 0
+
+#define LCDWIDTH 84
+#define LCDHEIGHT 48
+
+// Nokia 5110 (PCD8544) with a local framebuffer in the controller's bank
+// layout: byte x + (y / 8) * LCDWIDTH holds 8 vertical pixels, LSB on top.
+class Adafruit_PCD8544 : public Adafruit_GFX
+{
+public:
+    Adafruit_PCD8544(int8_t sclkPin, int8_t dinPin, int8_t dcPin, int8_t csPin, int8_t rstPin);
+
+    bool begin(uint8_t contrast = 40, uint8_t bias = 0x04);
+    void setContrast(uint8_t value) { contrast = value; }
+    uint8_t getContrast() const { return contrast; }
+    void clearDisplay();
+    void display();
+
+    void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+    bool getPixel(int8_t x, int8_t y);
+
+    uint8_t *getBuffer() { return buffer; }
+    uint32_t frameCount() const { return frames; }
+
+private:
+    uint8_t buffer[LCDWIDTH * LCDHEIGHT / 8];
+    uint8_t contrast = 40;
+    uint32_t frames = 0;
+};
@@ -0,0 +1,217 @@
+#include "Arduino.h"
+
+#include "SimHarness.h"
+
+long map(long x, long inMin, long inMax, long outMin, long outMax)
+{
+    return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+static unsigned long randomState = 1;
+
+long random(long howBig)
+{
+    if (howBig <= 0)
+    {
+        return 0;
+    }
+    randomState = randomState * 1103515245UL + 12345UL;
+    return (long)((randomState >> 1) % (unsigned long)howBig);
+}
+
+long random(long howSmall, long howBig)
+{
+    if (howSmall >= howBig)
+    {
+        return howSmall;
+    }
+    return random(howBig - howSmall) + howSmall;
+}
+
+void randomSeed(unsigned long seed)
+{
+    if (seed != 0)
+    {
+        randomState = seed;
+    }
+}
+
+unsigned long millis()
+{
+    sim::advanceMicros(sim::costs().clockRead);
+    return sim::nowMillis();
+}
+
+unsigned long micros()
+{
+    sim::advanceMicros(sim::costs().clockRead);
+    return (unsigned long)sim::nowMicros();
+}
+
+void delay(unsigned long ms)
+{
+    sim::advanceMicros((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+    sim::advanceMicros(us);
+}
+
+void yield()
+{
+}
+
+// GPIO and ADC state
+struct PinState
+{
+    uint8_t mode = INPUT;
+    bool output = false;
+    bool driven = false; // Input level forced by the harness
+    bool input = false;
+    int analogIn = 0;
+    int analogOut = 0;
+};
+
+static PinState pins[NUM_DIGITAL_PINS];
+static int analogNoise = 0;
+
+static PinState *pinState(uint8_t pin)
+{
+    return pin < NUM_DIGITAL_PINS ? &pins[pin] : nullptr;
+}
+
+void pinMode(uint8_t pin, uint8_t mode)
+{
+    if (PinState *state = pinState(pin))
+    {
+        state->mode = mode;
+    }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value)
+{
+    sim::advanceMicros(sim::costs().digitalIo);
+    if (PinState *state = pinState(pin))
+    {
+        state->output = value != LOW;
+    }
+}
+
+int digitalRead(uint8_t pin)
+{
+    sim::advanceMicros(sim::costs().digitalIo);
+    PinState *state = pinState(pin);
+    if (state == nullptr)
+    {
+        return LOW;
+    }
+    if (state->mode == OUTPUT)
+    {
+        return state->output ? HIGH : LOW;
+    }
+    if (state->driven)
+    {
+        return state->input ? HIGH : LOW;
+    }
+    return state->mode == INPUT_PULLUP ? HIGH : LOW;
+}
+
+int analogRead(uint8_t pin)
+{
+    sim::advanceMicros(sim::costs().analogRead);
+    PinState *state = pinState(pin);
+    if (state == nullptr)
+    {
+        return 0;
+    }
+
+    int value = state->analogIn;
+    if (analogNoise > 0)
+    {
+        value += random(-analogNoise, analogNoise + 1);
+    }
+    return constrain(value, 0, 1023);
+}
+
+void analogWrite(uint8_t pin, int value)
+{
+    sim::advanceMicros(sim::costs().analogWrite);
+    if (PinState *state = pinState(pin))
+    {
+        state->analogOut = constrain(value, 0, 255);
+        state->output = value != 0;
+    }
+}
+
+static std::function<void(uint8_t)> pinChangeListener;
+
+static bool inputLevel(const PinState &state)
+{
+    return state.driven ? state.input : state.mode == INPUT_PULLUP;
+}
+
+static void notifyPinChange(uint8_t pin, bool before, const PinState &state)
+{
+    if (pinChangeListener && state.mode != OUTPUT && inputLevel(state) != before)
+    {
+        pinChangeListener(pin);
+    }
+}
+
+void sim::setDigitalInput(uint8_t pin, bool level)
+{
+    if (PinState *state = pinState(pin))
+    {
+        bool before = inputLevel(*state);
+        state->driven = true;
+        state->input = level;
+        notifyPinChange(pin, before, *state);
+    }
+}
+
+void sim::releaseDigitalInput(uint8_t pin)
+{
+    if (PinState *state = pinState(pin))
+    {
+        bool before = inputLevel(*state);
+        state->driven = false;
+        notifyPinChange(pin, before, *state);
+    }
+}
+
+void sim::setPinChangeListener(std::function<void(uint8_t)> listener)
+{
+    pinChangeListener = listener;
+}
+
+bool sim::digitalOutput(uint8_t pin)
+{
+    PinState *state = pinState(pin);
+    return state != nullptr && state->output;
+}
+
+uint8_t sim::pinModeOf(uint8_t pin)
+{
+    PinState *state = pinState(pin);
+    return state != nullptr ? state->mode : INPUT;
+}
+
+void sim::setAnalogInput(uint8_t pin, int value)
+{
+    if (PinState *state = pinState(pin))
+    {
+        state->analogIn = value;
+    }
+}
+
+void sim::setAnalogNoise(int amplitude)
+{
+    analogNoise = amplitude;
+}
+
+int sim::analogOutput(uint8_t pin)
+{
+    PinState *state = pinState(pin);
+    return state != nullptr ? state->analogOut : 0;
+}
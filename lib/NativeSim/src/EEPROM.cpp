@@ -0,0 +1,43 @@
+#include "EEPROM.h"
+
+#include <string.h>
+
+#include "SimHarness.h"
+
+EEPROMClass EEPROM;
+
+static uint8_t eepromBytes[4096];
+static bool eepromErased = false;
+
+uint8_t *sim::eeprom()
+{
+    if (!eepromErased)
+    {
+        memset(eepromBytes, 0xFF, sizeof(eepromBytes));
+        eepromErased = true;
+    }
+    return eepromBytes;
+}
+
+uint8_t EEPROMClass::read(int address)
+{
+    sim::advanceMicros(sim::costs().digitalIo);
+    return address >= 0 && address < length() ? sim::eeprom()[address] : 0xFF;
+}
+
+void EEPROMClass::write(int address, uint8_t value)
+{
+    sim::advanceMicros(sim::costs().eepromWrite);
+    if (address >= 0 && address < length())
+    {
+        sim::eeprom()[address] = value;
+    }
+}
+
+void EEPROMClass::update(int address, uint8_t value)
+{
+    if (read(address) != value)
+    {
+        write(address, value);
+    }
+}
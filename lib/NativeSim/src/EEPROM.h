@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Arduino.h"
+
+// ATmega2560 EEPROM: 4 KB, erased bytes read 0xFF, writes cost ~3.4 ms
+class EEPROMClass
+{
+public:
+    uint8_t read(int address);
+    void write(int address, uint8_t value);
+    void update(int address, uint8_t value);
+    uint16_t length() const { return 4096; }
+
+    template <typename T>
+    T &get(int address, T &value)
+    {
+        uint8_t *bytes = (uint8_t *)&value;
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            bytes[i] = read(address + i);
+        }
+        return value;
+    }
+
+    template <typename T>
+    const T &put(int address, const T &value)
+    {
+        const uint8_t *bytes = (const uint8_t *)&value;
+        for (size_t i = 0; i < sizeof(T); i++)
+        {
+            update(address + i, bytes[i]);
+        }
+        return value;
+    }
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,98 @@
+#include "HX711.h"
+
+#include "SimHarness.h"
+
+static sim::LoadCellModel loadCellModel;
+
+sim::LoadCellModel &sim::loadCell()
+{
+    return loadCellModel;
+}
+
+void HX711::begin(uint8_t dout, uint8_t pdSck, uint8_t gain)
+{
+    lastSampleUs = sim::nowMicros();
+}
+
+bool HX711::is_ready()
+{
+    sim::advanceMicros(sim::costs().digitalIo);
+    return loadCellModel.connected && sim::nowMicros() - lastSampleUs >= loadCellModel.samplePeriodUs;
+}
+
+void HX711::wait_ready(unsigned long delayMs)
+{
+    // Like the library this never gives up on a disconnected cell
+    while (!is_ready() && !sim::stopRequested())
+    {
+        delay(delayMs > 0 ? delayMs : 1);
+    }
+}
+
+bool HX711::wait_ready_retry(int retries, unsigned long delayMs)
+{
+    for (int i = 0; i < retries; i++)
+    {
+        if (is_ready())
+        {
+            return true;
+        }
+        delay(delayMs > 0 ? delayMs : 1);
+    }
+    return false;
+}
+
+bool HX711::wait_ready_timeout(unsigned long timeout, unsigned long delayMs)
+{
+    unsigned long start = millis();
+    while (millis() - start < timeout)
+    {
+        if (is_ready())
+        {
+            return true;
+        }
+        delay(delayMs > 0 ? delayMs : 1);
+    }
+    return false;
+}
+
+long HX711::read()
+{
+    wait_ready();
+    lastSampleUs = sim::nowMicros();
+
+    // 25 clock pulses, bit-banged
+    sim::advanceMicros(60);
+
+    long counts = loadCellModel.zeroCounts + (long)(loadCellModel.grams * loadCellModel.countsPerGram);
+    if (loadCellModel.noiseCounts > 0)
+    {
+        counts += random(-loadCellModel.noiseCounts, loadCellModel.noiseCounts + 1);
+    }
+    return constrain(counts, -0x800000L, 0x7FFFFFL);
+}
+
+long HX711::read_average(uint8_t times)
+{
+    long sum = 0;
+    for (uint8_t i = 0; i < times; i++)
+    {
+        sum += read();
+    }
+    return times > 0 ? sum / times : 0;
+}
+
+double HX711::get_value(uint8_t times)
+{
+    return read_average(times) - offsetCounts;
+}
+
+float HX711::get_units(uint8_t times)
+{
+    return get_value(times) / scaleFactor;
+}
+
+void HX711::tare(uint8_t times)
+{
+    set_offset(read_average(times));
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "Arduino.h"
+
+class HX711
+{
+public:
+    void begin(uint8_t dout, uint8_t pdSck, uint8_t gain = 128);
+    bool is_ready();
+    void wait_ready(unsigned long delayMs = 0);
+    bool wait_ready_retry(int retries = 3, unsigned long delayMs = 0);
+    bool wait_ready_timeout(unsigned long timeout = 1000, unsigned long delayMs = 0);
+
+    long read();
+    long read_average(uint8_t times = 10);
+    double get_value(uint8_t times = 1);
+    float get_units(uint8_t times = 1);
+    void tare(uint8_t times = 10);
+
+    void set_scale(float scale = 1.f) { scaleFactor = scale; }
+    float get_scale() const { return scaleFactor; }
+    void set_offset(long offset = 0) { offsetCounts = offset; }
+    long get_offset() const { return offsetCounts; }
+    void set_gain(uint8_t gain = 128) {}
+    void power_down() {}
+    void power_up() {}
+
+private:
+    float scaleFactor = 1.f;
+    long offsetCounts = 0;
+    uint64_t lastSampleUs = 0;
+};
@@ -0,0 +1,94 @@
+#include "HardwareSerial.h"
+
+#include "Arduino.h"
+#include "SimHarness.h"
+
+HardwareSerial Serial;
+
+static const int SERIAL_TX_BUFFER_SIZE = 64;
+
+static FILE *serialOutput = stdout;
+
+void sim::setSerialOutput(FILE *out)
+{
+    serialOutput = out;
+}
+
+void sim::queueSerialInput(const std::string &text)
+{
+    Serial.queueInput(text);
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+    baudRate = baud > 0 ? baud : 9600;
+}
+
+void HardwareSerial::queueInput(const std::string &text)
+{
+    rxQueue.insert(rxQueue.end(), text.begin(), text.end());
+}
+
+int HardwareSerial::available()
+{
+    sim::advanceMicros(sim::costs().clockRead);
+    return rxQueue.size();
+}
+
+int HardwareSerial::read()
+{
+    if (rxQueue.empty())
+    {
+        return -1;
+    }
+    uint8_t c = rxQueue.front();
+    rxQueue.pop_front();
+    return c;
+}
+
+int HardwareSerial::peek()
+{
+    return rxQueue.empty() ? -1 : rxQueue.front();
+}
+
+int HardwareSerial::availableForWrite()
+{
+    uint64_t now = sim::nowMicros();
+    if (txBusyUntilUs <= now)
+    {
+        return SERIAL_TX_BUFFER_SIZE - 1;
+    }
+    uint64_t queued = (txBusyUntilUs - now + byteTimeUs() - 1) / byteTimeUs();
+    return queued >= SERIAL_TX_BUFFER_SIZE - 1 ? 0 : SERIAL_TX_BUFFER_SIZE - 1 - (int)queued;
+}
+
+size_t HardwareSerial::write(uint8_t byte)
+{
+    // Block like the AVR core when the TX buffer is full
+    while (availableForWrite() == 0)
+    {
+        sim::advanceMicros(byteTimeUs());
+    }
+
+    uint64_t now = sim::nowMicros();
+    txBusyUntilUs = (txBusyUntilUs > now ? txBusyUntilUs : now) + byteTimeUs();
+
+    if (serialOutput != nullptr)
+    {
+        fputc(byte, serialOutput);
+    }
+    return 1;
+}
+
+void HardwareSerial::flush()
+{
+    uint64_t now = sim::nowMicros();
+    if (txBusyUntilUs > now)
+    {
+        sim::advanceMicros(txBusyUntilUs - now);
+    }
+    if (serialOutput != nullptr)
+    {
+        fflush(serialOutput);
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <deque>
+#include "Stream.h"
+
+// USB serial port. Output goes to the harness sink with the TX buffer and
+// baud rate modelled in virtual time; input comes from sim::queueSerialInput().
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long baud);
+    void end() {}
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t byte) override;
+    using Print::write;
+    int availableForWrite() override;
+    void flush() override;
+
+    operator bool() const { return true; }
+
+    void queueInput(const std::string &text);
+
+private:
+    unsigned long baudRate = 9600;
+    uint64_t txBusyUntilUs = 0;
+    std::deque<uint8_t> rxQueue;
+
+    uint32_t byteTimeUs() const { return 10000000UL / baudRate; }
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,81 @@
+#include "LiquidCrystal_I2C.h"
+
+#include "SimHarness.h"
+
+static LiquidCrystal_I2C *activeLcd = nullptr;
+
+LiquidCrystal_I2C::LiquidCrystal_I2C(uint8_t address, uint8_t cols, uint8_t rows)
+    : cols(cols > 40 ? 40 : cols), rows(rows > 4 ? 4 : rows)
+{
+    memset(text, ' ', sizeof(text));
+    activeLcd = this;
+}
+
+void LiquidCrystal_I2C::init()
+{
+    clear();
+}
+
+void LiquidCrystal_I2C::begin(uint8_t cols, uint8_t rows)
+{
+    clear();
+}
+
+void LiquidCrystal_I2C::clear()
+{
+    sim::advanceMicros(sim::costs().lcdClear);
+    memset(text, ' ', sizeof(text));
+    cursorCol = 0;
+    cursorRow = 0;
+}
+
+void LiquidCrystal_I2C::home()
+{
+    sim::advanceMicros(sim::costs().lcdClear);
+    cursorCol = 0;
+    cursorRow = 0;
+}
+
+void LiquidCrystal_I2C::setCursor(uint8_t col, uint8_t row)
+{
+    sim::advanceMicros(sim::costs().lcdByte);
+    cursorCol = col;
+    cursorRow = row < rows ? row : rows - 1;
+}
+
+void LiquidCrystal_I2C::backlight()
+{
+    backlightState = true;
+}
+
+void LiquidCrystal_I2C::noBacklight()
+{
+    backlightState = false;
+}
+
+size_t LiquidCrystal_I2C::write(uint8_t c)
+{
+    sim::advanceMicros(sim::costs().lcdByte);
+    // Characters past the visible width land in DDRAM but are not shown
+    if (cursorCol < 40)
+    {
+        text[cursorRow][cursorCol] = c;
+    }
+    cursorCol++;
+    return 1;
+}
+
+std::string LiquidCrystal_I2C::line(uint8_t row) const
+{
+    return row < rows ? std::string(text[row], cols) : std::string();
+}
+
+std::string sim::lcdLine(uint8_t row)
+{
+    return activeLcd != nullptr ? activeLcd->line(row) : std::string();
+}
+
+bool sim::lcdBacklight()
+{
+    return activeLcd != nullptr && activeLcd->backlightOn();
+}
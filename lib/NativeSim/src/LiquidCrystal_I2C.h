@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Arduino.h"
+
+// 16x2 character LCD behind a PCF8574 I2C backpack
+class LiquidCrystal_I2C : public Print
+{
+public:
+    LiquidCrystal_I2C(uint8_t address, uint8_t cols, uint8_t rows);
+
+    void init();
+    void begin(uint8_t cols, uint8_t rows);
+    void clear();
+    void home();
+    void setCursor(uint8_t col, uint8_t row);
+    void backlight();
+    void noBacklight();
+    void display() {}
+    void noDisplay() {}
+
+    size_t write(uint8_t c) override;
+    using Print::write;
+
+    std::string line(uint8_t row) const;
+    bool backlightOn() const { return backlightState; }
+
+private:
+    uint8_t cols;
+    uint8_t rows;
+    uint8_t cursorCol = 0;
+    uint8_t cursorRow = 0;
+    bool backlightState = false;
+    char text[4][40];
+};
@@ -0,0 +1,206 @@
+#include "MFRC522.h"
+
+#include "SimHarness.h"
+
+// Card life cycle as seen by REQA: only idle cards answer
+enum CardState
+{
+    CARD_IDLE,
+    CARD_READY,
+    CARD_ACTIVE,
+    CARD_HALTED
+};
+
+static sim::Card *fieldCard = nullptr;
+static CardState fieldCardState = CARD_IDLE;
+
+void sim::presentCard(Card *card)
+{
+    fieldCard = card;
+    fieldCardState = CARD_IDLE;
+}
+
+void sim::removeCard()
+{
+    fieldCard = nullptr;
+}
+
+sim::Card *sim::presentedCard()
+{
+    return fieldCard;
+}
+
+static void transaction()
+{
+    sim::advanceMicros(sim::costs().rfidTransaction);
+}
+
+MFRC522::MFRC522(byte chipSelectPin, byte resetPowerDownPin)
+{
+    memset(&uid, 0, sizeof(uid));
+}
+
+void MFRC522::PCD_Init()
+{
+    sim::advanceMicros(50000);
+    antennaOn = true;
+    authenticatedSector = -1;
+}
+
+void MFRC522::PCD_Reset()
+{
+    sim::advanceMicros(50000);
+    authenticatedSector = -1;
+}
+
+bool MFRC522::PCD_PerformSelfTest()
+{
+    sim::advanceMicros(20000);
+    return true;
+}
+
+byte MFRC522::PCD_ReadRegister(PCD_Register reg)
+{
+    sim::advanceMicros(20);
+    return reg == VersionReg ? 0x92 : 0x00;
+}
+
+bool MFRC522::PICC_IsNewCardPresent()
+{
+    transaction();
+    if (!antennaOn || fieldCard == nullptr)
+    {
+        return false;
+    }
+
+    if (fieldCardState == CARD_IDLE)
+    {
+        fieldCardState = CARD_READY;
+        return true;
+    }
+
+    // A selected card ignores REQA; it drops back to idle on the next field reset
+    if (fieldCardState != CARD_HALTED)
+    {
+        fieldCardState = CARD_IDLE;
+    }
+    return false;
+}
+
+bool MFRC522::PICC_ReadCardSerial()
+{
+    transaction();
+    if (fieldCard == nullptr || fieldCardState != CARD_READY)
+    {
+        return false;
+    }
+
+    uid.size = 4;
+    memcpy(uid.uidByte, fieldCard->uid, 4);
+    uid.sak = fieldCard->sak;
+    fieldCardState = CARD_ACTIVE;
+    return true;
+}
+
+MFRC522::StatusCode MFRC522::PICC_HaltA()
+{
+    transaction();
+    if (fieldCard != nullptr)
+    {
+        fieldCardState = CARD_HALTED;
+    }
+    return STATUS_OK;
+}
+
+MFRC522::StatusCode MFRC522::PCD_Authenticate(byte command, byte blockAddr, MIFARE_Key *key, Uid *uid)
+{
+    transaction();
+    if (fieldCard == nullptr || fieldCardState != CARD_ACTIVE || blockAddr >= 64)
+    {
+        return STATUS_TIMEOUT;
+    }
+
+    // Cards keep the factory transport key
+    for (byte i = 0; i < 6; i++)
+    {
+        if (key->keyByte[i] != 0xFF)
+        {
+            return STATUS_ERROR;
+        }
+    }
+
+    authenticatedSector = blockAddr / 4;
+    return STATUS_OK;
+}
+
+MFRC522::StatusCode MFRC522::MIFARE_Read(byte blockAddr, byte *buffer, byte *bufferSize)
+{
+    transaction();
+    if (buffer == nullptr || *bufferSize < 18)
+    {
+        return STATUS_NO_ROOM;
+    }
+    if (fieldCard == nullptr || authenticatedSector != blockAddr / 4)
+    {
+        return STATUS_TIMEOUT;
+    }
+
+    memcpy(buffer, fieldCard->blocks[blockAddr], 16);
+    buffer[16] = 0;
+    buffer[17] = 0;
+    *bufferSize = 18;
+    return STATUS_OK;
+}
+
+MFRC522::StatusCode MFRC522::MIFARE_Write(byte blockAddr, byte *buffer, byte bufferSize)
+{
+    transaction();
+    transaction();
+    if (buffer == nullptr || bufferSize < 16)
+    {
+        return STATUS_INVALID;
+    }
+    if (fieldCard == nullptr || authenticatedSector != blockAddr / 4)
+    {
+        return STATUS_TIMEOUT;
+    }
+
+    memcpy(fieldCard->blocks[blockAddr], buffer, 16);
+    return STATUS_OK;
+}
+
+MFRC522::PICC_Type MFRC522::PICC_GetType(byte sak)
+{
+    switch (sak & 0x7F)
+    {
+    case 0x04:
+        return PICC_TYPE_NOT_COMPLETE;
+    case 0x09:
+        return PICC_TYPE_MIFARE_MINI;
+    case 0x08:
+        return PICC_TYPE_MIFARE_1K;
+    case 0x18:
+        return PICC_TYPE_MIFARE_4K;
+    case 0x00:
+        return PICC_TYPE_MIFARE_UL;
+    default:
+        return PICC_TYPE_UNKNOWN;
+    }
+}
+
+const __FlashStringHelper *MFRC522::PICC_GetTypeName(PICC_Type type)
+{
+    switch (type)
+    {
+    case PICC_TYPE_MIFARE_MINI:
+        return F("MIFARE Mini, 320 bytes");
+    case PICC_TYPE_MIFARE_1K:
+        return F("MIFARE 1KB");
+    case PICC_TYPE_MIFARE_4K:
+        return F("MIFARE 4KB");
+    case PICC_TYPE_MIFARE_UL:
+        return F("MIFARE Ultralight or Ultralight C");
+    default:
+        return F("Unknown type");
+    }
+}
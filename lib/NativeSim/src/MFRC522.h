@@ -0,0 +1,114 @@
+#pragma once
+
+#include "Arduino.h"
+
+// MFRC522 reader with a simulated MIFARE Classic 1K card (sim::presentCard)
+class MFRC522
+{
+public:
+    enum PCD_Register : byte
+    {
+        CommandReg = 0x01 << 1,
+        ComIrqReg = 0x04 << 1,
+        ErrorReg = 0x06 << 1,
+        Status2Reg = 0x08 << 1,
+        ModeReg = 0x11 << 1,
+        TxControlReg = 0x14 << 1,
+        RFCfgReg = 0x26 << 1,
+        VersionReg = 0x37 << 1
+    };
+
+    enum PCD_RxGain : byte
+    {
+        RxGain_18dB = 0x00 << 4,
+        RxGain_23dB = 0x01 << 4,
+        RxGain_33dB = 0x04 << 4,
+        RxGain_38dB = 0x05 << 4,
+        RxGain_43dB = 0x06 << 4,
+        RxGain_48dB = 0x07 << 4,
+        RxGain_min = 0x00 << 4,
+        RxGain_avg = 0x04 << 4,
+        RxGain_max = 0x07 << 4
+    };
+
+    enum PICC_Command : byte
+    {
+        PICC_CMD_REQA = 0x26,
+        PICC_CMD_WUPA = 0x52,
+        PICC_CMD_HLTA = 0x50,
+        PICC_CMD_MF_AUTH_KEY_A = 0x60,
+        PICC_CMD_MF_AUTH_KEY_B = 0x61,
+        PICC_CMD_MF_READ = 0x30,
+        PICC_CMD_MF_WRITE = 0xA0
+    };
+
+    enum PICC_Type : byte
+    {
+        PICC_TYPE_UNKNOWN,
+        PICC_TYPE_ISO_14443_4,
+        PICC_TYPE_ISO_18092,
+        PICC_TYPE_MIFARE_MINI,
+        PICC_TYPE_MIFARE_1K,
+        PICC_TYPE_MIFARE_4K,
+        PICC_TYPE_MIFARE_UL,
+        PICC_TYPE_MIFARE_PLUS,
+        PICC_TYPE_MIFARE_DESFIRE,
+        PICC_TYPE_TNP3XXX,
+        PICC_TYPE_NOT_COMPLETE = 0xff
+    };
+
+    enum StatusCode : byte
+    {
+        STATUS_OK,
+        STATUS_ERROR,
+        STATUS_COLLISION,
+        STATUS_TIMEOUT,
+        STATUS_NO_ROOM,
+        STATUS_INTERNAL_ERROR,
+        STATUS_INVALID,
+        STATUS_CRC_WRONG,
+        STATUS_MIFARE_NACK = 0xff
+    };
+
+    typedef struct
+    {
+        byte size;
+        byte uidByte[10];
+        byte sak;
+    } Uid;
+
+    typedef struct
+    {
+        byte keyByte[6];
+    } MIFARE_Key;
+
+    Uid uid;
+
+    MFRC522(byte chipSelectPin, byte resetPowerDownPin);
+
+    void PCD_Init();
+    void PCD_Reset();
+    void PCD_AntennaOn() { antennaOn = true; }
+    void PCD_AntennaOff() { antennaOn = false; }
+    byte PCD_GetAntennaGain() { return antennaGain; }
+    void PCD_SetAntennaGain(byte mask) { antennaGain = mask & (0x07 << 4); }
+    bool PCD_PerformSelfTest();
+    byte PCD_ReadRegister(PCD_Register reg);
+    void PCD_WriteRegister(PCD_Register reg, byte value) {}
+
+    bool PICC_IsNewCardPresent();
+    bool PICC_ReadCardSerial();
+    StatusCode PICC_HaltA();
+    StatusCode PCD_Authenticate(byte command, byte blockAddr, MIFARE_Key *key, Uid *uid);
+    void PCD_StopCrypto1() { authenticatedSector = -1; }
+    StatusCode MIFARE_Read(byte blockAddr, byte *buffer, byte *bufferSize);
+    StatusCode MIFARE_Write(byte blockAddr, byte *buffer, byte bufferSize);
+
+    static PICC_Type PICC_GetType(byte sak);
+    static const __FlashStringHelper *PICC_GetTypeName(PICC_Type type);
+
+private:
+    bool antennaOn = false;
+    byte antennaGain = RxGain_33dB;
+    int authenticatedSector = -1;
+};
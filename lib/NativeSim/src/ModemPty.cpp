@@ -0,0 +1,101 @@
+#include "ModemPty.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+
+ModemPty::~ModemPty()
+{
+    if (slave >= 0)
+    {
+        close(slave);
+    }
+    if (master >= 0)
+    {
+        close(master);
+    }
+}
+
+bool ModemPty::open()
+{
+    master = posix_openpt(O_RDWR | O_NOCTTY);
+    if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0)
+    {
+        return false;
+    }
+    name = ptsname(master);
+    slave = ::open(name.c_str(), O_RDWR | O_NOCTTY);
+    if (slave < 0)
+    {
+        return false;
+    }
+
+    // Raw bytes both ways, like a UART
+    struct termios settings;
+    tcgetattr(slave, &settings);
+    cfmakeraw(&settings);
+    tcsetattr(slave, TCSANOW, &settings);
+    fcntl(master, F_SETFL, fcntl(master, F_GETFL) | O_NONBLOCK);
+    return true;
+}
+
+// Bytes left in the pty while held stay there, as they would in the modem
+void ModemPty::fill()
+{
+    if (held || master < 0)
+    {
+        return;
+    }
+    uint8_t buffer[64];
+    ssize_t n;
+    while ((n = ::read(master, buffer, sizeof(buffer))) > 0)
+    {
+        rxQueue.insert(rxQueue.end(), buffer, buffer + n);
+        linkStats.rxBytes += n;
+    }
+    if (rxQueue.size() > linkStats.rxHighWater)
+    {
+        linkStats.rxHighWater = rxQueue.size();
+    }
+}
+
+int ModemPty::available()
+{
+    fill();
+    return rxQueue.size();
+}
+
+int ModemPty::read()
+{
+    fill();
+    if (rxQueue.empty())
+    {
+        return -1;
+    }
+    uint8_t c = rxQueue.front();
+    rxQueue.pop_front();
+    return c;
+}
+
+int ModemPty::peek()
+{
+    fill();
+    return rxQueue.empty() ? -1 : rxQueue.front();
+}
+
+size_t ModemPty::write(uint8_t byte)
+{
+    while (master >= 0 && ::write(master, &byte, 1) < 0)
+    {
+        if (errno != EAGAIN)
+        {
+            return 0;
+        }
+        linkStats.ctsStalls++;
+        usleep(1000);
+    }
+    linkStats.txBytes++;
+    return 1;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <ModemTransport.h>
+
+// Modem link over a host pseudo-terminal, for running the native build
+// against something other than the built-in SIM800 model: a script playing
+// the modem, or a real SIM800 through socat. Use it with sim::WallClock so
+// the firmware's timeouts run at the speed of the far end.
+class ModemPty : public ModemTransport
+{
+public:
+    ~ModemPty();
+
+    bool open();                                     // false with errno set
+    const std::string &path() const { return name; } // Slave side for the far end
+
+    void begin(unsigned long baud) override {}
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t byte) override;
+    void holdReceive(bool hold) override { held = hold; }
+    void stats(ModemLinkStats &stats) override { stats = linkStats; }
+    using Print::write;
+
+private:
+    int master = -1;
+    int slave = -1; // Kept open so the master never sees a hang-up
+    std::string name;
+    std::deque<uint8_t> rxQueue;
+    bool held = false;
+    ModemLinkStats linkStats = {};
+
+    void fill();
+};
@@ -0,0 +1,146 @@
+// Native ModemUart: the firmware's USART2 driver with its ring buffers and
+// flow control, wired to the simulated SIM800 instead of the USART. The
+// receive interrupt runs lazily, when the firmware next looks at the link.
+#include <ModemUart.h>
+
+#include "Sim800.h"
+#include "SimHarness.h"
+
+ModemUart modemUart;
+
+static unsigned long baudRate = 9600;
+static uint64_t txBusyUntilUs = 0;
+static bool rtsOff = false;
+
+static uint32_t byteTimeUs()
+{
+    return 10000000UL / baudRate;
+}
+
+void ModemUart::begin(unsigned long baud)
+{
+    baudRate = baud > 0 ? baud : 9600;
+}
+
+void ModemUart::rxInterrupt(uint8_t byte)
+{
+    uint8_t next = rxHead + 1;
+    if (next == rxTail)
+    {
+        linkStats.rxOverruns++;
+        return;
+    }
+    rxBuffer[rxHead] = byte;
+    rxHead = next;
+    linkStats.rxBytes++;
+
+    uint8_t count = rxCount();
+    if (count > linkStats.rxHighWater)
+    {
+        linkStats.rxHighWater = count;
+    }
+    if (count >= MODEM_RX_HOLD_LEVEL)
+    {
+        rtsOff = true;
+    }
+}
+
+void ModemUart::txInterrupt()
+{
+}
+
+void ModemUart::updateRts()
+{
+    if (held || rxCount() >= MODEM_RX_HOLD_LEVEL)
+    {
+        rtsOff = true;
+    }
+    else if (rxCount() < MODEM_RX_RESUME_LEVEL)
+    {
+        rtsOff = false;
+    }
+}
+
+// Delivers the modem's bytes that have arrived; with RTS off they wait in
+// the modem, as with AT+IFC=2,2
+void ModemUart::resumeTx()
+{
+    uint8_t byte;
+    while (!rtsOff && sim800::ready(sim::nowMicros(), byte))
+    {
+        sim800::take();
+        rxInterrupt(byte);
+    }
+}
+
+int ModemUart::available()
+{
+    sim::advanceMicros(sim::costs().clockRead);
+    resumeTx();
+    return rxCount();
+}
+
+int ModemUart::peek()
+{
+    resumeTx();
+    return rxCount() ? rxBuffer[rxTail] : -1;
+}
+
+int ModemUart::read()
+{
+    resumeTx();
+    if (rxCount() == 0)
+    {
+        return -1;
+    }
+    uint8_t byte = rxBuffer[rxTail];
+    rxTail = rxTail + 1;
+    updateRts();
+    return byte;
+}
+
+int ModemUart::availableForWrite()
+{
+    uint64_t now = sim::nowMicros();
+    if (txBusyUntilUs <= now)
+    {
+        return MODEM_TX_BUFFER_SIZE - 1;
+    }
+    uint64_t queued = (txBusyUntilUs - now + byteTimeUs() - 1) / byteTimeUs();
+    return queued >= MODEM_TX_BUFFER_SIZE - 1 ? 0 : MODEM_TX_BUFFER_SIZE - 1 - (int)queued;
+}
+
+size_t ModemUart::write(uint8_t byte)
+{
+    written = true;
+    linkStats.txBytes++;
+    while (availableForWrite() == 0)
+    {
+        sim::advanceMicros(byteTimeUs());
+    }
+    uint64_t now = sim::nowMicros();
+    txBusyUntilUs = (txBusyUntilUs > now ? txBusyUntilUs : now) + byteTimeUs();
+    sim::advanceMicros(sim::costs().digitalIo);
+    sim800::receive(byte);
+    return 1;
+}
+
+void ModemUart::flush()
+{
+    uint64_t now = sim::nowMicros();
+    if (txBusyUntilUs > now)
+    {
+        sim::advanceMicros(txBusyUntilUs - now);
+    }
+}
+
+void ModemUart::holdReceive(bool hold)
+{
+    held = hold;
+    updateRts();
+}
+
+void ModemUart::stats(ModemLinkStats &stats)
+{
+    stats = linkStats;
+}
@@ -0,0 +1,86 @@
+#include "NewPing.h"
+
+#include "SimHarness.h"
+
+static float sonarDistance = 100.0f; // Empty bin, no echo inside the range
+
+void sim::setSonarDistanceCm(float cm)
+{
+    sonarDistance = cm;
+}
+
+float sim::sonarDistanceCm()
+{
+    return sonarDistance;
+}
+
+NewPing::NewPing(uint8_t triggerPin, uint8_t echoPin, unsigned int maxDistanceCm)
+    : maxDistanceCm(maxDistanceCm)
+{
+}
+
+unsigned int NewPing::ping(unsigned int maxDistance)
+{
+    unsigned int limit = maxDistance > 0 ? maxDistance : maxDistanceCm;
+    unsigned int maxEchoTime = limit * US_ROUNDTRIP_CM + US_ROUNDTRIP_CM / 2;
+
+    // Trigger pulse plus the sensor's own burst time
+    sim::advanceMicros(460);
+
+    unsigned int echoTime = (unsigned int)(sonarDistance * US_ROUNDTRIP_CM);
+    if (sonarDistance <= 0 || echoTime > maxEchoTime)
+    {
+        sim::advanceMicros(maxEchoTime);
+        return NO_ECHO;
+    }
+
+    sim::advanceMicros(echoTime);
+    return echoTime;
+}
+
+unsigned long NewPing::ping_cm(unsigned int maxDistance)
+{
+    return convert_cm(ping(maxDistance));
+}
+
+unsigned long NewPing::ping_median(uint8_t iterations, unsigned int maxDistance)
+{
+    unsigned int samples[16];
+    uint8_t count = 0;
+    if (iterations > 16)
+    {
+        iterations = 16;
+    }
+
+    for (uint8_t i = 0; i < iterations; i++)
+    {
+        unsigned long start = micros();
+        unsigned int echo = ping(maxDistance);
+        if (echo != NO_ECHO)
+        {
+            // Insertion sort, as the library does
+            uint8_t j = count;
+            for (; j > 0 && samples[j - 1] > echo; j--)
+            {
+                samples[j] = samples[j - 1];
+            }
+            samples[j] = echo;
+            count++;
+        }
+        if (i + 1 < iterations)
+        {
+            unsigned long elapsed = micros() - start;
+            if (elapsed < PING_MEDIAN_DELAY)
+            {
+                sim::advanceMicros(PING_MEDIAN_DELAY - elapsed);
+            }
+        }
+    }
+
+    return count > 0 ? samples[count / 2] : NO_ECHO;
+}
+
+unsigned int NewPing::convert_cm(unsigned int echoTime)
+{
+    return (echoTime + US_ROUNDTRIP_CM / 2) / US_ROUNDTRIP_CM;
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "Arduino.h"
+
+#define NO_ECHO 0
+#define US_ROUNDTRIP_CM 57
+#define PING_MEDIAN_DELAY 30000
+#define MAX_SENSOR_DISTANCE 500
+
+class NewPing
+{
+public:
+    NewPing(uint8_t triggerPin, uint8_t echoPin, unsigned int maxDistanceCm = MAX_SENSOR_DISTANCE);
+
+    unsigned int ping(unsigned int maxDistanceCm = 0);
+    unsigned long ping_cm(unsigned int maxDistanceCm = 0);
+    unsigned long ping_median(uint8_t iterations = 5, unsigned int maxDistanceCm = 0);
+    static unsigned int convert_cm(unsigned int echoTime);
+
+private:
+    unsigned int maxDistanceCm;
+};
@@ -0,0 +1,145 @@
+#include "Print.h"
+
+#include <math.h>
+#include <string.h>
+
+size_t Print::write(const uint8_t *buffer, size_t size)
+{
+    size_t n = 0;
+    while (size--)
+    {
+        n += write(*buffer++);
+    }
+    return n;
+}
+
+size_t Print::write(const char *text)
+{
+    return text ? write((const uint8_t *)text, strlen(text)) : 0;
+}
+
+size_t Print::print(const __FlashStringHelper *text)
+{
+    return write(reinterpret_cast<const char *>(text));
+}
+
+size_t Print::print(const String &text)
+{
+    return write((const uint8_t *)text.c_str(), text.length());
+}
+
+size_t Print::print(const char *text)
+{
+    return write(text);
+}
+
+size_t Print::print(char c)
+{
+    return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char number, int base)
+{
+    return print((unsigned long)number, base);
+}
+
+size_t Print::print(int number, int base)
+{
+    return print((long)number, base);
+}
+
+size_t Print::print(unsigned int number, int base)
+{
+    return print((unsigned long)number, base);
+}
+
+size_t Print::print(long number, int base)
+{
+    if (base == 0)
+    {
+        return write((uint8_t)number);
+    }
+    if (base == 10 && number < 0)
+    {
+        return print('-') + printNumber(-(unsigned long)number, 10);
+    }
+    return printNumber((unsigned long)number, base);
+}
+
+size_t Print::print(unsigned long number, int base)
+{
+    if (base == 0)
+    {
+        return write((uint8_t)number);
+    }
+    return printNumber(number, base);
+}
+
+size_t Print::print(double number, int digits)
+{
+    if (isnan(number))
+    {
+        return print("nan");
+    }
+    if (isinf(number))
+    {
+        return print("inf");
+    }
+
+    size_t n = 0;
+    if (number < 0.0)
+    {
+        n += print('-');
+        number = -number;
+    }
+
+    // Round like the AVR core does
+    double rounding = 0.5;
+    for (int i = 0; i < digits; i++)
+    {
+        rounding /= 10.0;
+    }
+    number += rounding;
+
+    unsigned long integer = (unsigned long)number;
+    double remainder = number - (double)integer;
+    n += print(integer);
+    if (digits > 0)
+    {
+        n += print('.');
+    }
+    while (digits-- > 0)
+    {
+        remainder *= 10.0;
+        unsigned int digit = (unsigned int)remainder;
+        n += print(digit);
+        remainder -= digit;
+    }
+    return n;
+}
+
+size_t Print::println()
+{
+    return write("\r\n");
+}
+
+size_t Print::printNumber(unsigned long number, uint8_t base)
+{
+    char buffer[8 * sizeof(long) + 1];
+    char *text = &buffer[sizeof(buffer) - 1];
+    *text = '\0';
+
+    if (base < 2)
+    {
+        base = 10;
+    }
+
+    do
+    {
+        char digit = number % base;
+        number /= base;
+        *--text = digit < 10 ? digit + '0' : digit + 'A' - 10;
+    } while (number);
+
+    return write(text);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <stdint.h>
+
+class SPIClass
+{
+public:
+    void begin() {}
+    void end() {}
+};
+
+extern SPIClass SPI;
@@ -0,0 +1,66 @@
+#include "Servo.h"
+
+#include "SimHarness.h"
+
+struct ServoPinState
+{
+    bool attached = false;
+    int angle = 90;
+};
+
+static ServoPinState servoPins[NUM_DIGITAL_PINS];
+
+uint8_t Servo::attach(int pin)
+{
+    return attach(pin, 544, 2400);
+}
+
+uint8_t Servo::attach(int pin, int minUs, int maxUs)
+{
+    if (pin < 0 || pin >= NUM_DIGITAL_PINS)
+    {
+        return 0;
+    }
+    this->pin = pin;
+    servoPins[pin].attached = true;
+    servoPins[pin].angle = angle;
+    return 1;
+}
+
+void Servo::detach()
+{
+    if (pin >= 0)
+    {
+        servoPins[pin].attached = false;
+    }
+    pin = -1;
+}
+
+void Servo::write(int value)
+{
+    if (value >= 544)
+    {
+        writeMicroseconds(value);
+        return;
+    }
+    angle = constrain(value, 0, 180);
+    if (pin >= 0)
+    {
+        servoPins[pin].angle = angle;
+    }
+}
+
+void Servo::writeMicroseconds(int value)
+{
+    write((int)map(constrain(value, 544, 2400), 544, 2400, 0, 180));
+}
+
+int sim::servoAngle(uint8_t pin)
+{
+    return pin < NUM_DIGITAL_PINS ? servoPins[pin].angle : 0;
+}
+
+bool sim::servoAttached(uint8_t pin)
+{
+    return pin < NUM_DIGITAL_PINS && servoPins[pin].attached;
+}
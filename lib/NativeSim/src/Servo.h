@@ -0,0 +1,19 @@
+#pragma once
+
+#include "Arduino.h"
+
+class Servo
+{
+public:
+    uint8_t attach(int pin);
+    uint8_t attach(int pin, int minUs, int maxUs);
+    void detach();
+    void write(int value);
+    void writeMicroseconds(int value);
+    int read() const { return angle; }
+    bool attached() const { return pin >= 0; }
+
+private:
+    int pin = -1;
+    int angle = 90;
+};
@@ -0,0 +1,127 @@
+#include "Sim800.h"
+
+#include <deque>
+#include <string>
+#include "SimHarness.h"
+
+struct PendingByte
+{
+    uint64_t readyUs;
+    uint8_t value;
+};
+
+static sim::ModemModel modemModel;
+static std::deque<PendingByte> modemOutput;
+static std::string modemLine;
+static std::string smsBody;
+static bool smsPrompt = false;
+
+sim::ModemModel &sim::modem()
+{
+    return modemModel;
+}
+
+static void modemReply(const std::string &text, uint32_t latencyMs)
+{
+    uint64_t ready = sim::nowMicros() + (uint64_t)latencyMs * 1000;
+    if (!modemOutput.empty() && modemOutput.back().readyUs > ready)
+    {
+        ready = modemOutput.back().readyUs;
+    }
+    for (char c : text)
+    {
+        modemOutput.push_back({ready, (uint8_t)c});
+    }
+}
+
+void sim::queueModemInput(const std::string &text)
+{
+    modemReply(text, 0);
+}
+
+static void modemCommand(const std::string &line)
+{
+    const uint32_t latency = modemModel.responseLatencyMs;
+
+    if (line.rfind("AT+CMGS=", 0) == 0)
+    {
+        smsPrompt = true;
+        smsBody.clear();
+        modemReply("\r\n> ", latency);
+    }
+    else if (line == "AT+CREG?")
+    {
+        modemReply(modemModel.registered ? "\r\n+CREG: 0,1\r\n\r\nOK\r\n" : "\r\n+CREG: 0,2\r\n\r\nOK\r\n", latency);
+    }
+    else if (line == "AT+CSQ")
+    {
+        modemReply("\r\n+CSQ: 20,0\r\n\r\nOK\r\n", latency);
+    }
+    else if (line.rfind("AT", 0) == 0)
+    {
+        modemReply("\r\nOK\r\n", latency);
+    }
+    else
+    {
+        modemReply("\r\nERROR\r\n", latency);
+    }
+}
+
+void sim800::receive(uint8_t c)
+{
+    if (smsPrompt)
+    {
+        if (c == 0x1A)
+        {
+            smsPrompt = false;
+            modemModel.sentMessages.push_back(smsBody);
+            if (modemModel.registered)
+            {
+                modemReply("\r\n+CMGS: " + std::to_string(modemModel.sentMessages.size()) + "\r\n\r\nOK\r\n",
+                           modemModel.sendLatencyMs);
+            }
+            else
+            {
+                modemReply("\r\n+CMS ERROR: 331\r\n", modemModel.sendLatencyMs);
+            }
+        }
+        else if (c == 0x1B)
+        {
+            smsPrompt = false;
+        }
+        else
+        {
+            smsBody += (char)c;
+        }
+        return;
+    }
+
+    modemReply(std::string(1, (char)c), 0); // Echo (ATE1 default)
+    if (c == '\r' || c == '\n')
+    {
+        if (!modemLine.empty())
+        {
+            modemCommand(modemLine);
+        }
+        modemLine.clear();
+    }
+    else
+    {
+        modemLine += (char)c;
+    }
+}
+
+bool sim800::ready(uint64_t nowUs, uint8_t &byte)
+{
+    if (modemOutput.empty() || modemOutput.front().readyUs > nowUs)
+    {
+        return false;
+    }
+    byte = modemOutput.front().value;
+    return true;
+}
+
+void sim800::take()
+{
+    modemOutput.pop_front();
+}
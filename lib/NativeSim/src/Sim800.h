@@ -0,0 +1,13 @@
+#pragma once
+
+#include <stdint.h>
+
+// SIM800 model behind the simulated modem link: echoes input, answers AT
+// commands after a latency and accepts one SMS body after the AT+CMGS
+// prompt. Replies become readable at their modelled arrival time.
+namespace sim800
+{
+void receive(uint8_t c);                   // A byte sent to the modem
+bool ready(uint64_t nowUs, uint8_t &byte); // Next reply byte, if it has arrived
+void take();                               // Consume the byte ready() returned
+}
@@ -0,0 +1,86 @@
+#include "SimHarness.h"
+
+#include <chrono>
+#include <thread>
+
+static sim::VirtualClock defaultClock;
+static sim::Clock *activeClock = &defaultClock;
+static sim::CostModel costModel;
+static std::function<void(uint64_t)> timeListener;
+static bool inListener = false;
+static bool stopFlag = false;
+
+void sim::setClock(Clock *clock)
+{
+    activeClock = clock != nullptr ? clock : &defaultClock;
+}
+
+sim::Clock &sim::clock()
+{
+    return *activeClock;
+}
+
+uint64_t sim::nowMicros()
+{
+    return activeClock->nowMicros();
+}
+
+uint32_t sim::nowMillis()
+{
+    return (uint32_t)(activeClock->nowMicros() / 1000);
+}
+
+void sim::advanceMicros(uint64_t us)
+{
+    activeClock->advanceMicros(us);
+
+    // The listener may itself touch the core; don't recurse into it
+    if (timeListener && !inListener)
+    {
+        inListener = true;
+        timeListener(activeClock->nowMicros());
+        inListener = false;
+    }
+}
+
+sim::CostModel &sim::costs()
+{
+    return costModel;
+}
+
+void sim::setTimeListener(std::function<void(uint64_t)> listener)
+{
+    timeListener = listener;
+}
+
+bool sim::stopRequested()
+{
+    return stopFlag;
+}
+
+void sim::requestStop()
+{
+    stopFlag = true;
+}
+
+static uint64_t steadyMicros()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+sim::WallClock::WallClock() : startUs(steadyMicros()) {}
+
+uint64_t sim::WallClock::nowMicros()
+{
+    return steadyMicros() - startUs;
+}
+
+void sim::WallClock::advanceMicros(uint64_t us)
+{
+    // Costs of a few microseconds pass on their own while the host runs
+    if (us >= 100)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(us));
+    }
+}
@@ -0,0 +1,149 @@
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Simulation harness for the native build.
+// The firmware talks to the usual Arduino/library interfaces; this header is
+// the other side of them - the state of the simulated world and the knobs a
+// host program uses to drive it.
+
+namespace sim
+{
+
+// Time source for millis()/micros()/delay(). Replace it to run the firmware
+// against a different notion of time.
+class Clock
+{
+public:
+    virtual ~Clock() {}
+    virtual uint64_t nowMicros() = 0;
+    virtual void advanceMicros(uint64_t us) = 0;
+};
+
+// Default clock: time only moves when the firmware waits or spends modelled
+// CPU time, so delay() returns instantly in wall-clock terms.
+class VirtualClock : public Clock
+{
+public:
+    uint64_t nowMicros() override { return now; }
+    void advanceMicros(uint64_t us) override { now += us; }
+
+private:
+    uint64_t now = 0;
+};
+
+// Wall-clock time: delay() sleeps and modelled costs take real time. For
+// running against something outside the simulation, such as ModemPty.
+class WallClock : public Clock
+{
+public:
+    WallClock();
+    uint64_t nowMicros() override;
+    void advanceMicros(uint64_t us) override;
+
+private:
+    uint64_t startUs;
+};
+
+void setClock(Clock *clock);
+Clock &clock();
+uint64_t nowMicros();
+uint32_t nowMillis();
+
+// Advance time and notify the time listener
+void advanceMicros(uint64_t us);
+
+// Modelled CPU cost of core calls, in microseconds
+struct CostModel
+{
+    uint32_t clockRead = 1;
+    uint32_t digitalIo = 4;
+    uint32_t analogRead = 112;
+    uint32_t analogWrite = 8;
+    uint32_t lcdByte = 400;      // I2C backpack, 4 transfers per byte at 100 kHz
+    uint32_t lcdClear = 2000;
+    uint32_t nokiaFrame = 4500;  // 504 bytes over software SPI
+    uint32_t rfidTransaction = 3000;
+    uint32_t eepromWrite = 3400;
+};
+CostModel &costs();
+
+// Called after every advance of virtual time with the new time in microseconds
+void setTimeListener(std::function<void(uint64_t)> listener);
+
+// GPIO and ADC
+void setDigitalInput(uint8_t pin, bool level);
+void releaseDigitalInput(uint8_t pin); // Back to pull-up/floating default
+// Called when the harness changes an input's level, where the MCU would
+// raise a pin-change interrupt
+void setPinChangeListener(std::function<void(uint8_t pin)> listener);
+bool digitalOutput(uint8_t pin);
+uint8_t pinModeOf(uint8_t pin);
+void setAnalogInput(uint8_t pin, int value);
+void setAnalogNoise(int amplitude);
+int analogOutput(uint8_t pin);
+
+// Load cell (HX711)
+struct LoadCellModel
+{
+    float grams = 0;          // Load on the platform
+    float countsPerGram = -350.82f;
+    long zeroCounts = 84000;  // Raw reading with an empty platform
+    long noiseCounts = 40;
+    bool connected = true;
+    uint32_t samplePeriodUs = 100000; // 10 SPS
+};
+LoadCellModel &loadCell();
+
+// Ultrasonic sonar, distance to the bin contents
+void setSonarDistanceCm(float cm);
+float sonarDistanceCm();
+
+// RFID
+struct Card
+{
+    uint8_t uid[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+    uint8_t sak = 0x08; // MIFARE Classic 1K
+    uint8_t blocks[64][16] = {};
+};
+void presentCard(Card *card);
+void removeCard();
+Card *presentedCard();
+
+// SIM800 modem
+struct ModemModel
+{
+    uint32_t responseLatencyMs = 200;
+    uint32_t sendLatencyMs = 3000; // Network time for an SMS
+    bool registered = true;
+    std::vector<std::string> sentMessages;
+};
+ModemModel &modem();
+void queueModemInput(const std::string &text); // Unsolicited output from the modem
+
+// Servos
+int servoAngle(uint8_t pin);
+bool servoAttached(uint8_t pin);
+
+// Displays
+std::string lcdLine(uint8_t row);
+bool lcdBacklight();
+uint32_t nokiaFrameCount();
+const uint8_t *nokiaFramebuffer(); // 84x48, PCD8544 bank layout
+
+// EEPROM contents, 4 KB, starts erased (0xFF)
+uint8_t *eeprom();
+
+// USB serial
+void queueSerialInput(const std::string &text);
+void setSerialOutput(FILE *out); // nullptr discards output
+
+// Set by the native main loop runner
+bool stopRequested();
+void requestStop();
+
+} // namespace sim
@@ -0,0 +1,68 @@
+#include "Stream.h"
+
+#include <string.h>
+#include "Arduino.h"
+
+int Stream::timedRead()
+{
+    unsigned long start = millis();
+    do
+    {
+        int c = read();
+        if (c >= 0)
+        {
+            return c;
+        }
+        delay(1);
+    } while (millis() - start < timeoutMs);
+    return -1;
+}
+
+bool Stream::find(const char *target)
+{
+    size_t length = strlen(target);
+    size_t matched = 0;
+    if (length == 0)
+    {
+        return true;
+    }
+
+    int c;
+    while ((c = timedRead()) >= 0)
+    {
+        if (c == target[matched])
+        {
+            if (++matched == length)
+            {
+                return true;
+            }
+        }
+        else
+        {
+            matched = c == target[0] ? 1 : 0;
+        }
+    }
+    return false;
+}
+
+String Stream::readString()
+{
+    std::string text;
+    int c;
+    while ((c = timedRead()) >= 0)
+    {
+        text += (char)c;
+    }
+    return String(text);
+}
+
+String Stream::readStringUntil(char terminator)
+{
+    std::string text;
+    int c;
+    while ((c = timedRead()) >= 0 && c != terminator)
+    {
+        text += (char)c;
+    }
+    return String(text);
+}
@@ -0,0 +1,106 @@
+#include "WString.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static std::string formatInteger(unsigned long long number, unsigned char base, bool negative)
+{
+    if (base < 2)
+    {
+        base = 10;
+    }
+
+    std::string digits;
+    do
+    {
+        unsigned digit = number % base;
+        digits.insert(digits.begin(), (char)(digit < 10 ? '0' + digit : 'A' + digit - 10));
+        number /= base;
+    } while (number > 0);
+
+    return negative ? "-" + digits : digits;
+}
+
+String::String(int number, unsigned char base) : String((long)number, base) {}
+
+String::String(unsigned int number, unsigned char base) : String((unsigned long)number, base) {}
+
+String::String(long number, unsigned char base)
+{
+    bool negative = base == 10 && number < 0;
+    unsigned long magnitude = negative ? -(unsigned long)number : (unsigned long)number;
+    value = formatInteger(magnitude, base, negative);
+}
+
+String::String(unsigned long number, unsigned char base)
+{
+    value = formatInteger(number, base, false);
+}
+
+String::String(float number, unsigned char decimals) : String((double)number, decimals) {}
+
+String::String(double number, unsigned char decimals)
+{
+    char buffer[48];
+    snprintf(buffer, sizeof(buffer), "%.*f", decimals, number);
+    value = buffer;
+}
+
+String String::substring(unsigned int from) const
+{
+    return substring(from, value.size());
+}
+
+String String::substring(unsigned int from, unsigned int to) const
+{
+    if (from > to)
+    {
+        unsigned int swap = from;
+        from = to;
+        to = swap;
+    }
+    if (from >= value.size())
+    {
+        return String();
+    }
+    if (to > value.size())
+    {
+        to = value.size();
+    }
+    return String(value.substr(from, to - from));
+}
+
+int String::indexOf(char c, unsigned int from) const
+{
+    size_t found = value.find(c, from);
+    return found == std::string::npos ? -1 : (int)found;
+}
+
+int String::indexOf(const String &text, unsigned int from) const
+{
+    size_t found = value.find(text.value, from);
+    return found == std::string::npos ? -1 : (int)found;
+}
+
+int String::lastIndexOf(char c) const
+{
+    return value.empty() ? -1 : lastIndexOf(c, value.size() - 1);
+}
+
+int String::lastIndexOf(char c, unsigned int from) const
+{
+    size_t found = value.rfind(c, from);
+    return found == std::string::npos ? -1 : (int)found;
+}
+
+void String::trim()
+{
+    size_t begin = value.find_first_not_of(" \t\r\n");
+    size_t end = value.find_last_not_of(" \t\r\n");
+    value = begin == std::string::npos ? std::string() : value.substr(begin, end - begin + 1);
+}
+
+long String::toInt() const
+{
+    return strtol(value.c_str(), nullptr, 10);
+}
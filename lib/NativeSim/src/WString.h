@@ -0,0 +1,68 @@
+#pragma once
+
+#include <string>
+
+class __FlashStringHelper;
+
+// Heap-backed String with the subset of the Arduino API the firmware uses
+class String
+{
+public:
+    String() {}
+    String(const char *text) : value(text ? text : "") {}
+    String(const __FlashStringHelper *text) : value(reinterpret_cast<const char *>(text)) {}
+    String(const std::string &text) : value(text) {}
+    explicit String(char c) : value(1, c) {}
+    explicit String(int number, unsigned char base = 10);
+    explicit String(unsigned int number, unsigned char base = 10);
+    explicit String(long number, unsigned char base = 10);
+    explicit String(unsigned long number, unsigned char base = 10);
+    explicit String(float number, unsigned char decimals = 2);
+    explicit String(double number, unsigned char decimals = 2);
+
+    unsigned int length() const { return value.size(); }
+    const char *c_str() const { return value.c_str(); }
+    char charAt(unsigned int index) const { return index < value.size() ? value[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+
+    String substring(unsigned int from) const;
+    String substring(unsigned int from, unsigned int to) const;
+    int indexOf(char c, unsigned int from = 0) const;
+    int indexOf(const String &text, unsigned int from = 0) const;
+    int lastIndexOf(char c) const;
+    int lastIndexOf(char c, unsigned int from) const;
+    bool startsWith(const String &prefix) const { return value.compare(0, prefix.value.size(), prefix.value) == 0; }
+    void trim();
+    long toInt() const;
+
+    String &operator+=(const String &other)
+    {
+        value += other.value;
+        return *this;
+    }
+    String &operator+=(const char *other)
+    {
+        value += other;
+        return *this;
+    }
+    String &operator+=(char c)
+    {
+        value += c;
+        return *this;
+    }
+
+    bool operator==(const String &other) const { return value == other.value; }
+    bool operator!=(const String &other) const { return value != other.value; }
+    bool operator==(const char *other) const { return value == other; }
+    bool operator!=(const char *other) const { return value != other; }
+
+    const std::string &str() const { return value; }
+
+private:
+    std::string value;
+};
+
+inline String operator+(const String &a, const String &b) { return String(a.str() + b.str()); }
+inline String operator+(const String &a, const char *b) { return String(a.str() + b); }
+inline String operator+(const char *a, const String &b) { return String(a + b.str()); }
+inline String operator+(const String &a, char b) { return String(a.str() + b); }
@@ -0,0 +1,114 @@
+// Entry point for the native build: runs setup() once and loop() until the
+// requested amount of virtual time has elapsed. Programs that drive the
+// simulation themselves define SIM_CUSTOM_MAIN and provide their own main(),
+// as do the unit tests under test/ (PlatformIO defines PIO_UNIT_TESTING).
+#if !defined(SIM_CUSTOM_MAIN) && !defined(PIO_UNIT_TESTING)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+
+#include "Arduino.h"
+#include "ModemPty.h"
+#include "SimHarness.h"
+
+extern ModemTransport *modemLink; // main.cpp
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [--seconds N] [--script FILE] [--modem-pty]\n"
+            "  --seconds N    virtual seconds to run (default 60)\n"
+            "  --script FILE  console commands fed to Serial (stdin when piped)\n"
+            "  --modem-pty    run in real time with the modem on a pseudo-terminal\n",
+            program);
+}
+
+static std::string readAll(FILE *in)
+{
+    std::string text;
+    char buffer[512];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0)
+    {
+        text.append(buffer, n);
+    }
+    return text;
+}
+
+int main(int argc, char **argv)
+{
+    double seconds = 60;
+    const char *script = nullptr;
+    bool modemPty = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)
+        {
+            seconds = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc)
+        {
+            script = argv[++i];
+        }
+        else if (strcmp(argv[i], "--modem-pty") == 0)
+        {
+            modemPty = true;
+        }
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    if (script != nullptr)
+    {
+        FILE *in = fopen(script, "r");
+        if (in == nullptr)
+        {
+            perror(script);
+            return 1;
+        }
+        sim::queueSerialInput(readAll(in));
+        fclose(in);
+    }
+    else if (!isatty(STDIN_FILENO))
+    {
+        sim::queueSerialInput(readAll(stdin));
+    }
+
+    static ModemPty pty;
+    static sim::WallClock wallClock;
+    if (modemPty)
+    {
+        if (!pty.open())
+        {
+            perror("modem pty");
+            return 1;
+        }
+        fprintf(stderr, "[sim] modem on %s\n", pty.path().c_str());
+        modemLink = &pty;
+        sim::setClock(&wallClock);
+    }
+
+    const uint64_t endUs = (uint64_t)(seconds * 1e6);
+    unsigned long loops = 0;
+
+    setup();
+    while (sim::nowMicros() < endUs && !sim::stopRequested())
+    {
+        loop();
+        loops++;
+    }
+    Serial.flush();
+
+    fprintf(stderr, "\n[sim] %.1f virtual s, %lu loop() iterations, %u display frames, %zu SMS\n",
+            sim::nowMicros() / 1e6, loops, sim::nokiaFrameCount(), sim::modem().sentMessages.size());
+    return 0;
+}
+
+#endif
@@ -0,0 +1,204 @@
+#include "AtParser.h"
+
+static Stream *atLink = nullptr;
+static const AtUrc *atUrcs = nullptr;
+static uint8_t atUrcCount = 0;
+
+static char lineBuffer[AT_LINE_LENGTH + 1];
+static uint8_t lineLength = 0;
+static bool lineTruncated = false;
+static bool skipLine = false;  // Rest of the prompt line
+static bool lastWasCr = false; // "\r\n" ends one line, not two
+static const AtUrc *bodyUrc = nullptr;
+static uint8_t bodyPart = 0;
+
+static AtResult result = AT_IDLE;
+static int16_t errorCode = 0;
+static unsigned long commandStart = 0;
+static unsigned long commandTimeout = 0;
+
+static AtStats stats;
+
+void atBegin(Stream &link, const AtUrc *urcs, uint8_t urcCount)
+{
+    atLink = &link;
+    atUrcs = urcs;
+    atUrcCount = urcCount;
+    lineLength = 0;
+    lineTruncated = false;
+    skipLine = false;
+    lastWasCr = false;
+    bodyUrc = nullptr;
+    result = AT_IDLE;
+}
+
+// prefix is in flash
+static bool startsWith(const char *prefix, uint8_t prefixLength)
+{
+    return lineLength >= prefixLength && strncmp_P(lineBuffer, prefix, prefixLength) == 0;
+}
+
+static void finish(AtResult final)
+{
+    if (result == AT_PENDING)
+    {
+        result = final;
+    }
+}
+
+static void endLine()
+{
+    lineBuffer[lineLength] = '\0';
+    if (lineLength > 0)
+    {
+        stats.lines++;
+    }
+    if (lineTruncated)
+    {
+        stats.truncated++;
+    }
+
+    if (bodyUrc != nullptr)
+    {
+        // Lines owned by the last URC, such as the +CMT message text, which
+        // may be anything including "OK"
+        const AtUrc *urc = bodyUrc;
+        if (++bodyPart >= urc->bodyLines)
+        {
+            bodyUrc = nullptr;
+        }
+        urc->handler(lineBuffer, lineLength, bodyPart);
+        return;
+    }
+    if (lineLength == 0)
+    {
+        return;
+    }
+
+    if (lineLength == 2 && lineBuffer[0] == 'O' && lineBuffer[1] == 'K')
+    {
+        finish(AT_OK);
+        return;
+    }
+    if (lineLength == 5 && startsWith(PSTR("ERROR"), 5))
+    {
+        stats.errors++;
+        finish(AT_ERROR);
+        return;
+    }
+    if (startsWith(PSTR("+CMS ERROR:"), 11) || startsWith(PSTR("+CME ERROR:"), 11))
+    {
+        stats.errors++;
+        if (result == AT_PENDING)
+        {
+            errorCode = atoi(lineBuffer + 11);
+        }
+        finish(AT_CMS_ERROR);
+        return;
+    }
+
+    for (uint8_t i = 0; i < atUrcCount; i++)
+    {
+        const AtUrc &urc = atUrcs[i];
+        uint8_t prefixLength = strlen(urc.prefix);
+        if (lineLength >= prefixLength && strncmp(lineBuffer, urc.prefix, prefixLength) == 0)
+        {
+            stats.urcs++;
+            if (urc.bodyLines > 0)
+            {
+                bodyUrc = &urc;
+                bodyPart = 0;
+            }
+            urc.handler(lineBuffer, lineLength, 0);
+            return;
+        }
+    }
+    // Anything else is command echo or an information line nobody asked for
+}
+
+void atFeed(uint8_t byte)
+{
+    bool wasCr = lastWasCr;
+    lastWasCr = byte == '\r';
+    if (byte == '\r' || byte == '\n')
+    {
+        if (byte == '\n' && wasCr)
+        {
+            return;
+        }
+        if (!skipLine)
+        {
+            endLine();
+        }
+        lineLength = 0;
+        lineTruncated = false;
+        skipLine = false;
+        return;
+    }
+    if (skipLine)
+    {
+        return;
+    }
+    if (byte == '>' && lineLength == 0 && bodyUrc == nullptr)
+    {
+        // The prompt is followed by a space and then nothing
+        finish(AT_PROMPT);
+        skipLine = true;
+        return;
+    }
+    if (lineLength < AT_LINE_LENGTH)
+    {
+        lineBuffer[lineLength++] = byte;
+    }
+    else
+    {
+        lineTruncated = true;
+    }
+}
+
+void atPoll()
+{
+    if (atLink == nullptr)
+    {
+        return;
+    }
+    for (uint8_t i = 0; i < AT_BYTES_PER_POLL && atLink->available() > 0; i++)
+    {
+        atFeed(atLink->read());
+    }
+}
+
+Print &atCommand(unsigned long timeoutMs)
+{
+    result = AT_PENDING;
+    errorCode = 0;
+    commandStart = millis();
+    commandTimeout = timeoutMs;
+    return *atLink;
+}
+
+void atEnd(uint8_t terminator)
+{
+    atLink->write(terminator);
+}
+
+AtResult atResult()
+{
+    atPoll();
+    if (result == AT_PENDING && millis() - commandStart >= commandTimeout)
+    {
+        stats.timeouts++;
+        result = AT_TIMEOUT;
+    }
+    return result;
+}
+
+int16_t atErrorCode()
+{
+    return errorCode;
+}
+
+const AtStats &atStats()
+{
+    return stats;
+}
@@ -0,0 +1,295 @@
+#include "BottleClassifier.h"
+#include "ClassifierModel.h"
+#include "LoadCell.h"
+
+const int16_t FEATURE_FULL = 256;
+
+// Defaults come from the generated model header
+static const int16_t DEFAULT_MODEL[CLASSIFIER_PARAM_COUNT] PROGMEM = {
+    MODEL_CAPACITIVE_LOW,
+    MODEL_CAPACITIVE_HIGH,
+    MODEL_WEIGHT_MIN,
+    MODEL_WEIGHT_MAX,
+    MODEL_WEIGHT_RAMP,
+    MODEL_INDUCTIVE_LOW,
+    MODEL_INDUCTIVE_HIGH,
+    MODEL_LDR_LOW,
+    MODEL_LDR_HIGH,
+    MODEL_CAPACITIVE_WEIGHT,
+    MODEL_WEIGHT_WEIGHT,
+    MODEL_INDUCTIVE_WEIGHT,
+    MODEL_LDR_WEIGHT,
+    MODEL_ACCEPT_SCORE};
+
+static const char PARAM_NAME_0[] PROGMEM = "caplow";
+static const char PARAM_NAME_1[] PROGMEM = "caphigh";
+static const char PARAM_NAME_2[] PROGMEM = "wmin";
+static const char PARAM_NAME_3[] PROGMEM = "wmax";
+static const char PARAM_NAME_4[] PROGMEM = "wramp";
+static const char PARAM_NAME_5[] PROGMEM = "indlow";
+static const char PARAM_NAME_6[] PROGMEM = "indhigh";
+static const char PARAM_NAME_7[] PROGMEM = "ldrlow";
+static const char PARAM_NAME_8[] PROGMEM = "ldrhigh";
+static const char PARAM_NAME_9[] PROGMEM = "capw";
+static const char PARAM_NAME_10[] PROGMEM = "weightw";
+static const char PARAM_NAME_11[] PROGMEM = "indw";
+static const char PARAM_NAME_12[] PROGMEM = "ldrw";
+static const char PARAM_NAME_13[] PROGMEM = "accept";
+static const char *const PARAM_NAMES[CLASSIFIER_PARAM_COUNT] PROGMEM = {
+    PARAM_NAME_0,
+    PARAM_NAME_1,
+    PARAM_NAME_2,
+    PARAM_NAME_3,
+    PARAM_NAME_4,
+    PARAM_NAME_5,
+    PARAM_NAME_6,
+    PARAM_NAME_7,
+    PARAM_NAME_8,
+    PARAM_NAME_9,
+    PARAM_NAME_10,
+    PARAM_NAME_11,
+    PARAM_NAME_12,
+    PARAM_NAME_13};
+
+static const char REASON_NAME_0[] PROGMEM = "ok";
+static const char REASON_NAME_1[] PROGMEM = "no object";
+static const char REASON_NAME_2[] PROGMEM = "weight";
+static const char REASON_NAME_3[] PROGMEM = "metal";
+static const char REASON_NAME_4[] PROGMEM = "opaque";
+static const char *const REASON_NAMES[] PROGMEM = {
+    REASON_NAME_0,
+    REASON_NAME_1,
+    REASON_NAME_2,
+    REASON_NAME_3,
+    REASON_NAME_4};
+
+// Working copy of the model, plus the weight limits in net load cell counts
+static int16_t model[CLASSIFIER_PARAM_COUNT];
+static int32_t weightMinCounts;
+static int32_t weightMaxCounts;
+static int32_t weightLowCounts;  // Weight feature reaches 0 here...
+static int32_t weightHighCounts; // ...and here
+
+// Running sample state
+static int16_t capacitiveQ4; // EWMA, alpha 1/4
+static uint8_t capacitiveSamples;
+static int32_t weightSum;
+static int32_t weightLow;
+static int32_t weightHigh;
+static uint8_t weightSamples;
+static uint8_t inductiveHigh;
+static uint8_t inductiveSamples;
+static uint8_t ldrClear;
+static uint8_t ldrSamples;
+
+static void updateWeightLimits()
+{
+    int16_t minDg = model[CLASSIFIER_WEIGHT_MIN];
+    int16_t maxDg = model[CLASSIFIER_WEIGHT_MAX];
+    int16_t rampDg = model[CLASSIFIER_WEIGHT_RAMP];
+    weightMinCounts = loadCellNetFor(minDg);
+    weightMaxCounts = loadCellNetFor(maxDg);
+    weightLowCounts = loadCellNetFor(minDg - rampDg);
+    weightHighCounts = loadCellNetFor(maxDg + rampDg);
+}
+
+// 0 at or below low, FEATURE_FULL at or above high, linear in between
+static int16_t ramp(int32_t x, int32_t low, int32_t high)
+{
+    if (x <= low)
+    {
+        return 0;
+    }
+    if (x >= high)
+    {
+        return FEATURE_FULL;
+    }
+    return (int16_t)(((x - low) << 8) / (high - low));
+}
+
+// Share of hits in 1/256 units
+static int16_t share(uint8_t hits, uint8_t samples)
+{
+    return samples == 0 ? 0 : (int16_t)(((uint16_t)hits << 8) / samples);
+}
+
+void classifierBegin()
+{
+    for (uint8_t i = 0; i < CLASSIFIER_PARAM_COUNT; i++)
+    {
+        model[i] = (int16_t)pgm_read_word(&DEFAULT_MODEL[i]);
+    }
+    updateWeightLimits();
+    classifierReset();
+}
+
+void classifierCalibrationChanged()
+{
+    updateWeightLimits();
+}
+
+void classifierReset()
+{
+    capacitiveQ4 = 0;
+    capacitiveSamples = 0;
+    weightSum = 0;
+    weightSamples = 0;
+    inductiveHigh = 0;
+    inductiveSamples = 0;
+    ldrClear = 0;
+    ldrSamples = 0;
+}
+
+void classifierAddCapacitive(int adc)
+{
+    int16_t sample = adc << 4;
+    if (capacitiveSamples == 0)
+    {
+        capacitiveQ4 = sample;
+    }
+    else
+    {
+        capacitiveQ4 += (sample - capacitiveQ4) >> 2;
+    }
+    if (capacitiveSamples < 255)
+    {
+        capacitiveSamples++;
+    }
+}
+
+void classifierAddWeight(int32_t net)
+{
+    if (weightSamples == 255)
+    {
+        return;
+    }
+    if (weightSamples == 0 || net < weightLow)
+    {
+        weightLow = net;
+    }
+    if (weightSamples == 0 || net > weightHigh)
+    {
+        weightHigh = net;
+    }
+    weightSum += net;
+    weightSamples++;
+}
+
+void classifierAddInductive(uint8_t level)
+{
+    if (inductiveSamples == 255)
+    {
+        return;
+    }
+    inductiveHigh += level ? 1 : 0;
+    inductiveSamples++;
+}
+
+void classifierAddLdr(uint8_t level)
+{
+    if (ldrSamples == 255)
+    {
+        return;
+    }
+    ldrClear += level ? 0 : 1;
+    ldrSamples++;
+}
+
+bool classifierReady()
+{
+    return capacitiveSamples >= CLASSIFIER_MIN_CAPACITIVE &&
+           weightSamples >= CLASSIFIER_MIN_WEIGHT &&
+           inductiveSamples >= CLASSIFIER_MIN_INDUCTIVE &&
+           ldrSamples >= CLASSIFIER_MIN_LDR;
+}
+
+void classifierDecide(ClassifierResult &result)
+{
+    int32_t weight = weightSamples ? weightSum / weightSamples : 0;
+
+    int16_t inductive = share(inductiveHigh, inductiveSamples);
+    int16_t ldr = share(ldrClear, ldrSamples);
+    result.capacitive = capacitiveQ4 >> 4;
+    result.inductiveShare = inductive;
+    result.ldrShare = ldr;
+
+    int16_t features[4];
+    features[0] = ramp(result.capacitive, model[CLASSIFIER_CAPACITIVE_LOW], model[CLASSIFIER_CAPACITIVE_HIGH]);
+    if (weightSamples == 0)
+    {
+        features[1] = 0;
+    }
+    else
+    {
+        int16_t rising = ramp(weight, weightLowCounts, weightMinCounts);
+        int16_t falling = FEATURE_FULL - ramp(weight, weightMaxCounts, weightHighCounts);
+        features[1] = min(rising, falling);
+    }
+    features[2] = ramp(inductive, model[CLASSIFIER_INDUCTIVE_LOW], model[CLASSIFIER_INDUCTIVE_HIGH]);
+    features[3] = ramp(ldr, model[CLASSIFIER_LDR_LOW], model[CLASSIFIER_LDR_HIGH]);
+
+    static const uint8_t reasons[4] = {CLASSIFIER_NO_OBJECT, CLASSIFIER_WEIGHT, CLASSIFIER_METAL, CLASSIFIER_OPAQUE};
+    int32_t sum = 0;
+    int32_t total = 0;
+    int32_t worstLoss = 0;
+    uint8_t reason = CLASSIFIER_OK;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        int16_t w = model[CLASSIFIER_CAPACITIVE_WEIGHT + i];
+        sum += (int32_t)w * features[i];
+        total += w;
+
+        int32_t loss = (int32_t)w * (FEATURE_FULL - features[i]);
+        if (loss > worstLoss)
+        {
+            worstLoss = loss;
+            reason = reasons[i];
+        }
+    }
+
+    int16_t score = sum >> 8;
+    int16_t accept = model[CLASSIFIER_ACCEPT_SCORE];
+    result.accepted = score >= accept;
+    result.score = score;
+    result.reason = result.accepted ? CLASSIFIER_OK : reason;
+
+    // Distance from the accept line, scaled to the room on that side of it
+    int32_t room = result.accepted ? total - accept : accept;
+    result.confidence = room > 0 ? (int8_t)constrain((int32_t)(score - accept) * 100 / room, -100, 100) : 0;
+
+    result.weightDg = loadCellDecigrams(weight);
+    result.spreadDg = weightSamples ? loadCellDecigrams(weightHigh) - loadCellDecigrams(weightLow) : 0;
+}
+
+int16_t classifierGet(uint8_t param)
+{
+    return param < CLASSIFIER_PARAM_COUNT ? model[param] : 0;
+}
+
+void classifierSet(uint8_t param, int16_t value)
+{
+    if (param >= CLASSIFIER_PARAM_COUNT)
+    {
+        return;
+    }
+    model[param] = value;
+    updateWeightLimits();
+}
+
+const __FlashStringHelper *classifierParamName(uint8_t param)
+{
+    if (param >= CLASSIFIER_PARAM_COUNT)
+    {
+        return F("unknown");
+    }
+    return (const __FlashStringHelper *)pgm_read_ptr(&PARAM_NAMES[param]);
+}
+
+const __FlashStringHelper *classifierReasonName(uint8_t reason)
+{
+    if (reason > CLASSIFIER_OPAQUE)
+    {
+        return F("unknown");
+    }
+    return (const __FlashStringHelper *)pgm_read_ptr(&REASON_NAMES[reason]);
+}
@@ -0,0 +1,261 @@
+#include "Buttons.h"
+
+#include "PinMap.h"
+
+#ifndef __AVR__
+#include <SimHarness.h>
+#endif
+
+static_assert(fastpin::PIN_PORTS[upButton] == fastpin::PORT_K && fastpin::PIN_PORTS[downButton] == fastpin::PORT_K &&
+                  fastpin::PIN_PORTS[selectButton] == fastpin::PORT_K,
+              "The button ISR is PCINT2, port K");
+static_assert((BUTTON_EDGE_QUEUE & (BUTTON_EDGE_QUEUE - 1)) == 0, "Edge indexes wrap by mask");
+
+struct ButtonEdge
+{
+    uint16_t timeMs; // Low bits of millis(); edges are read well within 65 s
+    uint8_t pressed; // One bit per Button
+};
+
+// Written by the ISR
+static volatile ButtonEdge edges[BUTTON_EDGE_QUEUE];
+static volatile uint8_t edgeHead = 0; // Next edge to write
+static volatile uint8_t edgeTail = 0;
+static volatile uint8_t edgeLevels = 0; // Levels of the last queued edge
+static volatile bool edgeOverflow = false;
+
+struct ButtonState
+{
+    uint32_t changedMs; // Last accepted press or release
+    uint32_t nextRepeatMs;
+    uint16_t repeatMs;
+    uint16_t repeats;
+    bool longSent;
+};
+
+static ButtonState states[BUTTON_COUNT];
+static uint8_t rawLevels = 0;    // As of the last edge
+static uint8_t stableLevels = 0; // Debounced
+static uint8_t mutedLevels = 0;  // Held through buttonsFlush()
+
+static ButtonEvent events[BUTTON_EVENT_QUEUE];
+static uint8_t eventHead = 0; // Oldest event
+static uint8_t eventCount = 0;
+
+static ButtonStats stats;
+
+static uint8_t readLevels()
+{
+    return (upButton.read() == LOW ? 1 << BUTTON_UP : 0) | (downButton.read() == LOW ? 1 << BUTTON_DOWN : 0) |
+           (selectButton.read() == LOW ? 1 << BUTTON_SELECT : 0);
+}
+
+static void queueEdge(uint8_t levels)
+{
+    if (levels == edgeLevels)
+    {
+        return; // Bounced back before the ISR ran
+    }
+    uint8_t next = (edgeHead + 1) & (BUTTON_EDGE_QUEUE - 1);
+    if (next == edgeTail)
+    {
+        edgeOverflow = true;
+        return;
+    }
+    edges[edgeHead].timeMs = millis();
+    edges[edgeHead].pressed = levels;
+    edgeHead = next;
+    edgeLevels = levels;
+}
+
+#ifdef __AVR__
+ISR(PCINT2_vect)
+{
+    queueEdge(readLevels());
+}
+#endif
+
+static bool takeEdge(ButtonEdge &edge)
+{
+    noInterrupts();
+    bool taken = edgeTail != edgeHead;
+    if (taken)
+    {
+        edge.timeMs = edges[edgeTail].timeMs;
+        edge.pressed = edges[edgeTail].pressed;
+        edgeTail = (edgeTail + 1) & (BUTTON_EDGE_QUEUE - 1);
+    }
+    interrupts();
+    return taken;
+}
+
+static void pushEvent(uint8_t type, uint8_t button, uint16_t value)
+{
+    if ((1 << button) & mutedLevels)
+    {
+        return;
+    }
+    if (eventCount == BUTTON_EVENT_QUEUE)
+    {
+        stats.dropped++;
+        return;
+    }
+    ButtonEvent &event = events[(eventHead + eventCount) % BUTTON_EVENT_QUEUE];
+    event.type = type;
+    event.button = button;
+    event.value = value;
+    eventCount++;
+}
+
+// Accepts level changes outside the debounce window of the last one
+static void settle(uint8_t levels, uint32_t timeMs, bool edge)
+{
+    uint8_t changed = levels ^ stableLevels;
+    for (uint8_t button = 0; button < BUTTON_COUNT; button++)
+    {
+        uint8_t bit = 1 << button;
+        if (!(changed & bit))
+        {
+            continue;
+        }
+        ButtonState &state = states[button];
+        if ((int32_t)(timeMs - state.changedMs) < BUTTON_DEBOUNCE_MS)
+        {
+            stats.bounces += edge;
+            continue;
+        }
+        uint32_t heldMs = timeMs - state.changedMs;
+        state.changedMs = timeMs;
+        if (levels & bit)
+        {
+            stableLevels |= bit;
+            state.nextRepeatMs = timeMs + BUTTON_REPEAT_DELAY_MS;
+            state.repeatMs = BUTTON_REPEAT_START_MS;
+            state.repeats = 0;
+            state.longSent = false;
+            pushEvent(BUTTON_PRESS, button, 0);
+        }
+        else
+        {
+            stableLevels &= ~bit;
+            pushEvent(BUTTON_RELEASE, button, min(heldMs, 0xFFFFUL));
+            mutedLevels &= ~bit;
+        }
+    }
+}
+
+static void buttonsPoll()
+{
+    uint32_t now = millis();
+    ButtonEdge edge;
+    while (takeEdge(edge))
+    {
+        uint16_t ageMs = (uint16_t)now - edge.timeMs;
+        if (ageMs > stats.maxLatencyMs)
+        {
+            stats.maxLatencyMs = ageMs;
+        }
+        stats.edges++;
+        rawLevels = edge.pressed;
+        settle(rawLevels, now - ageMs, true);
+    }
+    if (edgeOverflow)
+    {
+        // Edges were lost; start again from the pins
+        noInterrupts();
+        edgeOverflow = false;
+        rawLevels = readLevels();
+        edgeLevels = rawLevels;
+        interrupts();
+        stats.overflows++;
+    }
+    // A level that changed inside a debounce window counts once it has passed
+    settle(rawLevels, now, false);
+
+    for (uint8_t button = 0; button < BUTTON_COUNT; button++)
+    {
+        ButtonState &state = states[button];
+        if (!(stableLevels & (1 << button)))
+        {
+            continue;
+        }
+        if ((int32_t)(now - state.nextRepeatMs) >= 0)
+        {
+            state.repeats++;
+            pushEvent(BUTTON_REPEAT, button, state.repeats);
+            state.repeatMs = max(state.repeatMs - BUTTON_REPEAT_STEP_MS, (int)BUTTON_REPEAT_MIN_MS);
+            state.nextRepeatMs = now + state.repeatMs;
+        }
+        if (!state.longSent && now - state.changedMs >= BUTTON_LONG_PRESS_MS)
+        {
+            state.longSent = true;
+            pushEvent(BUTTON_LONG_PRESS, button, 0);
+        }
+    }
+}
+
+void buttonsBegin()
+{
+    upButton.inputPullup();
+    downButton.inputPullup();
+    selectButton.inputPullup();
+
+    // Buttons held at boot stay quiet until released
+    rawLevels = readLevels();
+    stableLevels = rawLevels;
+    mutedLevels = rawLevels;
+    edgeLevels = rawLevels;
+    for (uint8_t button = 0; button < BUTTON_COUNT; button++)
+    {
+        states[button].changedMs = millis() - BUTTON_DEBOUNCE_MS;
+    }
+
+#ifdef __AVR__
+    const uint8_t pins[] = {upButton, downButton, selectButton};
+    for (uint8_t i = 0; i < sizeof(pins); i++)
+    {
+        *digitalPinToPCMSK(pins[i]) |= _BV(digitalPinToPCMSKbit(pins[i]));
+    }
+    PCIFR = _BV(PCIF2);
+    PCICR |= _BV(PCIE2);
+#else
+    // The harness stands in for the pin-change interrupt
+    sim::setPinChangeListener([](uint8_t) { queueEdge(readLevels()); });
+#endif
+}
+
+bool buttonNext(ButtonEvent &event)
+{
+    buttonsPoll();
+    if (eventCount == 0)
+    {
+        return false;
+    }
+    event = events[eventHead];
+    eventHead = (eventHead + 1) % BUTTON_EVENT_QUEUE;
+    eventCount--;
+    return true;
+}
+
+bool buttonHeld(uint8_t button)
+{
+    buttonsPoll();
+    return stableLevels & (1 << button);
+}
+
+bool buttonsPending()
+{
+    return edgeHead != edgeTail || eventCount > 0 || (stableLevels & ~mutedLevels) != 0;
+}
+
+void buttonsFlush()
+{
+    buttonsPoll();
+    eventCount = 0;
+    mutedLevels = stableLevels;
+}
+
+const ButtonStats &buttonStats()
+{
+    return stats;
+}
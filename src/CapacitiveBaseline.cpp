@@ -0,0 +1,144 @@
+#include "CapacitiveBaseline.h"
+
+#include "ClassifierModel.h"
+
+const uint16_t MIN_SAMPLES = 64;       // Before the estimate is trusted
+const uint8_t LEVEL_SHIFT = 6;         // Level EWMA, alpha 1/64
+const uint8_t VARIANCE_SHIFT = 5;      // Variance EWMA, alpha 1/32
+const int16_t MAX_SIGMA_X16 = 40 * 16; // Noisier: use the fixed thresholds
+const int16_t MIN_CLIP_X16 = 8 * 16;   // Deviations clip at 4 sigma, at least this
+const int16_t MAX_SHIFT = 300;         // Larger: learned with an object present
+const uint8_t DETECT_SIGMAS = 8;       // Noise floors above the baseline
+const uint8_t CLEAR_SIGMAS = 4;
+
+static int32_t levelX16;
+static uint32_t varianceX256; // Of the x16 deviations
+static uint16_t samples;
+static uint16_t outliers;
+static bool enabled = true;
+static int fixedDetectThreshold;
+static int fixedClearThreshold;
+
+static uint16_t isqrt(uint32_t x)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1UL << 30;
+    while (bit > x)
+    {
+        bit >>= 2;
+    }
+    while (bit != 0)
+    {
+        if (x >= root + bit)
+        {
+            x -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+static int16_t sigmaX16()
+{
+    return isqrt(varianceX256);
+}
+
+static int16_t rawShift()
+{
+    return (levelX16 >> 4) - CAPACITIVE_NOMINAL_BASELINE;
+}
+
+// The estimate is usable once settled, quiet, and plausibly close to nominal
+static bool adaptive()
+{
+    return enabled && samples >= MIN_SAMPLES && sigmaX16() <= MAX_SIGMA_X16 && abs(rawShift()) <= MAX_SHIFT;
+}
+
+int capBaselineShift()
+{
+    return adaptive() ? rawShift() : 0;
+}
+
+void capBaselineBegin(int fixedDetect, int fixedClear)
+{
+    capBaselineSetFixed(fixedDetect, fixedClear);
+    samples = 0;
+    outliers = 0;
+    varianceX256 = 0;
+}
+
+void capBaselineSetFixed(int fixedDetect, int fixedClear)
+{
+    fixedDetectThreshold = fixedDetect;
+    fixedClearThreshold = fixedClear;
+}
+
+void capBaselineEnable(bool on)
+{
+    enabled = on;
+}
+
+void capBaselineUpdate(int value)
+{
+    int32_t x = (int32_t)value << 4;
+    if (samples == 0)
+    {
+        levelX16 = x;
+        samples = 1;
+        return;
+    }
+
+    // Clip so a hand hovering over the inlet barely moves the estimate
+    int32_t limit = max((int32_t)sigmaX16() * 4, (int32_t)MIN_CLIP_X16);
+    int32_t deviation = x - levelX16;
+    if (samples >= MIN_SAMPLES && abs(deviation) > limit)
+    {
+        deviation = deviation > 0 ? limit : -limit;
+        outliers += outliers < 0xFFFF ? 1 : 0;
+    }
+
+    // Settle quickly at first, then follow slowly
+    uint8_t shift = samples < MIN_SAMPLES ? 2 : LEVEL_SHIFT;
+    levelX16 += deviation >> shift;
+    int32_t square = deviation * deviation;
+    varianceX256 += (square - (int32_t)varianceX256) >> VARIANCE_SHIFT;
+    samples += samples < 0xFFFF ? 1 : 0;
+}
+
+// The fixed threshold moved with the baseline, kept clear of its noise
+static int thresholdFor(int fixedThreshold, uint8_t sigmas)
+{
+    if (!adaptive())
+    {
+        return fixedThreshold;
+    }
+    int32_t floor = (levelX16 + (int32_t)sigmaX16() * sigmas) >> 4;
+    return constrain(max((int32_t)fixedThreshold + rawShift(), floor), 0L, 1023L);
+}
+
+int capBaselineDetect()
+{
+    return thresholdFor(fixedDetectThreshold, DETECT_SIGMAS);
+}
+
+int capBaselineClear()
+{
+    return thresholdFor(fixedClearThreshold, CLEAR_SIGMAS);
+}
+
+void capBaselineStats(CapacitiveBaselineStats &stats)
+{
+    stats.baseline = levelX16 >> 4;
+    stats.shift = capBaselineShift();
+    stats.sigmaX16 = sigmaX16();
+    stats.detect = capBaselineDetect();
+    stats.clear = capBaselineClear();
+    stats.adaptive = adaptive();
+    stats.samples = samples;
+    stats.outliers = outliers;
+}
@@ -0,0 +1,145 @@
+#include "DiagConsole.h"
+
+static Stream *consolePort = nullptr;
+static const ConsoleCommand *consoleCommands = nullptr;
+static uint8_t consoleCommandCount = 0;
+
+static char lineBuffer[CONSOLE_LINE_LENGTH];
+static uint8_t lineLength = 0;
+static bool lineOverflow = false;
+
+static ConsoleStreamStep activeStream = nullptr;
+static uint16_t streamIndex = 0;
+
+void consoleBegin(Stream &port, const ConsoleCommand *commands, uint8_t commandCount)
+{
+    consolePort = &port;
+    consoleCommands = commands;
+    consoleCommandCount = commandCount;
+    lineLength = 0;
+    lineOverflow = false;
+    activeStream = nullptr;
+}
+
+void consoleStream(ConsoleStreamStep step)
+{
+    activeStream = step;
+    streamIndex = 0;
+}
+
+bool consoleStreaming()
+{
+    return activeStream != nullptr;
+}
+
+char *consoleNextToken(char *&args)
+{
+    while (*args == ' ')
+    {
+        args++;
+    }
+    if (*args == '\0')
+    {
+        return nullptr;
+    }
+
+    char *token = args;
+    while (*args != '\0' && *args != ' ')
+    {
+        args++;
+    }
+    if (*args == ' ')
+    {
+        *args++ = '\0';
+    }
+    return token;
+}
+
+bool consoleParseInt(const char *token, long &value)
+{
+    if (token == nullptr || *token == '\0')
+    {
+        return false;
+    }
+
+    char *end;
+    value = strtol(token, &end, 10);
+    return *end == '\0';
+}
+
+static void executeLine()
+{
+    char *args = lineBuffer;
+    char *name = consoleNextToken(args);
+    if (name == nullptr)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < consoleCommandCount; i++)
+    {
+        if (strcmp(name, consoleCommands[i].name) == 0)
+        {
+            consoleCommands[i].handler(*consolePort, args);
+            return;
+        }
+    }
+
+    consolePort->print(F("? unknown command: "));
+    consolePort->println(name);
+}
+
+void consolePoll()
+{
+    if (consolePort == nullptr)
+    {
+        return;
+    }
+
+    // Continue a streamed response only while the TX buffer has room
+    if (activeStream != nullptr)
+    {
+        if (consolePort->availableForWrite() >= CONSOLE_STREAM_CHUNK)
+        {
+            if (!activeStream(*consolePort, streamIndex++))
+            {
+                activeStream = nullptr;
+            }
+        }
+        return;
+    }
+
+    for (uint8_t n = 0; n < CONSOLE_BYTES_PER_POLL && consolePort->available(); n++)
+    {
+        char c = consolePort->read();
+
+        if (c == '\r' || c == '\n')
+        {
+            if (lineOverflow)
+            {
+                consolePort->println(F("? line too long"));
+            }
+            else if (lineLength > 0)
+            {
+                lineBuffer[lineLength] = '\0';
+                executeLine();
+            }
+            lineLength = 0;
+            lineOverflow = false;
+
+            // Let a streamed response drain before reading the next command
+            if (activeStream != nullptr)
+            {
+                return;
+            }
+        }
+        else if (lineLength < CONSOLE_LINE_LENGTH - 1)
+        {
+            lineBuffer[lineLength++] = c;
+        }
+        else
+        {
+            lineOverflow = true;
+        }
+    }
+}
@@ -0,0 +1,294 @@
+#include "FillForecast.h"
+
+static FillBucket history[FILL_HISTORY];
+static uint8_t historyHead = 0; // Next bucket to write
+static uint8_t historySize = 0;
+
+// Bucket being filled
+static uint32_t bucketStart = 0;
+static uint32_t bucketDistanceMm = 0;
+static uint8_t bucketSamples = 0;
+static uint16_t bucketDeposits = 0;
+static bool started = false;
+
+static uint32_t lastAccepted = 0;
+static uint32_t depositsSinceEmptied = 0;
+static uint8_t peakLevel = 0;
+static bool pickupSent = false;
+static uint8_t pickupAheadHours = FILL_PICKUP_AHEAD_HOURS;
+
+// Welford-style running fit of level against depositsSinceEmptied; floats
+// keep their precision on the centred sums
+static uint16_t fitCount = 0;
+static float fitMeanX = 0;
+static float fitMeanY = 0;
+static float fitSxx = 0;
+static float fitSxy = 0;
+static uint32_t fitFirstX = 0;
+
+static FillForecast forecast = {0, 0, 0, 0, FILL_UNKNOWN, FILL_UNKNOWN, 0, 0};
+
+static uint8_t levelFor(float distanceCm)
+{
+    if (distanceCm >= BIN_EMPTY_CM)
+    {
+        return 0;
+    }
+    if (distanceCm <= BIN_FULL_CM)
+    {
+        return 100;
+    }
+    return (uint8_t)((BIN_EMPTY_CM - distanceCm) * 100 / (BIN_EMPTY_CM - BIN_FULL_CM));
+}
+
+static void resetFit()
+{
+    fitCount = 0;
+    fitMeanX = 0;
+    fitMeanY = 0;
+    fitSxx = 0;
+    fitSxy = 0;
+}
+
+static void addFitPoint(uint32_t x, uint8_t y)
+{
+    if (fitCount == 0)
+    {
+        fitFirstX = x;
+    }
+    if (fitCount < 0xFFFF)
+    {
+        fitCount++;
+    }
+    float dx = x - fitMeanX;
+    fitMeanX += dx / fitCount;
+    fitMeanY += (y - fitMeanY) / fitCount;
+    fitSxx += dx * (x - fitMeanX);
+    fitSxy += dx * (y - fitMeanY);
+}
+
+static void closeBucket()
+{
+    FillBucket &bucket = history[historyHead];
+    bucket.distanceMm = bucketSamples > 0 ? bucketDistanceMm / bucketSamples : 0;
+    bucket.deposits = min(bucketDeposits, (uint16_t)255);
+    historyHead = (historyHead + 1) % FILL_HISTORY;
+    if (historySize < FILL_HISTORY)
+    {
+        historySize++;
+    }
+    bucketDistanceMm = 0;
+    bucketSamples = 0;
+    bucketDeposits = 0;
+}
+
+static float depositRate(uint32_t now)
+{
+    // The open bucket plus the newest closed ones
+    uint32_t deposits = bucketDeposits;
+    uint32_t spanMs = now - bucketStart;
+    for (uint8_t i = 0; i < historySize && i + 1 < FILL_RATE_BUCKETS; i++)
+    {
+        deposits += history[(historyHead + FILL_HISTORY - 1 - i) % FILL_HISTORY].deposits;
+        spanMs += FILL_BUCKET_MS;
+    }
+    if (spanMs < FILL_SAMPLE_INTERVAL_MS * 10)
+    {
+        return 0; // Too soon after boot to say
+    }
+    return deposits * 3600000.0f / spanMs;
+}
+
+static void updateForecast(uint32_t now)
+{
+    forecast.fitPoints = fitCount;
+    forecast.bottlesPerHour = depositRate(now);
+    forecast.percentPerBottle = 0;
+    forecast.bottlesToFull = FILL_UNKNOWN;
+    forecast.minutesToFull = FILL_UNKNOWN;
+
+    if (fitCount < FILL_MIN_POINTS || depositsSinceEmptied - fitFirstX < FILL_MIN_SPAN || fitSxx <= 0)
+    {
+        return;
+    }
+    float slope = fitSxy / fitSxx;
+    if (slope <= 0)
+    {
+        return; // Sonar noise with the bin barely filling
+    }
+    forecast.percentPerBottle = slope;
+
+    float bottles = (100 - forecast.level) / slope;
+    forecast.bottlesToFull = bottles < FILL_UNKNOWN ? (uint16_t)bottles : FILL_UNKNOWN - 1;
+    if (forecast.bottlesPerHour > 0)
+    {
+        float minutes = bottles * 60 / forecast.bottlesPerHour;
+        forecast.minutesToFull = minutes < FILL_UNKNOWN ? (uint16_t)minutes : FILL_UNKNOWN - 1;
+    }
+}
+
+void fillEmptied()
+{
+    resetFit();
+    depositsSinceEmptied = 0;
+    peakLevel = 0;
+    pickupSent = false;
+    forecast.emptied++;
+}
+
+void fillSample(float distanceCm, uint32_t acceptedTotal)
+{
+    uint32_t now = millis();
+    if (distanceCm <= 0)
+    {
+        distanceCm = BIN_RANGE_CM; // No echo within the range is an empty bin
+    }
+    if (!started)
+    {
+        started = true;
+        bucketStart = now;
+        lastAccepted = acceptedTotal;
+    }
+    while (now - bucketStart >= FILL_BUCKET_MS)
+    {
+        closeBucket();
+        bucketStart += FILL_BUCKET_MS;
+    }
+
+    uint32_t deposits = acceptedTotal - lastAccepted;
+    lastAccepted = acceptedTotal;
+    bucketDeposits += deposits;
+    depositsSinceEmptied += deposits;
+
+    uint8_t level = levelFor(distanceCm);
+    if (peakLevel >= FILL_EMPTIED_DROP && level + FILL_EMPTIED_DROP <= peakLevel)
+    {
+        fillEmptied();
+    }
+    peakLevel = max(peakLevel, level);
+
+    forecast.level = level;
+    forecast.distanceMm = (uint16_t)(distanceCm * 10);
+    bucketDistanceMm += forecast.distanceMm;
+    bucketSamples++;
+
+    if (deposits > 0 || fitCount == 0)
+    {
+        addFitPoint(depositsSinceEmptied, level);
+    }
+    updateForecast(now);
+}
+
+bool fillPickupDue()
+{
+    if (pickupSent)
+    {
+        return false;
+    }
+    if (forecast.level >= FILL_PICKUP_LEVEL ||
+        (forecast.minutesToFull != FILL_UNKNOWN && forecast.minutesToFull <= pickupAheadHours * 60U))
+    {
+        pickupSent = true;
+        return true;
+    }
+    return false;
+}
+
+void fillSetPickupAhead(uint8_t hours)
+{
+    pickupAheadHours = hours;
+}
+
+const FillForecast &fillForecast()
+{
+    return forecast;
+}
+
+uint8_t fillHistory(FillBucket *buckets, uint8_t max)
+{
+    uint8_t count = min(historySize, max);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        buckets[i] = history[(historyHead + FILL_HISTORY - 1 - i) % FILL_HISTORY];
+    }
+    return count;
+}
+
+// Buckets printed per call, so each call fits the console's TX chunk
+const uint8_t FILL_REPORT_BUCKETS = 5;
+
+bool fillReport(Print &out, uint16_t line)
+{
+    if (line == 0)
+    {
+        out.print(F("fill level "));
+        out.print(forecast.level);
+        out.print(F("% distance "));
+        out.print(forecast.distanceMm / 10);
+        out.print('.');
+        out.print(forecast.distanceMm % 10);
+        out.println(F(" cm"));
+        return true;
+    }
+    if (line == 1)
+    {
+        out.print(F("rate "));
+        out.print(forecast.bottlesPerHour, 1);
+        out.print(F(" bottles/h, "));
+        out.print(forecast.percentPerBottle, 3);
+        out.println(F("%/bottle"));
+        return true;
+    }
+    if (line == 2)
+    {
+        out.print(F("forecast "));
+        if (forecast.bottlesToFull == FILL_UNKNOWN)
+        {
+            out.print(F("unknown"));
+        }
+        else
+        {
+            out.print(forecast.bottlesToFull);
+            out.print(F(" bottles"));
+            if (forecast.minutesToFull != FILL_UNKNOWN)
+            {
+                out.print(F(" "));
+                out.print(forecast.minutesToFull / 60);
+                out.print('h');
+                out.print(forecast.minutesToFull % 60);
+                out.print('m');
+            }
+        }
+        out.println(F(" to full"));
+        return true;
+    }
+    if (line == 3)
+    {
+        out.print(F("fit points "));
+        out.print(forecast.fitPoints);
+        out.print(F(" emptied "));
+        out.println(forecast.emptied);
+        return true;
+    }
+
+    // Oldest first, level and deposits per bucket
+    uint8_t first = (line - 4) * FILL_REPORT_BUCKETS;
+    if (first == 0)
+    {
+        out.print(F("history"));
+    }
+    for (uint8_t i = first; i < historySize && i < first + FILL_REPORT_BUCKETS; i++)
+    {
+        const FillBucket &bucket = history[(historyHead + FILL_HISTORY - historySize + i) % FILL_HISTORY];
+        out.print(' ');
+        out.print(bucket.distanceMm > 0 ? levelFor(bucket.distanceMm / 10.0f) : 0);
+        out.print('/');
+        out.print(bucket.deposits);
+    }
+    if (first + FILL_REPORT_BUCKETS < historySize)
+    {
+        return true;
+    }
+    out.println();
+    return false;
+}
@@ -0,0 +1,75 @@
+#include "Journal.h"
+
+static JournalEntry journalEntries[JOURNAL_CAPACITY];
+static uint8_t journalHead = 0; // Next slot to write
+static uint8_t journalSize = 0;
+
+static const char EVENT_NAME_0[] PROGMEM = "boot";
+static const char EVENT_NAME_1[] PROGMEM = "accepted";
+static const char EVENT_NAME_2[] PROGMEM = "rejected";
+static const char EVENT_NAME_3[] PROGMEM = "stored";
+static const char EVENT_NAME_4[] PROGMEM = "dispensed";
+static const char EVENT_NAME_5[] PROGMEM = "dispenseFault";
+static const char EVENT_NAME_6[] PROGMEM = "binFull";
+static const char EVENT_NAME_7[] PROGMEM = "tare";
+static const char EVENT_NAME_8[] PROGMEM = "setting";
+static const char EVENT_NAME_9[] PROGMEM = "recovered";
+static const char EVENT_NAME_10[] PROGMEM = "pickupDue";
+static const char *const EVENT_NAMES[JOURNAL_EVENT_COUNT] PROGMEM = {
+    EVENT_NAME_0,
+    EVENT_NAME_1,
+    EVENT_NAME_2,
+    EVENT_NAME_3,
+    EVENT_NAME_4,
+    EVENT_NAME_5,
+    EVENT_NAME_6,
+    EVENT_NAME_7,
+    EVENT_NAME_8,
+    EVENT_NAME_9,
+    EVENT_NAME_10};
+
+void journalRecord(JournalEvent event, int16_t value)
+{
+    JournalEntry &entry = journalEntries[journalHead];
+    entry.timeMs = millis();
+    entry.event = event;
+    entry.value = value;
+
+    journalHead = (journalHead + 1) % JOURNAL_CAPACITY;
+    if (journalSize < JOURNAL_CAPACITY)
+    {
+        journalSize++;
+    }
+}
+
+uint8_t journalCount()
+{
+    return journalSize;
+}
+
+bool journalGet(uint8_t index, JournalEntry &entry)
+{
+    if (index >= journalSize)
+    {
+        return false;
+    }
+
+    uint8_t oldest = (journalHead + JOURNAL_CAPACITY - journalSize) % JOURNAL_CAPACITY;
+    entry = journalEntries[(oldest + index) % JOURNAL_CAPACITY];
+    return true;
+}
+
+void journalClear()
+{
+    journalHead = 0;
+    journalSize = 0;
+}
+
+const __FlashStringHelper *journalEventName(uint8_t event)
+{
+    if (event >= JOURNAL_EVENT_COUNT)
+    {
+        return F("unknown");
+    }
+    return (const __FlashStringHelper *)pgm_read_ptr(&EVENT_NAMES[event]);
+}
@@ -0,0 +1,90 @@
+#include "LastState.h"
+
+#include <EEPROM.h>
+
+#include "EepromLayout.h"
+
+const uint8_t LAST_STATE_MAGIC = 0x1A;
+
+struct LastStateSlot
+{
+    uint8_t magic;
+    uint8_t sequence; // Newest slot wins, compared modulo 256
+    LastState state;
+    uint8_t checksum;
+};
+
+static_assert(LAST_STATE_SLOTS * sizeof(LastStateSlot) <= 160, "ring outgrows its EEPROM space");
+
+static LastStateSlot current;
+static int8_t currentSlot = -1; // None valid yet
+
+static uint8_t checksumOf(const LastStateSlot &slot)
+{
+    const uint8_t *bytes = (const uint8_t *)&slot;
+    uint8_t sum = 0;
+    for (size_t i = 0; i < offsetof(LastStateSlot, checksum); i++)
+    {
+        sum += bytes[i];
+    }
+    return sum;
+}
+
+static bool sameState(const LastState &a, const LastState &b)
+{
+    return a.kind == b.kind && a.points == b.points && a.done == b.done && a.tareOffset == b.tareOffset;
+}
+
+static int slotAddress(uint8_t slot)
+{
+    return EEPROM_LAST_STATE_ADDR + slot * sizeof(LastStateSlot);
+}
+
+void lastStateBegin()
+{
+    currentSlot = -1;
+    for (uint8_t i = 0; i < LAST_STATE_SLOTS; i++)
+    {
+        LastStateSlot slot;
+        EEPROM.get(slotAddress(i), slot);
+        if (slot.magic != LAST_STATE_MAGIC || slot.checksum != checksumOf(slot))
+        {
+            continue;
+        }
+        if (currentSlot < 0 || (int8_t)(slot.sequence - current.sequence) > 0)
+        {
+            current = slot;
+            currentSlot = i;
+        }
+    }
+}
+
+bool lastStateGet(LastState &state)
+{
+    if (currentSlot < 0)
+    {
+        return false;
+    }
+    state = current.state;
+    return true;
+}
+
+void lastStateSave(const LastState &state)
+{
+    if (currentSlot >= 0 && sameState(state, current.state))
+    {
+        return;
+    }
+
+    // Written to the slot after the newest one, which stays valid until
+    // this one is complete
+    LastStateSlot slot;
+    memset(&slot, 0, sizeof(slot));
+    slot.magic = LAST_STATE_MAGIC;
+    slot.sequence = currentSlot < 0 ? 0 : current.sequence + 1;
+    slot.state = state;
+    slot.checksum = checksumOf(slot);
+    currentSlot = currentSlot < 0 ? 0 : (currentSlot + 1) % LAST_STATE_SLOTS;
+    EEPROM.put(slotAddress(currentSlot), slot);
+    current = slot;
+}
@@ -0,0 +1,205 @@
+#include "LoadCell.h"
+
+#include <EEPROM.h>
+
+#include "EepromLayout.h"
+
+const uint8_t CALIBRATION_MAGIC = 0xCA;
+const int32_t DEFAULT_COUNTS = -35082; // 100 g on the reference unit (-350.82/g)
+const int16_t DEFAULT_DECIGRAMS = 1000;
+const int32_t MIN_POINT_COUNTS = 100; // Too close to tare to fix a slope
+const int32_t NET_LIMIT = 1000000L;  // About 2.8 kg at the reference slope; bounds points and readings
+
+struct LoadCellCalibration
+{
+    uint8_t magic;
+    uint8_t count;
+    LoadCellPoint points[LOADCELL_MAX_POINTS]; // Sorted by weight
+    uint8_t checksum;
+};
+
+static LoadCellCalibration calibration;
+
+// Working table: the tare point followed by the calibration points in net
+// counts, with the slope of each segment in decigrams per count, Q16
+static int8_t sign = 1;
+static uint8_t pointCount;
+static int32_t nets[LOADCELL_MAX_POINTS + 1];
+static int16_t decigrams[LOADCELL_MAX_POINTS + 1];
+static int32_t slopesQ16[LOADCELL_MAX_POINTS];
+
+static uint8_t checksumOf(const LoadCellCalibration &record)
+{
+    const uint8_t *bytes = (const uint8_t *)&record;
+    uint8_t sum = 0;
+    for (size_t i = 0; i < offsetof(LoadCellCalibration, checksum); i++)
+    {
+        sum += bytes[i];
+    }
+    return sum;
+}
+
+static void setDefault()
+{
+    calibration.magic = CALIBRATION_MAGIC;
+    calibration.count = 1;
+    calibration.points[0].counts = DEFAULT_COUNTS;
+    calibration.points[0].decigrams = DEFAULT_DECIGRAMS;
+}
+
+// Rebuilds the working table; false if the points do not rise together
+static bool buildTable(const LoadCellCalibration &record)
+{
+    if (record.count == 0 || record.count > LOADCELL_MAX_POINTS)
+    {
+        return false;
+    }
+
+    int8_t newSign = record.points[0].counts < 0 ? -1 : 1;
+    int32_t newNets[LOADCELL_MAX_POINTS + 1] = {0};
+    int16_t newDecigrams[LOADCELL_MAX_POINTS + 1] = {0};
+    for (uint8_t i = 0; i < record.count; i++)
+    {
+        newNets[i + 1] = record.points[i].counts * newSign;
+        newDecigrams[i + 1] = record.points[i].decigrams;
+        if (newNets[i + 1] <= newNets[i] || newNets[i + 1] > NET_LIMIT || newDecigrams[i + 1] <= newDecigrams[i])
+        {
+            return false;
+        }
+    }
+
+    sign = newSign;
+    pointCount = record.count + 1;
+    for (uint8_t i = 0; i < pointCount; i++)
+    {
+        nets[i] = newNets[i];
+        decigrams[i] = newDecigrams[i];
+    }
+    for (uint8_t i = 0; i + 1 < pointCount; i++)
+    {
+        int32_t span = nets[i + 1] - nets[i];
+        slopesQ16[i] = (((int32_t)(decigrams[i + 1] - decigrams[i]) << 16) + span / 2) / span;
+    }
+    return true;
+}
+
+static void save()
+{
+    calibration.checksum = checksumOf(calibration);
+    EEPROM.put(EEPROM_CALIBRATION_ADDR, calibration);
+}
+
+void loadCellBegin()
+{
+    EEPROM.get(EEPROM_CALIBRATION_ADDR, calibration);
+    if (calibration.magic != CALIBRATION_MAGIC || calibration.checksum != checksumOf(calibration) ||
+        !buildTable(calibration))
+    {
+        setDefault();
+        buildTable(calibration);
+    }
+}
+
+int32_t loadCellNet(int32_t countsFromTare)
+{
+    return countsFromTare * sign;
+}
+
+int16_t loadCellDecigrams(int32_t net)
+{
+    net = constrain(net, -NET_LIMIT, NET_LIMIT);
+
+    // Segments past either end are extended
+    uint8_t i = 0;
+    while (i + 2 < pointCount && net >= nets[i + 1])
+    {
+        i++;
+    }
+    // Up to 2 * NET_LIMIT counts times a Q16 slope: needs the 64-bit product
+    int32_t dg = decigrams[i] + (int32_t)(((int64_t)(net - nets[i]) * slopesQ16[i] + 0x8000) >> 16);
+    return (int16_t)constrain(dg, -32000L, 32000L);
+}
+
+int32_t loadCellNetFor(int16_t dg)
+{
+    uint8_t i = 0;
+    while (i + 2 < pointCount && dg >= decigrams[i + 1])
+    {
+        i++;
+    }
+    // Only used for limits at boot, so the 64-bit division is affordable
+    return nets[i] + (int64_t)(dg - decigrams[i]) * (nets[i + 1] - nets[i]) / (decigrams[i + 1] - decigrams[i]);
+}
+
+bool loadCellCalibrate(int32_t countsFromTare, int16_t dg)
+{
+    if (dg <= 0 || abs(countsFromTare) < MIN_POINT_COUNTS)
+    {
+        return false;
+    }
+
+    // Insert in weight order, replacing a point at the same weight
+    LoadCellCalibration updated = calibration;
+    uint8_t i = 0;
+    while (i < updated.count && updated.points[i].decigrams < dg)
+    {
+        i++;
+    }
+    if (i == updated.count || updated.points[i].decigrams != dg)
+    {
+        if (updated.count == LOADCELL_MAX_POINTS)
+        {
+            return false;
+        }
+        for (uint8_t k = updated.count; k > i; k--)
+        {
+            updated.points[k] = updated.points[k - 1];
+        }
+        updated.count++;
+    }
+    updated.points[i].counts = countsFromTare;
+    updated.points[i].decigrams = dg;
+
+    // Refuse points that would make the table non-monotonic
+    if (!buildTable(updated))
+    {
+        return false;
+    }
+    calibration = updated;
+    save();
+    return true;
+}
+
+void loadCellResetCalibration()
+{
+    setDefault();
+    buildTable(calibration);
+    save();
+}
+
+uint8_t loadCellPointCount()
+{
+    return calibration.count;
+}
+
+bool loadCellPoint(uint8_t index, LoadCellPoint &point)
+{
+    if (index >= calibration.count)
+    {
+        return false;
+    }
+    point = calibration.points[index];
+    return true;
+}
+
+void loadCellPrintGrams(Print &out, int16_t dg)
+{
+    if (dg < 0)
+    {
+        out.print('-');
+    }
+    out.print(abs(dg) / 10);
+    out.print('.');
+    out.print(abs(dg) % 10);
+    out.print('g');
+}
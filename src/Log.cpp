@@ -0,0 +1,109 @@
+#include "Log.h"
+
+#if LOG_LEVEL > LOG_LEVEL_NONE
+
+struct LogRecord
+{
+    uint8_t id;
+    uint16_t time;
+    int32_t a;
+    int32_t b;
+};
+
+static Print *logPort = nullptr;
+static LogRecord logRing[LOG_RING_RECORDS];
+static uint8_t logHead = 0; // Next slot to write
+static uint8_t logTail = 0; // Next slot to send
+static uint8_t logSize = 0;
+static uint32_t droppedRecords = 0;
+static uint32_t droppedReported = 0;
+
+static bool pushRecord(uint8_t id, int32_t a, int32_t b)
+{
+    if (logSize >= LOG_RING_RECORDS)
+    {
+        return false;
+    }
+
+    LogRecord &record = logRing[logHead];
+    record.id = id;
+    record.time = (uint16_t)millis();
+    record.a = a;
+    record.b = b;
+
+    logHead = (logHead + 1) % LOG_RING_RECORDS;
+    logSize++;
+    return true;
+}
+
+static void sendRecord(const LogRecord &record)
+{
+    uint8_t bytes[LOG_RECORD_SIZE];
+    bytes[0] = LOG_SYNC_BYTE;
+    bytes[1] = record.id;
+    bytes[2] = record.time & 0xFF;
+    bytes[3] = record.time >> 8;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        bytes[4 + i] = (uint32_t)record.a >> (8 * i);
+        bytes[8 + i] = (uint32_t)record.b >> (8 * i);
+    }
+
+    uint8_t checksum = 0;
+    for (uint8_t i = 1; i < LOG_RECORD_SIZE - 1; i++)
+    {
+        checksum += bytes[i];
+    }
+    bytes[LOG_RECORD_SIZE - 1] = checksum;
+
+    logPort->write(bytes, LOG_RECORD_SIZE);
+}
+
+void logBegin(Print &port)
+{
+    logPort = &port;
+    logWrite(LOG_BOOT);
+}
+
+void logWrite(uint8_t id, int32_t a, int32_t b)
+{
+    if (!pushRecord(id, a, b))
+    {
+        droppedRecords++;
+    }
+}
+
+void logFlush()
+{
+    if (logPort == nullptr)
+    {
+        return;
+    }
+
+    // Report drops once the ring has room again
+    if (droppedRecords != droppedReported && pushRecord(LOG_DROPPED, droppedRecords - droppedReported, 0))
+    {
+        droppedReported = droppedRecords;
+    }
+
+    while (logSize > 0 && logPort->availableForWrite() >= LOG_RECORD_SIZE)
+    {
+        sendRecord(logRing[logTail]);
+        logTail = (logTail + 1) % LOG_RING_RECORDS;
+        logSize--;
+    }
+}
+
+uint32_t logDroppedCount()
+{
+    return droppedRecords;
+}
+
+#else
+
+void logBegin(Print &port) {}
+void logWrite(uint8_t id, int32_t a, int32_t b) {}
+void logFlush() {}
+uint32_t logDroppedCount() { return 0; }
+
+#endif
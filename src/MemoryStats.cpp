@@ -0,0 +1,191 @@
+#include "MemoryStats.h"
+
+#include "Log.h"
+
+#ifdef __AVR__
+const uint8_t STACK_CANARY = 0xC5;
+const uint8_t CANARY_RUN = 16; // Untouched bytes in a row that mark the free gap
+const unsigned long SCAN_INTERVAL_MS = 10000;
+
+// Section bounds from the linker script, and the malloc state from avr-libc
+extern uint8_t __data_start;
+extern uint8_t __data_end;
+extern uint8_t __bss_start;
+extern uint8_t __bss_end;
+extern uint8_t __noinit_start;
+extern uint8_t __noinit_end;
+extern uint8_t __heap_start;
+extern char *__brkval; // 0 until the first malloc()
+
+struct __freelist
+{
+    size_t sz; // Usable bytes, after the size word
+    struct __freelist *nx;
+};
+extern struct __freelist *__flp;
+
+static uint8_t *heapPeak = &__heap_start;
+static unsigned long lastScanMs = 0;
+static uint16_t lowestLogged = 0xFFFF;
+
+// Runs before the C runtime init, once the stack pointer is set. The heap
+// is still empty then, so everything above the static data is free.
+void memoryPaintStack() __attribute__((naked, used, section(".init3")));
+void memoryPaintStack()
+{
+    uint8_t *p = &__heap_start;
+    while (p < (uint8_t *)SP)
+    {
+        *p++ = STACK_CANARY;
+    }
+}
+
+static uint8_t *heapTop()
+{
+    return __brkval ? (uint8_t *)__brkval : &__heap_start;
+}
+
+static void sampleHeap()
+{
+    uint8_t *top = heapTop();
+    if (top > heapPeak)
+    {
+        heapPeak = top;
+    }
+}
+
+// Lowest address the stack has written: the top of the first run of
+// CANARY_RUN canary bytes above the heap peak. Heap blocks freed since the
+// peak are not repainted, so the scan starts above them. heapPeak is only
+// sampled, though, and the heap may have reached past it in between; the
+// stray bytes it left there end at the run, which becomes the new peak.
+static uint8_t *stackLowWater()
+{
+    uint8_t *sp = (uint8_t *)SP;
+    uint8_t *runStart = heapPeak;
+    uint8_t *p = heapPeak;
+    for (; p < sp; p++)
+    {
+        if (*p == STACK_CANARY)
+        {
+            continue;
+        }
+        if (p - runStart >= CANARY_RUN)
+        {
+            break;
+        }
+        runStart = p + 1;
+    }
+    if (p - runStart < CANARY_RUN)
+    {
+        return heapPeak; // No gap left; the heap and stack have met
+    }
+    heapPeak = runStart;
+    return p;
+}
+
+bool memoryStats(MemoryStats &stats)
+{
+    sampleHeap();
+    stats.dataBytes = &__data_end - &__data_start;
+    stats.bssBytes = &__bss_end - &__bss_start;
+    stats.noinitBytes = &__noinit_end - &__noinit_start;
+
+    stats.heapBytes = heapTop() - &__heap_start;
+    stats.freeListBytes = 0;
+    stats.freeBlocks = 0;
+    stats.largestFreeBlock = 0;
+    noInterrupts();
+    for (struct __freelist *block = __flp; block; block = block->nx)
+    {
+        stats.freeListBytes += block->sz;
+        stats.freeBlocks++;
+        if (block->sz > stats.largestFreeBlock)
+        {
+            stats.largestFreeBlock = block->sz;
+        }
+    }
+    interrupts();
+
+    uint8_t *low = stackLowWater();
+    stats.heapPeakBytes = heapPeak - &__heap_start;
+    stats.stackBytes = (uint8_t *)RAMEND - (uint8_t *)SP;
+    stats.stackPeakBytes = (uint8_t *)RAMEND + 1 - low;
+    stats.headroom = low - heapPeak;
+    stats.totalBytes = RAMEND - RAMSTART + 1;
+    return true;
+}
+
+void memoryPoll()
+{
+    sampleHeap();
+    if (millis() - lastScanMs < SCAN_INTERVAL_MS)
+    {
+        return;
+    }
+    lastScanMs = millis();
+
+    MemoryStats stats;
+    memoryStats(stats);
+    if (stats.headroom < MEMORY_LOW_HEADROOM && stats.headroom < lowestLogged)
+    {
+        lowestLogged = stats.headroom;
+        LOG_WARN(LOG_MEMORY_LOW, stats.headroom, stats.largestFreeBlock);
+    }
+}
+#else
+bool memoryStats(MemoryStats &stats)
+{
+    memset(&stats, 0, sizeof(stats));
+    return false;
+}
+
+void memoryPoll()
+{
+}
+#endif
+
+bool memoryReport(Print &out, uint16_t line)
+{
+    MemoryStats stats;
+    if (!memoryStats(stats))
+    {
+        out.println(F("memory n/a on this build"));
+        return false;
+    }
+    switch (line)
+    {
+    case 0:
+        out.print(F("ram data "));
+        out.print(stats.dataBytes);
+        out.print(F(" bss "));
+        out.print(stats.bssBytes);
+        out.print(F(" noinit "));
+        out.print(stats.noinitBytes);
+        out.print(F(" of "));
+        out.println(stats.totalBytes);
+        return true;
+    case 1:
+        out.print(F("heap "));
+        out.print(stats.heapBytes);
+        out.print(F(" peak "));
+        out.println(stats.heapPeakBytes);
+        return true;
+    case 2:
+        out.print(F("free list "));
+        out.print(stats.freeListBytes);
+        out.print(F(" in "));
+        out.print(stats.freeBlocks);
+        out.print(F(" largest "));
+        out.println(stats.largestFreeBlock);
+        return true;
+    default:
+        out.print(F("stack "));
+        out.print(stats.stackBytes);
+        out.print(F(" peak "));
+        out.print(stats.stackPeakBytes);
+        out.print(F(" headroom "));
+        out.println(stats.headroom);
+        return false;
+    }
+}
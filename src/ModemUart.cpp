@@ -0,0 +1,260 @@
+#include "ModemUart.h"
+
+// The native build's ModemUart lives in lib/NativeSim
+#ifdef __AVR__
+
+#include "PinMap.h"
+
+static_assert(MODEM_RX_BUFFER_SIZE == 256, "Receive indexes rely on 8-bit wrap-around");
+
+// Stall waits are counted in fixed steps, since millis() stands still when
+// the caller has interrupts off
+const uint8_t CTS_WAIT_STEP_US = 100;
+const uint16_t CTS_WAIT_STEPS = MODEM_CTS_TIMEOUT_MS * (1000 / CTS_WAIT_STEP_US);
+
+ModemUart modemUart;
+
+ISR(USART2_RX_vect)
+{
+    uint8_t status = UCSR2A;
+    uint8_t byte = UDR2;
+    if (status & _BV(UPE2))
+    {
+        return; // Parity error, drop like the core does
+    }
+    modemUart.rxInterrupt(byte);
+}
+
+ISR(USART2_UDRE_vect)
+{
+    modemUart.txInterrupt();
+}
+
+void ModemUart::begin(unsigned long baud)
+{
+    // RTS and CTS are active low: RTS low lets the modem send, CTS low means
+    // it takes data
+    SIM_RTS.output();
+    SIM_RTS.low();
+    SIM_CTS.inputPullup();
+
+    // Double speed mode, as the core uses for the standard rates
+    uint16_t setting = (F_CPU / 4 / baud - 1) / 2;
+    UCSR2A = _BV(U2X2);
+    UBRR2 = setting;
+    UCSR2C = _BV(UCSZ21) | _BV(UCSZ20); // 8N1
+    UCSR2B = _BV(RXEN2) | _BV(TXEN2) | _BV(RXCIE2);
+}
+
+void ModemUart::rxInterrupt(uint8_t byte)
+{
+    uint8_t next = rxHead + 1;
+    if (next == rxTail)
+    {
+        linkStats.rxOverruns++;
+        return;
+    }
+    rxBuffer[rxHead] = byte;
+    rxHead = next;
+    linkStats.rxBytes++;
+
+    uint8_t count = rxCount();
+    if (count > linkStats.rxHighWater)
+    {
+        linkStats.rxHighWater = count;
+    }
+    if (count >= MODEM_RX_HOLD_LEVEL)
+    {
+        SIM_RTS.high();
+    }
+}
+
+void ModemUart::txInterrupt()
+{
+    if (SIM_CTS.read() == HIGH)
+    {
+        // Stop until resumeTx() sees CTS again, rather than spin in here
+        UCSR2B &= ~_BV(UDRIE2);
+        txStalled = true;
+        linkStats.ctsStalls++;
+        return;
+    }
+    uint8_t byte = txBuffer[txTail];
+    txTail = (txTail + 1) % MODEM_TX_BUFFER_SIZE;
+    UCSR2A = (UCSR2A & _BV(U2X2)) | _BV(TXC2); // Clear TXC for flush()
+    UDR2 = byte;
+    if (txHead == txTail)
+    {
+        UCSR2B &= ~_BV(UDRIE2);
+    }
+}
+
+void ModemUart::updateRts()
+{
+    if (held || rxCount() >= MODEM_RX_HOLD_LEVEL)
+    {
+        SIM_RTS.high();
+    }
+    else if (rxCount() < MODEM_RX_RESUME_LEVEL)
+    {
+        SIM_RTS.low();
+    }
+}
+
+void ModemUart::resumeTx()
+{
+    if (txStalled && SIM_CTS.read() == LOW)
+    {
+        txStalled = false;
+        txDiscarding = false;
+        uint8_t sreg = SREG;
+        cli();
+        if (txHead != txTail)
+        {
+            UCSR2B |= _BV(UDRIE2);
+        }
+        SREG = sreg;
+    }
+}
+
+// One step of waiting on a stalled transmitter; false once CTS has been
+// off for MODEM_CTS_TIMEOUT_MS in all
+bool ModemUart::waitCts(uint16_t &waitedSteps)
+{
+    if (++waitedSteps > CTS_WAIT_STEPS)
+    {
+        return false;
+    }
+    delayMicroseconds(CTS_WAIT_STEP_US);
+    return true;
+}
+
+void ModemUart::discardTx()
+{
+    uint8_t sreg = SREG;
+    cli();
+    UCSR2B &= ~_BV(UDRIE2);
+    linkStats.txDiscarded += (uint8_t)(txHead + MODEM_TX_BUFFER_SIZE - txTail) % MODEM_TX_BUFFER_SIZE;
+    txTail = txHead;
+    SREG = sreg;
+    txDiscarding = true;
+}
+
+int ModemUart::available()
+{
+    resumeTx();
+    return rxCount();
+}
+
+int ModemUart::peek()
+{
+    return rxCount() ? rxBuffer[rxTail] : -1;
+}
+
+int ModemUart::read()
+{
+    if (rxCount() == 0)
+    {
+        return -1;
+    }
+    uint8_t byte = rxBuffer[rxTail];
+    rxTail = rxTail + 1;
+    updateRts();
+    return byte;
+}
+
+int ModemUart::availableForWrite()
+{
+    uint8_t head = txHead;
+    uint8_t tail = txTail;
+    return (tail + MODEM_TX_BUFFER_SIZE - head - 1) % MODEM_TX_BUFFER_SIZE;
+}
+
+size_t ModemUart::write(uint8_t byte)
+{
+    written = true;
+    resumeTx();
+    if (txDiscarding)
+    {
+        linkStats.txDiscarded++;
+        return 0;
+    }
+
+    // Idle line: straight into the data register, as the core does
+    if (txHead == txTail && !txStalled && (UCSR2A & _BV(UDRE2)) && SIM_CTS.read() == LOW)
+    {
+        linkStats.txBytes++;
+        uint8_t sreg = SREG;
+        cli();
+        UDR2 = byte;
+        UCSR2A = (UCSR2A & _BV(U2X2)) | _BV(TXC2);
+        SREG = sreg;
+        return 1;
+    }
+
+    uint8_t next = (txHead + 1) % MODEM_TX_BUFFER_SIZE;
+    uint16_t waitedSteps = 0;
+    while (next == txTail)
+    {
+        resumeTx();
+        if (txStalled && !waitCts(waitedSteps))
+        {
+            discardTx();
+            linkStats.txDiscarded++;
+            return 0;
+        }
+        // With interrupts off nothing drains the buffer, so do it here
+        if (bit_is_clear(SREG, SREG_I) && (UCSR2A & _BV(UDRE2)) && !txStalled)
+        {
+            txInterrupt();
+        }
+    }
+    linkStats.txBytes++;
+    txBuffer[txHead] = byte;
+    uint8_t sreg = SREG;
+    cli();
+    txHead = next;
+    if (!txStalled)
+    {
+        UCSR2B |= _BV(UDRIE2);
+    }
+    SREG = sreg;
+    return 1;
+}
+
+void ModemUart::flush()
+{
+    if (!written || txDiscarding)
+    {
+        return;
+    }
+    uint16_t waitedSteps = 0;
+    while ((UCSR2B & _BV(UDRIE2)) || txStalled || !(UCSR2A & _BV(TXC2)))
+    {
+        resumeTx();
+        if (txStalled && !waitCts(waitedSteps))
+        {
+            discardTx();
+            return;
+        }
+        if (bit_is_clear(SREG, SREG_I) && (UCSR2B & _BV(UDRIE2)) && (UCSR2A & _BV(UDRE2)))
+        {
+            txInterrupt();
+        }
+    }
+}
+
+void ModemUart::holdReceive(bool hold)
+{
+    held = hold;
+    updateRts();
+}
+
+void ModemUart::stats(ModemLinkStats &stats)
+{
+    noInterrupts();
+    stats = linkStats;
+    interrupts();
+}
+
+#endif
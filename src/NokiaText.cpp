@@ -0,0 +1,238 @@
+#include "NokiaText.h"
+
+const uint8_t GLYPH_COLUMNS = 5;
+const char FIRST_GLYPH = ' ';
+const char LAST_GLYPH = '~';
+
+// 180 degree rotation: the columns run right to left and each one upside down
+constexpr uint8_t flipColumn(uint8_t bits)
+{
+    return (bits & 0x01) << 7 | (bits & 0x02) << 5 | (bits & 0x04) << 3 | (bits & 0x08) << 1 |
+           (bits & 0x10) >> 1 | (bits & 0x20) >> 3 | (bits & 0x40) >> 5 | (bits & 0x80) >> 7;
+}
+
+#define NOKIA_GLYPH(c0, c1, c2, c3, c4) \
+    flipColumn(c4), flipColumn(c3), flipColumn(c2), flipColumn(c1), flipColumn(c0)
+
+// Classic 5x8 ASCII font, columns top to bottom from the LSB as written
+static const uint8_t FONT[] PROGMEM = {
+    NOKIA_GLYPH(0x00, 0x00, 0x00, 0x00, 0x00), // space
+    NOKIA_GLYPH(0x00, 0x00, 0x5f, 0x00, 0x00), // !
+    NOKIA_GLYPH(0x00, 0x07, 0x00, 0x07, 0x00), // "
+    NOKIA_GLYPH(0x14, 0x7f, 0x14, 0x7f, 0x14), // #
+    NOKIA_GLYPH(0x24, 0x2a, 0x7f, 0x2a, 0x12), // $
+    NOKIA_GLYPH(0x23, 0x13, 0x08, 0x64, 0x62), // %
+    NOKIA_GLYPH(0x36, 0x49, 0x55, 0x22, 0x50), // &
+    NOKIA_GLYPH(0x00, 0x05, 0x03, 0x00, 0x00), // '
+    NOKIA_GLYPH(0x00, 0x1c, 0x22, 0x41, 0x00), // (
+    NOKIA_GLYPH(0x00, 0x41, 0x22, 0x1c, 0x00), // )
+    NOKIA_GLYPH(0x14, 0x08, 0x3e, 0x08, 0x14), // *
+    NOKIA_GLYPH(0x08, 0x08, 0x3e, 0x08, 0x08), // +
+    NOKIA_GLYPH(0x00, 0x50, 0x30, 0x00, 0x00), // ,
+    NOKIA_GLYPH(0x08, 0x08, 0x08, 0x08, 0x08), // -
+    NOKIA_GLYPH(0x00, 0x60, 0x60, 0x00, 0x00), // .
+    NOKIA_GLYPH(0x20, 0x10, 0x08, 0x04, 0x02), // /
+    NOKIA_GLYPH(0x3e, 0x51, 0x49, 0x45, 0x3e), // 0
+    NOKIA_GLYPH(0x00, 0x42, 0x7f, 0x40, 0x00), // 1
+    NOKIA_GLYPH(0x42, 0x61, 0x51, 0x49, 0x46), // 2
+    NOKIA_GLYPH(0x21, 0x41, 0x45, 0x4b, 0x31), // 3
+    NOKIA_GLYPH(0x18, 0x14, 0x12, 0x7f, 0x10), // 4
+    NOKIA_GLYPH(0x27, 0x45, 0x45, 0x45, 0x39), // 5
+    NOKIA_GLYPH(0x3c, 0x4a, 0x49, 0x49, 0x30), // 6
+    NOKIA_GLYPH(0x01, 0x71, 0x09, 0x05, 0x03), // 7
+    NOKIA_GLYPH(0x36, 0x49, 0x49, 0x49, 0x36), // 8
+    NOKIA_GLYPH(0x06, 0x49, 0x49, 0x29, 0x1e), // 9
+    NOKIA_GLYPH(0x00, 0x36, 0x36, 0x00, 0x00), // :
+    NOKIA_GLYPH(0x00, 0x56, 0x36, 0x00, 0x00), // ;
+    NOKIA_GLYPH(0x08, 0x14, 0x22, 0x41, 0x00), // <
+    NOKIA_GLYPH(0x14, 0x14, 0x14, 0x14, 0x14), // =
+    NOKIA_GLYPH(0x00, 0x41, 0x22, 0x14, 0x08), // >
+    NOKIA_GLYPH(0x02, 0x01, 0x51, 0x09, 0x06), // ?
+    NOKIA_GLYPH(0x32, 0x49, 0x79, 0x41, 0x3e), // @
+    NOKIA_GLYPH(0x7e, 0x11, 0x11, 0x11, 0x7e), // A
+    NOKIA_GLYPH(0x7f, 0x49, 0x49, 0x49, 0x36), // B
+    NOKIA_GLYPH(0x3e, 0x41, 0x41, 0x41, 0x22), // C
+    NOKIA_GLYPH(0x7f, 0x41, 0x41, 0x22, 0x1c), // D
+    NOKIA_GLYPH(0x7f, 0x49, 0x49, 0x49, 0x41), // E
+    NOKIA_GLYPH(0x7f, 0x09, 0x09, 0x09, 0x01), // F
+    NOKIA_GLYPH(0x3e, 0x41, 0x49, 0x49, 0x7a), // G
+    NOKIA_GLYPH(0x7f, 0x08, 0x08, 0x08, 0x7f), // H
+    NOKIA_GLYPH(0x00, 0x41, 0x7f, 0x41, 0x00), // I
+    NOKIA_GLYPH(0x20, 0x40, 0x41, 0x3f, 0x01), // J
+    NOKIA_GLYPH(0x7f, 0x08, 0x14, 0x22, 0x41), // K
+    NOKIA_GLYPH(0x7f, 0x40, 0x40, 0x40, 0x40), // L
+    NOKIA_GLYPH(0x7f, 0x02, 0x0c, 0x02, 0x7f), // M
+    NOKIA_GLYPH(0x7f, 0x04, 0x08, 0x10, 0x7f), // N
+    NOKIA_GLYPH(0x3e, 0x41, 0x41, 0x41, 0x3e), // O
+    NOKIA_GLYPH(0x7f, 0x09, 0x09, 0x09, 0x06), // P
+    NOKIA_GLYPH(0x3e, 0x41, 0x51, 0x21, 0x5e), // Q
+    NOKIA_GLYPH(0x7f, 0x09, 0x19, 0x29, 0x46), // R
+    NOKIA_GLYPH(0x46, 0x49, 0x49, 0x49, 0x31), // S
+    NOKIA_GLYPH(0x01, 0x01, 0x7f, 0x01, 0x01), // T
+    NOKIA_GLYPH(0x3f, 0x40, 0x40, 0x40, 0x3f), // U
+    NOKIA_GLYPH(0x1f, 0x20, 0x40, 0x20, 0x1f), // V
+    NOKIA_GLYPH(0x3f, 0x40, 0x38, 0x40, 0x3f), // W
+    NOKIA_GLYPH(0x63, 0x14, 0x08, 0x14, 0x63), // X
+    NOKIA_GLYPH(0x07, 0x08, 0x70, 0x08, 0x07), // Y
+    NOKIA_GLYPH(0x61, 0x51, 0x49, 0x45, 0x43), // Z
+    NOKIA_GLYPH(0x00, 0x7f, 0x41, 0x41, 0x00), // [
+    NOKIA_GLYPH(0x02, 0x04, 0x08, 0x10, 0x20), // backslash
+    NOKIA_GLYPH(0x00, 0x41, 0x41, 0x7f, 0x00), // ]
+    NOKIA_GLYPH(0x04, 0x02, 0x01, 0x02, 0x04), // ^
+    NOKIA_GLYPH(0x40, 0x40, 0x40, 0x40, 0x40), // _
+    NOKIA_GLYPH(0x00, 0x01, 0x02, 0x04, 0x00), // `
+    NOKIA_GLYPH(0x20, 0x54, 0x54, 0x54, 0x78), // a
+    NOKIA_GLYPH(0x7f, 0x48, 0x44, 0x44, 0x38), // b
+    NOKIA_GLYPH(0x38, 0x44, 0x44, 0x44, 0x20), // c
+    NOKIA_GLYPH(0x38, 0x44, 0x44, 0x48, 0x7f), // d
+    NOKIA_GLYPH(0x38, 0x54, 0x54, 0x54, 0x18), // e
+    NOKIA_GLYPH(0x08, 0x7e, 0x09, 0x01, 0x02), // f
+    NOKIA_GLYPH(0x0c, 0x52, 0x52, 0x52, 0x3e), // g
+    NOKIA_GLYPH(0x7f, 0x08, 0x04, 0x04, 0x78), // h
+    NOKIA_GLYPH(0x00, 0x44, 0x7d, 0x40, 0x00), // i
+    NOKIA_GLYPH(0x20, 0x40, 0x44, 0x3d, 0x00), // j
+    NOKIA_GLYPH(0x7f, 0x10, 0x28, 0x44, 0x00), // k
+    NOKIA_GLYPH(0x00, 0x41, 0x7f, 0x40, 0x00), // l
+    NOKIA_GLYPH(0x7c, 0x04, 0x18, 0x04, 0x78), // m
+    NOKIA_GLYPH(0x7c, 0x08, 0x04, 0x04, 0x78), // n
+    NOKIA_GLYPH(0x38, 0x44, 0x44, 0x44, 0x38), // o
+    NOKIA_GLYPH(0x7c, 0x14, 0x14, 0x14, 0x08), // p
+    NOKIA_GLYPH(0x08, 0x14, 0x14, 0x18, 0x7c), // q
+    NOKIA_GLYPH(0x7c, 0x08, 0x04, 0x04, 0x08), // r
+    NOKIA_GLYPH(0x48, 0x54, 0x54, 0x54, 0x20), // s
+    NOKIA_GLYPH(0x04, 0x3f, 0x44, 0x40, 0x20), // t
+    NOKIA_GLYPH(0x3c, 0x40, 0x40, 0x20, 0x7c), // u
+    NOKIA_GLYPH(0x1c, 0x20, 0x40, 0x20, 0x1c), // v
+    NOKIA_GLYPH(0x3c, 0x40, 0x30, 0x40, 0x3c), // w
+    NOKIA_GLYPH(0x44, 0x28, 0x10, 0x28, 0x44), // x
+    NOKIA_GLYPH(0x0c, 0x50, 0x50, 0x50, 0x3c), // y
+    NOKIA_GLYPH(0x44, 0x64, 0x54, 0x4c, 0x44), // z
+    NOKIA_GLYPH(0x00, 0x08, 0x36, 0x41, 0x00), // {
+    NOKIA_GLYPH(0x00, 0x00, 0x7f, 0x00, 0x00), // |
+    NOKIA_GLYPH(0x00, 0x41, 0x36, 0x08, 0x00), // }
+    NOKIA_GLYPH(0x10, 0x08, 0x08, 0x10, 0x08), // ~
+};
+
+#undef NOKIA_GLYPH
+
+#ifdef __AVR__
+// Adafruit_PCD8544 keeps its framebuffer in this global
+extern uint8_t pcd8544_buffer[];
+
+static uint8_t *frameBuffer(Adafruit_PCD8544 &display)
+{
+    return pcd8544_buffer;
+}
+#else
+static uint8_t *frameBuffer(Adafruit_PCD8544 &display)
+{
+    return display.getBuffer();
+}
+#endif
+
+// Draws width pre-rotated columns from PROGMEM with the top left corner at
+// (x, y) in rotated coordinates
+static void blit(Adafruit_PCD8544 &display, int16_t x, int16_t y, const uint8_t *columns, uint8_t width)
+{
+    if (display.getRotation() != NOKIA_PANEL_ROTATION)
+    {
+        for (uint8_t i = 0; i < width; i++)
+        {
+            uint8_t bits = pgm_read_byte(&columns[i]);
+            for (uint8_t b = 0; b < 8; b++)
+            {
+                if (bits & (1 << b))
+                {
+                    display.drawPixel(x + width - 1 - i, y + 7 - b, BLACK);
+                }
+            }
+        }
+        return;
+    }
+
+    // Panel coordinates of the bottom right corner, which is the top left
+    // of the rotated data
+    int16_t px = LCDWIDTH - x - width;
+    int16_t py = LCDHEIGHT - y - 8;
+    if (py <= -8 || py >= LCDHEIGHT)
+    {
+        return;
+    }
+    uint8_t *buffer = frameBuffer(display);
+    uint8_t bank = py < 0 ? 0 : py >> 3;
+    uint8_t *upper = buffer + bank * LCDWIDTH;
+    uint8_t *lower = bank + 1 < LCDHEIGHT / 8 ? upper + LCDWIDTH : nullptr;
+    for (uint8_t i = 0; i < width; i++, px++)
+    {
+        if (px < 0 || px >= LCDWIDTH)
+        {
+            continue;
+        }
+        uint8_t bits = pgm_read_byte(&columns[i]);
+        if (py < 0)
+        {
+            upper[px] |= bits >> -py;
+        }
+        else if ((py & 7) == 0)
+        {
+            upper[px] |= bits;
+        }
+        else
+        {
+            upper[px] |= bits << (py & 7);
+            if (lower)
+            {
+                lower[px] |= bits >> (8 - (py & 7));
+            }
+        }
+    }
+}
+
+// One character, laid out as Adafruit GFX would
+static void drawChar(Adafruit_PCD8544 &display, int16_t &x, int16_t &y, char c)
+{
+    if (c == '\n')
+    {
+        x = 0;
+        y += NOKIA_LINE_HEIGHT;
+        return;
+    }
+    if (c == '\r')
+    {
+        return;
+    }
+    if (x + NOKIA_CHAR_WIDTH > display.width())
+    {
+        x = 0;
+        y += NOKIA_LINE_HEIGHT;
+    }
+    if (c > FIRST_GLYPH && c <= LAST_GLYPH)
+    {
+        blit(display, x, y, &FONT[(c - FIRST_GLYPH) * GLYPH_COLUMNS], GLYPH_COLUMNS);
+    }
+    x += NOKIA_CHAR_WIDTH;
+}
+
+void nokiaText(Adafruit_PCD8544 &display, int16_t x, int16_t y, const char *text, size_t length)
+{
+    for (size_t i = 0; i < length && text[i]; i++)
+    {
+        drawChar(display, x, y, text[i]);
+    }
+    display.setCursor(x, y);
+}
+
+void nokiaText(Adafruit_PCD8544 &display, int16_t x, int16_t y, const __FlashStringHelper *text)
+{
+    const char *p = (const char *)text;
+    for (char c = pgm_read_byte(p); c; c = pgm_read_byte(++p))
+    {
+        drawChar(display, x, y, c);
+    }
+    display.setCursor(x, y);
+}
+
+void nokiaIcon(Adafruit_PCD8544 &display, int16_t x, int16_t y, const uint8_t *icon)
+{
+    blit(display, x, y, icon, NOKIA_ICON_SIZE);
+}
@@ -0,0 +1,133 @@
+#include "PowerManager.h"
+
+#include "Buttons.h"
+#include "ModemUart.h"
+#include "Watchdog.h"
+
+#ifdef __AVR__
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+
+// Kept by wiring.c; moved on by hand across a power-down sleep
+extern volatile unsigned long timer0_millis;
+#endif
+
+static const uint16_t TICK_MS[POWER_LEVEL_COUNT] = {100, 250, WATCHDOG_PERIOD_MS};
+
+static uint32_t lastActivityMs = 0;
+static bool deepSleep = true;
+static PowerStats stats;
+
+void powerActivity()
+{
+    lastActivityMs = millis();
+}
+
+uint8_t powerLevel()
+{
+    uint32_t idle = millis() - lastActivityMs;
+    if (idle >= POWER_DEEP_AFTER_MS)
+    {
+        return POWER_DEEP;
+    }
+    return idle >= POWER_DIM_AFTER_MS ? POWER_DIM : POWER_ACTIVE;
+}
+
+#ifdef __AVR__
+static void sleepOnce(uint8_t mode)
+{
+    set_sleep_mode(mode);
+    noInterrupts();
+    sleep_enable();
+    // The instruction after sei() always runs, so no wake-up is lost between
+    // enabling interrupts and sleeping
+    interrupts();
+    sleep_cpu();
+    sleep_disable();
+}
+
+static void sleepTick(uint8_t level)
+{
+    if (level == POWER_DEEP && deepSleep)
+    {
+        // The UART clocks stop in power-down, and the modem's TXD cannot wake
+        // the CPU, so the modem holds its output until the next tick. Bytes
+        // CTS is holding back wait in the buffer rather than delay the sleep
+        Serial.flush();
+        if (!modemUart.stalled())
+        {
+            modemUart.flush();
+        }
+        modemUart.holdReceive(true);
+        wdt_reset(); // Next watchdog interrupt a full period from now
+        sleepOnce(SLEEP_MODE_PWR_DOWN);
+        modemUart.holdReceive(false);
+        // A button wake cut the period short by an unknown amount
+        if (!buttonsPending())
+        {
+            noInterrupts();
+            timer0_millis += WATCHDOG_PERIOD_MS;
+            interrupts();
+        }
+        return;
+    }
+
+    // Timer0 wakes the CPU every millisecond, a button edge sooner
+    unsigned long start = millis();
+    while (millis() - start < TICK_MS[level] && !buttonsPending())
+    {
+        sleepOnce(SLEEP_MODE_IDLE);
+    }
+}
+#else
+// Native build: wait out the tick in short steps, so a button still ends it
+static void sleepTick(uint8_t level)
+{
+    unsigned long start = millis();
+    while (millis() - start < TICK_MS[level] && !buttonsPending())
+    {
+        delay(10);
+    }
+}
+#endif
+
+void powerSleep()
+{
+    uint8_t level = powerLevel();
+    unsigned long start = millis();
+    sleepTick(level);
+    stats.levelMs[level] += millis() - start;
+    if (level != POWER_ACTIVE && buttonsPending())
+    {
+        stats.buttonWakes++;
+    }
+}
+
+void powerSetDeepSleep(bool enabled)
+{
+    deepSleep = enabled;
+}
+
+bool powerDeepSleepEnabled()
+{
+    return deepSleep;
+}
+
+const PowerStats &powerStats()
+{
+    return stats;
+}
+
+const __FlashStringHelper *powerLevelName(uint8_t level)
+{
+    switch (level)
+    {
+    case POWER_ACTIVE:
+        return F("active");
+    case POWER_DIM:
+        return F("dim");
+    case POWER_DEEP:
+        return F("deep");
+    }
+    return F("unknown");
+}
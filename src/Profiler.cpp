@@ -0,0 +1,166 @@
+#include "Profiler.h"
+
+#if defined(PISO_PROFILE) && !(defined(PISO_BENCH) && defined(__AVR__))
+
+#ifdef __AVR__
+// Timer5 is claimed first by the Servo library on the Mega, so the profiler
+// uses Timer1 free-running and extends it to 32 bits with the overflow ISR.
+static volatile uint16_t timerOverflows = 0;
+#endif
+
+static ProfileSlot profileTable[PROF_PROBE_COUNT];
+static uint32_t lastLoopMark = 0;
+static uint32_t worstLoopGap = 0;
+static uint32_t loopCount = 0;
+
+static const char PROBE_NAME_0[] PROGMEM = "dualDisplay";
+static const char PROBE_NAME_1[] PROGMEM = "capacitive";
+static const char PROBE_NAME_2[] PROGMEM = "readPoints";
+static const char PROBE_NAME_3[] PROGMEM = "nokiaDisplay";
+static const char PROBE_NAME_4[] PROGMEM = "sonarPing";
+static const char PROBE_NAME_5[] PROGMEM = "writePoints";
+static const char PROBE_NAME_6[] PROGMEM = "deposit";
+static const char *const PROBE_NAMES[PROF_PROBE_COUNT] PROGMEM = {
+    PROBE_NAME_0,
+    PROBE_NAME_1,
+    PROBE_NAME_2,
+    PROBE_NAME_3,
+    PROBE_NAME_4,
+    PROBE_NAME_5,
+    PROBE_NAME_6};
+
+#ifdef __AVR__
+ISR(TIMER1_OVF_vect)
+{
+    timerOverflows++;
+}
+
+void profilerBegin()
+{
+    noInterrupts();
+    TCCR1A = 0;
+    TCCR1B = _BV(CS11); // Normal mode, clk/8
+    TCNT1 = 0;
+    TIFR1 = _BV(TOV1);
+    TIMSK1 = _BV(TOIE1);
+    interrupts();
+
+    profilerReset();
+}
+
+uint32_t profilerTicks()
+{
+    uint8_t oldSREG = SREG;
+    cli();
+    uint16_t low = TCNT1;
+    uint16_t high = timerOverflows;
+
+    // Overflow happened after interrupts were disabled but before the read
+    if ((TIFR1 & _BV(TOV1)) && low < 0x8000)
+    {
+        high++;
+    }
+    SREG = oldSREG;
+
+    return ((uint32_t)high << 16) | low;
+}
+#else
+// Native build: ticks come from the simulation clock at the same resolution
+void profilerBegin()
+{
+    profilerReset();
+}
+
+uint32_t profilerTicks()
+{
+    return micros() * PROFILE_TICKS_PER_US;
+}
+#endif
+
+void profilerRecord(uint8_t id, uint32_t ticks)
+{
+    if (id >= PROF_PROBE_COUNT)
+    {
+        return;
+    }
+
+    ProfileSlot &slot = profileTable[id];
+    slot.calls++;
+    slot.totalTicks += ticks;
+    if (ticks < slot.minTicks)
+    {
+        slot.minTicks = ticks;
+    }
+    if (ticks > slot.maxTicks)
+    {
+        slot.maxTicks = ticks;
+    }
+}
+
+void profilerLoopMark()
+{
+    uint32_t now = profilerTicks();
+
+    if (loopCount > 0)
+    {
+        uint32_t gap = now - lastLoopMark;
+        if (gap > worstLoopGap)
+        {
+            worstLoopGap = gap;
+        }
+    }
+
+    lastLoopMark = now;
+    loopCount++;
+}
+
+void profilerReset()
+{
+    for (uint8_t i = 0; i < PROF_PROBE_COUNT; i++)
+    {
+        profileTable[i].calls = 0;
+        profileTable[i].totalTicks = 0;
+        profileTable[i].minTicks = 0xFFFFFFFFUL;
+        profileTable[i].maxTicks = 0;
+    }
+    worstLoopGap = 0;
+    loopCount = 0;
+}
+
+bool profilerReport(Print &out, uint16_t line)
+{
+    if (line == 0)
+    {
+        out.println(F("=== Profile (us) ==="));
+        out.println(F("probe calls min avg max"));
+        return true;
+    }
+    if (line <= PROF_PROBE_COUNT)
+    {
+        const ProfileSlot &slot = profileTable[line - 1];
+        out.print((const __FlashStringHelper *)pgm_read_ptr(&PROBE_NAMES[line - 1]));
+        out.print(' ');
+        out.print(slot.calls);
+        out.print(' ');
+        if (slot.calls == 0)
+        {
+            out.println(F("- - -"));
+            return true;
+        }
+        out.print(slot.minTicks / PROFILE_TICKS_PER_US);
+        out.print(' ');
+        out.print(slot.totalTicks / slot.calls / PROFILE_TICKS_PER_US);
+        out.print(' ');
+        out.println(slot.maxTicks / PROFILE_TICKS_PER_US);
+        return true;
+    }
+
+    out.print(F("loops "));
+    out.print(loopCount);
+    out.print(F(" worst gap "));
+    out.print(worstLoopGap / PROFILE_TICKS_PER_US);
+    out.println(F("us"));
+    return false;
+}
+
+#endif
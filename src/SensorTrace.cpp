@@ -0,0 +1,175 @@
+#include "SensorTrace.h"
+
+// A full packet waits in the second buffer while the next one fills, so a
+// 48-byte packet has a whole fill period to drain through the 64-byte UART.
+struct TracePacket
+{
+    uint8_t bytes[TRACE_PACKET_SIZE];
+    uint8_t length; // Payload bytes used
+};
+
+bool traceEnabled = false;
+
+static Print *tracePort = nullptr;
+static TracePacket packets[2];
+static TracePacket *filling = &packets[0];
+static TracePacket *pending = nullptr;
+static uint8_t sequence = 0;
+static uint32_t lastSampleTime = 0;
+static int32_t lastValues[TRACE_CHANNEL_COUNT];
+static uint16_t droppedPackets = 0;
+
+static void startPacket(uint32_t now)
+{
+    filling->length = 0;
+    filling->bytes[0] = TRACE_SYNC_BYTE;
+    filling->bytes[2] = sequence++;
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        filling->bytes[3 + i] = now >> (8 * i);
+    }
+    lastSampleTime = now;
+    for (uint8_t i = 0; i < TRACE_CHANNEL_COUNT; i++)
+    {
+        lastValues[i] = 0;
+    }
+}
+
+static void sendPending()
+{
+    if (pending == nullptr || tracePort->availableForWrite() < TRACE_HEADER_SIZE + pending->length + 1)
+    {
+        return;
+    }
+
+    uint8_t size = TRACE_HEADER_SIZE + pending->length;
+    pending->bytes[1] = pending->length;
+
+    uint8_t checksum = 0;
+    for (uint8_t i = 1; i < size; i++)
+    {
+        checksum += pending->bytes[i];
+    }
+    pending->bytes[size] = checksum;
+
+    tracePort->write(pending->bytes, size + 1);
+    pending = nullptr;
+}
+
+// Hand the filling packet over for sending; drops it if the previous one
+// has still not left
+static void closePacket()
+{
+    if (filling->length == 0)
+    {
+        return;
+    }
+
+    sendPending();
+    if (pending != nullptr)
+    {
+        droppedPackets++;
+        filling->length = 0;
+        return;
+    }
+
+    pending = filling;
+    filling = (filling == &packets[0]) ? &packets[1] : &packets[0];
+    filling->length = 0;
+}
+
+void traceBegin(Print &port)
+{
+    tracePort = &port;
+}
+
+void traceStart()
+{
+    if (tracePort == nullptr)
+    {
+        return;
+    }
+
+    pending = nullptr;
+    droppedPackets = 0;
+    startPacket(millis());
+    traceEnabled = true;
+}
+
+void traceStop()
+{
+    closePacket();
+    traceEnabled = false;
+}
+
+void traceRecord(uint8_t channel, int32_t value)
+{
+    uint32_t now = millis();
+    uint32_t dt = now - lastSampleTime;
+    uint8_t encoded[8];
+    uint8_t size = 0;
+
+    if (filling->length == 0 || dt > 0xFFFF)
+    {
+        // A gap too long to encode ends the packet; its samples still go out
+        closePacket();
+        startPacket(now);
+        dt = 0;
+    }
+
+    if (dt < TRACE_DT_ESCAPE)
+    {
+        encoded[size++] = (channel << 5) | dt;
+    }
+    else
+    {
+        encoded[size++] = (channel << 5) | TRACE_DT_ESCAPE;
+        encoded[size++] = dt & 0xFF;
+        encoded[size++] = dt >> 8;
+    }
+
+    int32_t delta = value - lastValues[channel];
+    uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+    do
+    {
+        uint8_t b = zigzag & 0x7F;
+        zigzag >>= 7;
+        encoded[size++] = zigzag ? (b | 0x80) : b;
+    } while (zigzag);
+
+    if (filling->length + size > TRACE_PAYLOAD_SIZE)
+    {
+        closePacket();
+        traceRecord(channel, value);
+        return;
+    }
+
+    memcpy(&filling->bytes[TRACE_HEADER_SIZE + filling->length], encoded, size);
+    filling->length += size;
+    lastSampleTime = now;
+    lastValues[channel] = value;
+
+    sendPending();
+}
+
+void traceFlush()
+{
+    if (!traceEnabled)
+    {
+        return;
+    }
+
+    // Ship a partly filled packet once the previous one is out, so samples
+    // reach the host while the kiosk sits idle
+    sendPending();
+    if (pending == nullptr && filling->length > 0)
+    {
+        closePacket();
+        sendPending();
+    }
+}
+
+uint16_t traceDroppedPackets()
+{
+    return droppedPackets;
+}
@@ -0,0 +1,156 @@
+#include "Telemetry.h"
+
+#define TELEMETRY_FIELD_WIDTH(id, bytes, name) bytes,
+#define TELEMETRY_FIELD_NAME(id, bytes, name) static const char NAME_##id[] PROGMEM = name;
+#define TELEMETRY_FIELD_NAME_ENTRY(id, bytes, name) NAME_##id,
+
+static const uint8_t FIELD_BYTES[TELEMETRY_FIELD_COUNT] PROGMEM = {
+    TELEMETRY_FIELDS(TELEMETRY_FIELD_WIDTH)};
+
+TELEMETRY_FIELDS(TELEMETRY_FIELD_NAME)
+
+static const char *const FIELD_NAMES[TELEMETRY_FIELD_COUNT] PROGMEM = {
+    TELEMETRY_FIELDS(TELEMETRY_FIELD_NAME_ENTRY)};
+
+static const char BASE64[] PROGMEM = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static uint16_t crc16(const uint8_t *bytes, uint8_t length)
+{
+    uint16_t crc = 0xFFFF;
+    for (uint8_t i = 0; i < length; i++)
+    {
+        crc ^= (uint16_t)bytes[i] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static int8_t base64Value(char c)
+{
+    if (c >= 'A' && c <= 'Z')
+    {
+        return c - 'A';
+    }
+    if (c >= 'a' && c <= 'z')
+    {
+        return c - 'a' + 26;
+    }
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0' + 52;
+    }
+    return c == '+' ? 62 : c == '/' ? 63 : -1;
+}
+
+uint8_t telemetryFieldBytes(uint8_t field)
+{
+    return field < TELEMETRY_FIELD_COUNT ? pgm_read_byte(&FIELD_BYTES[field]) : 0;
+}
+
+const __FlashStringHelper *telemetryFieldName(uint8_t field)
+{
+    if (field >= TELEMETRY_FIELD_COUNT)
+    {
+        return F("unknown");
+    }
+    return (const __FlashStringHelper *)pgm_read_ptr(&FIELD_NAMES[field]);
+}
+
+uint8_t telemetryEncode(const TelemetryDigest &digest, char *text)
+{
+    uint8_t packed[TELEMETRY_PACKED_SIZE];
+    uint8_t size = 0;
+    for (uint8_t field = 0; field < TELEMETRY_FIELD_COUNT; field++)
+    {
+        uint8_t bytes = telemetryFieldBytes(field);
+        uint32_t limit = bytes >= 4 ? 0xFFFFFFFF : (1UL << (8 * bytes)) - 1;
+        uint32_t value = min(digest.values[field], limit);
+        for (uint8_t i = 0; i < bytes; i++)
+        {
+            packed[size++] = value >> (8 * i);
+        }
+    }
+    uint16_t crc = crc16(packed, size);
+    packed[size++] = crc & 0xFF;
+    packed[size++] = crc >> 8;
+
+    uint8_t length = 0;
+    text[length++] = 'P';
+    text[length++] = 'B';
+    text[length++] = '0' + TELEMETRY_VERSION;
+    text[length++] = ' ';
+    // Three bytes to four characters; the tail is left unpadded
+    for (uint8_t i = 0; i < size; i += 3)
+    {
+        uint32_t group = (uint32_t)packed[i] << 16;
+        if (i + 1 < size)
+        {
+            group |= (uint32_t)packed[i + 1] << 8;
+        }
+        if (i + 2 < size)
+        {
+            group |= packed[i + 2];
+        }
+        uint8_t characters = min(size - i, 3) + 1;
+        for (uint8_t c = 0; c < characters; c++)
+        {
+            text[length++] = pgm_read_byte(&BASE64[(group >> (18 - 6 * c)) & 0x3F]);
+        }
+    }
+    text[length] = '\0';
+    return length;
+}
+
+bool telemetryDecode(const char *text, size_t length, TelemetryDigest &digest)
+{
+    if (length != TELEMETRY_TEXT_LENGTH || text[0] != 'P' || text[1] != 'B' ||
+        text[2] != '0' + TELEMETRY_VERSION || text[3] != ' ')
+    {
+        return false;
+    }
+
+    uint8_t packed[TELEMETRY_PACKED_SIZE];
+    uint8_t size = 0;
+    uint32_t bits = 0;
+    uint8_t bitCount = 0;
+    for (size_t i = TELEMETRY_TAG_LENGTH; i < length; i++)
+    {
+        int8_t value = base64Value(text[i]);
+        if (value < 0)
+        {
+            return false;
+        }
+        bits = (bits << 6) | value;
+        bitCount += 6;
+        if (bitCount >= 8)
+        {
+            bitCount -= 8;
+            packed[size++] = bits >> bitCount;
+        }
+    }
+    if (size != TELEMETRY_PACKED_SIZE)
+    {
+        return false;
+    }
+    uint16_t crc = crc16(packed, size - 2);
+    if (packed[size - 2] != (crc & 0xFF) || packed[size - 1] != crc >> 8)
+    {
+        return false;
+    }
+
+    uint8_t offset = 0;
+    for (uint8_t field = 0; field < TELEMETRY_FIELD_COUNT; field++)
+    {
+        uint32_t value = 0;
+        uint8_t bytes = telemetryFieldBytes(field);
+        for (uint8_t i = 0; i < bytes; i++)
+        {
+            value |= (uint32_t)packed[offset++] << (8 * i);
+        }
+        digest.values[field] = value;
+    }
+    return true;
+}
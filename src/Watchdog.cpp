@@ -0,0 +1,243 @@
+#include "Watchdog.h"
+
+#include "Log.h"
+
+#ifdef __AVR__
+#include <avr/wdt.h>
+#endif
+
+const uint8_t WATCHDOG_MAX_DEPTH = 6;
+const uint16_t TRIP_MAGIC = 0x5744;
+
+// Longest time each task may go without a heartbeat, ms
+static const uint32_t TASK_BUDGETS[WATCHDOG_TASK_COUNT] PROGMEM = {
+    10000,  // WATCHDOG_BOOT, checked in between init steps
+    8000,   // WATCHDOG_LOOP, covers the maintenance sonar wait
+    120000, // WATCHDOG_ACTION, customer prompts time out well before this
+    15000,  // WATCHDOG_INTAKE
+    70000,  // WATCHDOG_PAYOUT, kicked per coin; outlasts COIN_DISPENSE_TIMEOUT
+    15000}; // WATCHDOG_MODEM
+
+static const char TASK_NAME_0[] PROGMEM = "boot";
+static const char TASK_NAME_1[] PROGMEM = "loop";
+static const char TASK_NAME_2[] PROGMEM = "action";
+static const char TASK_NAME_3[] PROGMEM = "intake";
+static const char TASK_NAME_4[] PROGMEM = "payout";
+static const char TASK_NAME_5[] PROGMEM = "modem";
+static const char *const TASK_NAMES[WATCHDOG_TASK_COUNT] PROGMEM = {
+    TASK_NAME_0,
+    TASK_NAME_1,
+    TASK_NAME_2,
+    TASK_NAME_3,
+    TASK_NAME_4,
+    TASK_NAME_5};
+
+static const char CAUSE_NAME_0[] PROGMEM = "power on";
+static const char CAUSE_NAME_1[] PROGMEM = "external";
+static const char CAUSE_NAME_2[] PROGMEM = "brown out";
+static const char CAUSE_NAME_3[] PROGMEM = "watchdog";
+static const char CAUSE_NAME_4[] PROGMEM = "unknown";
+static const char *const CAUSE_NAMES[] PROGMEM = {
+    CAUSE_NAME_0,
+    CAUSE_NAME_1,
+    CAUSE_NAME_2,
+    CAUSE_NAME_3,
+    CAUSE_NAME_4};
+
+// Task stack; the heartbeat time belongs to the innermost task
+static volatile uint8_t taskStack[WATCHDOG_MAX_DEPTH];
+static volatile uint8_t depth = 0;
+static volatile uint32_t lastKickMs = 0;
+static WatchdogStats stats;
+
+static uint32_t budgetOf(uint8_t task)
+{
+    return pgm_read_dword(&TASK_BUDGETS[task]);
+}
+
+#ifdef __AVR__
+// Written by the supervisor just before it lets the watchdog reset the MCU,
+// and kept by the reset since .noinit is not cleared at startup
+struct WatchdogTrip
+{
+    uint16_t magic;
+    uint8_t task;
+};
+static WatchdogTrip trip __attribute__((section(".noinit")));
+static uint8_t resetFlags __attribute__((section(".noinit")));
+// Trips since power-on; trusted while tripCountCheck is its complement
+static uint16_t tripCount __attribute__((section(".noinit")));
+static uint16_t tripCountCheck __attribute__((section(".noinit")));
+
+// Runs before the C runtime init. After a watchdog reset the watchdog stays
+// enabled at its shortest period, so it has to be stopped this early.
+void watchdogSaveResetFlags() __attribute__((naked, used, section(".init3")));
+void watchdogSaveResetFlags()
+{
+    resetFlags = MCUSR;
+    MCUSR = 0;
+    wdt_disable();
+}
+
+ISR(WDT_vect)
+{
+    uint8_t task = depth ? taskStack[depth - 1] : WATCHDOG_LOOP;
+    if (millis() - lastKickMs <= budgetOf(task))
+    {
+        // The timeout cleared WDIE; setting it again keeps interrupt mode
+        WDTCSR |= _BV(WDIE);
+        return;
+    }
+    trip.magic = TRIP_MAGIC;
+    trip.task = task;
+}
+
+static uint8_t readResetCause()
+{
+    // The trip record survives even if the bootloader cleared MCUSR
+    if (trip.magic == TRIP_MAGIC || (resetFlags & _BV(WDRF)))
+    {
+        return RESET_WATCHDOG;
+    }
+    if (resetFlags & _BV(BORF))
+    {
+        return RESET_BROWN_OUT;
+    }
+    if (resetFlags & _BV(EXTRF))
+    {
+        return RESET_EXTERNAL;
+    }
+    if (resetFlags & _BV(PORF))
+    {
+        return RESET_POWER_ON;
+    }
+    return RESET_UNKNOWN;
+}
+
+static void startHardware()
+{
+    stats.expiredTask = trip.magic == TRIP_MAGIC ? trip.task : WATCHDOG_TASK_COUNT;
+    if ((resetFlags & (_BV(PORF) | _BV(BORF))) || tripCountCheck != (uint16_t)~tripCount)
+    {
+        tripCount = 0;
+    }
+    if (trip.magic == TRIP_MAGIC)
+    {
+        tripCount++;
+    }
+    tripCountCheck = ~tripCount;
+    stats.lateKicks = tripCount;
+    trip.magic = 0;
+
+    // Interrupt and system reset mode, WATCHDOG_PERIOD_MS
+    noInterrupts();
+    wdt_reset();
+    WDTCSR = _BV(WDCE) | _BV(WDE);
+    WDTCSR = _BV(WDIE) | _BV(WDE) | _BV(WDP2) | _BV(WDP1);
+    interrupts();
+}
+#else
+// Native build: nothing resets, so late heartbeats are only counted
+static uint8_t readResetCause()
+{
+    return RESET_POWER_ON;
+}
+
+static void startHardware()
+{
+    stats.expiredTask = WATCHDOG_TASK_COUNT;
+}
+#endif
+
+// Starts a new heartbeat period, noting late ones
+static void heartbeat()
+{
+    uint32_t now = millis();
+    uint8_t task = taskStack[depth - 1];
+    uint32_t gap = now - lastKickMs;
+    if (gap > stats.worstGapMs[task])
+    {
+        stats.worstGapMs[task] = gap;
+    }
+    // On the Mega these are overruns the supervisor had not checked yet
+    if (gap > budgetOf(task))
+    {
+        stats.lateKicks++;
+        LOG_WARN(LOG_WATCHDOG_LATE, task, gap);
+    }
+    noInterrupts();
+    lastKickMs = now;
+    interrupts();
+}
+
+void watchdogBegin()
+{
+    stats.resetCause = readResetCause();
+    depth = 0;
+    watchdogEnter(WATCHDOG_BOOT);
+    startHardware();
+}
+
+void watchdogEnter(uint8_t task)
+{
+    if (depth > 0)
+    {
+        heartbeat(); // The outer task got this far
+    }
+    noInterrupts();
+    if (depth < WATCHDOG_MAX_DEPTH)
+    {
+        taskStack[depth++] = task;
+    }
+    lastKickMs = millis();
+    interrupts();
+}
+
+void watchdogLeave(uint8_t task)
+{
+    if (depth == 0 || taskStack[depth - 1] != task)
+    {
+        return;
+    }
+    heartbeat();
+    noInterrupts();
+    depth--;
+    lastKickMs = millis();
+    interrupts();
+}
+
+void watchdogKick(uint8_t task)
+{
+    if (depth > 0 && taskStack[depth - 1] == task)
+    {
+        heartbeat();
+    }
+}
+
+uint8_t watchdogCurrentTask()
+{
+    return depth ? taskStack[depth - 1] : WATCHDOG_TASK_COUNT;
+}
+
+const WatchdogStats &watchdogStats()
+{
+    return stats;
+}
+
+const __FlashStringHelper *watchdogTaskName(uint8_t task)
+{
+    if (task >= WATCHDOG_TASK_COUNT)
+    {
+        return F("none");
+    }
+    return (const __FlashStringHelper *)pgm_read_ptr(&TASK_NAMES[task]);
+}
+
+const __FlashStringHelper *resetCauseName(uint8_t cause)
+{
+    if (cause > RESET_UNKNOWN)
+    {
+        return F("unknown");
+    }
+    return (const __FlashStringHelper *)pgm_read_ptr(&CAUSE_NAMES[cause]);
+}
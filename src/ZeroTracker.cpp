@@ -0,0 +1,113 @@
+#include "ZeroTracker.h"
+
+#include "LoadCell.h"
+
+const uint8_t WINDOW_SAMPLES = 16;
+const unsigned long SETTLE_MS = 5000; // After the platform was last disturbed
+const int16_t STEADY_BAND_DG = 5;     // Max - min within a window
+const int16_t CAPTURE_DG = 50;        // Farther from zero is a load, not drift
+const int16_t MAX_STEP_DG = 2;        // Largest correction per window
+
+static int32_t steadyBand;
+static int32_t deadband; // Noise in the mean, not worth an adjustment
+static int32_t captureRange;
+static int32_t maxStep;
+
+static int32_t windowSum;
+static int32_t windowLow;
+static int32_t windowHigh;
+static uint8_t windowSamples;
+static unsigned long holdTime;
+static ZeroTrackStats stats;
+
+static void clearWindow()
+{
+    windowSum = 0;
+    windowSamples = 0;
+}
+
+static void updateLimits()
+{
+    steadyBand = loadCellNetFor(STEADY_BAND_DG);
+    captureRange = loadCellNetFor(CAPTURE_DG);
+    maxStep = max(loadCellNetFor(MAX_STEP_DG), 1L);
+    deadband = steadyBand / 8;
+}
+
+void zeroTrackBegin()
+{
+    updateLimits();
+    zeroTrackHold();
+}
+
+void zeroTrackCalibrationChanged()
+{
+    updateLimits();
+    zeroTrackHold(); // The platform was just loaded
+}
+
+void zeroTrackRebase()
+{
+    stats.drift = 0;
+    stats.lastError = 0;
+    zeroTrackHold();
+}
+
+void zeroTrackHold()
+{
+    clearWindow();
+    holdTime = millis();
+}
+
+int32_t zeroTrackSample(int32_t countsFromTare)
+{
+    if (millis() - holdTime < SETTLE_MS)
+    {
+        return 0;
+    }
+
+    if (windowSamples == 0 || countsFromTare < windowLow)
+    {
+        windowLow = countsFromTare;
+    }
+    if (windowSamples == 0 || countsFromTare > windowHigh)
+    {
+        windowHigh = countsFromTare;
+    }
+    windowSum += countsFromTare;
+    if (++windowSamples < WINDOW_SAMPLES)
+    {
+        return 0;
+    }
+
+    int32_t mean = windowSum / WINDOW_SAMPLES;
+    int32_t spread = windowHigh - windowLow;
+    clearWindow();
+
+    if (spread > steadyBand)
+    {
+        stats.unsteadyWindows++;
+        return 0;
+    }
+    stats.lastError = mean;
+    if (abs(mean) > captureRange)
+    {
+        stats.outOfRange++;
+        return 0;
+    }
+
+    if (abs(mean) <= deadband)
+    {
+        return 0;
+    }
+    int32_t step = constrain(mean, -maxStep, maxStep);
+    stats.drift += step;
+    stats.adjustments++;
+    stats.lastAdjustMs = millis();
+    return step;
+}
+
+const ZeroTrackStats &zeroTrackStats()
+{
+    return stats;
+}
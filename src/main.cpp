@@ -1,36 +1,39 @@
-#include <Arduino.h>
-#include <LiquidCrystal_I2C.h>
-#include <Servo.h>
-#include <MFRC522.h>
-#include <SoftwareSerial.h>
-#include <NewPing.h>
-#include <HX711.h>
-#include <Adafruit_GFX.h>
-#include <Adafruit_PCD8544.h>
+#include "Hal.h"
+#include "PinMap.h"
+#include "Profiler.h"
+#include "Journal.h"
+#include "DiagConsole.h"
+#include "Log.h"
+#include "SensorTrace.h"
+#include "BottleClassifier.h"
+#include "ClassifierModel.h"
+#include "LoadCell.h"
+#include "ZeroTracker.h"
+#include "CapacitiveBaseline.h"
+#include "Watchdog.h"
+#include "LastState.h"
+#include "PowerManager.h"
+#include "MemoryStats.h"
+#include "NokiaText.h"
+#include "ModemUart.h"
+#include "AtParser.h"
+#include "FillForecast.h"
+#include "Telemetry.h"
+#include "Buttons.h"
 
 // Constant Variables
 //const int POINTS_BLOCK = 4;
 const int MAX_DISTANCE = 20;
 const int ITERATIONS = 5;
-const float MAX_WEIGHT = 500.00;
-
-// Constant Var Pin Definitions
-const int upButton = 40;
-const int downButton = 41;
-const int selectButton = 42;
-// Servo
-const int servoPin1 = 36;
-const int servoPin2 = 37;
+
 // Sensors
 
 // Capacitive sensor configuration for analog reading
-const int CAPACITIVE_SENSOR_PIN = A0; // Analog pin for capacitive sensor
-const int DETECTION_THRESHOLD = 650;  // Threshold for bottle detection (adjust if needed)
-const int NO_BOTTLE_THRESHOLD = 500;  // Threshold for confirming bottle removal
+// Detection thresholds come from ClassifierModel.h
 const int HYSTERESIS = 50;            // Prevent flickering
 const int SAMPLE_COUNT = 5;           // Number of readings to average
 const int DEBOUNCE_MS = 50;           // Minimum time between readings
-const int inductiveSensorPin = 15;
+const int STRONG_SIGNAL_MARGIN = 100; // Above detection, no confirming read
 
 // Global state for the capacitive sensor
 
@@ -49,45 +52,32 @@ struct CapacitiveSensorState
     }
 };
 CapacitiveSensorState capacitiveSensor;
-// Ultasonic Sensor
-const int TRIGGER_PIN = 22;
-const int ECHO_PIN = 23;
-// RGB LED
-const int PIN_RED = 32;
-const int PIN_GREEN = 33;
-const int PIN_BLUE = 34;
-// RFID
-const int SS_PIN = 53;
-const int RST_PIN = 49;
-// SIM Module
-const int SIM_RX = 10;
-const int SIM_TX = 11;
-// Load Cell
-const int LOADCELL_DOUT_PIN = 44;
-const int LOADCELL_SCK_PIN = 45;
-const float CALIBRATION_FACTOR = -350.82; // Fixed calibration factor
-const float MIN_ACCEPTABLE_WEIGHT = 10.0; // Minimum weight in grams
-const float MAX_ACCEPTABLE_WEIGHT = 65.0; // Maximum weight in grams
-const int READINGS_COUNT = 5;             // Number of readings to average
-const float STABILITY_THRESHOLD = 1.0;    // Maximum variation between readings
-const int READING_DELAY = 100;
-// LDR & LED
-const int LDR_PIN = 46;
-const int LED_INLET_PIN = 47;
+// Fixed thresholds, tunable from the diagnostics console. They apply until
+// the adaptive baseline has settled (see CapacitiveBaseline.h)
+int detectionThreshold = DETECTION_THRESHOLD;
+int noBottleThreshold = NO_BOTTLE_THRESHOLD;
+// Load Cell (calibration table in EEPROM, see LoadCell.h)
+const uint8_t CALIBRATION_READINGS = 10; // Averaged per calibration point
+const unsigned long CALIBRATION_TIMEOUT = 3000;
+const uint8_t TARE_READINGS = 10;    // Averaged by the console tare, as scale.tare() does
+const unsigned long TARE_TIMEOUT = 3000;
+// Verification (acceptance limits live in the BottleClassifier model)
+const int VERIFY_TIMEOUT = 3000;    // Give up collecting samples after this
+const int VERIFY_SAMPLE_DELAY = 50; // Between sampling passes
+// Batch deposit sessions
+const unsigned long BATCH_IDLE_TIMEOUT = 10000; // No bottle for this long ends the session
+const unsigned long BATCH_HAND_WARNING = 1500;  // Shorter than single deposits, users are in the rhythm
+const unsigned long BATCH_DROP_TIMEOUT = 3000;  // Flap closes after this even if the platform reads full
+const unsigned long BATCH_DROP_MARGIN = 300;    // Flap stays open this long after the platform empties
+// Tap-first card sessions
+const unsigned long CARD_RETRY_INTERVAL = 500; // Between background writes while the card is away
+const unsigned long CARD_SAVE_TIMEOUT = 10000; // Final tap to save outstanding credit
+const unsigned long IDLE_BIN_CHECK_INTERVAL = 60000; // Sonar while dim or dark; the bin cannot fill at idle
+const int RFID_FIELD_SETTLE = 5; // ms a card needs in the field before it answers
 // Coin Hopper
-const int coinHopperSensor_PIN = 28;
-const int relayPin = 30;
-const int COIN_DISPENSE_TIMEOUT = 60000; // 60 second timeout
+const unsigned long COIN_DISPENSE_TIMEOUT = 60000; // 60 second timeout
 const int SENSOR_DEBOUNCE_DELAY = 10;    // 10ms debounce delay
 
-// Nokia 5110 LCD
-const int PIN_RST = 3; // RST (with 10kΩ resistor)    YELLOW
-const int PIN_CE = 4;  // CE (with 1kΩ resistor)      ORANGE
-const int PIN_DC = 5;  // DC (with 10kΩ resistor)     GREEN
-const int PIN_DIN = 6; // DIN (with 10kΩ resistor)    BLUE
-const int PIN_CLK = 7; // CLK (with 10kΩ resistor)    PURPLE
-const int PIN_BL = 13; // Backlight with 330Ω resistor   WHITE
-
 // For setting Nokia Display
 const int MIN_CONTRAST = 0;
 const int MAX_CONTRAST = 127;
@@ -96,8 +86,8 @@ const int MIN_BRIGHTNESS = 0;
 const int MAX_BRIGHTNESS = 255;
 const int BRIGHTNESS_STEP = 10;
 
-// Custom icons for Nokia display
-static const unsigned char PROGMEM BOTTLE_ICON[] = {
+// Custom icons for Nokia display, rows as drawn
+static const unsigned char PROGMEM BOTTLE_ICON[] = {NOKIA_ICON(
     0b00011000,
     0b00111100,
     0b00111100,
@@ -105,9 +95,9 @@ static const unsigned char PROGMEM BOTTLE_ICON[] = {
     0b00111100,
     0b01111110,
     0b01111110,
-    0b00111100};
+    0b00111100)};
 
-static const unsigned char PROGMEM COIN_ICON[] = {
+static const unsigned char PROGMEM COIN_ICON[] = {NOKIA_ICON(
     0b00111100,
     0b01111110,
     0b11100111,
@@ -115,9 +105,9 @@ static const unsigned char PROGMEM COIN_ICON[] = {
     0b11000011,
     0b11100111,
     0b01111110,
-    0b00111100};
+    0b00111100)};
 
-static const unsigned char PROGMEM CARD_ICON[] = {
+static const unsigned char PROGMEM CARD_ICON[] = {NOKIA_ICON(
     0b11111111,
     0b10000001,
     0b10111101,
@@ -125,9 +115,9 @@ static const unsigned char PROGMEM CARD_ICON[] = {
     0b10111101,
     0b10000001,
     0b11111111,
-    0b00000000};
+    0b00000000)};
 
-static const unsigned char PROGMEM ERROR_ICON[] = {
+static const unsigned char PROGMEM ERROR_ICON[] = {NOKIA_ICON(
     0b00111100,
     0b01000010,
     0b10100101,
@@ -135,8 +125,8 @@ static const unsigned char PROGMEM ERROR_ICON[] = {
     0b10011001,
     0b10100101,
     0b01000010,
-    0b00111100};
-static const unsigned char PROGMEM SETTINGS_ICON[] = {
+    0b00111100)};
+static const unsigned char PROGMEM SETTINGS_ICON[] = {NOKIA_ICON(
     0b00011000,
     0b00111100,
     0b11111111,
@@ -144,7 +134,7 @@ static const unsigned char PROGMEM SETTINGS_ICON[] = {
     0b11100111,
     0b11111111,
     0b00111100,
-    0b00011000};
+    0b00011000)};
 
 // Global Variables
 volatile int coinCount = 0;
@@ -162,8 +152,26 @@ bool lastSensorState = HIGH;
 bool isObjectInside = false;
 int totalPoints = 0;
 int pointsToRedeem = 0;
+bool tapFirstEnabled = true; // A card tap at the menu starts a card session
+uint8_t appliedPowerLevel = POWER_ACTIVE;
+// Tap-first card session: credit is written to the card after each bottle
+struct CardSession
+{
+    bool active;
+    bool selected;     // Card still selected and authenticated
+    byte uid[10];
+    byte uidSize;
+    int written;       // Balance last written to (or read from) the card
+    int target;        // Balance including this session's bottles
+    unsigned long lastAttempt;
+} cardSession;
 bool maintenanceMode = false;
 String maintainerNum = "+639932960906";
+#ifndef KIOSK_UNIT_ID
+#define KIOSK_UNIT_ID 0 // Per kiosk, from build_flags
+#endif
+uint8_t digestIntervalHours = 24; // Scheduled telemetry digest, 0 for on request only
+bool digestRequested = false;     // DIGEST by SMS from the maintainer
 const int MAX_RFID_INIT_ATTEMPTS = 3;
 const int RFID_RESET_DELAY = 50;
 const byte POINTS_BLOCK = 1;      // Data block for storing points
@@ -174,7 +182,6 @@ const int MAX_POINTS = 999;       // Maximum allowed points
 String previousLcdLine1;
 String previousLcdLine2;
 String previousNokiaMessage;
-const bool DEBUG_SENSORS = true;       // Set to true to enable sensor debugging
 const int SENSOR_STABILIZE_TIME = 500; // Time to wait for sensor readings to stabilize
 
 // Object instantations
@@ -183,12 +190,19 @@ LiquidCrystal_I2C lcd(0x27, 16, 2);
 Servo servo1, servo2;
 MFRC522 mfrc522(SS_PIN, RST_PIN);
 NewPing sonar(TRIGGER_PIN, ECHO_PIN, MAX_DISTANCE);
-SoftwareSerial sim800lv2(10, 11);
+ModemTransport *modemLink = &modemUart; // The native runner may swap in a ModemPty
+const unsigned long MODEM_COMMAND_TIMEOUT = 2000;
+const unsigned long MODEM_PROMPT_TIMEOUT = 5000;
+const unsigned long MODEM_SEND_TIMEOUT = 20000; // Network acknowledgement of AT+CMGS
 HX711 scale;
 MFRC522::MIFARE_Key key;
 
 // Function Prototypes
 void depositAction();
+void batchDepositAction();
+void cardSessionAction();
+int runIntakeSession(int &rejected);
+bool cardSessionService();
 void redeemAction();
 bool readCapacitiveSensorData();
 int readInductiveSensorData();
@@ -196,33 +210,45 @@ void rotateServo(Servo &servo, int angle);
 void openCloseBinLid(int lidNum, bool toOpen);
 void waitToRemoveObject();
 void waitForObjectPresence();
+bool confirmObjectPresence();
 bool verifyObject();
+bool sampleObject(ClassifierResult &result);
+void showRejection(const ClassifierResult &result);
+void handBackObject();
 void storePointsAction();
 void insertAnotherBottleAction();
 void redeemPointsAction();
 void setUpRFID();
 bool detectCard();
-bool writePoints(int points);
+bool writePoints(int points, bool authenticate = true);
 int readPoints();
 void sendSMS(String message);
 bool isBinFull();
+void trackBinFill();
+void collectTelemetry(TelemetryDigest &digest);
+void sendTelemetryDigest();
 void handleMaintenanceMode();
-bool isWeightAcceptable();
 int readLDRSensorData();
 void controlLedInlet(bool isOn);
-bool isObjectClear();
 void updateMenuDisplay();
 void navigateMenu(int direction);
 void selectMenuItem();
+void trackScaleZero();
 void pulseColor(int redValue, int greenValue, int blueValue);
 void ledStatusCode(int errorCode);
 void delayWithMsg(unsigned long duration, String message1, String message2, int statusCode);
 
 MFRC522::StatusCode authenticateBlock(int blockNumber);
 void calibrateLoadCell();
-void dispenseCoin(int count);
+void dispenseCoin(int count, bool resumed = false);
+void saveCredit(int points);
+void savePayout(int count, int done, bool resumed = false);
+void resumeLastState(const LastState &last, bool weighPlatform);
+void applyPowerLevel(uint8_t level);
+bool detectMenuCard();
 
 void displayNokiaStatus(const String &message, const unsigned char *icon = nullptr);
+void pushNokiaFrame();
 void updateMenuDisplay();
 void displayMainMenu();
 void settingsAction();
@@ -249,6 +275,7 @@ struct Menu
 // Menu definitions
 MenuItem mainMenuItems[] = {
     {"Deposit", depositAction},
+    {"Batch", batchDepositAction},
     {"Redeem", redeemAction},
     {"Settings", settingsAction}};
 
@@ -264,7 +291,7 @@ MenuItem postDepositMenuItems[] = {
 };
 
 // Menu structures - KEEP THESE
-Menu mainMenu = {mainMenuItems, 3, 0, "Main Menu"};
+Menu mainMenu = {mainMenuItems, 4, 0, "Main Menu"};
 Menu settingsMenu = {settingsMenuItems, 3, 0, "Settings"};
 Menu postDepositMenu = {postDepositMenuItems, 3, 0, "Options"};
 Menu *currentMenu = &mainMenu;
@@ -276,6 +303,18 @@ struct DisplayState
     int contrast;
     byte backlight;
 } displayState;
+// Running counters shown by the diagnostics console
+struct KioskStats
+{
+    unsigned long bottlesAccepted;
+    unsigned long bottlesRejected;
+    unsigned long coinsDispensed;
+    unsigned long cardTaps;
+    uint16_t rejectedFor[CLASSIFIER_REASON_COUNT];
+    uint16_t dispenseFaults;
+    uint16_t rfidErrors;
+    uint16_t binFullEvents;
+} kioskStats;
 
 // Function Implementation
 void postDepositRedeemAction()
@@ -296,16 +335,16 @@ void postDepositRedeemAction()
     delayWithMsg(2000, "Redeeming " + String(totalPoints), "Hold SELECT to cancel", 102);
     
     // Check if user wants to cancel (holding select button)
-    unsigned long startTime = millis();
-    while (digitalRead(selectButton) == LOW) {
-        if (millis() - startTime > 2000) {  // 2-second hold to cancel
+    ButtonEvent event;
+    do {
+        if (buttonNext(event) && event.button == BUTTON_SELECT && event.type == BUTTON_LONG_PRESS) {
             delayWithMsg(2000, "Redemption", "Cancelled", 404);
             currentMenu = &mainMenu;
             updateMenuDisplay();
             return;
         }
-        delay(50);
-    }
+        delay(10);
+    } while (buttonHeld(BUTTON_SELECT));
 
     // Proceed with redemption
     int pointsToDispense = totalPoints;
@@ -351,7 +390,7 @@ void setupCoinHopper()
 {
     // Configure pins with proper pullup/pulldown
     pinMode(relayPin, OUTPUT);
-    digitalWrite(relayPin, LOW); // Ensure relay starts OFF
+    relayPin.low(); // Ensure relay starts OFF
 
     pinMode(coinHopperSensor_PIN, INPUT_PULLUP);
 
@@ -370,9 +409,9 @@ bool updateSensorState(bool newState)
 bool initializeRFID()
 {
     // Power cycle the RFID module by toggling RST pin
-    digitalWrite(RST_PIN, LOW);
+    RST_PIN.low();
     delay(RFID_RESET_DELAY);
-    digitalWrite(RST_PIN, HIGH);
+    RST_PIN.high();
     delay(RFID_RESET_DELAY);
 
     int attempts = 0;
@@ -460,35 +499,42 @@ void adjustContrastAction()
         currentContrast = MAX_CONTRAST;
 
     bool adjusting = true;
-    unsigned long lastButtonPress = 0;
+    bool changed = true;
 
     nokia.clearDisplay();
     nokia.drawRect(0, 0, 84, 10, BLACK);
-    nokia.setCursor(10, 1);
-    nokia.print("Contrast");
+    nokiaText(nokia, 10, 1, F("Contrast"));
     ;
     ;
     nokia.drawLine(0, 12, 84, 12, BLACK);
 
     while (adjusting)
     {
-        if (millis() - lastButtonPress > 100)
+        ButtonEvent event;
+        while (buttonNext(event))
         {
-            if (digitalRead(upButton) == LOW && currentContrast < MAX_CONTRAST)
+            if (event.type != BUTTON_PRESS && event.type != BUTTON_REPEAT)
+            {
+                continue;
+            }
+            if (event.button == BUTTON_UP && currentContrast < MAX_CONTRAST)
             {
                 currentContrast += CONTRAST_STEP;
-                lastButtonPress = millis();
+                changed = true;
             }
-            if (digitalRead(downButton) == LOW && currentContrast > MIN_CONTRAST)
+            if (event.button == BUTTON_DOWN && currentContrast > MIN_CONTRAST)
             {
                 currentContrast -= CONTRAST_STEP;
-                lastButtonPress = millis();
+                changed = true;
             }
-            if (digitalRead(selectButton) == LOW)
+            if (event.button == BUTTON_SELECT && event.type == BUTTON_PRESS)
             {
                 adjusting = false;
-                lastButtonPress = millis();
             }
+        }
+        if (changed)
+        {
+            changed = false;
 
             // Update contrast
             nokia.setContrast(currentContrast);
@@ -497,8 +543,7 @@ void adjustContrastAction()
             // Update display
             nokia.clearDisplay();
             nokia.drawRect(0, 0, 84, 10, BLACK);
-            nokia.setCursor(10, 1);
-            nokia.print("Contrast");
+            nokiaText(nokia, 10, 1, F("Contrast"));
             nokia.drawLine(0, 12, 84, 12, BLACK);
 
             // Draw contrast bar
@@ -506,11 +551,10 @@ void adjustContrastAction()
             nokia.drawRect(10, 25, 64, 8, BLACK);
             nokia.fillRect(10, 25, barWidth, 8, BLACK);
 
-            nokia.setCursor(10, 40);
-            nokia.print("Value: ");
+            nokiaText(nokia, 10, 40, F("Value: "));
             nokia.print(currentContrast);
 
-            nokia.display();
+            pushNokiaFrame();
 
             // Update LCD display
             lcd.clear();
@@ -519,7 +563,8 @@ void adjustContrastAction()
             lcd.print("Value: ");
             lcd.print(currentContrast);
         }
-        delay(50);
+        watchdogKick(WATCHDOG_ACTION);
+        delay(10);
     }
 
     // Save contrast value to EEPROM here if needed
@@ -535,33 +580,40 @@ void adjustBrightnessAction()
         currentBrightness = MAX_BRIGHTNESS;
 
     bool adjusting = true;
-    unsigned long lastButtonPress = 0;
+    bool changed = true;
 
     nokia.clearDisplay();
     nokia.drawRect(0, 0, 84, 10, BLACK);
-    nokia.setCursor(8, 1);
-    nokia.print("Brightness");
+    nokiaText(nokia, 8, 1, F("Brightness"));
     nokia.drawLine(0, 12, 84, 12, BLACK);
 
     while (adjusting)
     {
-        if (millis() - lastButtonPress > 100)
+        ButtonEvent event;
+        while (buttonNext(event))
         {
-            if (digitalRead(upButton) == LOW && currentBrightness < MAX_BRIGHTNESS)
+            if (event.type != BUTTON_PRESS && event.type != BUTTON_REPEAT)
+            {
+                continue;
+            }
+            if (event.button == BUTTON_UP && currentBrightness < MAX_BRIGHTNESS)
             {
                 currentBrightness += BRIGHTNESS_STEP;
-                lastButtonPress = millis();
+                changed = true;
             }
-            if (digitalRead(downButton) == LOW && currentBrightness > MIN_BRIGHTNESS)
+            if (event.button == BUTTON_DOWN && currentBrightness > MIN_BRIGHTNESS)
             {
                 currentBrightness -= BRIGHTNESS_STEP;
-                lastButtonPress = millis();
+                changed = true;
             }
-            if (digitalRead(selectButton) == LOW)
+            if (event.button == BUTTON_SELECT && event.type == BUTTON_PRESS)
             {
                 adjusting = false;
-                lastButtonPress = millis();
             }
+        }
+        if (changed)
+        {
+            changed = false;
 
             // Update brightness
             analogWrite(PIN_BL, currentBrightness);
@@ -570,8 +622,7 @@ void adjustBrightnessAction()
             // Update display
             nokia.clearDisplay();
             nokia.drawRect(0, 0, 84, 10, BLACK);
-            nokia.setCursor(8, 1);
-            nokia.print("Brightness");
+            nokiaText(nokia, 8, 1, F("Brightness"));
             nokia.drawLine(0, 12, 84, 12, BLACK);
 
             // Draw brightness bar
@@ -579,11 +630,10 @@ void adjustBrightnessAction()
             nokia.drawRect(10, 25, 64, 8, BLACK);
             nokia.fillRect(10, 25, barWidth, 8, BLACK);
 
-            nokia.setCursor(10, 40);
-            nokia.print("Value: ");
+            nokiaText(nokia, 10, 40, F("Value: "));
             nokia.print(currentBrightness);
 
-            nokia.display();
+            pushNokiaFrame();
 
             // Update LCD display
             lcd.clear();
@@ -592,7 +642,8 @@ void adjustBrightnessAction()
             lcd.print("Value: ");
             lcd.print(currentBrightness);
         }
-        delay(50);
+        watchdogKick(WATCHDOG_ACTION);
+        delay(10);
     }
 
     // Save brightness value to EEPROM here if needed
@@ -613,24 +664,23 @@ void displayMainMenu()
     // Nokia menu display
     nokia.clearDisplay();
     nokia.drawRect(0, 0, 84, 10, BLACK);
-    nokia.setCursor(14, 1);
-    nokia.print("Main Menu");
+    nokiaText(nokia, 14, 1, F("Main Menu"));
     nokia.drawLine(0, 12, 84, 12, BLACK);
 
-    // Draw menu items with icons
-    nokia.setCursor(2, 15);
-    nokia.print("> Deposit");
-    nokia.drawBitmap(70, 13, BOTTLE_ICON, 8, 8, BLACK);
+    // Draw menu items with icons, four rows fit at a 9 pixel pitch
+    nokiaText(nokia, 2, 14, F("> Deposit"));
+    nokiaIcon(nokia, 70, 13, BOTTLE_ICON);
 
-    nokia.setCursor(2, 25);
-    nokia.print("  Redeem");
-    nokia.drawBitmap(70, 23, COIN_ICON, 8, 8, BLACK);
+    nokiaText(nokia, 2, 23, F("  Batch"));
+    nokiaIcon(nokia, 70, 22, BOTTLE_ICON);
 
-    nokia.setCursor(2, 35);
-    nokia.print("  Settings");
-    nokia.drawBitmap(70, 33, SETTINGS_ICON, 8, 8, BLACK);
+    nokiaText(nokia, 2, 32, F("  Redeem"));
+    nokiaIcon(nokia, 70, 31, COIN_ICON);
 
-    nokia.display();
+    nokiaText(nokia, 2, 41, F("  Settings"));
+    nokiaIcon(nokia, 70, 40, SETTINGS_ICON);
+
+    pushNokiaFrame();
 }
 bool setupNokiaDisplay()
 {
@@ -651,13 +701,18 @@ bool setupNokiaDisplay()
 
     // Display startup screen
     nokia.drawRect(0, 0, 84, 10, BLACK);
-    nokia.setCursor(14, 1);
-    nokia.println("PISO-BOTE");
+    nokiaText(nokia, 14, 1, F("PISO-BOTE"));
     nokia.drawLine(0, 12, 84, 12, BLACK);
-    nokia.display();
+    pushNokiaFrame();
 
     return true;
 }
+// Push the framebuffer to the Nokia display
+void pushNokiaFrame()
+{
+    PROFILE_SCOPE(PROF_NOKIA_DISPLAY);
+    nokia.display();
+}
 // Replace setPower with display enabling/disabling
 void setDisplayPower(bool nokiaOn, bool lcdOn)
 {
@@ -673,7 +728,7 @@ void setDisplayPower(bool nokiaOn, bool lcdOn)
         else
         {
             nokia.clearDisplay();
-            nokia.display();
+            pushNokiaFrame();
             analogWrite(PIN_BL, LOW);
         }
         displayState.nokiaDisplayActive = nokiaOn;
@@ -698,21 +753,16 @@ void displayNokiaStatus(const String &message, const unsigned char *icon)
 
     if (icon != nullptr)
     {
-        nokia.drawBitmap(38, 8, icon, 8, 8, BLACK);
+        nokiaIcon(nokia, 38, 8, icon);
         nokia.drawLine(0, 20, 84, 20, BLACK);
-        nokia.setCursor(0, 25);
-    }
-    else
-    {
-        nokia.setCursor(0, 15);
     }
-
-    nokia.print(message);
-    nokia.display();
+    nokiaText(nokia, 0, icon ? 25 : 15, message.c_str());
+    pushNokiaFrame();
 }
 // Modified updateDualDisplayStatus function
 void updateDualDisplayStatus(const String &message1, const String &message2, const unsigned char *icon = nullptr)
 {
+    PROFILE_SCOPE(PROF_DUAL_DISPLAY);
     const int LCD_WIDTH = 16;
     String lcd1 = message1.length() > LCD_WIDTH ? message1.substring(0, LCD_WIDTH) : message1;
     String lcd2 = message2.length() > LCD_WIDTH ? message2.substring(0, LCD_WIDTH) : message2;
@@ -742,13 +792,8 @@ void updateDualDisplayStatus(const String &message1, const String &message2, con
 
         if (icon != nullptr)
         {
-            nokia.drawBitmap(38, 8, icon, 8, 8, BLACK);
+            nokiaIcon(nokia, 38, 8, icon);
             nokia.drawLine(0, 20, 84, 20, BLACK);
-            nokia.setCursor(0, 25);
-        }
-        else
-        {
-            nokia.setCursor(0, 15);
         }
 
         // Word wrapping implementation
@@ -767,8 +812,7 @@ void updateDualDisplayStatus(const String &message1, const String &message2, con
                     endPos = lastSpace;
                 }
             }
-            nokia.setCursor(0, currentY);
-            nokia.print(message1.substring(startPos, endPos));
+            nokiaText(nokia, 0, currentY, message1.c_str() + startPos, endPos - startPos);
             startPos = endPos + 1;
             currentY += 8;
         }
@@ -789,14 +833,13 @@ void updateDualDisplayStatus(const String &message1, const String &message2, con
                         endPos = lastSpace;
                     }
                 }
-                nokia.setCursor(0, currentY);
-                nokia.print(message2.substring(startPos, endPos));
+                nokiaText(nokia, 0, currentY, message2.c_str() + startPos, endPos - startPos);
                 startPos = endPos + 1;
                 currentY += 8;
             }
         }
 
-        nokia.display();
+        pushNokiaFrame();
         previousNokiaMessage = nokiaMessage;
     }
 }
@@ -811,7 +854,7 @@ void resetSystem()
 
     // Reset displays
     nokia.clearDisplay();
-    nokia.display();
+    pushNokiaFrame();
     lcd.clear();
 
     // Reset menu state
@@ -840,6 +883,13 @@ void handleError(const String &message1, const String &message2)
     delayWithMsg(2000, message1, message2, 404);
     ledStatusCode(200);
 }
+// One menu row: selection marker and item name
+void drawNokiaMenuRow(int16_t y, bool selected, const char *name)
+{
+    nokiaText(nokia, 2, y, selected ? ">" : " ");
+    nokiaText(nokia, 2 + NOKIA_CHAR_WIDTH, y, name);
+}
+
 void updateMenuDisplay()
 {
     // Show static welcome message on LCD
@@ -848,50 +898,42 @@ void updateMenuDisplay()
     lcd.setCursor(0, 1);
     lcd.print(F("PISO-BOTE"));
 
-    String title = currentMenu->title;
-
     // Nokia-specific menu layout
     nokia.clearDisplay();
     nokia.drawRect(0, 0, 84, 10, BLACK);
-    nokia.setCursor(14, 1);
-    nokia.print(title);
+    nokiaText(nokia, 14, 1, currentMenu->title);
     nokia.drawLine(0, 12, 84, 12, BLACK);
 
     if (currentMenu == &mainMenu)
     {
-        // Main menu with icons
-        nokia.setCursor(2, 15);
-        nokia.print(currentMenu->currentItem == 0 ? ">" : " ");
-        nokia.print("Deposit");
-        nokia.drawBitmap(70, 13, BOTTLE_ICON, 8, 8, BLACK);
+        // Main menu with icons, four rows fit at a 9 pixel pitch
+        drawNokiaMenuRow(14, currentMenu->currentItem == 0, "Deposit");
+        nokiaIcon(nokia, 70, 13, BOTTLE_ICON);
+
+        drawNokiaMenuRow(23, currentMenu->currentItem == 1, "Batch");
+        nokiaIcon(nokia, 70, 22, BOTTLE_ICON);
 
-        nokia.setCursor(2, 25);
-        nokia.print(currentMenu->currentItem == 1 ? ">" : " ");
-        nokia.print("Redeem");
-        nokia.drawBitmap(70, 23, COIN_ICON, 8, 8, BLACK);
+        drawNokiaMenuRow(32, currentMenu->currentItem == 2, "Redeem");
+        nokiaIcon(nokia, 70, 31, COIN_ICON);
 
-        nokia.setCursor(2, 35);
-        nokia.print(currentMenu->currentItem == 2 ? ">" : " ");
-        nokia.print("Settings");
-        nokia.drawBitmap(70, 33, SETTINGS_ICON, 8, 8, BLACK);
+        drawNokiaMenuRow(41, currentMenu->currentItem == 3, "Settings");
+        nokiaIcon(nokia, 70, 40, SETTINGS_ICON);
     }
     else if (currentMenu == &settingsMenu)
     {
         // Settings menu with icons
         for (size_t i = 0; i < currentMenu->itemCount; i++)
         {
-            nokia.setCursor(2, 15 + (i * 10));
-            nokia.print(currentMenu->currentItem == i ? ">" : " ");
-            nokia.print(currentMenu->items[i].name);
+            drawNokiaMenuRow(15 + (i * 10), currentMenu->currentItem == i, currentMenu->items[i].name);
 
             // Add icons for settings menu items
             if (i == 0)
             { // Contrast
-                nokia.drawBitmap(70, 13, SETTINGS_ICON, 8, 8, BLACK);
+                nokiaIcon(nokia, 70, 13, SETTINGS_ICON);
             }
             else if (i == 1)
             { // Brightness
-                nokia.drawBitmap(70, 23, SETTINGS_ICON, 8, 8, BLACK);
+                nokiaIcon(nokia, 70, 23, SETTINGS_ICON);
             }
         }
     }
@@ -900,13 +942,11 @@ void updateMenuDisplay()
         // Post deposit menu
         for (size_t i = 0; i < currentMenu->itemCount; i++)
         {
-            nokia.setCursor(2, 15 + (i * 10));
-            nokia.print(currentMenu->currentItem == i ? ">" : " ");
-            nokia.print(currentMenu->items[i].name);
+            drawNokiaMenuRow(15 + (i * 10), currentMenu->currentItem == i, currentMenu->items[i].name);
         }
     }
 
-    nokia.display();
+    pushNokiaFrame();
 }
 
 void updateProgressDisplay(const String &message1, const String &message2, int progress)
@@ -981,10 +1021,13 @@ void delayWithMsg(unsigned long duration, String message1, String message2, int
     while (millis() - startTime < duration)
     {
         ledStatusCode(statusCode);
+        logFlush();
+        traceFlush();
     }
 }
 int getCapacitiveSensorValue()
 {
+    PROFILE_SCOPE(PROF_CAPACITIVE_READ);
     long sum = 0;
 
     // Take multiple samples to reduce noise
@@ -995,6 +1038,7 @@ int getCapacitiveSensorValue()
     }
 
     int averageValue = sum / SAMPLE_COUNT;
+    traceSample(TRACE_CAPACITIVE, averageValue);
 
     // if (DEBUG_SENSORS) {
     //     Serial.print("Raw Capacitive Value: ");
@@ -1018,17 +1062,22 @@ bool readCapacitiveSensorData()
     int currentValue = getCapacitiveSensorValue();
 
     // Update detection state with hysteresis to prevent flickering
-    if (currentValue >= DETECTION_THRESHOLD)
+    if (currentValue >= capBaselineDetect())
     {
         capacitiveSensor.isDetecting = true;
         capacitiveSensor.lastStableValue = currentValue;
     }
-    else if (currentValue < NO_BOTTLE_THRESHOLD)
+    else if (currentValue < capBaselineClear())
     {
         capacitiveSensor.isDetecting = false;
         capacitiveSensor.lastStableValue = currentValue;
     }
 
+    if (!capacitiveSensor.isDetecting)
+    {
+        capBaselineUpdate(currentValue);
+    }
+
     // if (DEBUG_SENSORS) {
     //     Serial.print("Capacitive Value: ");
     //     Serial.print(currentValue);
@@ -1041,7 +1090,8 @@ bool readCapacitiveSensorData()
 int readInductiveSensorData()
 {
     delay(50); // Short delay for sensor stabilization
-    int reading = digitalRead(inductiveSensorPin);
+    int reading = inductiveSensorPin.read();
+    traceSample(TRACE_INDUCTIVE, reading);
     // if (DEBUG_SENSORS) {
     //     Serial.print("Inductive Reading: ");
     //     Serial.println(reading);
@@ -1051,15 +1101,15 @@ int readInductiveSensorData()
 bool isBottleFullyRemoved()
 {
     int currentValue = getCapacitiveSensorValue();
-    return currentValue < NO_BOTTLE_THRESHOLD;
+    return currentValue < capBaselineClear();
 }
 
 void testCapacitiveSensor()
 {
     Serial.println("\n=== Testing Analog Capacitive Sensor ===");
     Serial.println("Place and remove a plastic bottle multiple times");
-    Serial.println("Detection Threshold: " + String(DETECTION_THRESHOLD));
-    Serial.println("No Bottle Threshold: " + String(NO_BOTTLE_THRESHOLD));
+    Serial.println("Detection Threshold: " + String(detectionThreshold));
+    Serial.println("No Bottle Threshold: " + String(noBottleThreshold));
     Serial.println("Testing for 30 seconds...");
 
     unsigned long startTime = millis();
@@ -1088,13 +1138,14 @@ void testCapacitiveSensor()
     Serial.println("Minimum Reading: " + String(minReading));
     Serial.println("Maximum Reading: " + String(maxReading));
     Serial.println("Current Thresholds:");
-    Serial.println("- Detection: " + String(DETECTION_THRESHOLD));
-    Serial.println("- No Bottle: " + String(NO_BOTTLE_THRESHOLD));
+    Serial.println("- Detection: " + String(detectionThreshold));
+    Serial.println("- No Bottle: " + String(noBottleThreshold));
 }
 void setupCapacitiveSensor()
 {
     pinMode(CAPACITIVE_SENSOR_PIN, INPUT);
     capacitiveSensor = CapacitiveSensorState(); // Initialize using constructor
+    capBaselineBegin(detectionThreshold, noBottleThreshold);
 
     // if (DEBUG_SENSORS) {
     //     testCapacitiveSensor();
@@ -1135,6 +1186,15 @@ void openCloseBinLid(int lidNum, bool toOpen)
     }
 }
 void waitToRemoveObject()
+{
+    handBackObject();
+    delay(2000);
+    openCloseBinLid(1, false);
+    ledStatusCode(200);
+}
+
+// Opens the inlet and waits for the object to be taken out
+void handBackObject()
 {
     lcd.clear();
     lcd.print(F("Remove Bottle!"));
@@ -1152,13 +1212,11 @@ void waitToRemoveObject()
             lcd.print(F("Timeout!"));
             break;
         }
+        watchdogKick(WATCHDOG_INTAKE);
         delay(100);
     }
 
     isObjectInside = false;
-    delay(2000);
-    openCloseBinLid(1, false);
-    ledStatusCode(200);
 }
 bool verifyObject()
 {
@@ -1173,111 +1231,115 @@ bool verifyObject()
     openCloseBinLid(1, false);
     delay(1000); // Give time for lid to close and readings to stabilize
 
-    unsigned long startTime = millis();
-    bool verificationComplete = false;
-    bool verificationResult = false;
-
-    // Main verification loop
-    while (!verificationComplete && (millis() - startTime < 3000))
-    { // 3 second timeout
-        ledStatusCode(102);
+    ClassifierResult result;
+    if (!sampleObject(result))
+    {
         lcd.clear();
-        lcd.print(F("Verifying...."));
-
-        // Get sensor readings
-        bool capacitiveReading = readCapacitiveSensorData();
-        int inductiveReading = readInductiveSensorData();
+        lcd.print(F("Verification"));
+        lcd.setCursor(0, 1);
+        lcd.print(F("timeout!"));
+        ledStatusCode(404);
+        waitToRemoveObject();
+        return false;
+    }
 
-        // Debug output
-        if (DEBUG_SENSORS)
-        {
-            Serial.println("Verification in progress:");
-            Serial.println("Capacitive: " + String(capacitiveReading));
-            Serial.println("Inductive: " + String(inductiveReading));
-        }
+    if (result.accepted)
+    {
+        lcd.clear();
+        lcd.print(F("Verified!"));
+        ledStatusCode(200);
 
-        // Check if object is present and verify all conditions
-        if (getCapacitiveSensorValue() >= DETECTION_THRESHOLD)
-        {
-            // Check all three conditions: capacitive, inductive, and weight
-            if (readInductiveSensorData() == 1 && isWeightAcceptable() && isObjectClear())
-            {
-                lcd.clear();
-                lcd.print(F("Verified!"));
-                ledStatusCode(200);
+        // Open second lid to drop bottle
+        openCloseBinLid(2, true);
+        delay(3000);
+        openCloseBinLid(2, false);
+    }
+    else
+    {
+        showRejection(result);
+        ledStatusCode(404);
 
-                // Open second lid to drop bottle
-                openCloseBinLid(2, true);
-                delay(3000);
-                openCloseBinLid(2, false);
+        // Handle invalid object
+        waitToRemoveObject();
+        delayWithMsg(3000, "Lid closing", "remove hand", 404);
+        openCloseBinLid(1, false);
+    }
 
-                verificationResult = true;
-                verificationComplete = true;
-            }
-            else
-            {
-                lcd.clear();
-                lcd.print(F("Invalid object"));
-                ledStatusCode(404);
+    controlLedInlet(false);
+    return result.accepted;
+}
 
-                // Handle invalid object
-                waitToRemoveObject();
-                delayWithMsg(3000, "Lid closing", "remove hand", 404);
-                openCloseBinLid(1, false);
+// Samples every sensor on each pass and lets the classifier fold the
+// readings in; the load cell is read whenever a conversion is ready.
+// Returns false if the classifier did not get enough samples in time.
+bool sampleObject(ClassifierResult &result)
+{
+    ledStatusCode(102);
+    lcd.clear();
+    lcd.print(F("Verifying...."));
 
-                verificationResult = false;
-                verificationComplete = true;
-            }
-        }
-        // If we've waited at least 2 seconds and no valid object detected
-        else if (millis() - startTime >= 2000)
+    classifierReset();
+    unsigned long startTime = millis();
+    while (!classifierReady() && (millis() - startTime < VERIFY_TIMEOUT))
+    {
+        classifierAddCapacitive(getCapacitiveSensorValue() - capBaselineShift());
+        classifierAddInductive(readInductiveSensorData());
+        classifierAddLdr(readLDRSensorData());
+        if (scale.is_ready())
         {
-            lcd.clear();
-            lcd.print(F("Invalid object"));
-            ledStatusCode(404);
-
-            // Handle invalid object
-            waitToRemoveObject();
-            delayWithMsg(3000, "Lid closing", "remove hand", 404);
-            openCloseBinLid(1, false);
-
-            verificationResult = false;
-            verificationComplete = true;
+            long raw = scale.read();
+            traceSample(TRACE_LOADCELL, raw);
+            classifierAddWeight(loadCellNet(raw - scale.get_offset()));
         }
-
-        delay(100); // Small delay to prevent tight loop
+        watchdogKick(WATCHDOG_INTAKE);
+        delay(VERIFY_SAMPLE_DELAY);
     }
 
-    // Handle timeout case
-    if (!verificationComplete)
+    if (!classifierReady())
     {
-        lcd.clear();
-        lcd.print(F("Verification"));
-        lcd.setCursor(0, 1);
-        lcd.print(F("timeout!"));
-        ledStatusCode(404);
-        waitToRemoveObject();
         return false;
     }
-    controlLedInlet(false);
-    return verificationResult;
+
+    classifierDecide(result);
+    LOG_INFO(LOG_WEIGHT, (int32_t)result.weightDg * 10, (int32_t)result.spreadDg * 10);
+    LOG_INFO(LOG_CLASSIFIED, result.score, result.confidence);
+    return true;
+}
+
+void showRejection(const ClassifierResult &result)
+{
+    LOG_INFO(LOG_REJECT_REASON, result.reason, result.weightDg);
+    if (result.reason < CLASSIFIER_REASON_COUNT)
+    {
+        kioskStats.rejectedFor[result.reason]++;
+    }
+    lcd.clear();
+    lcd.print(F("Invalid object"));
+    lcd.setCursor(0, 1);
+    lcd.print(classifierReasonName(result.reason));
+    if (result.reason == CLASSIFIER_WEIGHT)
+    {
+        // Grams only exist for the display
+        lcd.print(' ');
+        loadCellPrintGrams(lcd, result.weightDg);
+    }
 }
 void navigateMenu(int direction)
 {
     currentMenu->currentItem = (currentMenu->currentItem + direction + currentMenu->itemCount) % currentMenu->itemCount;
     updateMenuDisplay();
-    delay(200);
-    while (digitalRead(direction > 0 ? downButton : upButton) == LOW)
-        ;
 }
 
 void selectMenuItem()
 {
-    currentMenu->items[currentMenu->currentItem].action();
+    {
+        WatchdogScope watchdog(WATCHDOG_ACTION);
+        currentMenu->items[currentMenu->currentItem].action();
+    }
+    zeroTrackHold(); // The platform may have been used
     updateMenuDisplay();
-    delay(200);
-    while (digitalRead(selectButton) == LOW)
-        ;
+    // Presses made while the action ran were meant for its screens
+    buttonsFlush();
 }
 // Example of how to use in waitForObjectPresence
 void waitForObjectPresence() {
@@ -1289,12 +1351,9 @@ void waitForObjectPresence() {
     while (!objectDetected) {
         ledStatusCode(102);
 
-        if (readCapacitiveSensorData()) {
-            delay(100);
-            if (readCapacitiveSensorData()) {
-                objectDetected = true;
-                break;
-            }
+        if (confirmObjectPresence()) {
+            objectDetected = true;
+            break;
         }
 
         if (millis() - startTime >= 3000) {
@@ -1307,21 +1366,40 @@ void waitForObjectPresence() {
             isObjectInside = false;
             return;
         }
+        watchdogKick(WATCHDOG_INTAKE);
     }
 
-    Serial.println("Bottle detected!");
+    LOG_DEBUG(LOG_BOTTLE_DETECTED, capacitiveSensor.lastStableValue);
     isObjectInside = true;
     // LED stays on for verification process
 }
 
+// Detection needs a confirming read unless the signal is clearly strong
+bool confirmObjectPresence()
+{
+    if (!readCapacitiveSensorData())
+    {
+        return false;
+    }
+    if (capacitiveSensor.lastStableValue >= capBaselineDetect() + STRONG_SIGNAL_MARGIN)
+    {
+        return true;
+    }
+    delay(100);
+    return readCapacitiveSensorData();
+}
+
 void depositAction()
 {
+    PROFILE_SCOPE(PROF_DEPOSIT);
     if (maintenanceMode)
     {
         displayNokiaStatus("System Full", ERROR_ICON);
         delayWithMsg(2000, "PISO-BOTE is full", "Try again later", 404);
         return;
     }
+    WatchdogScope watchdog(WATCHDOG_INTAKE);
+    traceSample(TRACE_MARK, TRACE_MARK_DEPOSIT);
 
     displayNokiaStatus("Ready for Bottle", BOTTLE_ICON);
     lcd.clear();
@@ -1333,9 +1411,15 @@ void depositAction()
     lcd.print(F("Insert Bottle!"));
 
     waitForObjectPresence();
-    if (verifyObject())
+    bool objectPresent = isObjectInside;
+    bool accepted = verifyObject();
+    traceSample(TRACE_MARK, accepted ? TRACE_MARK_ACCEPTED : objectPresent ? TRACE_MARK_REJECTED : TRACE_MARK_NO_OBJECT);
+    if (accepted)
     {
         totalPoints++;
+        saveCredit(totalPoints);
+        kioskStats.bottlesAccepted++;
+        journalRecord(JOURNAL_DEPOSIT_ACCEPTED, totalPoints);
         displayNokiaStatus("Success!", BOTTLE_ICON);
         lcd.clear();
         lcd.print(F("Deposit success!"));
@@ -1346,115 +1430,465 @@ void depositAction()
         currentMenu = &postDepositMenu;
         updateMenuDisplay();
     }
+    else if (objectPresent)
+    {
+        kioskStats.bottlesRejected++;
+        journalRecord(JOURNAL_DEPOSIT_REJECTED);
+    }
 }
 void insertAnotherBottleAction()
 {
     depositAction();
 }
 
-// RFID Functions
-void redeemAction()
+// Flap state of the last accepted batch bottle, which drops while its
+// verdict is on screen
+struct BatchDrop
 {
-    if (maintenanceMode)
+    bool pending;
+    bool empty;
+    unsigned long openedAt;
+    unsigned long emptySince;
+    int32_t emptyNet;
+};
+
+BatchDrop batchDrop = {false, false, 0, 0, 0};
+
+void startBatchDrop(int32_t emptyNet)
+{
+    openCloseBinLid(2, true);
+    batchDrop.pending = true;
+    batchDrop.empty = false;
+    batchDrop.openedAt = millis();
+    batchDrop.emptyNet = emptyNet;
+}
+
+// Closes the flap as soon as the platform has read empty for a moment,
+// rather than after a fixed time. Returns true once the flap is closed.
+bool serviceBatchDrop()
+{
+    if (!batchDrop.pending)
     {
-        displayNokiaStatus("System Full", ERROR_ICON);
-        delayWithMsg(2000, "PISO-BOTE is full", "Try again later", 404);
-        return;
+        return true;
+    }
+    if (scale.is_ready())
+    {
+        bool nowEmpty = loadCellNet(scale.read() - scale.get_offset()) < batchDrop.emptyNet;
+        if (nowEmpty && !batchDrop.empty)
+        {
+            batchDrop.emptySince = millis();
+        }
+        batchDrop.empty = nowEmpty;
+    }
+    if ((batchDrop.empty && millis() - batchDrop.emptySince >= BATCH_DROP_MARGIN) ||
+        millis() - batchDrop.openedAt >= BATCH_DROP_TIMEOUT)
+    {
+        openCloseBinLid(2, false);
+        batchDrop.pending = false;
     }
+    return !batchDrop.pending;
+}
 
-    displayNokiaStatus("Present Card", CARD_ICON);
-    lcd.clear();
-    lcd.print("Present RFID");
-    lcd.setCursor(0, 1);
-    lcd.print("Card");
+// Waits for the flap to close; card writes go on meanwhile
+void finishBatchDrop()
+{
+    while (!serviceBatchDrop())
+    {
+        cardSessionService();
+        watchdogKick(WATCHDOG_INTAKE);
+        delay(VERIFY_SAMPLE_DELAY);
+    }
+}
 
+// Waits for the next bottle of a batch; false once the user presses
+// SELECT or stops inserting
+bool waitForBatchObject()
+{
+    // The press that opened the session was taken by the menu, so a
+    // SELECT press here is a new one
     unsigned long startTime = millis();
-    while (millis() - startTime < 10000)
+    while (millis() - startTime < BATCH_IDLE_TIMEOUT)
     {
-        if (detectCard())
+        ButtonEvent event;
+        if (buttonNext(event) && event.button == BUTTON_SELECT && event.type == BUTTON_PRESS)
         {
-            int currentPoints = readPoints();
-            if (currentPoints >= 0)
-            {
-                totalPoints = currentPoints;
-                pointsToRedeem = 0;
-                redeemPointsAction();
-                mfrc522.PICC_HaltA();
-                mfrc522.PCD_StopCrypto1();
-                return;
-            }
+            return false;
         }
-        delay(100);
+        // Card writes happen here, while the user reaches for the next bottle
+        cardSessionService();
+        if (confirmObjectPresence())
+        {
+            LOG_DEBUG(LOG_BOTTLE_DETECTED, capacitiveSensor.lastStableValue);
+            return true;
+        }
+        watchdogKick(WATCHDOG_INTAKE);
+        delay(DEBOUNCE_MS);
     }
-    displayNokiaStatus("No Card Found", ERROR_ICON);
-    delayWithMsg(2000, "No card detected", "", 404);
+    return false;
 }
 
-void redeemPointsAction()
+// Verifies bottles back to back without leaving the session. An accepted
+// bottle drops while its verdict is shown; rejected ones are handed back.
+// Returns the number accepted.
+int runIntakeSession(int &rejected)
 {
-    lcd.clear();
-    lcd.print("Redeem Points");
-    lcd.setCursor(0, 1);
-    lcd.print("Points: ");
-    lcd.print(pointsToRedeem);
-
-    unsigned long lastButtonPress = 0;
-    int holdTime = 0;
-    const int maxRedeemable = min(totalPoints, 20);
-    delay(1000);
+    WatchdogScope watchdog(WATCHDOG_INTAKE);
+    // Half the minimum bottle weight counts as an empty platform
+    int32_t emptyNet = loadCellNetFor(classifierGet(CLASSIFIER_WEIGHT_MIN) / 2);
+    int accepted = 0;
+    rejected = 0;
     while (true)
     {
-        lcd.setCursor(8, 1);
-        lcd.print("    ");
-        lcd.setCursor(8, 1);
-        lcd.print(pointsToRedeem);
+        // The inlet stays shut until the flap under the platform has closed
+        // again, or the next bottle would fall straight into the bin
+        bool dropped = batchDrop.pending;
+        finishBatchDrop();
+        if (dropped && isBinFull())
+        {
+            // Stop taking bottles; loop() takes it from here
+            maintenanceMode = true;
+            kioskStats.binFullEvents++;
+            journalRecord(JOURNAL_BIN_FULL);
+            break;
+        }
 
-        if (digitalRead(upButton) == LOW || digitalRead(downButton) == LOW)
+        traceSample(TRACE_MARK, TRACE_MARK_DEPOSIT);
+        lcd.clear();
+        lcd.print(F("Insert Bottle!"));
+        lcd.setCursor(0, 1);
+        if (cardSession.active)
         {
-            if (millis() - lastButtonPress > 200)
-            {
-                int direction = (digitalRead(upButton) == LOW) ? 1 : -1;
-                pointsToRedeem += direction * (1 + (holdTime / 1000));
-                pointsToRedeem = constrain(pointsToRedeem, 0, maxRedeemable);
-                lastButtonPress = millis();
-                holdTime += 200;
-            }
+            displayNokiaStatus("Card: " + String(cardSession.target), CARD_ICON);
+            lcd.print(F("Card pts "));
+            lcd.print(cardSession.target);
         }
         else
         {
-            holdTime = 0;
+            displayNokiaStatus("Batch: " + String(accepted), BOTTLE_ICON);
+            lcd.print(F("SELECT=done "));
+            lcd.print(accepted);
+        }
+        controlLedInlet(true);
+        openCloseBinLid(1, true);
+
+        if (!waitForBatchObject())
+        {
+            traceSample(TRACE_MARK, TRACE_MARK_NO_OBJECT);
+            break;
         }
 
-        if (digitalRead(selectButton) == LOW)
+        delayWithMsg(BATCH_HAND_WARNING, "Lid is closing...", "Remove hand!!!", 404);
+        openCloseBinLid(1, false);
+        controlLedInlet(false);
+        delay(SENSOR_STABILIZE_TIME);
+
+        ClassifierResult result;
+        bool decided = sampleObject(result);
+        if (decided && result.accepted)
         {
-            if (millis() - lastButtonPress > 2000)
+            traceSample(TRACE_MARK, TRACE_MARK_ACCEPTED);
+            accepted++;
+            kioskStats.bottlesAccepted++;
+            if (cardSession.active)
             {
-                delayWithMsg(2000, "Redemption", "Cancelled", 404);
-                pointsToRedeem = 0;
-                currentMenu = &mainMenu;
-                updateMenuDisplay();
-                break;
+                cardSession.target++;
+                saveCredit(cardSession.target - cardSession.written);
+                journalRecord(JOURNAL_DEPOSIT_ACCEPTED, cardSession.target);
             }
             else
             {
-                totalPoints -= pointsToRedeem;
-                if (writePoints(totalPoints))
-                {
-                    delayWithMsg(2000, "Redeeming: " + String(pointsToRedeem), "Please wait...", 200);
-                    dispenseCoin(pointsToRedeem); // Dispense coins equal to pointsToRedeem
-                    delayWithMsg(2000, "Redeemed: " + String(pointsToRedeem), "Remaining: " + String(totalPoints), 200);
-                }
-                else
-                {
-                    delayWithMsg(2000, "Failed to update", "card. Try again.", 404);
-                }
-                currentMenu = &mainMenu;
-                updateMenuDisplay();
-                break;
+                saveCredit(totalPoints + accepted);
+                journalRecord(JOURNAL_DEPOSIT_ACCEPTED, totalPoints + accepted);
+            }
+            startBatchDrop(emptyNet);
+            displayNokiaStatus("Success!", BOTTLE_ICON);
+            lcd.clear();
+            lcd.print(F("Verified!"));
+            lcd.setCursor(0, 1);
+            lcd.print(F("Bottles: "));
+            lcd.print(accepted);
+            ledStatusCode(200);
+        }
+        else
+        {
+            traceSample(TRACE_MARK, TRACE_MARK_REJECTED);
+            rejected++;
+            kioskStats.bottlesRejected++;
+            journalRecord(JOURNAL_DEPOSIT_REJECTED);
+            if (decided)
+            {
+                showRejection(result);
+            }
+            else
+            {
+                lcd.clear();
+                lcd.print(F("Verification"));
+                lcd.setCursor(0, 1);
+                lcd.print(F("timeout!"));
             }
+            ledStatusCode(404);
+            handBackObject();
         }
+    }
 
-        delay(50);
+    openCloseBinLid(1, false);
+    controlLedInlet(false);
+    isObjectInside = false;
+    return accepted;
+}
+
+// Batch session: points are tallied once at the end
+void batchDepositAction()
+{
+    PROFILE_SCOPE(PROF_DEPOSIT);
+    if (maintenanceMode)
+    {
+        displayNokiaStatus("System Full", ERROR_ICON);
+        delayWithMsg(2000, "PISO-BOTE is full", "Try again later", 404);
+        return;
+    }
+
+    int rejected;
+    int accepted = runIntakeSession(rejected);
+    totalPoints += accepted;
+    if (accepted == 0)
+    {
+        delayWithMsg(2000, "Batch done", "No bottles", 404);
+        return;
+    }
+    displayNokiaStatus("Success!", BOTTLE_ICON);
+    lcd.clear();
+    lcd.print(F("Batch: "));
+    lcd.print(accepted);
+    lcd.print(F(" ok "));
+    lcd.print(rejected);
+    lcd.print(F(" no"));
+    lcd.setCursor(0, 1);
+    lcd.print(F("Points: "));
+    lcd.print(totalPoints);
+    delay(2000);
+    currentMenu = &postDepositMenu;
+    updateMenuDisplay();
+}
+
+// Selects the session card again after it left the field
+static bool reselectSessionCard()
+{
+    // A card that stayed in the field ignores the first request
+    if (!mfrc522.PICC_IsNewCardPresent() && !mfrc522.PICC_IsNewCardPresent())
+    {
+        return false;
+    }
+    if (!mfrc522.PICC_ReadCardSerial() || mfrc522.uid.size != cardSession.uidSize ||
+        memcmp(mfrc522.uid.uidByte, cardSession.uid, cardSession.uidSize) != 0)
+    {
+        return false;
+    }
+    return authenticateBlock(POINTS_BLOCK) == MFRC522::STATUS_OK;
+}
+
+// Writes outstanding credit to the session card. The card stays selected
+// and authenticated between bottles, so a write is a single block write;
+// if the card has left the field it is retried now and then. Returns true
+// once the card holds the full balance.
+bool cardSessionService()
+{
+    if (!cardSession.active || cardSession.written == min(cardSession.target, MAX_POINTS))
+    {
+        return true;
+    }
+    if (!cardSession.selected)
+    {
+        if (millis() - cardSession.lastAttempt < CARD_RETRY_INTERVAL)
+        {
+            return false;
+        }
+        cardSession.lastAttempt = millis();
+        cardSession.selected = reselectSessionCard();
+        if (!cardSession.selected)
+        {
+            return false;
+        }
+    }
+
+    int balance = min(cardSession.target, MAX_POINTS);
+    if (!writePoints(balance, false))
+    {
+        cardSession.selected = false;
+        cardSession.lastAttempt = millis();
+        return false;
+    }
+    cardSession.written = balance;
+    saveCredit(cardSession.target - cardSession.written);
+    journalRecord(JOURNAL_POINTS_STORED, balance);
+    return balance == cardSession.target;
+}
+
+// Tap-first session, started by a card tap at the menu: every accepted
+// bottle is credited straight to the card, without the post-deposit menu
+void cardSessionAction()
+{
+    PROFILE_SCOPE(PROF_DEPOSIT);
+    int balance = readPoints();
+    if (balance < 0)
+    {
+        delayWithMsg(2000, "Card read failed", "Try again", 404);
+        mfrc522.PICC_HaltA();
+        mfrc522.PCD_StopCrypto1();
+        return;
+    }
+
+    cardSession.active = true;
+    cardSession.selected = true; // readPoints() left the sector authenticated
+    cardSession.uidSize = min(mfrc522.uid.size, (byte)sizeof(cardSession.uid));
+    memcpy(cardSession.uid, mfrc522.uid.uidByte, cardSession.uidSize);
+    cardSession.written = balance;
+    cardSession.target = balance;
+    cardSession.lastAttempt = 0;
+    delayWithMsg(1500, "Card: " + String(balance), "Leave it on reader", 200);
+
+    int rejected;
+    runIntakeSession(rejected);
+
+    // Anything not yet on the card needs one more tap
+    if (!cardSessionService())
+    {
+        lcd.clear();
+        lcd.print(F("Tap card to save"));
+        lcd.setCursor(0, 1);
+        lcd.print(F("Points: "));
+        lcd.print(cardSession.target - cardSession.written);
+        unsigned long startTime = millis();
+        while (!cardSessionService() && millis() - startTime < CARD_SAVE_TIMEOUT)
+        {
+            delay(100);
+        }
+    }
+    cardSession.active = false;
+    mfrc522.PICC_HaltA();
+    mfrc522.PCD_StopCrypto1();
+
+    int unsaved = cardSession.target - cardSession.written;
+    if (unsaved > 0)
+    {
+        // Same fallback as an unsaved batch: redeem or store from the menu
+        totalPoints += unsaved;
+        saveCredit(totalPoints);
+        delayWithMsg(2000, "Not saved: " + String(unsaved), "Choose an option", 404);
+        currentMenu = &postDepositMenu;
+        updateMenuDisplay();
+        return;
+    }
+    displayNokiaStatus("Points stored!", CARD_ICON);
+    delayWithMsg(2000, "Points stored!", "Total: " + String(cardSession.written), 200);
+}
+
+// RFID Functions
+void redeemAction()
+{
+    if (maintenanceMode)
+    {
+        displayNokiaStatus("System Full", ERROR_ICON);
+        delayWithMsg(2000, "PISO-BOTE is full", "Try again later", 404);
+        return;
+    }
+
+    displayNokiaStatus("Present Card", CARD_ICON);
+    lcd.clear();
+    lcd.print("Present RFID");
+    lcd.setCursor(0, 1);
+    lcd.print("Card");
+
+    unsigned long startTime = millis();
+    while (millis() - startTime < 10000)
+    {
+        if (detectCard())
+        {
+            int currentPoints = readPoints();
+            if (currentPoints >= 0)
+            {
+                totalPoints = currentPoints;
+                pointsToRedeem = 0;
+                redeemPointsAction();
+                mfrc522.PICC_HaltA();
+                mfrc522.PCD_StopCrypto1();
+                return;
+            }
+        }
+        delay(100);
+    }
+    displayNokiaStatus("No Card Found", ERROR_ICON);
+    delayWithMsg(2000, "No card detected", "", 404);
+}
+
+void redeemPointsAction()
+{
+    lcd.clear();
+    lcd.print("Redeem Points");
+    lcd.setCursor(0, 1);
+    lcd.print("Points: ");
+    lcd.print(pointsToRedeem);
+
+    const int maxRedeemable = min(totalPoints, 20);
+    buttonsFlush(); // The SELECT press that opened this screen
+    bool changed = true;
+    while (true)
+    {
+        if (changed)
+        {
+            changed = false;
+            lcd.setCursor(8, 1);
+            lcd.print("    ");
+            lcd.setCursor(8, 1);
+            lcd.print(pointsToRedeem);
+        }
+
+        // UP and DOWN step and repeat faster the longer they are held;
+        // a short SELECT confirms and a long one cancels
+        ButtonEvent event;
+        if (!buttonNext(event))
+        {
+            watchdogKick(WATCHDOG_ACTION);
+            delay(10);
+            continue;
+        }
+        if (event.button != BUTTON_SELECT && (event.type == BUTTON_PRESS || event.type == BUTTON_REPEAT))
+        {
+            int direction = event.button == BUTTON_UP ? 1 : -1;
+            pointsToRedeem = constrain(pointsToRedeem + direction, 0, maxRedeemable);
+            changed = true;
+        }
+
+        if (event.button == BUTTON_SELECT)
+        {
+            if (event.type == BUTTON_LONG_PRESS)
+            {
+                delayWithMsg(2000, "Redemption", "Cancelled", 404);
+                pointsToRedeem = 0;
+                currentMenu = &mainMenu;
+                updateMenuDisplay();
+                break;
+            }
+            else if (event.type == BUTTON_RELEASE)
+            {
+                totalPoints -= pointsToRedeem;
+                savePayout(pointsToRedeem, 0); // Owed from the moment the card is debited
+                if (writePoints(totalPoints))
+                {
+                    delayWithMsg(2000, "Redeeming: " + String(pointsToRedeem), "Please wait...", 200);
+                    dispenseCoin(pointsToRedeem); // Dispense coins equal to pointsToRedeem
+                    delayWithMsg(2000, "Redeemed: " + String(pointsToRedeem), "Remaining: " + String(totalPoints), 200);
+                }
+                else
+                {
+                    saveCredit(0);
+                    delayWithMsg(2000, "Failed to update", "card. Try again.", 404);
+                }
+                currentMenu = &mainMenu;
+                updateMenuDisplay();
+                break;
+            }
+        }
     }
 }
 
@@ -1466,7 +1900,7 @@ void setUpRFID() {
     
     // Configure RFID module pins
     pinMode(RST_PIN, OUTPUT);
-    digitalWrite(RST_PIN, HIGH);
+    RST_PIN.high();
     delay(50);  // Short delay after power up
     
     // Initialize MFRC522
@@ -1536,28 +1970,23 @@ bool detectCard() {
     }
 
     // Card is detected
-    Serial.print(F("\nCard UID: "));
-    for (byte i = 0; i < mfrc522.uid.size; i++) {
-        Serial.print(mfrc522.uid.uidByte[i] < 0x10 ? " 0" : " ");
-        Serial.print(mfrc522.uid.uidByte[i], HEX);
+    kioskStats.cardTaps++;
+    // Log the first four UID bytes and the card type
+    uint32_t uidPrefix = 0;
+    for (byte i = 0; i < 4 && i < mfrc522.uid.size; i++) {
+        uidPrefix = (uidPrefix << 8) | mfrc522.uid.uidByte[i];
     }
-    Serial.println();
-
-    // Print card type
-    MFRC522::PICC_Type piccType = mfrc522.PICC_GetType(mfrc522.uid.sak);
-    Serial.print(F("Card type: "));
-    Serial.println(mfrc522.PICC_GetTypeName(piccType));
+    LOG_DEBUG(LOG_CARD_UID, uidPrefix, mfrc522.uid.size);
+    LOG_DEBUG(LOG_CARD_TYPE, mfrc522.uid.sak, mfrc522.PICC_GetType(mfrc522.uid.sak));
 
     return true;
 }
 
 int readPoints() {
+    PROFILE_SCOPE(PROF_READ_POINTS);
     byte buffer[18];
     byte size = sizeof(buffer);
 
-    // Debug output
-    Serial.println(F("Reading points..."));
-
     // Authenticate using key A
     MFRC522::StatusCode status = mfrc522.PCD_Authenticate(
         MFRC522::PICC_CMD_MF_AUTH_KEY_A,
@@ -1567,59 +1996,63 @@ int readPoints() {
     );
 
     if (status != MFRC522::STATUS_OK) {
-        Serial.println(F("Authentication failed"));
+        LOG_WARN(LOG_RFID_AUTH_FAILED, POINTS_BLOCK, status);
+        kioskStats.rfidErrors++;
         return -1;
     }
 
     // Read the block
     status = mfrc522.MIFARE_Read(POINTS_BLOCK, buffer, &size);
     if (status != MFRC522::STATUS_OK) {
-        Serial.println(F("Reading failed"));
+        LOG_WARN(LOG_RFID_READ_FAILED, POINTS_BLOCK, status);
+        kioskStats.rfidErrors++;
         return -1;
     }
 
     // The points are stored in the first two bytes
     int points = (buffer[0] << 8) | buffer[1];
     
-    Serial.print(F("Points read: "));
-    Serial.println(points);
+    LOG_INFO(LOG_POINTS_READ, points);
 
     return points;
 }
-bool writePoints(int points) {
+bool writePoints(int points, bool authenticate) {
+    PROFILE_SCOPE(PROF_WRITE_POINTS);
     if (points < 0 || points > MAX_POINTS) {
         Serial.println(F("Invalid points value"));
         return false;
     }
 
-    Serial.print(F("Writing points: "));
-    Serial.println(points);
-
     byte buffer[16] = {0};  // Clear buffer
     buffer[0] = (points >> 8) & 0xFF;  // High byte
     buffer[1] = points & 0xFF;         // Low byte
 
-    // Authenticate using key A
-    MFRC522::StatusCode status = mfrc522.PCD_Authenticate(
-        MFRC522::PICC_CMD_MF_AUTH_KEY_A,
-        POINTS_BLOCK,
-        &key,
-        &(mfrc522.uid)
-    );
-
-    if (status != MFRC522::STATUS_OK) {
-        Serial.println(F("Authentication failed"));
-        return false;
+    // Authenticate using key A, unless the sector still is
+    MFRC522::StatusCode status;
+    if (authenticate) {
+        status = mfrc522.PCD_Authenticate(
+            MFRC522::PICC_CMD_MF_AUTH_KEY_A,
+            POINTS_BLOCK,
+            &key,
+            &(mfrc522.uid)
+        );
+
+        if (status != MFRC522::STATUS_OK) {
+            LOG_WARN(LOG_RFID_AUTH_FAILED, POINTS_BLOCK, status);
+            kioskStats.rfidErrors++;
+            return false;
+        }
     }
 
     // Write the block
     status = mfrc522.MIFARE_Write(POINTS_BLOCK, buffer, 16);
     if (status != MFRC522::STATUS_OK) {
-        Serial.println(F("Writing failed"));
+        LOG_WARN(LOG_RFID_WRITE_FAILED, POINTS_BLOCK, status);
+        kioskStats.rfidErrors++;
         return false;
     }
 
-    Serial.println(F("Write successful"));
+    LOG_INFO(LOG_POINTS_WRITTEN, points);
     return true;
 }
 
@@ -1666,12 +2099,14 @@ void storePointsAction() {
             cardDetected = true;
             ledStatusCode(102); // Processing
             if (writePoints(totalPoints)) {
+                journalRecord(JOURNAL_POINTS_STORED, totalPoints);
                 delayWithMsg(2000, "Points stored!", "Total: " + String(totalPoints), 200);
                 mfrc522.PICC_HaltA();
                 mfrc522.PCD_StopCrypto1();
                 currentMenu = &mainMenu;
                 updateMenuDisplay();
                 totalPoints = 0;
+                saveCredit(0);
                 return;
             } else {
                 // Card detected but writing failed
@@ -1700,9 +2135,11 @@ void storePointsAction() {
     delayWithMsg(2000, "Redeem " + String(totalPoints), "coins? SELECT=Yes", 102);
     
     // Wait for confirmation or cancellation
+    buttonsFlush();
+    ButtonEvent event;
     startTime = millis();
     while (millis() - startTime < 5000) {
-        if (digitalRead(selectButton) == LOW) {
+        if (buttonNext(event) && event.button == BUTTON_SELECT && event.type == BUTTON_PRESS) {
             // User confirmed, proceed with coin dispensing
             delayWithMsg(2000, "Dispensing coins", "Please wait...", 102);
             dispenseCoin(totalPoints);
@@ -1720,209 +2157,1082 @@ void storePointsAction() {
     currentMenu = &mainMenu;
     updateMenuDisplay();
 }
-void setup()
-{
-    // Start serial first for debugging
-    Serial.begin(9600);
-    Serial.println(F("Starting PISO-BOTE initialization..."));
-
-    // Initialize displays
-    Serial.println(F("Initializing displays..."));
-    if (!setupNokiaDisplay()) {
-        Serial.println(F("Nokia display initialization failed. System halted."));
-        while (1) { delay(1000); }
-    }
-    
-    lcd.init();
-    lcd.backlight();
-    lcd.clear();
-    lcd.print(F("Initializing..."));
-    
-    // Initialize buttons and basic pins
-    Serial.println(F("Setting up pins..."));
-    pinMode(upButton, INPUT_PULLUP);
-    pinMode(downButton, INPUT_PULLUP);
-    pinMode(selectButton, INPUT_PULLUP);
-    pinMode(CAPACITIVE_SENSOR_PIN, INPUT);
-    pinMode(inductiveSensorPin, INPUT);
-    pinMode(PIN_RED, OUTPUT);
-    pinMode(PIN_GREEN, OUTPUT);
-    pinMode(PIN_BLUE, OUTPUT);
-    pinMode(LDR_PIN, INPUT);
-    pinMode(LED_INLET_PIN, OUTPUT);
-    
-    // Initialize sensors
-    Serial.println(F("Setting up sensors..."));
-    setupCapacitiveSensor();
-    
-    // Set initial LED status
-    ledStatusCode(200);
-
-    // Initialize servos
-    Serial.println(F("Initializing servos..."));
-    servo1.attach(servoPin1);
-    servo2.attach(servoPin2);
-    delay(500);  // Give servos time to initialize
-    
-    // Test servos
-    Serial.println(F("Testing servo movements..."));
-    openCloseBinLid(1, false);
-    openCloseBinLid(2, false);
-    delay(500);
-
-    // Initialize scale
-    Serial.println(F("Initializing load cell..."));
-    scale.begin(LOADCELL_DOUT_PIN, LOADCELL_SCK_PIN);
-    delay(1000);  // Give the scale time to stabilize
-    scale.set_scale(CALIBRATION_FACTOR);
-    scale.tare();
-    Serial.println(F("Load cell initialized"));
-
-    // Initialize RFID
-    Serial.println(F("Setting up RFID..."));
-    setUpRFID();
-    
-    // Initialize GSM module
-    Serial.println(F("Setting up GSM module..."));
-    sim800lv2.begin(9600);
-    delay(3000);  // Give the module time to initialize
-    
-    // Configure GSM
-    Serial.println(F("Configuring GSM..."));
-    sim800lv2.println("AT");
-    delay(1000);
-    sim800lv2.println("AT+CMGF=1");
-    delay(1000);
-    sim800lv2.println("AT+CNMI=1,2,0,0,0");
-    delay(1000);
-    
-    // Test GSM
-    sim800lv2.println("AT");
-    delay(1000);
-    
-    // Initialize coin hopper
-    Serial.println(F("Setting up coin hopper..."));
-    pinMode(coinHopperSensor_PIN, INPUT_PULLUP);
-    pinMode(relayPin, OUTPUT);
-    digitalWrite(relayPin, LOW);
-    
-    // Final display setup
-    pinMode(PIN_BL, OUTPUT);
-    analogWrite(PIN_BL, 255);
-    updateMenuDisplay();
-
-    // Send initialization message
-    Serial.println(F("Sending initialization SMS..."));
-    sendSMS("PISO-BOTE system initialized");
-    
-    Serial.println(F("Initialization complete!"));
-    lcd.clear();
-    lcd.print(F("Ready!"));
-    delay(1000);
-    
-    // Show main menu
-    updateMenuDisplay();
-}
-
-void loop()
+// Diagnostics console commands. Reports longer than a line or two are
+// streamed, one line per consolePoll(), so they never wait on the UART.
+bool streamStatsLine(Print &out, uint16_t line)
 {
-    if (maintenanceMode)
+    const WatchdogStats &watchdog = watchdogStats();
+    switch (line)
     {
-        handleMaintenanceMode();
-        return;
+    case 0:
+        out.print(F("uptime "));
+        out.print(millis() / 1000);
+        out.println(F("s"));
+        return true;
+    case 1:
+        out.print(F("accepted "));
+        out.print(kioskStats.bottlesAccepted);
+        out.print(F(" rejected "));
+        out.println(kioskStats.bottlesRejected);
+        return true;
+    case 2:
+        out.print(F("coins "));
+        out.print(kioskStats.coinsDispensed);
+        out.print(F(" cards "));
+        out.print(kioskStats.cardTaps);
+        out.print(F(" points "));
+        out.println(totalPoints);
+        return true;
+    case 3:
+        out.print(F("maintenance "));
+        out.print(maintenanceMode ? 1 : 0);
+        out.print(F(" log drops "));
+        out.println(logDroppedCount());
+        return true;
+    case 4:
+        out.print(F("reset "));
+        out.print(resetCauseName(watchdog.resetCause));
+        if (watchdog.resetCause == RESET_WATCHDOG)
+        {
+            out.print(F(" in "));
+            out.print(watchdogTaskName(watchdog.expiredTask));
+        }
+        out.println();
+        return true;
     }
-
-    if (isBinFull())
+    line -= 5;
+    if (line < WATCHDOG_TASK_COUNT)
     {
-        maintenanceMode = true;
-        displayNokiaStatus("System Full", ERROR_ICON);
-        return;
+        out.print(F("heartbeat gap "));
+        out.print(watchdogTaskName(line));
+        out.print(' ');
+        out.print(watchdog.worstGapMs[line]);
+        out.println(F(" ms"));
+        return true;
     }
+    line -= WATCHDOG_TASK_COUNT;
 
-    if (digitalRead(downButton) == LOW)
+    const PowerStats &power = powerStats();
+    if (line == 0)
     {
-        navigateMenu(1);
+        out.print(F("power "));
+        out.print(powerLevelName(appliedPowerLevel));
+        out.print(F(" button wakes "));
+        out.println(power.buttonWakes);
+        return true;
     }
-    if (digitalRead(upButton) == LOW)
+    line--;
+    if (line < POWER_LEVEL_COUNT)
     {
-        navigateMenu(-1);
+        out.print(F("power time "));
+        out.print(powerLevelName(line));
+        out.print(' ');
+        out.print(power.levelMs[line] / 1000);
+        out.println('s');
+        return true;
     }
-    if (digitalRead(selectButton) == LOW)
+    line -= POWER_LEVEL_COUNT;
+
+    ModemLinkStats link;
+    const AtStats &at = atStats();
+    const ButtonStats &buttons = buttonStats();
+    const ZeroTrackStats &zero = zeroTrackStats();
+    switch (line)
     {
-        selectMenuItem();
+    case 0:
+        modemLink->stats(link);
+        out.print(F("modem rx "));
+        out.print(link.rxBytes);
+        out.print(F(" tx "));
+        out.print(link.txBytes);
+        out.print(F(" overruns "));
+        out.println(link.rxOverruns);
+        return true;
+    case 1:
+        modemLink->stats(link);
+        out.print(F("modem high water "));
+        out.print(link.rxHighWater);
+        out.print(F(" cts stalls "));
+        out.print(link.ctsStalls);
+        out.print(F(" discarded "));
+        out.println(link.txDiscarded);
+        return true;
+    case 2:
+        out.print(F("at lines "));
+        out.print(at.lines);
+        out.print(F(" urcs "));
+        out.print(at.urcs);
+        out.print(F(" truncated "));
+        out.println(at.truncated);
+        return true;
+    case 3:
+        out.print(F("at errors "));
+        out.print(at.errors);
+        out.print(F(" timeouts "));
+        out.println(at.timeouts);
+        return true;
+    case 4:
+        out.print(F("buttons edges "));
+        out.print(buttons.edges);
+        out.print(F(" bounces "));
+        out.print(buttons.bounces);
+        out.print(F(" overflows "));
+        out.println(buttons.overflows);
+        return true;
+    case 5:
+        out.print(F("buttons dropped "));
+        out.print(buttons.dropped);
+        out.print(F(" latency max "));
+        out.print(buttons.maxLatencyMs);
+        out.println(F(" ms"));
+        return true;
+    case 6:
+        out.print(F("zero drift "));
+        loadCellPrintGrams(out, loadCellDecigrams(loadCellNet(zero.drift)));
+        out.print(F(" ("));
+        out.print(zero.drift);
+        out.print(F(" counts) error "));
+        out.println(zero.lastError);
+        return true;
+    case 7:
+        out.print(F("zero adjust "));
+        out.print(zero.adjustments);
+        out.print(F(" unsteady "));
+        out.print(zero.unsteadyWindows);
+        out.print(F(" range "));
+        out.println(zero.outOfRange);
+        return true;
+    case 8:
+        out.print(F("zero last adjust "));
+        out.print(zero.adjustments ? (millis() - zero.lastAdjustMs) / 1000 : 0);
+        out.println(F("s ago"));
+        return true;
     }
-    Serial.println(readCapacitiveSensorData());
-    delay(100);
+    return profilerReport(out, line - 9);
 }
 
-void sendSMS(String message)
+void consoleStatsCommand(Print &out, char *args)
 {
-    Serial.println("Sending SMS...");
+    consoleStream(streamStatsLine);
+}
+
+void consoleMemCommand(Print &out, char *args)
+{
+    consoleStream(memoryReport);
+}
+
+void consoleFillCommand(Print &out, char *args)
+{
+    consoleStream(fillReport);
+}
+
+bool streamDigestField(Print &out, uint16_t index)
+{
+    static TelemetryDigest digest;
+    if (index == 0)
+    {
+        collectTelemetry(digest);
+        char text[TELEMETRY_TEXT_LENGTH + 1];
+        telemetryEncode(digest, text);
+        out.println(text);
+        return true;
+    }
+    uint8_t field = index - 1;
+    out.print(telemetryFieldName(field));
+    out.print('=');
+    out.println(digest.values[field]);
+    return field + 1 < TELEMETRY_FIELD_COUNT;
+}
+
+// digest prints the telemetry digest and its fields, digest send texts it
+void consoleDigestCommand(Print &out, char *args)
+{
+    char *action = consoleNextToken(args);
+    if (action != nullptr && strcmp(action, "send") == 0)
+    {
+        digestRequested = true;
+        out.println(F("ok digest queued"));
+        return;
+    }
+    consoleStream(streamDigestField);
+}
+
+bool streamSensorLine(Print &out, uint16_t line)
+{
+    CapacitiveBaselineStats baseline;
+    switch (line)
+    {
+    case 0:
+        out.print(F("capacitive "));
+        out.print(getCapacitiveSensorValue());
+        out.print(capacitiveSensor.isDetecting ? F(" detecting") : F(" clear"));
+        out.print(F(" on>="));
+        out.print(capBaselineDetect());
+        out.print(F(" off<"));
+        out.println(capBaselineClear());
+        return true;
+    case 1:
+        capBaselineStats(baseline);
+        out.print(F("baseline "));
+        out.print(baseline.baseline);
+        out.print(F(" shift "));
+        out.print(baseline.shift);
+        out.print(F(" sigma "));
+        out.print(baseline.sigmaX16 / 16);
+        out.print('.');
+        out.print((baseline.sigmaX16 % 16) * 10 / 16);
+        out.println(baseline.adaptive ? F(" adaptive") : F(" fixed"));
+        return true;
+    case 2:
+        capBaselineStats(baseline);
+        out.print(F("baseline samples "));
+        out.print(baseline.samples);
+        out.print(F(" outliers "));
+        out.println(baseline.outliers);
+        return true;
+    case 3:
+        out.print(F("inductive "));
+        out.print(inductiveSensorPin.read());
+        out.print(F(" ldr "));
+        out.println(readLDRSensorData());
+        return true;
+    case 4:
+        out.print(F("weight "));
+        if (scale.is_ready())
+        {
+            long counts = scale.read() - scale.get_offset();
+            loadCellPrintGrams(out, loadCellDecigrams(loadCellNet(counts)));
+            out.print(F(" ("));
+            out.print(counts);
+            out.println(F(" counts)"));
+        }
+        else
+        {
+            out.println(F("not ready"));
+        }
+        return true;
+    default:
+        out.print(F("distance "));
+        out.print(sonar.ping_cm());
+        out.println(F("cm"));
+        return false;
+    }
+}
+
+void consoleSensorsCommand(Print &out, char *args)
+{
+    consoleStream(streamSensorLine);
+}
+
+// Averages TARE_READINGS conversions as scale.tare() does, taking each one
+// as the HX711 has it ready instead of waiting a second for all of them
+bool streamTareStep(Print &out, uint16_t index)
+{
+    static unsigned long startTime;
+    static long sum;
+    static uint8_t readings;
+    if (index == 0)
+    {
+        startTime = millis();
+        sum = 0;
+        readings = 0;
+    }
+    if (scale.is_ready())
+    {
+        sum += scale.read();
+        readings++;
+    }
+    if (readings < TARE_READINGS)
+    {
+        if (millis() - startTime < TARE_TIMEOUT)
+        {
+            return true;
+        }
+        out.println(F("? load cell not ready"));
+        return false;
+    }
+
+    scale.set_offset(sum / TARE_READINGS);
+    zeroTrackRebase();
+    traceSample(TRACE_TARE, scale.get_offset());
+    journalRecord(JOURNAL_TARE);
+    out.println(F("ok tare"));
+    return false;
+}
+
+void consoleTareCommand(Print &out, char *args)
+{
+    consoleStream(streamTareStep);
+}
+
+// Limits converted to counts follow the calibration
+void calibrationChanged()
+{
+    classifierCalibrationChanged();
+    zeroTrackCalibrationChanged();
+}
+
+bool streamCalPoint(Print &out, uint16_t index)
+{
+    LoadCellPoint point;
+    if (!loadCellPoint(index, point))
+    {
+        return false;
+    }
+    loadCellPrintGrams(out, point.decigrams);
+    out.print(' ');
+    out.println(point.counts);
+    return true;
+}
+
+static long calibrationGrams;
+
+// Averages CALIBRATION_READINGS conversions as the HX711 has them ready,
+// records them as a point at calibrationGrams, then lists the points
+bool streamCalStep(Print &out, uint16_t index)
+{
+    static unsigned long startTime;
+    static long sum;
+    static uint8_t readings;
+    static uint16_t firstPointStep; // 0 while still reading
+    if (index == 0)
+    {
+        startTime = millis();
+        sum = 0;
+        readings = 0;
+        firstPointStep = 0;
+    }
+    if (firstPointStep > 0)
+    {
+        return streamCalPoint(out, index - firstPointStep);
+    }
+
+    if (scale.is_ready())
+    {
+        sum += scale.read();
+        readings++;
+    }
+    if (readings < CALIBRATION_READINGS)
+    {
+        if (millis() - startTime < CALIBRATION_TIMEOUT)
+        {
+            return true;
+        }
+        out.println(F("? load cell not ready"));
+        return false;
+    }
+
+    long counts = sum / CALIBRATION_READINGS - scale.get_offset();
+    if (calibrationGrams <= 0 || calibrationGrams > 3000 || !loadCellCalibrate(counts, calibrationGrams * 10))
+    {
+        out.print(F("? rejected point at "));
+        out.println(counts);
+        return false;
+    }
+    journalRecord(JOURNAL_SETTING_CHANGED, calibrationGrams);
+    calibrationChanged();
+    firstPointStep = index + 1;
+    return true;
+}
+
+// cal lists the calibration points, cal <grams> records the load on the
+// platform as a point and cal reset returns to the default slope
+void consoleCalCommand(Print &out, char *args)
+{
+    char *action = consoleNextToken(args);
+    if (action != nullptr && strcmp(action, "reset") == 0)
+    {
+        loadCellResetCalibration();
+        calibrationChanged();
+    }
+    else if (action != nullptr && consoleParseInt(action, calibrationGrams))
+    {
+        consoleStream(streamCalStep);
+        return;
+    }
+    else if (action != nullptr)
+    {
+        out.println(F("? usage: cal [<grams>|reset]"));
+        return;
+    }
+    consoleStream(streamCalPoint);
+}
+
+void consoleSetCommand(Print &out, char *args)
+{
+    char *key = consoleNextToken(args);
+    long value;
+    if (key == nullptr || !consoleParseInt(consoleNextToken(args), value))
+    {
+        out.println(F("? usage: set <contrast|brightness|detect|nobottle|adaptive|tapfirst|sleep|pickup|digest> <value>"));
+        return;
+    }
+
+    if (strcmp(key, "contrast") == 0)
+    {
+        displayState.contrast = constrain(value, MIN_CONTRAST, MAX_CONTRAST);
+        nokia.setContrast(displayState.contrast);
+    }
+    else if (strcmp(key, "brightness") == 0)
+    {
+        displayState.backlight = constrain(value, MIN_BRIGHTNESS, MAX_BRIGHTNESS);
+        analogWrite(PIN_BL, displayState.backlight);
+    }
+    else if (strcmp(key, "detect") == 0)
+    {
+        detectionThreshold = constrain(value, 0, 1023);
+    }
+    else if (strcmp(key, "nobottle") == 0)
+    {
+        noBottleThreshold = constrain(value, 0, 1023);
+    }
+    else if (strcmp(key, "adaptive") == 0)
+    {
+        capBaselineEnable(value != 0);
+    }
+    else if (strcmp(key, "tapfirst") == 0)
+    {
+        tapFirstEnabled = value != 0;
+    }
+    else if (strcmp(key, "sleep") == 0)
+    {
+        powerSetDeepSleep(value != 0);
+    }
+    else if (strcmp(key, "pickup") == 0)
+    {
+        fillSetPickupAhead(constrain(value, 0, 48)); // Hours of warning
+    }
+    else if (strcmp(key, "digest") == 0)
+    {
+        digestIntervalHours = constrain(value, 0, 168); // Hours between digests, 0 for off
+    }
+    else
+    {
+        out.print(F("? unknown key: "));
+        out.println(key);
+        return;
+    }
+
+    capBaselineSetFixed(detectionThreshold, noBottleThreshold);
+    journalRecord(JOURNAL_SETTING_CHANGED, value);
+    out.print(F("ok "));
+    out.print(key);
+    out.print(' ');
+    out.println(value);
+}
+
+bool streamModelParam(Print &out, uint16_t index)
+{
+    out.print(classifierParamName(index));
+    out.print(' ');
+    out.println(classifierGet(index));
+    return index + 1 < CLASSIFIER_PARAM_COUNT;
+}
 
-    // Clear any pending serial data
-    while (sim800lv2.available())
+// model lists the classifier parameters, model <name> <value> changes one
+void consoleModelCommand(Print &out, char *args)
+{
+    char *name = consoleNextToken(args);
+    if (name != nullptr)
     {
-        sim800lv2.read();
+        long value;
+        uint8_t param = 0;
+        while (param < CLASSIFIER_PARAM_COUNT && strcmp_P(name, (const char *)classifierParamName(param)) != 0)
+        {
+            param++;
+        }
+        if (param == CLASSIFIER_PARAM_COUNT || !consoleParseInt(consoleNextToken(args), value))
+        {
+            out.println(F("? usage: model [<name> <value>]"));
+            return;
+        }
+        classifierSet(param, constrain(value, -32000, 32000));
+        journalRecord(JOURNAL_SETTING_CHANGED, value);
     }
+    consoleStream(streamModelParam);
+}
 
-    // Set SMS mode
-    sim800lv2.println("AT+CMGF=1");
-    delay(2000); // Keep this delay to ensure SMS mode is set
+void consoleTraceCommand(Print &out, char *args)
+{
+    char *action = consoleNextToken(args);
+    if (action != nullptr && strcmp(action, "on") == 0)
+    {
+        traceStart();
+        // Lets the replay tool convert raw counts the way this kiosk does
+        traceSample(TRACE_TARE, scale.get_offset());
+        // Counts per gram x1000, from the reading at 100 g
+        traceSample(TRACE_SCALE, loadCellNet(loadCellNetFor(1000)) * 10);
+    }
+    else if (action != nullptr && strcmp(action, "off") == 0)
+    {
+        traceStop();
+    }
+    else if (action != nullptr)
+    {
+        out.println(F("? usage: trace [on|off]"));
+        return;
+    }
 
-    // Set message destination
-    sim800lv2.print("AT+CMGS=\"");
-    sim800lv2.print(maintainerNum);
-    sim800lv2.println("\"");
+    out.print(F("trace "));
+    out.print(traceEnabled ? F("on") : F("off"));
+    out.print(F(" dropped "));
+    out.println(traceDroppedPackets());
+}
+
+bool streamJournalEntry(Print &out, uint16_t index)
+{
+    JournalEntry entry;
+    if (!journalGet(index, entry))
+    {
+        out.println(F("end"));
+        return false;
+    }
+
+    out.print(entry.timeMs);
+    out.print(' ');
+    out.print(journalEventName(entry.event));
+    out.print(' ');
+    out.println(entry.value);
+    return true;
+}
 
-    // Increase delay to allow the SIM module more time to respond with ">"
-    delay(3000); // Increased from 1000ms to 2000ms
+void consoleJournalCommand(Print &out, char *args)
+{
+    char *action = consoleNextToken(args);
+    if (action != nullptr && strcmp(action, "dump") == 0)
+    {
+        consoleStream(streamJournalEntry);
+    }
+    else if (action != nullptr && strcmp(action, "clear") == 0)
+    {
+        journalClear();
+        out.println(F("ok journal cleared"));
+    }
+    else
+    {
+        out.println(F("? usage: journal <dump|clear>"));
+    }
+}
 
-    // Check for ">" response
-    if (sim800lv2.find(">"))
+// Each selftest step checks one peripheral without blocking for long
+bool streamSelfTestStep(Print &out, uint16_t index)
+{
+    switch (index)
+    {
+    case 0:
+    {
+        byte version = mfrc522.PCD_ReadRegister(mfrc522.VersionReg);
+        out.print(version == 0x91 || version == 0x92 ? F("PASS") : F("FAIL"));
+        out.print(F(" rfid version 0x"));
+        out.println(version, HEX);
+        return true;
+    }
+    case 1:
     {
-        // Send message content
-        sim800lv2.println(message);
+        bool ready = scale.wait_ready_timeout(200);
+        out.print(ready ? F("PASS") : F("FAIL"));
+        out.println(F(" load cell"));
+        return true;
+    }
+    case 2:
+    {
+        int value = getCapacitiveSensorValue();
+        out.print(value > 0 && value < 1023 ? F("PASS") : F("FAIL"));
+        out.print(F(" capacitive "));
+        out.println(value);
+        return true;
+    }
+    case 3:
+    {
+        unsigned int distance = sonar.ping_cm();
+        out.print(distance > 0 ? F("PASS") : F("WARN"));
+        out.print(F(" sonar "));
+        out.print(distance);
+        out.println(F("cm"));
+        return true;
+    }
+    default:
+        out.println(F("selftest done"));
+        return false;
+    }
+}
+
+void consoleSelfTestCommand(Print &out, char *args)
+{
+    consoleStream(streamSelfTestStep);
+}
+
+void consoleHelpCommand(Print &out, char *args);
+
+ConsoleCommand consoleCommands[] = {
+    {"help", consoleHelpCommand},
+    {"stats", consoleStatsCommand},
+    {"sensors", consoleSensorsCommand},
+    {"mem", consoleMemCommand},
+    {"fill", consoleFillCommand},
+    {"digest", consoleDigestCommand},
+    {"tare", consoleTareCommand},
+    {"cal", consoleCalCommand},
+    {"set", consoleSetCommand},
+    {"model", consoleModelCommand},
+    {"journal", consoleJournalCommand},
+    {"trace", consoleTraceCommand},
+    {"selftest", consoleSelfTestCommand}};
+
+bool streamHelpName(Print &out, uint16_t index)
+{
+    const uint16_t count = sizeof(consoleCommands) / sizeof(consoleCommands[0]);
+    out.print(consoleCommands[index].name);
+    if (index + 1 < count)
+    {
+        out.print(' ');
+        return true;
+    }
+    out.println();
+    return false;
+}
+
+void consoleHelpCommand(Print &out, char *args)
+{
+    consoleStream(streamHelpName);
+}
+
+// Unsolicited result codes from the SIM800, see AtParser.h
+void modemSmsReceived(const char *line, uint8_t length, uint8_t part)
+{
+    // The +CMT header, then the message text (AT+CNMI=1,2 routes it here).
+    // Commands are taken from the maintainer's number only.
+    static bool fromMaintainer = false;
+    if (part == 0)
+    {
+        fromMaintainer = strstr(line, maintainerNum.c_str()) != nullptr;
+        return;
+    }
+    LOG_INFO(LOG_SMS_RECEIVED, length);
+    if (fromMaintainer && strncasecmp(line, "DIGEST", 6) == 0)
+    {
+        digestRequested = true; // Sent from loop(), not from inside another command's wait
+    }
+}
+
+void modemRegistration(const char *line, uint8_t length, uint8_t part)
+{
+    // "+CREG: <stat>" unsolicited, "+CREG: <n>,<stat>" in reply to AT+CREG?
+    const char *comma = strrchr(line, ',');
+    LOG_INFO(LOG_MODEM_REGISTRATION, atoi(comma != nullptr ? comma + 1 : line + 6));
+}
+
+void modemRing(const char *line, uint8_t length, uint8_t part)
+{
+    LOG_INFO(LOG_MODEM_RING);
+}
+
+const AtUrc modemUrcs[] = {
+    {"+CMT:", 1, modemSmsReceived},
+    {"+CREG:", 0, modemRegistration},
+    {"RING", 0, modemRing}};
+
+// Polls the AT parser until the command finishes; URCs are dispatched
+// meanwhile. A byte takes about 1 ms at 9600 baud, so looking once a
+// millisecond loses nothing.
+AtResult modemWait()
+{
+    AtResult result;
+    while ((result = atResult()) == AT_PENDING)
+    {
+        watchdogKick(WATCHDOG_MODEM);
+        delay(1);
+    }
+    return result;
+}
+
+// Sends a command and waits for its final result code
+AtResult modemCommand(const __FlashStringHelper *command)
+{
+    atCommand(MODEM_COMMAND_TIMEOUT).print(command);
+    atEnd();
+    return modemWait();
+}
+
+void setup()
+{
+    // Start serial first for debugging
+    Serial.begin(9600);
+    logBegin(Serial);
+    traceBegin(Serial);
+    watchdogBegin();
+    lastStateBegin();
+
+    // After a watchdog reset the peripherals kept their power and settings,
+    // so the slow settling and modem setup are skipped
+    const WatchdogStats &watchdog = watchdogStats();
+    bool fastBoot = watchdog.resetCause == RESET_WATCHDOG;
+    LastState last;
+    bool haveLast = lastStateGet(last);
+    Serial.println(fastBoot ? F("PISO-BOTE restarting after watchdog reset...") : F("Starting PISO-BOTE initialization..."));
+    profilerBegin();
+    journalRecord(JOURNAL_BOOT, watchdog.resetCause);
+    LOG_WARN(LOG_RESET_CAUSE, watchdog.resetCause, watchdog.expiredTask);
+
+    // Initialize displays
+    Serial.println(F("Initializing displays..."));
+    if (!setupNokiaDisplay()) {
+        Serial.println(F("Nokia display initialization failed. System halted."));
+        while (1) { delay(1000); }
+    }
+    
+    lcd.init();
+    lcd.backlight();
+    lcd.clear();
+    lcd.print(F("Initializing..."));
+    
+    // Initialize buttons and basic pins
+    Serial.println(F("Setting up pins..."));
+    buttonsBegin();
+    pinMode(CAPACITIVE_SENSOR_PIN, INPUT);
+    pinMode(inductiveSensorPin, INPUT);
+    pinMode(PIN_RED, OUTPUT);
+    pinMode(PIN_GREEN, OUTPUT);
+    pinMode(PIN_BLUE, OUTPUT);
+    pinMode(LDR_PIN, INPUT);
+    pinMode(LED_INLET_PIN, OUTPUT);
+    
+    // Initialize sensors
+    Serial.println(F("Setting up sensors..."));
+    setupCapacitiveSensor();
+    
+    // Set initial LED status
+    ledStatusCode(200);
+
+    // Initialize servos
+    Serial.println(F("Initializing servos..."));
+    if (fastBoot) {
+        // Attach straight into the closed position, a bottle may be inside
+        servo1.write(0);
+        servo2.write(0);
+    }
+    servo1.attach(servoPin1);
+    servo2.attach(servoPin2);
+    if (!fastBoot) {
+        delay(500);  // Give servos time to initialize
+
+        // Test servos
+        Serial.println(F("Testing servo movements..."));
+        openCloseBinLid(1, false);
+        openCloseBinLid(2, false);
         delay(500);
+    }
+    watchdogKick(WATCHDOG_BOOT);
+
+    // Initialize scale
+    Serial.println(F("Initializing load cell..."));
+    scale.begin(LOADCELL_DOUT_PIN, LOADCELL_SCK_PIN);
+    if (fastBoot && haveLast) {
+        // Keep the old zero so a bottle left on the platform still weighs
+        scale.set_offset(last.tareOffset);
+    } else {
+        if (!fastBoot) {
+            delay(1000);  // Give the scale time to stabilize
+        }
+        // A missing HX711 would block tare() forever and reset in a loop
+        if (scale.wait_ready_timeout(2000)) {
+            scale.tare();
+        }
+    }
+    loadCellBegin();
+    classifierBegin();
+    zeroTrackBegin();
+    Serial.println(F("Load cell initialized"));
+    watchdogKick(WATCHDOG_BOOT);
+
+    // Initialize RFID
+    Serial.println(F("Setting up RFID..."));
+    setUpRFID();
+    watchdogKick(WATCHDOG_BOOT);
+    
+    // Initialize GSM module
+    Serial.println(F("Setting up GSM module..."));
+    modemLink->begin(9600);
+    atBegin(*modemLink, modemUrcs, sizeof(modemUrcs) / sizeof(modemUrcs[0]));
+    if (!fastBoot) {
+        delay(3000);  // Give the module time to initialize
+        watchdogKick(WATCHDOG_BOOT);
+
+        // Configure GSM
+        Serial.println(F("Configuring GSM..."));
+        WatchdogScope watchdog(WATCHDOG_MODEM);
+        modemCommand(F("AT"));
+        modemCommand(F("AT+CMGF=1"));
+        modemCommand(F("AT+CNMI=1,2,0,0,0"));
+        modemCommand(F("AT+IFC=2,2")); // RTS/CTS flow control
+
+        // Test GSM
+        if (modemCommand(F("AT")) != AT_OK)
+        {
+            Serial.println(F("GSM module not responding"));
+        }
+    }
+    
+    // Initialize coin hopper
+    Serial.println(F("Setting up coin hopper..."));
+    pinMode(coinHopperSensor_PIN, INPUT_PULLUP);
+    pinMode(relayPin, OUTPUT);
+    relayPin.low();
+    
+    // Final display setup
+    pinMode(PIN_BL, OUTPUT);
+    analogWrite(PIN_BL, 255);
+    updateMenuDisplay();
 
-        // Send message termination character
-        sim800lv2.write(0x1A); // Ctrl+Z character
-        delay(1000);
+    // Send initialization message
+    if (!fastBoot) {
+        Serial.println(F("Sending initialization SMS..."));
+        sendSMS("PISO-BOTE system initialized");
+    }
+    
+    consoleBegin(Serial, consoleCommands, sizeof(consoleCommands) / sizeof(consoleCommands[0]));
+    Serial.println(F("Initialization complete!"));
+    watchdogLeave(WATCHDOG_BOOT);
+    watchdogEnter(WATCHDOG_LOOP);
+    powerActivity();
+    if (haveLast && (fastBoot || last.kind != LAST_STATE_IDLE)) {
+        resumeLastState(last, fastBoot);
+        return;
+    }
+    lcd.clear();
+    lcd.print(F("Ready!"));
+    delay(1000);
+    
+    // Show main menu
+    updateMenuDisplay();
+}
 
-        // Wait for and check response
-        unsigned long start = millis();
-        bool success = false;
+void loop()
+{
+    profilerLoopMark();
+    watchdogKick(WATCHDOG_LOOP);
+    consolePoll();
+    atPoll();
+    logFlush();
+    traceFlush();
+    memoryPoll();
 
-        while (millis() - start < 10000)
-        { // 10-second timeout
-            if (sim800lv2.available())
-            {
-                String response = sim800lv2.readString();
-                if (response.indexOf("OK") != -1)
-                {
-                    success = true;
-                    break;
-                }
-            }
-            delay(100);
+    if (maintenanceMode)
+    {
+        handleMaintenanceMode();
+        return;
+    }
+
+    static unsigned long lastBinCheck = 0;
+    if (appliedPowerLevel == POWER_ACTIVE || millis() - lastBinCheck >= IDLE_BIN_CHECK_INTERVAL)
+    {
+        lastBinCheck = millis();
+        if (isBinFull())
+        {
+            maintenanceMode = true;
+            kioskStats.binFullEvents++;
+            journalRecord(JOURNAL_BIN_FULL);
+            applyPowerLevel(POWER_ACTIVE);
+            displayNokiaStatus("System Full", ERROR_ICON);
+            return;
         }
+    }
+    static unsigned long lastFillSample = 0;
+    if (millis() - lastFillSample >= FILL_SAMPLE_INTERVAL_MS)
+    {
+        lastFillSample = millis();
+        trackBinFill();
+    }
+    static unsigned long lastDigest = 0;
+    if (digestRequested ||
+        (digestIntervalHours > 0 && millis() - lastDigest >= digestIntervalHours * 3600000UL))
+    {
+        lastDigest = millis();
+        digestRequested = false;
+        sendTelemetryDigest();
+    }
 
-        if (success)
+    ButtonEvent event;
+    while (buttonNext(event))
+    {
+        powerActivity();
+        if (appliedPowerLevel != POWER_ACTIVE)
         {
-            Serial.println("SMS sent successfully!");
+            // The first press on a dim or dark kiosk only wakes it
+            applyPowerLevel(POWER_ACTIVE);
+            buttonsFlush();
+            break;
+        }
+        if (event.type != BUTTON_PRESS && event.type != BUTTON_REPEAT)
+        {
+            continue;
+        }
+        if (event.button == BUTTON_DOWN)
+        {
+            navigateMenu(1);
+        }
+        else if (event.button == BUTTON_UP)
+        {
+            navigateMenu(-1);
+        }
+        else if (event.type == BUTTON_PRESS)
+        {
+            selectMenuItem();
+            powerActivity(); // Idle time starts when the action ends
+        }
+    }
+    if (tapFirstEnabled && currentMenu == &mainMenu && detectMenuCard())
+    {
+        WatchdogScope watchdog(WATCHDOG_ACTION);
+        powerActivity();
+        applyPowerLevel(POWER_ACTIVE);
+        cardSessionAction();
+        zeroTrackHold();
+        updateMenuDisplay();
+        powerActivity();
+    }
+
+    applyPowerLevel(powerLevel());
+    readCapacitiveSensorData();
+    if (appliedPowerLevel != POWER_DEEP)
+    {
+        trackScaleZero();
+    }
+    powerSleep();
+}
+
+// Steps the peripherals to an idle power level, see PowerManager.h
+void applyPowerLevel(uint8_t level)
+{
+    if (level == appliedPowerLevel)
+    {
+        return;
+    }
+
+    if (level == POWER_ACTIVE)
+    {
+        if (appliedPowerLevel == POWER_DEEP)
+        {
+            // Servo keeps the last written angle, so the lids do not move
+            servo1.attach(servoPin1);
+            servo2.attach(servoPin2);
+            scale.power_up();
+            mfrc522.PCD_AntennaOn();
+            zeroTrackHold(); // Let the first conversions settle
+        }
+        setDisplayPower(true, true);
+        analogWrite(PIN_BL, displayState.backlight);
+        ledStatusCode(200);
+        updateMenuDisplay();
+    }
+    else
+    {
+        analogWrite(PIN_RED, 0);
+        analogWrite(PIN_GREEN, 0);
+        analogWrite(PIN_BLUE, 0);
+        if (level == POWER_DIM)
+        {
+            setDisplayPower(true, false);
+            analogWrite(PIN_BL, displayState.backlight / 8);
         }
         else
         {
-            Serial.println("SMS sending failed - timeout");
+            setDisplayPower(false, false);
+            servo1.detach();
+            servo2.detach();
+            scale.power_down();
+            mfrc522.PCD_AntennaOff();
         }
     }
+    appliedPowerLevel = level;
+}
+
+// Tap-first poll from the menu. While dark the RFID field is only switched
+// on for the poll, once per loop tick.
+bool detectMenuCard()
+{
+    if (appliedPowerLevel != POWER_DEEP)
+    {
+        return detectCard();
+    }
+    mfrc522.PCD_AntennaOn();
+    delay(RFID_FIELD_SETTLE);
+    if (detectCard())
+    {
+        return true;
+    }
+    mfrc522.PCD_AntennaOff();
+    return false;
+}
+
+// Follows load cell drift while the kiosk is idle, see ZeroTracker.h
+void trackScaleZero()
+{
+    if (capacitiveSensor.isDetecting)
+    {
+        zeroTrackHold();
+        return;
+    }
+    if (!scale.is_ready())
+    {
+        return;
+    }
+
+    int32_t correction = zeroTrackSample(scale.read() - scale.get_offset());
+    if (correction != 0)
+    {
+        scale.set_offset(scale.get_offset() + correction);
+        traceSample(TRACE_TARE, scale.get_offset());
+        LOG_DEBUG(LOG_ZERO_ADJUST, correction, zeroTrackStats().drift);
+    }
+}
+
+void sendSMS(String message)
+{
+    WatchdogScope watchdog(WATCHDOG_MODEM);
+    Serial.println("Sending SMS...");
+
+    if (modemCommand(F("AT+CMGF=1")) != AT_OK)
+    {
+        Serial.println(F("SMS sending failed - modem not ready"));
+        return;
+    }
+
+    Print &command = atCommand(MODEM_PROMPT_TIMEOUT);
+    command.print(F("AT+CMGS=\""));
+    command.print(maintainerNum);
+    command.print('"');
+    atEnd();
+    if (modemWait() != AT_PROMPT)
+    {
+        Serial.println(F("SMS sending failed - no prompt received"));
+        return;
+    }
+
+    atCommand(MODEM_SEND_TIMEOUT).print(message);
+    atEnd(0x1A); // Ctrl+Z sends the message
+    AtResult result = modemWait();
+    if (result == AT_OK)
+    {
+        Serial.println(F("SMS sent successfully!"));
+    }
+    else if (result == AT_TIMEOUT)
+    {
+        Serial.println(F("SMS sending failed - timeout"));
+    }
     else
     {
-        Serial.println("SMS sending failed - no prompt received");
+        Serial.print(F("SMS sending failed - error "));
+        Serial.println(atErrorCode());
     }
 }
 bool isBinFull()
 {
-    unsigned int duration = sonar.ping_median(ITERATIONS);
+    unsigned int duration;
+    {
+        PROFILE_SCOPE(PROF_SONAR_PING);
+        duration = sonar.ping_median(ITERATIONS);
+    }
     float distance = (duration / 2.0) * 0.0343;
     if (distance > 0 && distance <= 10)
     {
@@ -1934,6 +3244,85 @@ bool isBinFull()
     return false;
 }
 
+// Fill level over the whole bin depth, and the pickup alert ahead of
+// isBinFull(), see FillForecast.h
+void trackBinFill()
+{
+    unsigned int duration;
+    {
+        PROFILE_SCOPE(PROF_SONAR_PING);
+        duration = sonar.ping_median(ITERATIONS, BIN_RANGE_CM);
+    }
+    fillSample((duration / 2.0) * 0.0343, kioskStats.bottlesAccepted);
+    if (!fillPickupDue())
+    {
+        return;
+    }
+
+    const FillForecast &fill = fillForecast();
+    journalRecord(JOURNAL_PICKUP_DUE, fill.level);
+    LOG_INFO(LOG_PICKUP_DUE, fill.level, fill.minutesToFull);
+    String message = "Pickup needed ";
+    if (fill.minutesToFull != FILL_UNKNOWN)
+    {
+        message += "within " + String(fill.minutesToFull / 60 + 1) + " hours";
+    }
+    else
+    {
+        message += "soon";
+    }
+    message += ": PISO-BOTE bin is " + String(fill.level) + "% full";
+    if (fill.bottlesToFull != FILL_UNKNOWN)
+    {
+        message += ", about " + String(fill.bottlesToFull) + " bottles left";
+    }
+    sendSMS(message);
+}
+
+// Counters for the telemetry digest, see Telemetry.h
+void collectTelemetry(TelemetryDigest &digest)
+{
+    static uint16_t sequence = 0;
+    uint32_t *values = digest.values;
+    const WatchdogStats &watchdog = watchdogStats();
+    const FillForecast &fill = fillForecast();
+    const AtStats &at = atStats();
+
+    values[TELEMETRY_UNIT] = KIOSK_UNIT_ID;
+    values[TELEMETRY_SEQUENCE] = sequence++;
+    values[TELEMETRY_UPTIME_MIN] = millis() / 60000;
+    values[TELEMETRY_RESET_CAUSE] = watchdog.resetCause;
+    values[TELEMETRY_EXPIRED_TASK] = watchdog.expiredTask;
+    values[TELEMETRY_ACCEPTED] = kioskStats.bottlesAccepted;
+    values[TELEMETRY_REJECTED] = kioskStats.bottlesRejected;
+    values[TELEMETRY_REJECT_NO_OBJECT] = kioskStats.rejectedFor[CLASSIFIER_NO_OBJECT];
+    values[TELEMETRY_REJECT_WEIGHT] = kioskStats.rejectedFor[CLASSIFIER_WEIGHT];
+    values[TELEMETRY_REJECT_METAL] = kioskStats.rejectedFor[CLASSIFIER_METAL];
+    values[TELEMETRY_REJECT_OPAQUE] = kioskStats.rejectedFor[CLASSIFIER_OPAQUE];
+    values[TELEMETRY_COINS] = kioskStats.coinsDispensed;
+    values[TELEMETRY_CARD_TAPS] = kioskStats.cardTaps;
+    values[TELEMETRY_DISPENSE_FAULTS] = kioskStats.dispenseFaults;
+    values[TELEMETRY_FILL_LEVEL] = fill.level;
+    values[TELEMETRY_MINUTES_TO_FULL] = fill.minutesToFull;
+    values[TELEMETRY_BIN_FULL] = kioskStats.binFullEvents;
+    values[TELEMETRY_BIN_EMPTIED] = fill.emptied;
+    values[TELEMETRY_WATCHDOG_LATE] = watchdog.lateKicks;
+    values[TELEMETRY_MODEM_ERRORS] = at.errors + at.timeouts;
+    values[TELEMETRY_RFID_ERRORS] = kioskStats.rfidErrors;
+    values[TELEMETRY_LOG_DROPPED] = logDroppedCount();
+    MemoryStats memory;
+    values[TELEMETRY_MEMORY_HEADROOM] = memoryStats(memory) ? memory.headroom : 0;
+}
+
+void sendTelemetryDigest()
+{
+    TelemetryDigest digest;
+    collectTelemetry(digest);
+    char text[TELEMETRY_TEXT_LENGTH + 1];
+    telemetryEncode(digest, text);
+    sendSMS(text);
+}
+
 void handleMaintenanceMode()
 {
     lcd.clear();
@@ -1944,122 +3333,42 @@ void handleMaintenanceMode()
     while (isBinFull())
     {
         ledStatusCode(404);
+        watchdogKick(WATCHDOG_LOOP);
         delay(5000);
     }
     maintenanceMode = false;
+    fillEmptied();
     lcd.clear();
     lcd.print("PISO-BOTE ready");
     ledStatusCode(200);
     delay(2000);
 }
 
-// 2. Replace the existing isWeightAcceptable() function with this new version
-bool isWeightAcceptable() {
-    // Use more readings for better stability
-    const int STABLE_READINGS = 10;
-    float readings[STABLE_READINGS];
-    float totalWeight = 0;
-    
-    // Take multiple readings with longer delay between them
-    for (int i = 0; i < STABLE_READINGS; i++) {
-        readings[i] = scale.get_units();
-        delay(200);  // Longer delay for better stability
-    }
-    
-    // Calculate average and check stability
-    float maxReading = readings[0];
-    float minReading = readings[0];
-    
-    for (int i = 0; i < STABLE_READINGS; i++) {
-        totalWeight += readings[i];
-        maxReading = max(maxReading, readings[i]);
-        minReading = min(minReading, readings[i]);
-    }
-    
-    float averageWeight = totalWeight / STABLE_READINGS;
-    float variability = maxReading - minReading;
-    
-    // Debug output
-    Serial.print("Average Weight: ");
-    Serial.print(averageWeight);
-    Serial.print("g, Variability: ");
-    Serial.print(variability);
-    Serial.println("g");
-    
-    // Check if readings are stable enough
-    // if (variability > STABILITY_THRESHOLD * 2) {  // Increased threshold
-    //     delayWithMsg(1000, "Unstable weight", "Please try again", 404);
-    //     return false;
-    // }
-    
-    // More lenient weight validation
-    const float WEIGHT_TOLERANCE = 2.0;  // Added tolerance
-    
-    if (averageWeight < (MIN_ACCEPTABLE_WEIGHT - WEIGHT_TOLERANCE)) {
-        delayWithMsg(1000, "Too light:", String(averageWeight, 1) + "g", 404);
-        return false;
-    }
-    
-    if (averageWeight > (MAX_ACCEPTABLE_WEIGHT + WEIGHT_TOLERANCE)) {
-        delayWithMsg(1000, "Too heavy:", String(averageWeight, 1) + "g", 404);
-        return false;
-    }
-    
-    // Weight is acceptable
-    delayWithMsg(1000, "Weight OK:", String(averageWeight, 1) + "g", 200);
-    return true;
-}
 int readLDRSensorData()
 {
-    return digitalRead(LDR_PIN);
+    int reading = LDR_PIN.read();
+    traceSample(TRACE_LDR, reading);
+    return reading;
 }
 
 void controlLedInlet(bool isOn)
 {
-    digitalWrite(LED_INLET_PIN, isOn ? HIGH : LOW);
+    LED_INLET_PIN.write(isOn);
 }
 
-bool isObjectClear() {
-    if (!isObjectInside) {
-        return false;
-    }
-
-    const int NUM_READINGS = 5;
-    const int REQUIRED_CLEAR_READINGS = 3;
-    int clearReadings = 0;
-    
-    // LED should already be on from waitForObjectPresence()
-    
-    for (int i = 0; i < NUM_READINGS; i++) {
-        if (readLDRSensorData() == 0) {  // 0 indicates light detected
-            clearReadings++;
-        }
-        delay(100);
-    }
-    
-    bool isClear = (clearReadings >= REQUIRED_CLEAR_READINGS);
-    
-    // Display clarity status with icon based on result
-    if (isClear) {
-        delayWithMsg(1000, "Clarity Check:", "OK", 200);
-    } else {
-        delayWithMsg(1000, "Clarity Check:", "Failed", 404);
-    }
-    
-    // LED control handled by verifyObject()
-    return isClear;
-}
-void dispenseCoin(int count)
+void dispenseCoin(int count, bool resumed)
 {
+    WatchdogScope watchdog(WATCHDOG_PAYOUT);
+
     // Reset state
     coinCount = 0;
     dispensingActive = true;
+    savePayout(count, 0, resumed);
 
     // Clear any pending signals
     delay(50);
 
-    // Add serial debug message
-    Serial.println(F("Starting coin dispensing..."));
+    LOG_INFO(LOG_DISPENSE_START, count);
 
     // Update display
     lcd.clear();
@@ -2068,7 +3377,7 @@ void dispenseCoin(int count)
     lcd.print("Count: 0");
 
     // Activate relay with debounce protection
-    digitalWrite(relayPin, HIGH);
+    relayPin.high();
     delay(50); // Allow relay to settle
 
     unsigned long startTime = millis();
@@ -2079,7 +3388,8 @@ void dispenseCoin(int count)
         // Check timeout
         if (millis() - startTime > COIN_DISPENSE_TIMEOUT)
         {
-            Serial.println(F("Dispensing timeout!"));
+            LOG_WARN(LOG_DISPENSE_TIMEOUT, coinCount, count);
+            watchdogKick(WATCHDOG_PAYOUT);
             lcd.clear();
             lcd.print("Dispensing error");
             lcd.setCursor(0, 1);
@@ -2089,7 +3399,7 @@ void dispenseCoin(int count)
         }
 
         // Read sensor with debounce
-        bool currentSensorState = digitalRead(coinHopperSensor_PIN);
+        bool currentSensorState = coinHopperSensor_PIN.read();
 
         // Implement proper debounce logic
         if (currentSensorState != lastSensorState)
@@ -2099,8 +3409,11 @@ void dispenseCoin(int count)
                 if (currentSensorState == LOW)
                 { // Coin detected
                     coinCount++;
-                    Serial.print(F("Coin counted: "));
-                    Serial.println(coinCount);
+                    savePayout(count, coinCount, resumed);
+                    // Only a coin proves the hopper is running; an empty or
+                    // jammed hopper runs into the timeout above first
+                    watchdogKick(WATCHDOG_PAYOUT);
+                    LOG_DEBUG(LOG_COIN_COUNTED, coinCount, count);
 
                     // Update display
                     lcd.setCursor(7, 1);
@@ -2109,7 +3422,6 @@ void dispenseCoin(int count)
                     // Check if we've dispensed enough coins
                     if (coinCount >= count)
                     {
-                        Serial.println(F("Dispensing complete"));
                         dispensingActive = false;
                     }
                 }
@@ -2118,27 +3430,109 @@ void dispenseCoin(int count)
         }
 
         lastSensorState = currentSensorState;
+        logFlush();
+        traceFlush();
         delay(10); // Small delay to prevent tight loop
     }
 
     // Safely deactivate relay
     delay(50);
-    digitalWrite(relayPin, LOW);
+    relayPin.low();
     delay(50); // Allow relay to settle
 
+    kioskStats.coinsDispensed += coinCount;
+    saveCredit(0); // A short payout is left to staff, see the journal
+    LOG_INFO(LOG_DISPENSE_DONE, coinCount, count);
+    journalRecord(coinCount == count ? JOURNAL_COINS_DISPENSED : JOURNAL_DISPENSE_FAULT, coinCount);
+    if (coinCount != count)
+    {
+        kioskStats.dispenseFaults++;
+    }
+
     // Display final status
     lcd.clear();
     if (coinCount == count)
     {
         lcd.print("Dispensing done");
-        Serial.println(F("Dispensing successful"));
     }
     else
     {
         lcd.print("Incomplete dispense");
         lcd.setCursor(0, 1);
         lcd.print("Coins: " + String(coinCount) + "/" + String(count));
-        Serial.println(F("Dispensing incomplete"));
     }
     delay(2000);
-}
\ No newline at end of file
+}
+
+// Records the credit the customer is owed, so a reset cannot lose it
+void saveCredit(int points)
+{
+    LastState state = {points > 0 ? LAST_STATE_CREDIT : LAST_STATE_IDLE, (int16_t)points, 0, (int32_t)scale.get_offset()};
+    lastStateSave(state);
+}
+
+void savePayout(int count, int done, bool resumed)
+{
+    LastState state = {resumed ? LAST_STATE_PAYOUT_RESUMED : LAST_STATE_PAYOUT, (int16_t)count, (int16_t)done, (int32_t)scale.get_offset()};
+    lastStateSave(state);
+}
+
+// Finishes what a reset interrupted. A bottle still on the platform was
+// never credited, so it is handed back; credit goes back to the post-deposit
+// menu and a payout is completed. At most one coin can be paid twice, if
+// the reset hit between the coin passing the sensor and its record. A payout
+// is resumed only once: if that one is cut short too, the rest is left to
+// staff as a dispense fault rather than restarting the hopper on every boot.
+void resumeLastState(const LastState &last, bool weighPlatform)
+{
+    WatchdogScope watchdog(WATCHDOG_ACTION);
+
+    int32_t emptyNet = loadCellNetFor(classifierGet(CLASSIFIER_WEIGHT_MIN) / 2);
+    if (weighPlatform && scale.wait_ready_timeout(1000) && loadCellNet(scale.read() - scale.get_offset()) >= emptyNet)
+    {
+        delayWithMsg(2000, "Restarted", "Bottle returned", 404);
+        handBackObject();
+        delay(2000);
+        openCloseBinLid(1, false);
+        if (scale.wait_ready_timeout(2000))
+        {
+            scale.tare();
+            zeroTrackRebase();
+        }
+    }
+
+    if (last.kind == LAST_STATE_IDLE)
+    {
+        return;
+    }
+    LOG_INFO(LOG_RECOVERY, last.kind, last.points - last.done);
+    journalRecord(JOURNAL_RECOVERED, last.points - last.done);
+    if (last.kind == LAST_STATE_CREDIT)
+    {
+        totalPoints = last.points;
+        delayWithMsg(2000, "Restored: " + String(totalPoints), "Choose an option", 200);
+        currentMenu = &postDepositMenu;
+        updateMenuDisplay();
+    }
+    else if (last.kind == LAST_STATE_PAYOUT && last.points > last.done)
+    {
+        int remaining = last.points - last.done;
+        delayWithMsg(2000, "Resuming payout", "Coins: " + String(remaining), 102);
+        dispenseCoin(remaining, true);
+        delayWithMsg(2000, "Dispensed: " + String(coinCount), "Thank you!", 200);
+        updateMenuDisplay();
+    }
+    else if (last.kind == LAST_STATE_PAYOUT_RESUMED && last.points > last.done)
+    {
+        LOG_WARN(LOG_DISPENSE_TIMEOUT, last.done, last.points);
+        kioskStats.dispenseFaults++;
+        journalRecord(JOURNAL_DISPENSE_FAULT, last.done);
+        saveCredit(0);
+        delayWithMsg(3000, "Dispensing error", "Contact staff", 404);
+        updateMenuDisplay();
+    }
+    else if (last.kind != LAST_STATE_CREDIT)
+    {
+        saveCredit(0); // Every coin was out, only the final record was lost
+    }
+}
@@ -0,0 +1,157 @@
+// AtParser against scripted SIM800 output: command echo, final result
+// codes, the AT+CMGS prompt and +CMT bodies that look like result codes.
+#include <Arduino.h>
+#include <SimHarness.h>
+#include <string>
+#include <unity.h>
+
+#include "AtParser.h"
+
+// The parser's link: bytes queued by the test come back as modem output,
+// and whatever the parser sends is kept for inspection
+class ScriptedLink : public Stream
+{
+public:
+    int available() override { return (int)(input.size() - readPos); }
+    int read() override { return readPos < input.size() ? (uint8_t)input[readPos++] : -1; }
+    int peek() override { return readPos < input.size() ? (uint8_t)input[readPos] : -1; }
+    size_t write(uint8_t byte) override
+    {
+        sent += (char)byte;
+        return 1;
+    }
+    using Print::write;
+
+    void reply(const char *text) { input += text; }
+
+    std::string input;
+    size_t readPos = 0;
+    std::string sent;
+};
+
+static ScriptedLink link;
+static std::string cmtParts[3];
+static uint8_t cmtCalls = 0;
+
+static void onCmt(const char *line, uint8_t length, uint8_t part)
+{
+    if (part < 3)
+    {
+        cmtParts[part].assign(line, length);
+    }
+    cmtCalls++;
+}
+
+static const AtUrc urcs[] = {{"+CMT:", 1, onCmt}};
+
+void setUp()
+{
+    link = ScriptedLink();
+    for (std::string &part : cmtParts)
+    {
+        part.clear();
+    }
+    cmtCalls = 0;
+    atBegin(link, urcs, sizeof(urcs) / sizeof(urcs[0]));
+}
+
+void tearDown()
+{
+}
+
+static void test_echo_then_ok()
+{
+    atCommand(1000).print("AT");
+    atEnd();
+    TEST_ASSERT_EQUAL_STRING("AT\r", link.sent.c_str());
+    TEST_ASSERT_EQUAL(AT_PENDING, atResult());
+
+    // Echo on: the command comes back with its own \r before "\r\nOK\r\n"
+    link.reply("AT\r\r\nOK\r\n");
+    TEST_ASSERT_EQUAL(AT_OK, atResult());
+}
+
+static void test_echo_split_across_polls()
+{
+    atCommand(1000).print("AT+CMGF=1");
+    atEnd();
+    link.reply("AT+CMGF=1\r");
+    TEST_ASSERT_EQUAL(AT_PENDING, atResult());
+    link.reply("\r");
+    TEST_ASSERT_EQUAL(AT_PENDING, atResult());
+    link.reply("\nOK\r\n");
+    TEST_ASSERT_EQUAL(AT_OK, atResult());
+}
+
+static void test_error_codes()
+{
+    atCommand(1000).print("AT+CMGS=\"1\"");
+    atEnd();
+    link.reply("\r\n+CMS ERROR: 500\r\n");
+    TEST_ASSERT_EQUAL(AT_CMS_ERROR, atResult());
+    TEST_ASSERT_EQUAL(500, atErrorCode());
+
+    atCommand(1000).print("AT+FOO");
+    atEnd();
+    link.reply("\r\nERROR\r\n");
+    TEST_ASSERT_EQUAL(AT_ERROR, atResult());
+}
+
+static void test_cmt_body_reading_ok_is_not_a_result()
+{
+    atCommand(1000).print("AT");
+    atEnd();
+    link.reply("\r\n+CMT: \"+639171234567\",\"\",\"24/05/01,10:00:00+32\"\r\nOK\r\n");
+    TEST_ASSERT_EQUAL(AT_PENDING, atResult());
+    TEST_ASSERT_EQUAL(2, cmtCalls);
+    TEST_ASSERT_EQUAL_STRING("OK", cmtParts[1].c_str());
+
+    // The command's own OK still ends it
+    link.reply("\r\nOK\r\n");
+    TEST_ASSERT_EQUAL(AT_OK, atResult());
+}
+
+static void test_prompt_without_line_end()
+{
+    atCommand(1000).print("AT+CMGS=\"+639171234567\"");
+    atEnd();
+    link.reply("AT+CMGS=\"+639171234567\"\r\r\n> ");
+    TEST_ASSERT_EQUAL(AT_PROMPT, atResult());
+
+    atCommand(1000).print("hello");
+    atEnd(0x1A);
+    TEST_ASSERT_EQUAL('\x1A', link.sent.back());
+    link.reply("hello\x1A\r\n+CMGS: 12\r\n\r\nOK\r\n");
+    TEST_ASSERT_EQUAL(AT_OK, atResult());
+}
+
+static void test_timeout()
+{
+    uint16_t timeouts = atStats().timeouts;
+    atCommand(100).print("AT");
+    atEnd();
+    sim::advanceMicros(99000);
+    TEST_ASSERT_EQUAL(AT_PENDING, atResult());
+    sim::advanceMicros(1000);
+    TEST_ASSERT_EQUAL(AT_TIMEOUT, atResult());
+    TEST_ASSERT_EQUAL(timeouts + 1, atStats().timeouts);
+
+    // A late OK does not change the result
+    link.reply("\r\nOK\r\n");
+    TEST_ASSERT_EQUAL(AT_TIMEOUT, atResult());
+}
+
+int main()
+{
+    static sim::VirtualClock clock;
+    sim::setClock(&clock);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_echo_then_ok);
+    RUN_TEST(test_echo_split_across_polls);
+    RUN_TEST(test_error_codes);
+    RUN_TEST(test_cmt_body_reading_ok_is_not_a_result);
+    RUN_TEST(test_prompt_without_line_end);
+    RUN_TEST(test_timeout);
+    return UNITY_END();
+}
@@ -0,0 +1,152 @@
+// Button events from simulated pin edges: debounce, hold-to-repeat, long
+// press, and the buttons buttonsFlush() and a boot-time hold silence.
+#include <Arduino.h>
+#include <SimHarness.h>
+#include <unity.h>
+
+#include "Buttons.h"
+#include "PinMap.h"
+
+static void advanceMs(uint32_t ms)
+{
+    sim::advanceMicros(ms * 1000ULL);
+}
+
+static void press(uint8_t pin)
+{
+    sim::setDigitalInput(pin, LOW);
+}
+
+static void release(uint8_t pin)
+{
+    sim::releaseDigitalInput(pin);
+}
+
+void setUp()
+{
+    release(upButton);
+    release(downButton);
+    release(selectButton);
+    advanceMs(100);
+    buttonsBegin();
+    buttonsFlush();
+}
+
+void tearDown()
+{
+}
+
+static void test_bounces_make_one_press()
+{
+    uint16_t bounces = buttonStats().bounces;
+    press(selectButton);
+    advanceMs(2);
+    release(selectButton);
+    advanceMs(2);
+    press(selectButton);
+
+    ButtonEvent event;
+    TEST_ASSERT_TRUE(buttonNext(event));
+    TEST_ASSERT_EQUAL(BUTTON_PRESS, event.type);
+    TEST_ASSERT_EQUAL(BUTTON_SELECT, event.button);
+    TEST_ASSERT_FALSE(buttonNext(event));
+    // Only the release is a bounce; the second press matches the accepted level
+    TEST_ASSERT_EQUAL(bounces + 1, buttonStats().bounces);
+
+    advanceMs(30);
+    TEST_ASSERT_FALSE(buttonNext(event));
+    TEST_ASSERT_TRUE(buttonHeld(BUTTON_SELECT));
+
+    advanceMs(268);
+    release(selectButton);
+    TEST_ASSERT_TRUE(buttonNext(event));
+    TEST_ASSERT_EQUAL(BUTTON_RELEASE, event.type);
+    TEST_ASSERT_EQUAL(BUTTON_SELECT, event.button);
+    TEST_ASSERT_UINT_WITHIN(2, 300, event.value);
+    TEST_ASSERT_FALSE(buttonHeld(BUTTON_SELECT));
+}
+
+static void test_hold_repeats_then_long_press()
+{
+    press(upButton);
+    uint16_t repeats = 0;
+    uint8_t longPresses = 0;
+    uint32_t firstRepeatMs = 0;
+    ButtonEvent event;
+    for (uint32_t ms = 0; ms <= BUTTON_LONG_PRESS_MS + 100; ms += 10)
+    {
+        while (buttonNext(event))
+        {
+            TEST_ASSERT_EQUAL(BUTTON_UP, event.button);
+            if (event.type == BUTTON_REPEAT)
+            {
+                TEST_ASSERT_EQUAL(repeats + 1, event.value);
+                if (repeats++ == 0)
+                {
+                    firstRepeatMs = ms;
+                }
+            }
+            else if (event.type == BUTTON_LONG_PRESS)
+            {
+                longPresses++;
+            }
+        }
+        advanceMs(10);
+    }
+    TEST_ASSERT_UINT_WITHIN(10, BUTTON_REPEAT_DELAY_MS, firstRepeatMs);
+    TEST_ASSERT_TRUE(repeats >= 6);
+    TEST_ASSERT_EQUAL(1, longPresses);
+    release(upButton);
+    TEST_ASSERT_TRUE(buttonNext(event));
+    TEST_ASSERT_EQUAL(BUTTON_RELEASE, event.type);
+}
+
+static void test_flush_mutes_a_held_button_until_released()
+{
+    press(downButton);
+    ButtonEvent event;
+    TEST_ASSERT_TRUE(buttonNext(event));
+    buttonsFlush();
+
+    advanceMs(BUTTON_LONG_PRESS_MS + 100);
+    release(downButton);
+    TEST_ASSERT_FALSE(buttonNext(event));
+
+    advanceMs(50);
+    press(downButton);
+    TEST_ASSERT_TRUE(buttonNext(event));
+    TEST_ASSERT_EQUAL(BUTTON_PRESS, event.type);
+    TEST_ASSERT_EQUAL(BUTTON_DOWN, event.button);
+}
+
+static void test_button_held_at_boot_stays_quiet()
+{
+    press(selectButton);
+    advanceMs(50);
+    buttonsBegin();
+    buttonsFlush();
+
+    ButtonEvent event;
+    advanceMs(BUTTON_REPEAT_DELAY_MS + 100);
+    TEST_ASSERT_FALSE(buttonNext(event));
+    release(selectButton);
+    TEST_ASSERT_FALSE(buttonNext(event));
+
+    advanceMs(50);
+    press(selectButton);
+    TEST_ASSERT_TRUE(buttonNext(event));
+    TEST_ASSERT_EQUAL(BUTTON_PRESS, event.type);
+}
+
+int main()
+{
+    static sim::VirtualClock clock;
+    sim::setClock(&clock);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_bounces_make_one_press);
+    RUN_TEST(test_hold_repeats_then_long_press);
+    RUN_TEST(test_flush_mutes_a_held_button_until_released);
+    RUN_TEST(test_button_held_at_boot_stays_quiet);
+    return UNITY_END();
+}
@@ -0,0 +1,98 @@
+// Fill forecast over a simulated hour of steady deposits, then an emptying.
+// The module keeps its state between tests, so they run as one sequence.
+#include <Arduino.h>
+#include <SimHarness.h>
+#include <unity.h>
+
+#include "FillForecast.h"
+
+const float CM_PER_BOTTLE = 0.175f; // 0.5% of the 35 cm from empty to full
+
+static uint32_t accepted = 0;
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_level_from_distance()
+{
+    fillSample(BIN_EMPTY_CM, accepted);
+    TEST_ASSERT_EQUAL(0, fillForecast().level);
+    TEST_ASSERT_EQUAL(BIN_EMPTY_CM * 10, fillForecast().distanceMm);
+
+    // No echo reads as an empty bin
+    fillSample(0, accepted);
+    TEST_ASSERT_EQUAL(0, fillForecast().level);
+    TEST_ASSERT_EQUAL(BIN_RANGE_CM * 10, fillForecast().distanceMm);
+    TEST_ASSERT_EQUAL(FILL_UNKNOWN, fillForecast().minutesToFull);
+}
+
+static void test_forecast_from_steady_deposits()
+{
+    // One bottle a minute for an hour
+    fillSetPickupAhead(3);
+    uint8_t pickups = 0;
+    for (uint8_t minute = 1; minute <= 60; minute++)
+    {
+        sim::advanceMicros(FILL_SAMPLE_INTERVAL_MS * 1000ULL);
+        accepted++;
+        fillSample(BIN_EMPTY_CM - accepted * CM_PER_BOTTLE, accepted);
+        pickups += fillPickupDue();
+    }
+
+    const FillForecast &forecast = fillForecast();
+    TEST_ASSERT_UINT_WITHIN(1, 30, forecast.level);
+    TEST_ASSERT_FLOAT_WITHIN(0.05, 0.5, forecast.percentPerBottle);
+    TEST_ASSERT_FLOAT_WITHIN(3, 60, forecast.bottlesPerHour);
+    TEST_ASSERT_UINT_WITHIN(10, 140, forecast.bottlesToFull);
+    TEST_ASSERT_UINT_WITHIN(15, 140, forecast.minutesToFull);
+    // Under three hours to full: the crew is called once
+    TEST_ASSERT_EQUAL(1, pickups);
+    TEST_ASSERT_FALSE(fillPickupDue());
+}
+
+static void test_history_buckets()
+{
+    FillBucket buckets[FILL_HISTORY];
+    TEST_ASSERT_EQUAL(2, fillHistory(buckets, FILL_HISTORY));
+    // Newest first; the bottle of minute 30 opened the second bucket
+    TEST_ASSERT_EQUAL(30, buckets[0].deposits);
+    TEST_ASSERT_EQUAL(29, buckets[1].deposits);
+    TEST_ASSERT_TRUE(buckets[0].distanceMm < buckets[1].distanceMm);
+}
+
+static void test_emptying_restarts_the_forecast()
+{
+    uint16_t emptied = fillForecast().emptied;
+    sim::advanceMicros(FILL_SAMPLE_INTERVAL_MS * 1000ULL);
+    fillSample(BIN_EMPTY_CM, accepted);
+
+    const FillForecast &forecast = fillForecast();
+    TEST_ASSERT_EQUAL(emptied + 1, forecast.emptied);
+    TEST_ASSERT_EQUAL(0, forecast.level);
+    TEST_ASSERT_EQUAL(FILL_UNKNOWN, forecast.bottlesToFull);
+    TEST_ASSERT_EQUAL(FILL_UNKNOWN, forecast.minutesToFull);
+    TEST_ASSERT_FALSE(fillPickupDue());
+
+    // A full bin calls the crew again even without a forecast
+    sim::advanceMicros(FILL_SAMPLE_INTERVAL_MS * 1000ULL);
+    fillSample(BIN_FULL_CM, accepted);
+    TEST_ASSERT_TRUE(fillPickupDue());
+}
+
+int main()
+{
+    static sim::VirtualClock clock;
+    sim::setClock(&clock);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_level_from_distance);
+    RUN_TEST(test_forecast_from_steady_deposits);
+    RUN_TEST(test_history_buckets);
+    RUN_TEST(test_emptying_restarts_the_forecast);
+    return UNITY_END();
+}
@@ -0,0 +1,127 @@
+// LastState ring in the simulated EEPROM: reload after a restart, skipped
+// rewrites, an interrupted write, and sequence numbers wrapping around.
+#include <Arduino.h>
+#include <SimHarness.h>
+#include <unity.h>
+
+#include "EepromLayout.h"
+#include "LastState.h"
+
+const int RING_BYTES = 160;
+
+static LastState stateOf(uint8_t kind, int16_t points, int16_t done)
+{
+    LastState state = {};
+    state.kind = kind;
+    state.points = points;
+    state.done = done;
+    state.tareOffset = 84000L + points;
+    return state;
+}
+
+static void assertState(const LastState &expected)
+{
+    LastState state;
+    TEST_ASSERT_TRUE(lastStateGet(state));
+    TEST_ASSERT_EQUAL(expected.kind, state.kind);
+    TEST_ASSERT_EQUAL(expected.points, state.points);
+    TEST_ASSERT_EQUAL(expected.done, state.done);
+    TEST_ASSERT_EQUAL(expected.tareOffset, state.tareOffset);
+}
+
+void setUp()
+{
+    // Erased EEPROM
+    memset(sim::eeprom() + EEPROM_LAST_STATE_ADDR, 0xFF, RING_BYTES);
+    lastStateBegin();
+}
+
+void tearDown()
+{
+}
+
+static void test_erased_has_no_record()
+{
+    LastState state;
+    TEST_ASSERT_FALSE(lastStateGet(state));
+}
+
+static void test_record_survives_a_restart()
+{
+    LastState credit = stateOf(LAST_STATE_CREDIT, 7, 0);
+    lastStateSave(credit);
+    assertState(credit);
+
+    lastStateBegin();
+    assertState(credit);
+}
+
+static void test_unchanged_state_is_not_rewritten()
+{
+    LastState payout = stateOf(LAST_STATE_PAYOUT, 5, 2);
+    lastStateSave(payout);
+    uint8_t before[RING_BYTES];
+    memcpy(before, sim::eeprom() + EEPROM_LAST_STATE_ADDR, RING_BYTES);
+
+    lastStateSave(payout);
+    TEST_ASSERT_EQUAL(0, memcmp(before, sim::eeprom() + EEPROM_LAST_STATE_ADDR, RING_BYTES));
+}
+
+static void test_interrupted_write_keeps_the_previous_record()
+{
+    LastState previous = stateOf(LAST_STATE_PAYOUT, 5, 2);
+    lastStateSave(previous);
+    uint8_t before[RING_BYTES];
+    memcpy(before, sim::eeprom() + EEPROM_LAST_STATE_ADDR, RING_BYTES);
+
+    lastStateSave(stateOf(LAST_STATE_PAYOUT, 5, 3));
+
+    // Power lost halfway through the new slot: its second half, checksum
+    // included, still holds the erased bytes
+    uint8_t *ring = sim::eeprom() + EEPROM_LAST_STATE_ADDR;
+    int first = 0;
+    while (first < RING_BYTES && ring[first] == before[first])
+    {
+        first++;
+    }
+    int last = RING_BYTES - 1;
+    while (last > first && ring[last] == before[last])
+    {
+        last--;
+    }
+    TEST_ASSERT_TRUE(first < last);
+    for (int i = (first + last) / 2; i <= last; i++)
+    {
+        ring[i] = before[i];
+    }
+
+    lastStateBegin();
+    assertState(previous);
+}
+
+static void test_newest_wins_after_the_sequence_wraps()
+{
+    // More saves than slots and than sequence numbers
+    LastState state;
+    for (int16_t i = 1; i <= 300; i++)
+    {
+        state = stateOf(LAST_STATE_CREDIT, i, 0);
+        lastStateSave(state);
+    }
+    lastStateBegin();
+    assertState(state);
+}
+
+int main()
+{
+    static sim::VirtualClock clock;
+    sim::setClock(&clock);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_erased_has_no_record);
+    RUN_TEST(test_record_survives_a_restart);
+    RUN_TEST(test_unchanged_state_is_not_rewritten);
+    RUN_TEST(test_interrupted_write_keeps_the_previous_record);
+    RUN_TEST(test_newest_wins_after_the_sequence_wraps);
+    return UNITY_END();
+}
@@ -0,0 +1,102 @@
+// Telemetry digest encoding: round trip, saturation, and the checks that
+// make telemetryDecode() refuse a damaged SMS.
+#include <Arduino.h>
+#include <unity.h>
+
+#include "Telemetry.h"
+
+static TelemetryDigest sample()
+{
+    TelemetryDigest digest;
+    for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++)
+    {
+        // Distinct values that use every byte of the field
+        uint32_t max = telemetryFieldBytes(i) >= 4 ? 0xFFFFFFFFUL : (1UL << (8 * telemetryFieldBytes(i))) - 1;
+        digest.values[i] = max - i * 3;
+    }
+    return digest;
+}
+
+void setUp()
+{
+}
+
+void tearDown()
+{
+}
+
+static void test_round_trip()
+{
+    TelemetryDigest in = sample();
+    char text[TELEMETRY_TEXT_LENGTH + 1];
+    TEST_ASSERT_EQUAL(TELEMETRY_TEXT_LENGTH, telemetryEncode(in, text));
+    TEST_ASSERT_EQUAL(TELEMETRY_TEXT_LENGTH, strlen(text));
+    TEST_ASSERT_EQUAL(0, strncmp(text, "PB1 ", TELEMETRY_TAG_LENGTH));
+
+    TelemetryDigest out;
+    TEST_ASSERT_TRUE(telemetryDecode(text, strlen(text), out));
+    for (uint8_t i = 0; i < TELEMETRY_FIELD_COUNT; i++)
+    {
+        TEST_ASSERT_EQUAL_UINT32(in.values[i], out.values[i]);
+    }
+}
+
+static void test_values_saturate_at_field_width()
+{
+    TelemetryDigest in = {};
+    in.values[TELEMETRY_FILL_LEVEL] = 1000;     // 1 byte
+    in.values[TELEMETRY_ACCEPTED] = 0x12345678; // 3 bytes
+    char text[TELEMETRY_TEXT_LENGTH + 1];
+    telemetryEncode(in, text);
+
+    TelemetryDigest out;
+    TEST_ASSERT_TRUE(telemetryDecode(text, strlen(text), out));
+    TEST_ASSERT_EQUAL_UINT32(0xFF, out.values[TELEMETRY_FILL_LEVEL]);
+    TEST_ASSERT_EQUAL_UINT32(0xFFFFFF, out.values[TELEMETRY_ACCEPTED]);
+}
+
+static void test_bad_crc_is_refused()
+{
+    char text[TELEMETRY_TEXT_LENGTH + 1];
+    telemetryEncode(sample(), text);
+
+    // Flipping the top bit of any character changes a packed byte, even in
+    // the unpadded tail whose low bits are unused
+    static const char base64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    TelemetryDigest out;
+    for (uint8_t i = TELEMETRY_TAG_LENGTH; i < TELEMETRY_TEXT_LENGTH; i++)
+    {
+        char saved = text[i];
+        text[i] = base64[(strchr(base64, saved) - base64) ^ 0x20];
+        TEST_ASSERT_FALSE(telemetryDecode(text, TELEMETRY_TEXT_LENGTH, out));
+        text[i] = saved;
+    }
+    TEST_ASSERT_TRUE(telemetryDecode(text, TELEMETRY_TEXT_LENGTH, out));
+}
+
+static void test_wrong_length_or_tag_is_refused()
+{
+    char text[TELEMETRY_TEXT_LENGTH + 2];
+    telemetryEncode(sample(), text);
+    TelemetryDigest out;
+    TEST_ASSERT_FALSE(telemetryDecode(text, TELEMETRY_TEXT_LENGTH - 1, out));
+    TEST_ASSERT_FALSE(telemetryDecode(text, TELEMETRY_TAG_LENGTH, out));
+
+    text[TELEMETRY_TEXT_LENGTH] = 'A';
+    text[TELEMETRY_TEXT_LENGTH + 1] = '\0';
+    TEST_ASSERT_FALSE(telemetryDecode(text, TELEMETRY_TEXT_LENGTH + 1, out));
+
+    telemetryEncode(sample(), text);
+    text[2] = '9'; // "PB9 ", a version this build does not know
+    TEST_ASSERT_FALSE(telemetryDecode(text, TELEMETRY_TEXT_LENGTH, out));
+}
+
+int main()
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_values_saturate_at_field_width);
+    RUN_TEST(test_bad_crc_is_refused);
+    RUN_TEST(test_wrong_length_or_tag_is_refused);
+    return UNITY_END();
+}
@@ -0,0 +1,899 @@
+// Cycle-accurate benchmarks of the ATmega2560 firmware image under simavr.
+//
+// The image is built with -D PISO_BENCH (pio run -e megabench), which turns
+// every PROFILE_SCOPE probe into a GPIOR0 marker write. This harness stamps
+// each marker with the simulated cycle counter, drives a scripted session
+// through the buttons and stubs the peripherals the firmware waits on:
+//
+//   HX711      24-bit frames shifted out on SCK, 10 samples per second
+//   ADC0       capacitive sensor level in millivolts
+//   sonar      echo pulse after each trigger
+//   MFRC522    register-level model on hardware SPI with one MIFARE 1K card,
+//              in the field only while the script holds it there
+//   PCF8574    I2C LCD backpack, every byte ACKed
+//   hopper     coin pulses while the relay is on
+//   SIM800     USART2 responder for the boot and SMS commands, CTS held on
+//
+// Results are written as one JSON object to stdout, see run.sh.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+extern "C"
+{
+#include "sim_avr.h"
+#include "sim_elf.h"
+#include "sim_io.h"
+#include "sim_time.h"
+#include "avr_adc.h"
+#include "avr_ioport.h"
+#include "avr_spi.h"
+#include "avr_twi.h"
+#include "avr_uart.h"
+}
+
+// Probe ids, button indexes and pins come from the firmware's own headers,
+// read through lib/NativeSim's Arduino.h
+#include "Buttons.h"
+#include "PinMap.h"
+#include "Profiler.h"
+
+#define F_CPU_HZ 16000000UL
+#define GPIOR0_ADDR 0x3E // I/O 0x1E in data space
+
+// JSON names, in ProfileProbeId order
+static const char *const probeNames[] = {
+    "dual_display",
+    "capacitive_read",
+    "card_read",
+    "display_frame",
+    "sonar_ping",
+    "card_write",
+    "deposit_flow"};
+static_assert(sizeof(probeNames) / sizeof(probeNames[0]) == PROF_PROBE_COUNT, "One name per probe");
+
+#define LCD_I2C_ADDRESS 0x27
+#define HX711_ZERO_COUNTS 84000L
+#define HX711_COUNTS_PER_GRAM -350.82
+#define SONAR_DISTANCE_CM 40 // Empty bin, beyond MAX_DISTANCE
+#define ADC_BASELINE_MV 1560
+#define ADC_BOTTLE_MV 3810
+#define MODEM_BYTE_US 1042   // 9600 baud
+#define MODEM_REPLY_US 20000 // Before the modem answers a command
+#define MODEM_SEND_US 500000 // Network time for an SMS
+
+static avr_t *avr;
+
+// The port letter and bit Pin<N> compiles to
+static avr_irq_t *pinIrq(uint8_t pin)
+{
+    const char portNames[] = "ABCDEFGHJKL";
+    return avr_io_getirq(avr, AVR_IOCTL_IOPORT_GETIRQ(portNames[fastpin::PIN_PORTS[pin]]), fastpin::PIN_BITS[pin]);
+}
+
+static void setPin(uint8_t pin, int level)
+{
+    avr_raise_irq(pinIrq(pin), level);
+}
+
+// ---------------------------------------------------------------------------
+// Marker statistics
+
+typedef struct
+{
+    uint32_t count;
+    avr_cycle_count_t total;
+    avr_cycle_count_t min;
+    avr_cycle_count_t max;
+} bench_stat_t;
+
+static bench_stat_t probeStats[PROF_PROBE_COUNT];
+static avr_cycle_count_t probeEntry[PROF_PROBE_COUNT];
+static bench_stat_t idleLoopStats;
+static avr_cycle_count_t lastLoopMark;
+static uint32_t loopMarks;
+
+static void statAdd(bench_stat_t *stat, avr_cycle_count_t cycles)
+{
+    if (stat->count == 0 || cycles < stat->min)
+    {
+        stat->min = cycles;
+    }
+    if (cycles > stat->max)
+    {
+        stat->max = cycles;
+    }
+    stat->total += cycles;
+    stat->count++;
+}
+
+// ---------------------------------------------------------------------------
+// Scripted session
+
+typedef enum
+{
+    STEP_WAIT_LOOPS, // arg: loop() iterations
+    STEP_PRESS,      // arg: button index
+    STEP_WAIT_EXIT,  // arg: probe id
+    STEP_WAIT_MS,    // arg: milliseconds, for screens that run no loop()
+    STEP_CARD,       // arg: 1 brings the card into the field, 0 takes it away
+    STEP_DONE
+} step_kind_t;
+
+typedef struct
+{
+    step_kind_t kind;
+    int arg;
+} step_t;
+
+static void setButton(int button, int level)
+{
+    switch (button)
+    {
+    case BUTTON_UP:
+        setPin(upButton, level);
+        break;
+    case BUTTON_DOWN:
+        setPin(downButton, level);
+        break;
+    default:
+        setPin(selectButton, level);
+        break;
+    }
+}
+
+static const step_t script[] = {
+    {STEP_WAIT_LOOPS, 50}, // Idle loop baseline
+    {STEP_PRESS, BUTTON_SELECT}, // Deposit
+    {STEP_WAIT_EXIT, PROF_DEPOSIT},
+    {STEP_WAIT_LOOPS, 3},
+    {STEP_PRESS, BUTTON_DOWN},
+    {STEP_WAIT_LOOPS, 2},
+    {STEP_PRESS, BUTTON_DOWN},
+    {STEP_WAIT_LOOPS, 2},
+    {STEP_PRESS, BUTTON_SELECT}, // Store on card
+    {STEP_WAIT_MS, 500},
+    {STEP_CARD, 1},
+    {STEP_WAIT_EXIT, PROF_WRITE_POINTS},
+    {STEP_CARD, 0}, // Lifted before the menu's tap-first poll can see it
+    {STEP_WAIT_LOOPS, 3},
+    {STEP_PRESS, BUTTON_DOWN}, // Past Batch
+    {STEP_WAIT_LOOPS, 2},
+    {STEP_PRESS, BUTTON_DOWN},
+    {STEP_WAIT_LOOPS, 2},
+    {STEP_PRESS, BUTTON_SELECT}, // Redeem from card
+    {STEP_WAIT_MS, 500},
+    {STEP_CARD, 1},
+    {STEP_WAIT_EXIT, PROF_READ_POINTS},
+    {STEP_WAIT_MS, 500},
+    {STEP_PRESS, BUTTON_SELECT}, // Confirm redeeming 0 points
+    {STEP_WAIT_EXIT, PROF_WRITE_POINTS},
+    {STEP_CARD, 0},
+    {STEP_WAIT_LOOPS, 10},
+    {STEP_DONE, 0}};
+
+static int scriptStep;
+static int stepCounter;
+static int finished;
+
+static avr_cycle_count_t releaseButton(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+    setButton((int)(intptr_t)param, 1);
+    return 0;
+}
+
+static void cardPresent(int present);
+static void scriptAdvance(void);
+
+static avr_cycle_count_t waitElapsed(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+    scriptStep++;
+    stepCounter = 0;
+    scriptAdvance();
+    return 0;
+}
+
+static void scriptAdvance(void)
+{
+    while (!finished)
+    {
+        const step_t *step = &script[scriptStep];
+        switch (step->kind)
+        {
+        case STEP_PRESS:
+            setButton(step->arg, 0);
+            avr_cycle_timer_register_usec(avr, 300000, releaseButton, (void *)(intptr_t)step->arg);
+            scriptStep++;
+            stepCounter = 0;
+            break;
+        case STEP_WAIT_MS:
+            avr_cycle_timer_register_usec(avr, step->arg * 1000UL, waitElapsed, NULL);
+            return;
+        case STEP_CARD:
+            cardPresent(step->arg);
+            scriptStep++;
+            stepCounter = 0;
+            break;
+        case STEP_DONE:
+            finished = 1;
+            return;
+        default:
+            return; // Waits are completed from the marker hook
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Intake sensors
+
+static void setIntake(int bottle)
+{
+    avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_ADC_GETIRQ, ADC_IRQ_ADC0 + CAPACITIVE_SENSOR_PIN - A0), bottle ? ADC_BOTTLE_MV : ADC_BASELINE_MV);
+    setPin(inductiveSensorPin, bottle);
+    setPin(LDR_PIN, 0);
+}
+
+static avr_cycle_count_t insertBottle(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+    setIntake(1);
+    return 0;
+}
+
+// HX711: the current frame is shifted out MSB first, one bit per SCK rising edge
+static int32_t hxGrams;
+static uint32_t hxFrame;
+static int hxBit;
+static int hxSckLevel;
+
+static avr_cycle_count_t hxConversionDone(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+    hxFrame = (uint32_t)(HX711_ZERO_COUNTS + (int32_t)(hxGrams * HX711_COUNTS_PER_GRAM)) & 0xFFFFFF;
+    hxBit = 0;
+    setPin(LOADCELL_DOUT_PIN, 0);
+    return 0;
+}
+
+static void hxSckChanged(avr_irq_t *irq, uint32_t value, void *param)
+{
+    int rising = value && !hxSckLevel;
+    hxSckLevel = value;
+    if (!rising)
+    {
+        return;
+    }
+
+    if (hxBit < 24)
+    {
+        setPin(LOADCELL_DOUT_PIN, (hxFrame >> (23 - hxBit)) & 1);
+    }
+    else if (hxBit == 24)
+    {
+        // Gain pulse ends the frame; next conversion at 10 SPS
+        setPin(LOADCELL_DOUT_PIN, 1);
+        avr_cycle_timer_register_usec(avr, 100000, hxConversionDone, NULL);
+    }
+    hxBit++;
+}
+
+// Sonar: echo goes high after the burst and stays high for the round trip
+static avr_cycle_count_t echoFall(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+    setPin(ECHO_PIN, 0);
+    return 0;
+}
+
+static avr_cycle_count_t echoRise(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+    setPin(ECHO_PIN, 1);
+    avr_cycle_timer_register_usec(avr, SONAR_DISTANCE_CM * 57, echoFall, NULL);
+    return 0;
+}
+
+static int triggerLevel;
+
+static void triggerChanged(avr_irq_t *irq, uint32_t value, void *param)
+{
+    if (value == 0 && triggerLevel)
+    {
+        avr_cycle_timer_register_usec(avr, 450, echoRise, NULL);
+    }
+    triggerLevel = value;
+}
+
+// Hopper: one coin pulse every 250 ms while the relay is energised
+static int relayOn;
+
+static avr_cycle_count_t hopperPulseEnd(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+    setPin(coinHopperSensor_PIN, 1);
+    return 0;
+}
+
+static avr_cycle_count_t hopperCoin(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+    if (!relayOn)
+    {
+        return 0;
+    }
+    setPin(coinHopperSensor_PIN, 0);
+    avr_cycle_timer_register_usec(avr, 30000, hopperPulseEnd, NULL);
+    return when + avr_usec_to_cycles(avr, 250000);
+}
+
+static void relayChanged(avr_irq_t *irq, uint32_t value, void *param)
+{
+    if (value && !relayOn)
+    {
+        avr_cycle_timer_register_usec(avr, 250000, hopperCoin, NULL);
+    }
+    relayOn = value;
+}
+
+// ---------------------------------------------------------------------------
+// SIM800 on USART2: answers each AT command line with OK, AT+CMGS with the
+// "> " prompt, and the Ctrl+Z that ends the message text with +CMGS and OK.
+// Replies go out a byte at a time at the line rate.
+
+static char modemLine[64];
+static int modemLineLength;
+static int modemInText; // Between the prompt and Ctrl+Z
+static char modemReply[64];
+static int modemReplyLength;
+static int modemReplySent;
+
+static avr_cycle_count_t modemSendByte(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+    if (modemReplySent >= modemReplyLength)
+    {
+        return 0;
+    }
+    avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('2'), UART_IRQ_INPUT), (uint8_t)modemReply[modemReplySent++]);
+    return modemReplySent < modemReplyLength ? when + avr_usec_to_cycles(avr, MODEM_BYTE_US) : 0;
+}
+
+static void modemAnswer(const char *reply, uint32_t delayUs)
+{
+    modemReplyLength = (int)strlen(reply);
+    modemReplySent = 0;
+    memcpy(modemReply, reply, modemReplyLength);
+    avr_cycle_timer_register_usec(avr, delayUs, modemSendByte, NULL);
+}
+
+static void modemByteOut(avr_irq_t *irq, uint32_t value, void *param)
+{
+    if (modemInText)
+    {
+        if (value == 0x1A)
+        {
+            modemInText = 0;
+            modemAnswer("\r\n+CMGS: 1\r\n\r\nOK\r\n", MODEM_SEND_US);
+        }
+        return;
+    }
+    if (value == '\n')
+    {
+        return;
+    }
+    if (value != '\r')
+    {
+        if (modemLineLength < (int)sizeof(modemLine) - 1)
+        {
+            modemLine[modemLineLength++] = (char)value;
+        }
+        return;
+    }
+
+    modemLine[modemLineLength] = 0;
+    modemLineLength = 0;
+    if (strncmp(modemLine, "AT+CMGS", 7) == 0)
+    {
+        modemInText = 1;
+        modemAnswer("\r\n> ", MODEM_REPLY_US);
+    }
+    else if (strncmp(modemLine, "AT", 2) == 0)
+    {
+        modemAnswer("\r\nOK\r\n", MODEM_REPLY_US);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// MFRC522 register model
+
+enum
+{
+    REG_COMMAND = 0x01,
+    REG_COM_IRQ = 0x04,
+    REG_DIV_IRQ = 0x05,
+    REG_ERROR = 0x06,
+    REG_STATUS2 = 0x08,
+    REG_FIFO_DATA = 0x09,
+    REG_FIFO_LEVEL = 0x0A,
+    REG_CONTROL = 0x0C,
+    REG_BIT_FRAMING = 0x0D,
+    REG_CRC_RESULT_H = 0x21,
+    REG_CRC_RESULT_L = 0x22,
+    REG_VERSION = 0x37
+};
+
+enum
+{
+    CMD_IDLE = 0x00,
+    CMD_CALC_CRC = 0x03,
+    CMD_TRANSCEIVE = 0x0C,
+    CMD_MF_AUTHENT = 0x0E,
+    CMD_SOFT_RESET = 0x0F
+};
+
+typedef enum
+{
+    CARD_IDLE,
+    CARD_READY,
+    CARD_ACTIVE,
+    CARD_HALTED
+} card_state_t;
+
+static uint8_t rfidRegs[64];
+static uint8_t fifo[64];
+static int fifoLength;
+static int fifoRead;
+
+static const uint8_t cardUid[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+static uint8_t cardBlocks[64][16];
+static card_state_t cardState = CARD_IDLE;
+static int cardInField; // Out of the field until the script presents it
+static int cardPendingWrite = -1;
+
+static int spiByteIndex;
+static int spiReading;
+static int spiAddress;
+
+static uint16_t crcA(const uint8_t *data, int length)
+{
+    uint16_t crc = 0x6363;
+    for (int i = 0; i < length; i++)
+    {
+        uint8_t b = data[i] ^ (uint8_t)(crc & 0xFF);
+        b ^= b << 4;
+        crc = (crc >> 8) ^ ((uint16_t)b << 8) ^ ((uint16_t)b << 3) ^ (b >> 4);
+    }
+    return crc;
+}
+
+static void fifoReply(const uint8_t *data, int length, int lastBits)
+{
+    memcpy(fifo, data, length);
+    fifoLength = length;
+    fifoRead = 0;
+    rfidRegs[REG_CONTROL] = lastBits;
+    rfidRegs[REG_COM_IRQ] |= 0x30; // RxIRq | IdleIRq
+}
+
+static void fifoReplyWithCrc(const uint8_t *data, int length)
+{
+    uint8_t frame[20];
+    memcpy(frame, data, length);
+    uint16_t crc = crcA(data, length);
+    frame[length] = crc & 0xFF;
+    frame[length + 1] = crc >> 8;
+    fifoReply(frame, length + 2, 0);
+}
+
+static void cardPresent(int present)
+{
+    cardInField = present;
+    cardState = CARD_IDLE;
+}
+
+// A halted card still in the field is lifted and presented again a second
+// later
+static avr_cycle_count_t cardRepresented(avr_t *avr, avr_cycle_count_t when, void *param)
+{
+    cardState = CARD_IDLE;
+    return 0;
+}
+
+static void rfidTransceive(void)
+{
+    const uint8_t *tx = fifo;
+    int length = fifoLength;
+    const uint8_t ack = 0x0A;
+    fifoLength = 0;
+    fifoRead = 0;
+
+    if (!cardInField)
+    {
+        rfidRegs[REG_COM_IRQ] |= 0x01; // TimerIRq: nothing answers
+        return;
+    }
+
+    if (cardPendingWrite >= 0 && length == 18)
+    {
+        memcpy(cardBlocks[cardPendingWrite], tx, 16);
+        cardPendingWrite = -1;
+        fifoReply(&ack, 1, 4);
+        return;
+    }
+
+    if ((tx[0] == 0x26 && cardState == CARD_IDLE) || tx[0] == 0x52)
+    {
+        static const uint8_t atqa[2] = {0x04, 0x00};
+        cardState = CARD_READY;
+        fifoReply(atqa, 2, 0);
+        return;
+    }
+    if (tx[0] == 0x93 && tx[1] == 0x20 && cardState == CARD_READY)
+    {
+        uint8_t reply[5];
+        memcpy(reply, cardUid, 4);
+        reply[4] = cardUid[0] ^ cardUid[1] ^ cardUid[2] ^ cardUid[3];
+        fifoReply(reply, 5, 0);
+        return;
+    }
+    if (tx[0] == 0x93 && tx[1] == 0x70 && cardState == CARD_READY)
+    {
+        static const uint8_t sak = 0x08;
+        cardState = CARD_ACTIVE;
+        fifoReplyWithCrc(&sak, 1);
+        return;
+    }
+    if (cardState == CARD_ACTIVE)
+    {
+        if (tx[0] == 0x50)
+        {
+            cardState = CARD_HALTED;
+            avr_cycle_timer_register_usec(avr, 1000000, cardRepresented, NULL);
+        }
+        else if (tx[0] == 0x30)
+        {
+            fifoReplyWithCrc(cardBlocks[tx[1] & 0x3F], 16);
+            return;
+        }
+        else if (tx[0] == 0xA0)
+        {
+            cardPendingWrite = tx[1] & 0x3F;
+            fifoReply(&ack, 1, 4);
+            return;
+        }
+    }
+
+    rfidRegs[REG_COM_IRQ] |= 0x01; // TimerIRq: no answer from the card
+}
+
+static void rfidCommand(uint8_t command)
+{
+    switch (command & 0x0F)
+    {
+    case CMD_CALC_CRC:
+    {
+        uint16_t crc = crcA(fifo, fifoLength);
+        rfidRegs[REG_CRC_RESULT_L] = crc & 0xFF;
+        rfidRegs[REG_CRC_RESULT_H] = crc >> 8;
+        rfidRegs[REG_DIV_IRQ] |= 0x04;
+        break;
+    }
+    case CMD_MF_AUTHENT:
+        fifoLength = 0;
+        rfidRegs[REG_STATUS2] |= 0x08; // MFCrypto1On
+        rfidRegs[REG_COM_IRQ] |= 0x10;
+        break;
+    case CMD_SOFT_RESET:
+        memset(rfidRegs, 0, sizeof(rfidRegs));
+        fifoLength = 0;
+        return;
+    default:
+        break;
+    }
+    rfidRegs[REG_COMMAND] = command & 0x0F;
+}
+
+static uint8_t rfidRead(int reg)
+{
+    switch (reg)
+    {
+    case REG_FIFO_DATA:
+        return fifoRead < fifoLength ? fifo[fifoRead++] : 0;
+    case REG_FIFO_LEVEL:
+        return fifoLength - fifoRead;
+    case REG_VERSION:
+        return 0x92;
+    case REG_COMMAND:
+        return rfidRegs[REG_COMMAND] == CMD_SOFT_RESET ? 0 : rfidRegs[REG_COMMAND];
+    default:
+        return rfidRegs[reg];
+    }
+}
+
+static void rfidWrite(int reg, uint8_t value)
+{
+    switch (reg)
+    {
+    case REG_COMMAND:
+        rfidCommand(value);
+        break;
+    case REG_COM_IRQ:
+    case REG_DIV_IRQ:
+        // Bit 7 selects whether the marked bits are set or cleared
+        if (value & 0x80)
+        {
+            rfidRegs[reg] |= value & 0x7F;
+        }
+        else
+        {
+            rfidRegs[reg] &= ~value;
+        }
+        break;
+    case REG_FIFO_DATA:
+        if (fifoLength < (int)sizeof(fifo))
+        {
+            fifo[fifoLength++] = value;
+        }
+        break;
+    case REG_FIFO_LEVEL:
+        if (value & 0x80)
+        {
+            fifoLength = 0;
+            fifoRead = 0;
+        }
+        break;
+    case REG_BIT_FRAMING:
+        rfidRegs[reg] = value & 0x7F;
+        if ((value & 0x80) && rfidRegs[REG_COMMAND] == CMD_TRANSCEIVE)
+        {
+            rfidTransceive();
+        }
+        break;
+    default:
+        rfidRegs[reg] = value;
+        break;
+    }
+}
+
+static void rfidSelectChanged(avr_irq_t *irq, uint32_t value, void *param)
+{
+    if (value == 0)
+    {
+        spiByteIndex = 0;
+    }
+}
+
+static void spiByteOut(avr_irq_t *irq, uint32_t value, void *param)
+{
+    uint8_t reply = 0;
+
+    if (spiByteIndex == 0)
+    {
+        spiReading = value & 0x80;
+        spiAddress = (value >> 1) & 0x3F;
+    }
+    else if (spiReading)
+    {
+        reply = rfidRead(spiAddress);
+        spiAddress = (value >> 1) & 0x3F;
+    }
+    else
+    {
+        rfidWrite(spiAddress, value);
+    }
+    spiByteIndex++;
+
+    avr_raise_irq(avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(0), SPI_IRQ_INPUT), reply);
+}
+
+// ---------------------------------------------------------------------------
+// I2C LCD backpack: acknowledge everything addressed to it
+
+static int lcdSelected;
+
+static void twiOut(avr_irq_t *irq, uint32_t value, void *param)
+{
+    avr_twi_msg_irq_t msg;
+    msg.u.v = value;
+    avr_irq_t *input = avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_INPUT);
+
+    if (msg.u.twi.msg & TWI_COND_STOP)
+    {
+        lcdSelected = 0;
+    }
+    if (msg.u.twi.msg & TWI_COND_ADDR)
+    {
+        lcdSelected = (msg.u.twi.addr >> 1) == LCD_I2C_ADDRESS;
+        if (lcdSelected)
+        {
+            avr_raise_irq(input, avr_twi_irq_msg(TWI_COND_ACK, msg.u.twi.addr, 1));
+        }
+    }
+    if (lcdSelected && (msg.u.twi.msg & TWI_COND_WRITE))
+    {
+        avr_raise_irq(input, avr_twi_irq_msg(TWI_COND_ACK, msg.u.twi.addr, 1));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Marker hook
+
+static void markerWritten(avr_t *avr, avr_io_addr_t addr, uint8_t value, void *param)
+{
+    avr->data[addr] = value;
+    avr_cycle_count_t now = avr->cycle;
+    const step_t *step = &script[scriptStep];
+
+    if (value == BENCH_LOOP)
+    {
+        if (loopMarks > 0 && scriptStep == 0)
+        {
+            statAdd(&idleLoopStats, now - lastLoopMark);
+        }
+        lastLoopMark = now;
+        loopMarks++;
+
+        if (step->kind == STEP_WAIT_LOOPS && ++stepCounter >= step->arg)
+        {
+            scriptStep++;
+            stepCounter = 0;
+            scriptAdvance();
+        }
+        return;
+    }
+
+    int id = value & ~BENCH_EXIT;
+    if (id >= PROF_PROBE_COUNT)
+    {
+        return;
+    }
+
+    if (!(value & BENCH_EXIT))
+    {
+        probeEntry[id] = now;
+        if (id == PROF_DEPOSIT)
+        {
+            // The customer drops a bottle in once the lid has opened
+            hxGrams = 25;
+            avr_cycle_timer_register_usec(avr, 2000000, insertBottle, NULL);
+        }
+        return;
+    }
+
+    statAdd(&probeStats[id], now - probeEntry[id]);
+    if (id == PROF_DEPOSIT)
+    {
+        hxGrams = 0;
+        setIntake(0);
+    }
+    if (step->kind == STEP_WAIT_EXIT && step->arg == id)
+    {
+        scriptStep++;
+        stepCounter = 0;
+        scriptAdvance();
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+static void printStat(const char *name, const bench_stat_t *stat, int last)
+{
+    printf("    \"%s\": {\"count\": %u, \"min\": %llu, \"avg\": %llu, \"max\": %llu, \"avg_us\": %.1f}%s\n",
+           name,
+           stat->count,
+           (unsigned long long)stat->min,
+           (unsigned long long)(stat->count ? stat->total / stat->count : 0),
+           (unsigned long long)stat->max,
+           stat->count ? (double)stat->total / stat->count / (F_CPU_HZ / 1000000) : 0.0,
+           last ? "" : ",");
+}
+
+static void usage(const char *program)
+{
+    fprintf(stderr, "usage: %s firmware.elf [--label TEXT] [--max-seconds N]\n", program);
+}
+
+int main(int argc, char **argv)
+{
+    const char *firmwarePath = NULL;
+    const char *label = "";
+    double maxSeconds = 300;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--label") == 0 && i + 1 < argc)
+        {
+            label = argv[++i];
+        }
+        else if (strcmp(argv[i], "--max-seconds") == 0 && i + 1 < argc)
+        {
+            maxSeconds = atof(argv[++i]);
+        }
+        else if (firmwarePath == NULL)
+        {
+            firmwarePath = argv[i];
+        }
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (firmwarePath == NULL)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    elf_firmware_t firmware;
+    memset(&firmware, 0, sizeof(firmware));
+    if (elf_read_firmware(firmwarePath, &firmware) != 0)
+    {
+        fprintf(stderr, "cannot read %s\n", firmwarePath);
+        return 1;
+    }
+
+    avr = avr_make_mcu_by_name("atmega2560");
+    if (avr == NULL)
+    {
+        fprintf(stderr, "simavr has no atmega2560 core\n");
+        return 1;
+    }
+    avr_init(avr);
+    avr->frequency = F_CPU_HZ;
+    avr->vcc = avr->avcc = avr->aref = 5000;
+    avr_load_firmware(avr, &firmware);
+
+    // Keep the firmware's serial and modem output off our JSON
+    const char uarts[] = {'0', '2'};
+    for (int i = 0; i < (int)sizeof(uarts); i++)
+    {
+        uint32_t uartFlags = 0;
+        avr_ioctl(avr, AVR_IOCTL_UART_GET_FLAGS(uarts[i]), &uartFlags);
+        uartFlags &= ~AVR_UART_FLAG_STDIO;
+        avr_ioctl(avr, AVR_IOCTL_UART_SET_FLAGS(uarts[i]), &uartFlags);
+    }
+
+    avr_register_io_write(avr, GPIOR0_ADDR, markerWritten, NULL);
+
+    setPin(selectButton, 1);
+    setPin(downButton, 1);
+    setPin(upButton, 1);
+    setPin(coinHopperSensor_PIN, 1);
+    setPin(ECHO_PIN, 0);
+    setPin(SIM_CTS, 0);
+    setIntake(0);
+    hxConversionDone(avr, 0, NULL);
+
+    avr_irq_register_notify(pinIrq(LOADCELL_SCK_PIN), hxSckChanged, NULL);
+    avr_irq_register_notify(pinIrq(TRIGGER_PIN), triggerChanged, NULL);
+    avr_irq_register_notify(pinIrq(relayPin), relayChanged, NULL);
+    avr_irq_register_notify(pinIrq(SS_PIN), rfidSelectChanged, NULL);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_SPI_GETIRQ(0), SPI_IRQ_OUTPUT), spiByteOut, NULL);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_TWI_GETIRQ(0), TWI_IRQ_OUTPUT), twiOut, NULL);
+    avr_irq_register_notify(avr_io_getirq(avr, AVR_IOCTL_UART_GETIRQ('2'), UART_IRQ_OUTPUT), modemByteOut, NULL);
+
+    const avr_cycle_count_t maxCycles = (avr_cycle_count_t)(maxSeconds * F_CPU_HZ);
+    int state = cpu_Running;
+    while (!finished && avr->cycle < maxCycles)
+    {
+        state = avr_run(avr);
+        if (state == cpu_Done || state == cpu_Crashed)
+        {
+            break;
+        }
+    }
+
+    const char *status = finished ? "ok" : (state == cpu_Crashed ? "crashed" : "timeout");
+    printf("{\n");
+    printf("  \"label\": \"%s\",\n", label);
+    printf("  \"mcu\": \"atmega2560\",\n");
+    printf("  \"f_cpu\": %lu,\n", F_CPU_HZ);
+    printf("  \"status\": \"%s\",\n", status);
+    printf("  \"script_step\": %d,\n", scriptStep);
+    printf("  \"cycles\": %llu,\n", (unsigned long long)avr->cycle);
+    printf("  \"benchmarks\": {\n");
+    printStat("loop_idle", &idleLoopStats, 0);
+    for (int i = 0; i < PROF_PROBE_COUNT; i++)
+    {
+        printStat(probeNames[i], &probeStats[i], i == PROF_PROBE_COUNT - 1);
+    }
+    printf("  }\n");
+    printf("}\n");
+
+    return finished ? 0 : 1;
+}
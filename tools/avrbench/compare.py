@@ -0,0 +1,46 @@
+#!/usr/bin/env python3
+"""Compare two avrbench JSON results.
+
+Usage: compare.py BASE.json NEW.json [--threshold PERCENT]
+
+Prints the change in average cycles per benchmark and exits with status 1
+when any benchmark got slower than the threshold (default 5%).
+"""
+
+import argparse
+import json
+import sys
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("base")
+    parser.add_argument("new")
+    parser.add_argument("--threshold", type=float, default=5.0)
+    args = parser.parse_args()
+
+    with open(args.base) as f:
+        base = json.load(f)
+    with open(args.new) as f:
+        new = json.load(f)
+
+    print(f"{'benchmark':16} {base['label']:>12} {new['label']:>12}   change")
+    regressed = False
+    for name, result in new["benchmarks"].items():
+        before = base["benchmarks"].get(name, {}).get("avg", 0)
+        after = result["avg"]
+        if before == 0 or after == 0:
+            print(f"{name:16} {before:12} {after:12}        -")
+            continue
+        change = (after - before) * 100.0 / before
+        flag = ""
+        if change > args.threshold:
+            flag = "  SLOWER"
+            regressed = True
+        print(f"{name:16} {before:12} {after:12} {change:+7.1f}%{flag}")
+
+    return 1 if regressed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,18 @@
+#!/bin/sh
+# Build the PISO_BENCH firmware image and run the simavr benchmarks on it.
+# Needs PlatformIO, simavr (libsimavr headers and library) and libelf.
+#
+#   tools/avrbench/run.sh > bench.json
+#   tools/avrbench/compare.py base.json bench.json
+set -e
+cd "$(dirname "$0")/../.."
+
+SIMAVR_CFLAGS=${SIMAVR_CFLAGS:-$(pkg-config --cflags simavr 2>/dev/null || echo -I/usr/include/simavr)}
+SIMAVR_LIBS=${SIMAVR_LIBS:-$(pkg-config --libs simavr 2>/dev/null || echo -lsimavr)}
+
+pio run -e megabench >&2
+mkdir -p .pio/build/avrbench
+c++ -O2 -std=gnu++17 $SIMAVR_CFLAGS -Iinclude -Ilib/NativeSim/src -o .pio/build/avrbench/avrbench tools/avrbench/avrbench.cpp $SIMAVR_LIBS -lelf
+
+LABEL=$(git describe --always --dirty 2>/dev/null || echo unknown)
+exec .pio/build/avrbench/avrbench .pio/build/megabench/firmware.elf --label "$LABEL" "$@"
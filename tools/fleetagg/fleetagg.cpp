@@ -0,0 +1,1065 @@
+// Fleet telemetry aggregator.
+//
+// Collects the telemetry digests kiosks send by SMS (include/Telemetry.h)
+// and their "journal dump" exports into one store, and answers fleet-wide
+// queries from it. Digests are decoded with the firmware's own schema and
+// decoder, so the wire format and the tool cannot drift apart.
+//
+// Input is text, line by line, from files or a device:
+//   - SMS received by a modem: +CMT: "<sender>","","yy/MM/dd,hh:mm:ss+zz"
+//     header lines followed by the message text, as a SIM800 prints them
+//     with AT+CNMI=1,2 (a capture, or live with listen --modem)
+//   - serial console captures: any "PB1 ..." digest text on a line, and
+//     journal dump lines "<ms> <event> <value>" after it or with --unit
+//   - a native firmware run with --modem-pty: listen --kiosk plays the
+//     SIM800 on the kiosk's pseudo-terminal and takes its SMS as received
+//
+// The store is an append-only columnar file. Every ingest appends blocks,
+// one per table, in which each column's values are stored together at the
+// schema width, so a query reads only the columns it uses and seeks over
+// the rest. Repeated digests (same unit, uptime and sequence) and journal
+// entries are dropped on ingest. "compact" rewrites many small blocks from
+// listen sessions as one per table.
+//
+// Digest counters are cumulative since boot. Rates are computed from the
+// differences between consecutive digests of a unit and the kiosk's own
+// uptime, so they do not depend on SMS delivery times; a reboot shows as
+// the uptime going back and the counters restart from zero.
+//
+// Build and run:
+//   pio run -e fleetagg
+//   .pio/build/fleetagg/program ingest fleet.pbf sms/*.txt
+//   .pio/build/fleetagg/program ingest fleet.pbf --unit 17 kiosk17-journal.txt
+//   .pio/build/fleetagg/program throughput fleet.pbf
+
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <poll.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <Arduino.h>
+#include "FillForecast.h"
+#include "Journal.h"
+#include "Telemetry.h"
+
+// ---------------------------------------------------------------------------
+// Store format
+//
+// File: "PBFLEET1", then blocks. Block: payload bytes (u32), table (u8),
+// schema version (u8), column count (u8), reserved (u8), rows (u32), one
+// width byte per column, then each column's rows little-endian at its
+// width. A block cut short by a crash ends the store.
+
+static const char STORE_MAGIC[8] = {'P', 'B', 'F', 'L', 'E', 'E', 'T', '1'};
+static const size_t BLOCK_HEADER_SIZE = 12;
+
+enum Table : uint8_t
+{
+    TABLE_DIGEST,
+    TABLE_JOURNAL
+};
+
+// Digest table: receive time, then the telemetry fields in schema order
+static const uint8_t DIGEST_RECEIVED = 0;
+static const uint8_t DIGEST_COLUMNS = 1 + TELEMETRY_FIELD_COUNT;
+
+static uint8_t digestColumn(uint8_t field)
+{
+    return 1 + field;
+}
+
+enum JournalColumn : uint8_t
+{
+    JOURNAL_COLUMN_UNIT,
+    JOURNAL_COLUMN_RECEIVED,
+    JOURNAL_COLUMN_TIME_MS,
+    JOURNAL_COLUMN_EVENT,
+    JOURNAL_COLUMN_VALUE, // int16
+    JOURNAL_COLUMNS
+};
+
+static const uint8_t JOURNAL_WIDTHS[JOURNAL_COLUMNS] = {2, 4, 4, 1, 2};
+static const uint8_t JOURNAL_SCHEMA = 1;
+
+static uint8_t columnWidth(uint8_t table, uint8_t column)
+{
+    if (table == TABLE_JOURNAL)
+    {
+        return JOURNAL_WIDTHS[column];
+    }
+    return column == DIGEST_RECEIVED ? 4 : telemetryFieldBytes(column - 1);
+}
+
+// Rows of one table, column by column; columns not asked for stay empty
+struct ColumnSet
+{
+    size_t rows = 0;
+    std::vector<std::vector<uint32_t>> columns;
+
+    explicit ColumnSet(uint8_t count) : columns(count) {}
+    uint32_t at(uint8_t column, size_t row) const { return columns[column][row]; }
+};
+
+static bool writeStoreBlock(FILE *f, uint8_t table, const ColumnSet &set)
+{
+    if (set.rows == 0)
+    {
+        return true;
+    }
+    uint8_t count = (uint8_t)set.columns.size();
+    std::vector<uint8_t> block(BLOCK_HEADER_SIZE + count);
+    block[4] = table;
+    block[5] = table == TABLE_DIGEST ? TELEMETRY_VERSION : JOURNAL_SCHEMA;
+    block[6] = count;
+    for (int i = 0; i < 4; i++)
+    {
+        block[8 + i] = (uint8_t)(set.rows >> (8 * i));
+    }
+    for (uint8_t c = 0; c < count; c++)
+    {
+        uint8_t width = columnWidth(table, c);
+        block[BLOCK_HEADER_SIZE + c] = width;
+        for (size_t row = 0; row < set.rows; row++)
+        {
+            uint32_t value = set.at(c, row);
+            for (uint8_t i = 0; i < width; i++)
+            {
+                block.push_back((uint8_t)(value >> (8 * i)));
+            }
+        }
+    }
+    uint32_t payload = (uint32_t)(block.size() - 4);
+    for (int i = 0; i < 4; i++)
+    {
+        block[i] = (uint8_t)(payload >> (8 * i));
+    }
+    return fwrite(block.data(), 1, block.size(), f) == block.size() && fflush(f) == 0;
+}
+
+static FILE *openStoreForAppend(const char *path)
+{
+    FILE *f = fopen(path, "ab+");
+    if (f == nullptr)
+    {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return nullptr;
+    }
+    fseek(f, 0, SEEK_END);
+    if (ftell(f) == 0)
+    {
+        fwrite(STORE_MAGIC, 1, sizeof(STORE_MAGIC), f);
+        fflush(f);
+    }
+    return f;
+}
+
+static uint32_t readLe(const uint8_t *p, uint8_t width)
+{
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < width; i++)
+    {
+        value |= (uint32_t)p[i] << (8 * i);
+    }
+    return value;
+}
+
+// Appends the wanted columns of every block of the table to set. A missing
+// store is an empty one.
+static bool readStore(const char *path, uint8_t table, const std::vector<uint8_t> &wanted, ColumnSet &set)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == nullptr)
+    {
+        return errno == ENOENT;
+    }
+    char magic[sizeof(STORE_MAGIC)];
+    if (fread(magic, 1, sizeof(magic), f) != sizeof(magic) || memcmp(magic, STORE_MAGIC, sizeof(magic)) != 0)
+    {
+        fprintf(stderr, "%s: not a fleet store\n", path);
+        fclose(f);
+        return false;
+    }
+
+    std::vector<bool> want(set.columns.size(), false);
+    for (uint8_t column : wanted)
+    {
+        want[column] = true;
+    }
+
+    uint8_t header[BLOCK_HEADER_SIZE];
+    std::vector<uint8_t> data;
+    while (fread(header, 1, sizeof(header), f) == sizeof(header))
+    {
+        uint32_t payload = readLe(header, 4);
+        long blockEnd = ftell(f) - (long)sizeof(header) + 4 + payload;
+        uint8_t count = header[6];
+        uint32_t rows = readLe(header + 8, 4);
+        uint8_t widths[256];
+        if (fread(widths, 1, count, f) != count)
+        {
+            break;
+        }
+        if (header[4] != table)
+        {
+            fseek(f, blockEnd, SEEK_SET);
+            continue;
+        }
+
+        // Blocks from older schemas have fewer columns; the rest read as 0
+        for (uint8_t c = 0; c < set.columns.size(); c++)
+        {
+            if (want[c])
+            {
+                set.columns[c].resize(set.rows + rows, 0);
+            }
+        }
+        bool complete = true;
+        for (uint8_t c = 0; c < count && complete; c++)
+        {
+            size_t bytes = (size_t)widths[c] * rows;
+            if (c >= set.columns.size() || !want[c])
+            {
+                complete = fseek(f, (long)bytes, SEEK_CUR) == 0;
+                continue;
+            }
+            data.resize(bytes);
+            if (fread(data.data(), 1, bytes, f) != bytes)
+            {
+                complete = false;
+                break;
+            }
+            std::vector<uint32_t> &column = set.columns[c];
+            for (uint32_t row = 0; row < rows; row++)
+            {
+                column[set.rows + row] = readLe(&data[(size_t)row * widths[c]], widths[c]);
+            }
+        }
+        if (!complete || ftell(f) != blockEnd)
+        {
+            // Torn write at the end of the store
+            for (auto &column : set.columns)
+            {
+                column.resize(set.rows);
+            }
+            break;
+        }
+        set.rows += rows;
+    }
+    fclose(f);
+    return true;
+}
+
+static std::vector<uint8_t> allColumns(uint8_t count)
+{
+    std::vector<uint8_t> columns;
+    for (uint8_t c = 0; c < count; c++)
+    {
+        columns.push_back(c);
+    }
+    return columns;
+}
+
+// ---------------------------------------------------------------------------
+// Ingest
+
+struct Ingest
+{
+    const char *storePath;
+    ColumnSet digests{DIGEST_COLUMNS};
+    ColumnSet journal{JOURNAL_COLUMNS};
+    std::set<std::tuple<uint32_t, uint32_t, uint32_t>> digestKeys; // unit, uptime, sequence
+    std::set<std::tuple<uint32_t, uint32_t, uint32_t, uint32_t>> journalKeys;
+    std::map<std::string, uint8_t> eventIds;
+    int fixedUnit = -1;       // --unit
+    uint32_t fixedTime = 0;   // --time, else the +CMT time or now
+    int lastUnit = -1;        // From the last digest in the current input
+    uint32_t pendingTime = 0; // +CMT header seen, its text comes next
+    bool pendingBody = false;
+    unsigned duplicates = 0;
+    unsigned badDigests = 0;
+
+    explicit Ingest(const char *path) : storePath(path)
+    {
+        for (uint8_t event = 0; event < JOURNAL_EVENT_COUNT; event++)
+        {
+            eventIds[(const char *)journalEventName(event)] = event;
+        }
+    }
+
+    bool loadKeys()
+    {
+        ColumnSet existing(DIGEST_COLUMNS);
+        uint8_t unit = digestColumn(TELEMETRY_UNIT);
+        uint8_t uptime = digestColumn(TELEMETRY_UPTIME_MIN);
+        uint8_t sequence = digestColumn(TELEMETRY_SEQUENCE);
+        if (!readStore(storePath, TABLE_DIGEST, {unit, uptime, sequence}, existing))
+        {
+            return false;
+        }
+        for (size_t row = 0; row < existing.rows; row++)
+        {
+            digestKeys.insert({existing.at(unit, row), existing.at(uptime, row), existing.at(sequence, row)});
+        }
+
+        ColumnSet entries(JOURNAL_COLUMNS);
+        if (!readStore(storePath, TABLE_JOURNAL, allColumns(JOURNAL_COLUMNS), entries))
+        {
+            return false;
+        }
+        for (size_t row = 0; row < entries.rows; row++)
+        {
+            journalKeys.insert({entries.at(JOURNAL_COLUMN_UNIT, row), entries.at(JOURNAL_COLUMN_TIME_MS, row),
+                                entries.at(JOURNAL_COLUMN_EVENT, row), entries.at(JOURNAL_COLUMN_VALUE, row)});
+        }
+        return true;
+    }
+
+    uint32_t receivedTime()
+    {
+        if (fixedTime != 0)
+        {
+            return fixedTime;
+        }
+        return pendingTime != 0 ? pendingTime : (uint32_t)time(nullptr);
+    }
+
+    void addDigest(const char *text, uint32_t received)
+    {
+        TelemetryDigest digest;
+        if (!telemetryDecode(text, TELEMETRY_TEXT_LENGTH, digest))
+        {
+            badDigests++;
+            return;
+        }
+        lastUnit = (int)digest.values[TELEMETRY_UNIT];
+        auto key = std::make_tuple(digest.values[TELEMETRY_UNIT], digest.values[TELEMETRY_UPTIME_MIN],
+                                   digest.values[TELEMETRY_SEQUENCE]);
+        if (!digestKeys.insert(key).second)
+        {
+            duplicates++;
+            return;
+        }
+        digests.columns[DIGEST_RECEIVED].push_back(received);
+        for (uint8_t field = 0; field < TELEMETRY_FIELD_COUNT; field++)
+        {
+            digests.columns[digestColumn(field)].push_back(digest.values[field]);
+        }
+        digests.rows++;
+    }
+
+    // Journal dump line "<ms> <event> <value>"
+    bool addJournalLine(const char *line)
+    {
+        char name[32];
+        unsigned long timeMs;
+        long value;
+        int used = 0;
+        if (sscanf(line, "%lu %31s %ld%n", &timeMs, name, &value, &used) != 3 || line[used] != '\0')
+        {
+            return false;
+        }
+        auto event = eventIds.find(name);
+        int unit = fixedUnit >= 0 ? fixedUnit : lastUnit;
+        if (event == eventIds.end() || unit < 0)
+        {
+            return false;
+        }
+        auto key = std::make_tuple((uint32_t)unit, (uint32_t)timeMs, (uint32_t)event->second, (uint32_t)(uint16_t)value);
+        if (!journalKeys.insert(key).second)
+        {
+            duplicates++;
+            return true;
+        }
+        journal.columns[JOURNAL_COLUMN_UNIT].push_back(unit);
+        journal.columns[JOURNAL_COLUMN_RECEIVED].push_back(receivedTime());
+        journal.columns[JOURNAL_COLUMN_TIME_MS].push_back(timeMs);
+        journal.columns[JOURNAL_COLUMN_EVENT].push_back(event->second);
+        journal.columns[JOURNAL_COLUMN_VALUE].push_back((uint16_t)value);
+        journal.rows++;
+        return true;
+    }
+
+    void line(const char *text)
+    {
+        while (*text == ' ' || *text == '\t')
+        {
+            text++;
+        }
+        if (strncmp(text, "+CMT:", 5) == 0)
+        {
+            pendingTime = parseCmtTime(text);
+            pendingBody = true;
+            return;
+        }
+
+        // The tag can follow other console output or log bytes on the line
+        char tag[TELEMETRY_TAG_LENGTH + 1];
+        snprintf(tag, sizeof(tag), "PB%c ", '0' + TELEMETRY_VERSION);
+        const char *digest = strstr(text, tag);
+        if (digest != nullptr && strlen(digest) >= TELEMETRY_TEXT_LENGTH)
+        {
+            addDigest(digest, receivedTime());
+        }
+        else if (!pendingBody)
+        {
+            // Binary log frames share the console; the entry is the printable tail
+            const char *entry = text;
+            for (const char *c = text; *c != '\0'; c++)
+            {
+                if ((uint8_t)*c < ' ' || (uint8_t)*c > '~')
+                {
+                    entry = c + 1;
+                }
+            }
+            addJournalLine(entry);
+        }
+        if (pendingBody)
+        {
+            pendingBody = false;
+            pendingTime = 0;
+        }
+    }
+
+    // "+CMT: "<sender>","","yy/MM/dd,hh:mm:ss+zz"", zz in quarter hours
+    static uint32_t parseCmtTime(const char *header)
+    {
+        const char *stamp = header;
+        for (int quotes = 0; quotes < 5 && stamp != nullptr; quotes++)
+        {
+            stamp = strchr(stamp, '"');
+            stamp = stamp != nullptr ? stamp + 1 : nullptr;
+        }
+        int year, month, day, hour, minute, second, zone;
+        char sign;
+        if (stamp == nullptr ||
+            sscanf(stamp, "%d/%d/%d,%d:%d:%d%c%d", &year, &month, &day, &hour, &minute, &second, &sign, &zone) != 8)
+        {
+            return 0;
+        }
+        struct tm fields = {};
+        fields.tm_year = year + 100;
+        fields.tm_mon = month - 1;
+        fields.tm_mday = day;
+        fields.tm_hour = hour;
+        fields.tm_min = minute;
+        fields.tm_sec = second;
+        long offset = zone * 15L * 60 * (sign == '-' ? -1 : 1);
+        return (uint32_t)(timegm(&fields) - offset);
+    }
+
+    void feedFile(FILE *f)
+    {
+        lastUnit = -1;
+        pendingBody = false;
+        pendingTime = 0;
+        char *buffer = nullptr;
+        size_t size = 0;
+        ssize_t length;
+        while ((length = getline(&buffer, &size, f)) >= 0)
+        {
+            // Log frames in console captures carry NUL bytes; text follows the last
+            char *text = buffer;
+            for (ssize_t i = 0; i < length; i++)
+            {
+                if (buffer[i] == '\0')
+                {
+                    text = buffer + i + 1;
+                }
+            }
+            text[strcspn(text, "\r\n")] = '\0';
+            line(text);
+        }
+        free(buffer);
+    }
+
+    bool flush()
+    {
+        FILE *f = openStoreForAppend(storePath);
+        if (f == nullptr)
+        {
+            return false;
+        }
+        bool ok = writeStoreBlock(f, TABLE_DIGEST, digests) && writeStoreBlock(f, TABLE_JOURNAL, journal);
+        fclose(f);
+        digests = ColumnSet(DIGEST_COLUMNS);
+        journal = ColumnSet(JOURNAL_COLUMNS);
+        return ok;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Live input: a modem receiving the fleet's SMS, or one kiosk's modem pty
+
+static volatile sig_atomic_t stopListening = 0;
+
+static void onSignal(int)
+{
+    stopListening = 1;
+}
+
+static int openSerial(const char *path)
+{
+    int fd = open(path, O_RDWR | O_NOCTTY);
+    if (fd < 0)
+    {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    struct termios settings;
+    if (tcgetattr(fd, &settings) == 0)
+    {
+        cfmakeraw(&settings);
+        cfsetispeed(&settings, B9600);
+        cfsetospeed(&settings, B9600);
+        tcsetattr(fd, TCSANOW, &settings);
+    }
+    return fd;
+}
+
+static void sendText(int fd, const char *text)
+{
+    size_t length = strlen(text);
+    while (length > 0)
+    {
+        ssize_t n = write(fd, text, length);
+        if (n <= 0)
+        {
+            return;
+        }
+        text += n;
+        length -= n;
+    }
+}
+
+// Stands in for the SIM800 and the network: answers AT commands and takes
+// the text after AT+CMGS as a received SMS
+struct KioskModem
+{
+    std::string line;
+    bool inBody = false;
+    unsigned sent = 0;
+
+    void feed(int fd, uint8_t c, Ingest &ingest)
+    {
+        if (inBody)
+        {
+            if (c == 0x1A)
+            {
+                inBody = false;
+                ingest.line(line.c_str());
+                char reply[32];
+                snprintf(reply, sizeof(reply), "\r\n+CMGS: %u\r\n\r\nOK\r\n", ++sent);
+                sendText(fd, reply);
+                line.clear();
+            }
+            else if (c == 0x1B)
+            {
+                inBody = false;
+                line.clear();
+            }
+            else
+            {
+                line += (char)c;
+            }
+            return;
+        }
+        if (c != '\r' && c != '\n')
+        {
+            line += (char)c;
+            return;
+        }
+        if (line.rfind("AT+CMGS=", 0) == 0)
+        {
+            inBody = true;
+            sendText(fd, "\r\n> ");
+        }
+        else if (line.rfind("AT", 0) == 0)
+        {
+            sendText(fd, "\r\nOK\r\n");
+        }
+        line.clear();
+    }
+};
+
+static const unsigned LISTEN_FLUSH_ROWS = 64;
+static const int LISTEN_FLUSH_MS = 10000;
+
+static int listen(Ingest &ingest, const char *device, bool kiosk)
+{
+    int fd = openSerial(device);
+    if (fd < 0)
+    {
+        return 1;
+    }
+    if (!kiosk)
+    {
+        // Text mode, new messages straight to the serial line as +CMT
+        sendText(fd, "AT+CMGF=1\r");
+        usleep(500000);
+        sendText(fd, "AT+CNMI=1,2,0,0,0\r");
+    }
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    fprintf(stderr, "listening on %s as %s, Ctrl-C to stop\n", device, kiosk ? "the kiosk's modem" : "a modem");
+
+    KioskModem modem;
+    std::string text;
+    struct pollfd poller = {fd, POLLIN, 0};
+    while (!stopListening)
+    {
+        int ready = poll(&poller, 1, LISTEN_FLUSH_MS);
+        if (ready < 0 && errno != EINTR)
+        {
+            break;
+        }
+        uint8_t buffer[256];
+        ssize_t n = ready > 0 ? read(fd, buffer, sizeof(buffer)) : 0;
+        if (ready > 0 && n <= 0)
+        {
+            break; // The far end went away
+        }
+        for (ssize_t i = 0; i < n; i++)
+        {
+            if (kiosk)
+            {
+                modem.feed(fd, buffer[i], ingest);
+            }
+            else if (buffer[i] == '\r' || buffer[i] == '\n')
+            {
+                ingest.line(text.c_str());
+                text.clear();
+            }
+            else if (buffer[i] == '\0')
+            {
+                text.clear();
+            }
+            else
+            {
+                text += (char)buffer[i];
+            }
+        }
+        size_t rows = ingest.digests.rows + ingest.journal.rows;
+        if (rows >= LISTEN_FLUSH_ROWS || (ready == 0 && rows > 0))
+        {
+            ingest.flush();
+        }
+    }
+    ingest.flush();
+    close(fd);
+    return 0;
+}
+
+// ---------------------------------------------------------------------------
+// Queries
+
+struct UnitSeries
+{
+    std::vector<size_t> rows; // Digest rows by receive time, then store order
+};
+
+// Counter increase over a unit's digests, and the kiosk minutes it covers
+struct Totals
+{
+    double minutes = 0;
+    uint64_t values[TELEMETRY_FIELD_COUNT] = {};
+    unsigned reboots = 0;
+};
+
+class Fleet
+{
+public:
+    ColumnSet digests{DIGEST_COLUMNS};
+    std::map<uint32_t, UnitSeries> units;
+
+    bool load(const char *path)
+    {
+        if (!readStore(path, TABLE_DIGEST, allColumns(DIGEST_COLUMNS), digests))
+        {
+            return false;
+        }
+        uint8_t unit = digestColumn(TELEMETRY_UNIT);
+        for (size_t row = 0; row < digests.rows; row++)
+        {
+            units[digests.at(unit, row)].rows.push_back(row);
+        }
+        for (auto &entry : units)
+        {
+            std::stable_sort(entry.second.rows.begin(), entry.second.rows.end(), [this](size_t a, size_t b) {
+                return digests.at(DIGEST_RECEIVED, a) < digests.at(DIGEST_RECEIVED, b);
+            });
+        }
+        return true;
+    }
+
+    uint32_t field(size_t row, uint8_t telemetryField) const
+    {
+        return digests.at(digestColumn(telemetryField), row);
+    }
+
+    Totals totals(const UnitSeries &series) const
+    {
+        Totals totals;
+        for (size_t i = 1; i < series.rows.size(); i++)
+        {
+            size_t before = series.rows[i - 1];
+            size_t after = series.rows[i];
+            uint32_t uptimeBefore = field(before, TELEMETRY_UPTIME_MIN);
+            uint32_t uptimeAfter = field(after, TELEMETRY_UPTIME_MIN);
+            bool rebooted = uptimeAfter < uptimeBefore ||
+                            field(after, TELEMETRY_SEQUENCE) < field(before, TELEMETRY_SEQUENCE);
+            totals.reboots += rebooted;
+            totals.minutes += rebooted ? uptimeAfter : uptimeAfter - uptimeBefore;
+            for (uint8_t f = 0; f < TELEMETRY_FIELD_COUNT; f++)
+            {
+                uint32_t a = field(before, f);
+                uint32_t b = field(after, f);
+                totals.values[f] += rebooted ? b : b >= a ? b - a : 0;
+            }
+        }
+        return totals;
+    }
+};
+
+static std::string formatTime(uint32_t unixTime)
+{
+    time_t t = unixTime;
+    struct tm fields;
+    gmtime_r(&t, &fields);
+    char text[32];
+    strftime(text, sizeof(text), "%Y-%m-%d %H:%M", &fields);
+    return text;
+}
+
+static double share(uint64_t part, uint64_t whole)
+{
+    return whole > 0 ? 100.0 * part / whole : 0;
+}
+
+static void queryUnits(const Fleet &fleet)
+{
+    printf("%6s %7s %-16s %-16s %7s %5s %8s %6s %6s %6s %8s\n", "unit", "digests", "first seen", "last seen",
+           "reboots", "reset", "watchdog", "modem", "rfid", "logs", "headroom");
+    for (const auto &entry : fleet.units)
+    {
+        const std::vector<size_t> &rows = entry.second.rows;
+        Totals totals = fleet.totals(entry.second);
+        size_t last = rows.back();
+        printf("%6u %7zu %-16s %-16s %7u %5u %8llu %6llu %6llu %6llu %8u\n", entry.first, rows.size(),
+               formatTime(fleet.digests.at(DIGEST_RECEIVED, rows.front())).c_str(),
+               formatTime(fleet.digests.at(DIGEST_RECEIVED, last)).c_str(), totals.reboots,
+               fleet.field(last, TELEMETRY_RESET_CAUSE),
+               (unsigned long long)totals.values[TELEMETRY_WATCHDOG_LATE],
+               (unsigned long long)totals.values[TELEMETRY_MODEM_ERRORS],
+               (unsigned long long)totals.values[TELEMETRY_RFID_ERRORS],
+               (unsigned long long)totals.values[TELEMETRY_LOG_DROPPED], fleet.field(last, TELEMETRY_MEMORY_HEADROOM));
+    }
+}
+
+static void queryThroughput(const Fleet &fleet)
+{
+    printf("%6s %8s %9s %9s %8s %8s\n", "unit", "hours", "accepted", "rejected", "per hour", "reject%");
+    Totals fleetTotals;
+    for (const auto &entry : fleet.units)
+    {
+        Totals totals = fleet.totals(entry.second);
+        uint64_t accepted = totals.values[TELEMETRY_ACCEPTED];
+        uint64_t rejected = totals.values[TELEMETRY_REJECTED];
+        double hours = totals.minutes / 60;
+        printf("%6u %8.1f %9llu %9llu %8.1f %7.1f%%\n", entry.first, hours, (unsigned long long)accepted,
+               (unsigned long long)rejected, hours > 0 ? accepted / hours : 0, share(rejected, accepted + rejected));
+        fleetTotals.minutes += totals.minutes;
+        fleetTotals.values[TELEMETRY_ACCEPTED] += accepted;
+        fleetTotals.values[TELEMETRY_REJECTED] += rejected;
+    }
+    double hours = fleetTotals.minutes / 60;
+    uint64_t accepted = fleetTotals.values[TELEMETRY_ACCEPTED];
+    uint64_t rejected = fleetTotals.values[TELEMETRY_REJECTED];
+    printf("%6s %8.1f %9llu %9llu %8.1f %7.1f%%\n", "fleet", hours, (unsigned long long)accepted,
+           (unsigned long long)rejected, hours > 0 ? accepted / hours : 0, share(rejected, accepted + rejected));
+}
+
+static void queryRejects(const Fleet &fleet)
+{
+    static const uint8_t REASONS[] = {TELEMETRY_REJECT_NO_OBJECT, TELEMETRY_REJECT_WEIGHT, TELEMETRY_REJECT_METAL,
+                                      TELEMETRY_REJECT_OPAQUE};
+    printf("%6s %9s", "unit", "rejected");
+    for (uint8_t reason : REASONS)
+    {
+        printf(" %16s", (const char *)telemetryFieldName(reason));
+    }
+    printf("\n");
+
+    uint64_t fleetRejected = 0;
+    uint64_t fleetReasons[sizeof(REASONS)] = {};
+    for (const auto &entry : fleet.units)
+    {
+        Totals totals = fleet.totals(entry.second);
+        uint64_t rejected = totals.values[TELEMETRY_REJECTED];
+        printf("%6u %9llu", entry.first, (unsigned long long)rejected);
+        for (size_t i = 0; i < sizeof(REASONS); i++)
+        {
+            uint64_t count = totals.values[REASONS[i]];
+            printf(" %9llu %5.1f%%", (unsigned long long)count, share(count, rejected));
+            fleetReasons[i] += count;
+        }
+        printf("\n");
+        fleetRejected += rejected;
+    }
+    printf("%6s %9llu", "fleet", (unsigned long long)fleetRejected);
+    for (size_t i = 0; i < sizeof(REASONS); i++)
+    {
+        printf(" %9llu %5.1f%%", (unsigned long long)fleetReasons[i], share(fleetReasons[i], fleetRejected));
+    }
+    printf("\n");
+}
+
+// Coins per accepted bottle against the fleet median, with the median
+// absolute deviation as the scale; one point buys one coin, so more coins
+// than bottles is always flagged, as are dispense faults
+static void queryPayout(const Fleet &fleet)
+{
+    struct Payout
+    {
+        uint32_t unit;
+        uint64_t accepted;
+        uint64_t coins;
+        uint64_t faults;
+        double ratio;
+    };
+    std::vector<Payout> payouts;
+    for (const auto &entry : fleet.units)
+    {
+        Totals totals = fleet.totals(entry.second);
+        uint64_t accepted = totals.values[TELEMETRY_ACCEPTED];
+        uint64_t coins = totals.values[TELEMETRY_COINS];
+        payouts.push_back({entry.first, accepted, coins, totals.values[TELEMETRY_DISPENSE_FAULTS],
+                           accepted > 0 ? (double)coins / accepted : 0});
+    }
+
+    std::vector<double> ratios;
+    for (const Payout &payout : payouts)
+    {
+        if (payout.accepted > 0)
+        {
+            ratios.push_back(payout.ratio);
+        }
+    }
+    auto median = [](std::vector<double> values) {
+        if (values.empty())
+        {
+            return 0.0;
+        }
+        std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+        return values[values.size() / 2];
+    };
+    double center = median(ratios);
+    std::vector<double> deviations;
+    for (double ratio : ratios)
+    {
+        deviations.push_back(fabs(ratio - center));
+    }
+    double scale = std::max(median(deviations) * 1.4826, 0.02);
+
+    printf("fleet median %.2f coins per bottle\n", center);
+    printf("%6s %9s %8s %6s %7s %6s  %s\n", "unit", "accepted", "coins", "ratio", "score", "faults", "flags");
+    for (const Payout &payout : payouts)
+    {
+        double score = payout.accepted > 0 ? (payout.ratio - center) / scale : 0;
+        std::string flags;
+        if (payout.coins > payout.accepted)
+        {
+            flags += " overpaid";
+        }
+        else if (fabs(score) > 3.5)
+        {
+            flags += " outlier";
+        }
+        if (payout.faults > 0)
+        {
+            flags += " faults";
+        }
+        printf("%6u %9llu %8llu %6.2f %7.1f %6llu %s\n", payout.unit, (unsigned long long)payout.accepted,
+               (unsigned long long)payout.coins, payout.ratio, score, (unsigned long long)payout.faults,
+               flags.c_str());
+    }
+}
+
+// Latest fill report per unit, soonest full first
+static void queryFill(const Fleet &fleet)
+{
+    std::vector<std::pair<uint32_t, size_t>> latest;
+    for (const auto &entry : fleet.units)
+    {
+        latest.push_back({entry.first, entry.second.rows.back()});
+    }
+    std::sort(latest.begin(), latest.end(), [&fleet](const auto &a, const auto &b) {
+        return fleet.field(a.second, TELEMETRY_MINUTES_TO_FULL) < fleet.field(b.second, TELEMETRY_MINUTES_TO_FULL);
+    });
+
+    printf("%6s %-16s %6s %12s %9s %8s\n", "unit", "reported", "level", "full in", "bin full", "emptied");
+    for (const auto &entry : latest)
+    {
+        size_t row = entry.second;
+        uint32_t minutes = fleet.field(row, TELEMETRY_MINUTES_TO_FULL);
+        char fullIn[16] = "unknown";
+        if (minutes != FILL_UNKNOWN)
+        {
+            snprintf(fullIn, sizeof(fullIn), "%uh%02um", minutes / 60, minutes % 60);
+        }
+        printf("%6u %-16s %5u%% %12s %9u %8u\n", entry.first,
+               formatTime(fleet.digests.at(DIGEST_RECEIVED, row)).c_str(), fleet.field(row, TELEMETRY_FILL_LEVEL),
+               fullIn, fleet.field(row, TELEMETRY_BIN_FULL), fleet.field(row, TELEMETRY_BIN_EMPTIED));
+    }
+}
+
+static bool compact(const char *path)
+{
+    ColumnSet digests(DIGEST_COLUMNS);
+    ColumnSet journal(JOURNAL_COLUMNS);
+    if (!readStore(path, TABLE_DIGEST, allColumns(DIGEST_COLUMNS), digests) ||
+        !readStore(path, TABLE_JOURNAL, allColumns(JOURNAL_COLUMNS), journal))
+    {
+        return false;
+    }
+    std::string temporary = std::string(path) + ".tmp";
+    remove(temporary.c_str());
+    FILE *f = openStoreForAppend(temporary.c_str());
+    if (f == nullptr)
+    {
+        return false;
+    }
+    bool ok = writeStoreBlock(f, TABLE_DIGEST, digests) && writeStoreBlock(f, TABLE_JOURNAL, journal);
+    ok = fclose(f) == 0 && ok;
+    if (!ok || rename(temporary.c_str(), path) != 0)
+    {
+        fprintf(stderr, "%s: compact failed\n", path);
+        return false;
+    }
+    printf("%zu digests, %zu journal entries\n", digests.rows, journal.rows);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s <command> STORE [options]\n"
+            "  ingest STORE [--unit N] [--time UNIX] FILE...   add SMS captures, console captures\n"
+            "                                                  or journal dumps (- for stdin)\n"
+            "  listen STORE --modem DEVICE                     receive SMS on a modem until Ctrl-C\n"
+            "  listen STORE --kiosk DEVICE                     be the modem of a --modem-pty kiosk\n"
+            "  units STORE                                     reporting, reboots and error counters\n"
+            "  throughput STORE                                bottles per hour and reject rate\n"
+            "  rejects STORE                                   reject reasons\n"
+            "  payout STORE                                    coins per bottle and dispense faults\n"
+            "  fill STORE                                      latest fill level and forecast\n"
+            "  compact STORE                                   merge the store's blocks\n",
+            program);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    const char *command = argv[1];
+    const char *store = argv[2];
+
+    if (strcmp(command, "ingest") == 0 || strcmp(command, "listen") == 0)
+    {
+        Ingest ingest(store);
+        if (!ingest.loadKeys())
+        {
+            return 1;
+        }
+        if (strcmp(command, "listen") == 0)
+        {
+            if (argc != 5 || (strcmp(argv[3], "--modem") != 0 && strcmp(argv[3], "--kiosk") != 0))
+            {
+                usage(argv[0]);
+                return 2;
+            }
+            return listen(ingest, argv[4], strcmp(argv[3], "--kiosk") == 0);
+        }
+
+        unsigned files = 0;
+        for (int i = 3; i < argc; i++)
+        {
+            if (strcmp(argv[i], "--unit") == 0 && i + 1 < argc)
+            {
+                ingest.fixedUnit = atoi(argv[++i]);
+                continue;
+            }
+            if (strcmp(argv[i], "--time") == 0 && i + 1 < argc)
+            {
+                ingest.fixedTime = strtoul(argv[++i], nullptr, 10);
+                continue;
+            }
+            FILE *f = strcmp(argv[i], "-") == 0 ? stdin : fopen(argv[i], "r");
+            if (f == nullptr)
+            {
+                fprintf(stderr, "%s: %s\n", argv[i], strerror(errno));
+                return 1;
+            }
+            ingest.feedFile(f);
+            if (f != stdin)
+            {
+                fclose(f);
+            }
+            files++;
+        }
+        size_t digests = ingest.digests.rows;
+        size_t entries = ingest.journal.rows;
+        if (!ingest.flush())
+        {
+            return 1;
+        }
+        printf("%u files: %zu digests, %zu journal entries added, %u duplicates, %u bad digests\n", files, digests,
+               entries, ingest.duplicates, ingest.badDigests);
+        return 0;
+    }
+
+    if (strcmp(command, "compact") == 0)
+    {
+        return compact(store) ? 0 : 1;
+    }
+
+    Fleet fleet;
+    if (!fleet.load(store))
+    {
+        return 1;
+    }
+    if (strcmp(command, "units") == 0)
+        queryUnits(fleet);
+    else if (strcmp(command, "throughput") == 0)
+        queryThroughput(fleet);
+    else if (strcmp(command, "rejects") == 0)
+        queryRejects(fleet);
+    else if (strcmp(command, "payout") == 0)
+        queryPayout(fleet);
+    else if (strcmp(command, "fill") == 0)
+        queryFill(fleet);
+    else
+    {
+        usage(argv[0]);
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,954 @@
+// Discrete-event throughput simulator for the PISO-BOTE kiosk.
+//
+// Links the unmodified firmware (src/) against lib/NativeSim and plays a
+// day of customers against it in virtual time. Customers only see what a
+// real customer sees - LCD text, lid and flap servos - and act through the
+// buttons, the intake (capacitive, inductive, LDR, load cell) and the card
+// reader. The hopper, bin level and modem are modelled around the firmware.
+//
+// Build and run:
+//   pio run -e kiosksim && .pio/build/kiosksim/program --hours 24 --json
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <queue>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+#include <NewPing.h>
+#include <SimHarness.h>
+#include "PinMap.h"
+
+// ---------------------------------------------------------------------------
+// Configuration
+
+struct SimConfig
+{
+    double hours = 24;
+    double arrivalsPerHour = 12;     // Mean customer arrival rate
+    double bottlesPerCustomer = 5;   // Mean, geometric distribution
+    double invalidRate = 0.10;       // Share of items that should be rejected
+    double cardRate = 0.5;           // Share of customers who store points on a card
+    int batchMin = 0;                // Customers with this many bottles use Batch (0: never)
+    bool tapFirst = false;           // Card customers start by tapping their card
+    double patienceMinutes = 10;     // Customers leave the queue after this wait
+    double reactionMean = 1.2;       // Seconds to react to a prompt
+    double hopperCoinsPerSecond = 4; // Coin hopper payout rate
+    uint32_t modemLatencyMs = 3000;  // Network time for one SMS
+    int binCapacity = 400;           // Bottles until the bin is physically full
+    double staffResponseMinutes = 90;
+    double driftGramsPerHour = 0;    // Load cell zero drift (temperature)
+    int humidityCounts = 0;          // Capacitive baseline swing (humidity)
+    unsigned long seed = 1;
+    bool json = false;
+    const char *serialPath = nullptr; // Firmware serial output, for logdecode.py
+    bool trace = false;               // Start a sensor trace capture at boot
+};
+
+// ---------------------------------------------------------------------------
+// Event queue driven by the virtual clock
+
+class EventQueue
+{
+public:
+    void at(uint64_t timeUs, std::function<void()> action)
+    {
+        events.push({timeUs, nextSeq++, std::move(action)});
+    }
+
+    void after(double seconds, std::function<void()> action)
+    {
+        at(sim::nowMicros() + (uint64_t)(seconds * 1e6), std::move(action));
+    }
+
+    void runDue(uint64_t nowUs)
+    {
+        while (!events.empty() && events.top().timeUs <= nowUs)
+        {
+            std::function<void()> action = events.top().action;
+            events.pop();
+            action();
+        }
+    }
+
+private:
+    struct Event
+    {
+        uint64_t timeUs;
+        uint64_t seq;
+        std::function<void()> action;
+        bool operator>(const Event &other) const
+        {
+            return timeUs != other.timeUs ? timeUs > other.timeUs : seq > other.seq;
+        }
+    };
+
+    std::priority_queue<Event, std::vector<Event>, std::greater<Event>> events;
+    uint64_t nextSeq = 0;
+};
+
+// ---------------------------------------------------------------------------
+// Statistics
+
+struct Sample
+{
+    std::vector<double> values;
+
+    void add(double v) { values.push_back(v); }
+    size_t count() const { return values.size(); }
+    double mean() const
+    {
+        double sum = 0;
+        for (double v : values)
+        {
+            sum += v;
+        }
+        return values.empty() ? 0 : sum / values.size();
+    }
+    double percentile(double p) const
+    {
+        if (values.empty())
+        {
+            return 0;
+        }
+        std::vector<double> sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+        size_t index = (size_t)std::min<double>(sorted.size() - 1, floor(p * sorted.size()));
+        return sorted[index];
+    }
+    double max() const
+    {
+        return values.empty() ? 0 : *std::max_element(values.begin(), values.end());
+    }
+};
+
+struct SimStats
+{
+    int arrived = 0;
+    int served = 0;
+    int abandoned = 0;
+    int inserted = 0;
+    int accepted = 0;
+    int rejected = 0;
+    int falseRejects = 0; // Valid bottle rejected
+    int falseAccepts = 0; // Invalid item accepted
+    int detectTimeouts = 0;
+    int coinsPaid = 0;
+    int cardStores = 0;
+    int binFullEvents = 0;
+    int pickupAlerts = 0;
+    int smsSent = 0;
+    int stuckSessions = 0;
+    double downtimeSeconds = 0;
+    Sample queueWait;
+    Sample sessionTime;
+    Sample coinPayoutTime;
+    Sample cardPayoutTime;
+    Sample perBottleTime;
+};
+
+// ---------------------------------------------------------------------------
+// Customers and their items
+
+enum ItemKind
+{
+    ITEM_BOTTLE,
+    ITEM_METAL,
+    ITEM_HEAVY,
+    ITEM_OPAQUE
+};
+
+struct Item
+{
+    ItemKind kind;
+    float grams;
+    int capacitive;
+    int retries = 0;
+};
+
+struct Customer
+{
+    uint64_t arrivalUs;
+    std::deque<Item> items;
+    bool usesCard;
+    bool inBatch = false; // Inside a batch or card session
+    bool inCardSession = false;
+    sim::Card card;
+};
+
+// Firmware menu state as far as a customer can track it
+enum MenuId
+{
+    MENU_MAIN,
+    MENU_POST_DEPOSIT
+};
+
+static const int MENU_ITEMS[] = {4, 3};
+static const int MAIN_DEPOSIT = 0;
+static const int MAIN_BATCH = 1;
+
+enum AgentState
+{
+    AGENT_IDLE,           // Waiting for the main menu
+    AGENT_WAIT_PROMPT,    // Pressed Deposit/Insert, waiting for the open lid
+    AGENT_BATCH_END,      // Out of bottles, waiting for the prompt to press SELECT
+    AGENT_ITEM_PLACED,    // Item on the platform, waiting for the verdict
+    AGENT_WAIT_MENU,      // Verdict seen, waiting for the menu to come back
+    AGENT_WAIT_PAYOUT,    // Redeem or Store selected
+    AGENT_CARD_TAPPED     // Card on the reader
+};
+
+static const int CAPACITIVE_BASELINE = 320;
+static const float SONAR_EMPTY_CM = 45.0f;
+static const float SONAR_FULL_CM = 8.0f;
+static const double DRIFT_STEP_SECONDS = 10;
+static const double HUMIDITY_PERIOD_HOURS = 6;
+static const uint64_t MENU_SETTLE_US = 500000;
+
+class KioskSim
+{
+public:
+    explicit KioskSim(const SimConfig &config) : config(config), rng(config.seed) {}
+
+    void start()
+    {
+        serialFile = config.serialPath ? fopen(config.serialPath, "wb") : nullptr;
+        sim::setSerialOutput(serialFile);
+        if (config.trace)
+        {
+            sim::queueSerialInput("trace on\n");
+        }
+        sim::setAnalogNoise(8);
+        sim::modem().sendLatencyMs = config.modemLatencyMs;
+        clearPlatform();
+        updateBinLevel();
+
+        sim::setTimeListener([this](uint64_t now) { events.runDue(now); });
+        scheduleArrival();
+        events.after(0.05, [this] { tick(); });
+        events.at((uint64_t)(config.hours * 3600e6), [] { sim::requestStop(); });
+        if (config.driftGramsPerHour != 0 || config.humidityCounts != 0)
+        {
+            zeroCounts = sim::loadCell().zeroCounts;
+            events.after(DRIFT_STEP_SECONDS, [this] { drift(); });
+        }
+    }
+
+    void report(FILE *out) const;
+
+private:
+    const SimConfig config;
+    FILE *serialFile = nullptr;
+    std::mt19937 rng;
+    EventQueue events;
+    SimStats stats;
+
+    std::deque<std::unique_ptr<Customer>> queue;
+    std::unique_ptr<Customer> current;
+    uint64_t sessionStartUs = 0;
+    long zeroCounts = 0;
+    uint64_t itemStartUs = 0;
+    uint64_t payoutStartUs = 0;
+    bool payoutByCard = false;
+    bool payoutShown = false; // The payout screens have come up
+    AgentState state = AGENT_IDLE;
+    uint64_t stateSinceUs = 0;
+    bool actionPending = false;
+    uint64_t menuSinceUs = 0; // When the menu last came up
+    bool menuWasVisible = false;
+    MenuId menu = MENU_MAIN;
+    int cursor[2] = {0, 0};
+    int pointsEarned = 0;
+    bool itemOnPlatform = false;
+    Item placedItem;
+
+    int binFill = 0;
+    bool binFull = false;
+    uint64_t binFullSinceUs = 0;
+    uint64_t binEmptiedUs = 0; // Alerts still in flight after emptying are ignored
+    bool crewCalled = false;   // A visit is already on its way
+    size_t smsSeen = 0;
+
+    bool relayOn = false;
+    bool coinPulseActive = false;
+
+    // -- helpers ------------------------------------------------------------
+
+    double uniform(double a, double b) { return std::uniform_real_distribution<double>(a, b)(rng); }
+    double normal(double mean, double sd) { return std::normal_distribution<double>(mean, sd)(rng); }
+    double exponential(double mean) { return std::exponential_distribution<double>(1.0 / mean)(rng); }
+    bool chance(double p) { return uniform(0, 1) < p; }
+    double reaction() { return std::max(0.3, normal(config.reactionMean, config.reactionMean / 3)); }
+
+    static bool lcdStartsWith(uint8_t row, const char *text)
+    {
+        return sim::lcdLine(row).compare(0, strlen(text), text) == 0;
+    }
+
+    void setState(AgentState next)
+    {
+        state = next;
+        stateSinceUs = sim::nowMicros();
+    }
+
+    double secondsInState() const { return (sim::nowMicros() - stateSinceUs) / 1e6; }
+
+    void press(int pin, double holdSeconds = 0.4)
+    {
+        sim::setDigitalInput(pin, LOW);
+        events.after(holdSeconds, [pin] { sim::setDigitalInput(pin, HIGH); });
+    }
+
+    // The firmware only polls buttons from loop(), so customers press only
+    // when the menu is up and the bin is not visibly full. After maintenance
+    // the firmware leaves "PISO-BOTE ready" up instead of redrawing the menu.
+    bool menuVisible() const
+    {
+        return (lcdStartsWith(0, "Welcome to") || lcdStartsWith(0, "PISO-BOTE ready")) && !binVisiblyFull();
+    }
+
+    // Same echo-time conversion and 10 cm limit as isBinFull() in the firmware
+    static bool binVisiblyFull()
+    {
+        unsigned int echoUs = (unsigned int)(sim::sonarDistanceCm() * US_ROUNDTRIP_CM);
+        return (echoUs / 2.0) * 0.0343 <= 10;
+    }
+
+    // Move the firmware cursor to an item and select it, one press at a time.
+    // Nobody presses the instant a menu is drawn; the firmware is still
+    // finishing the previous action then and would swallow the press.
+    void selectItem(MenuId target, int item, std::function<void()> onSelected)
+    {
+        actionPending = true;
+        if (!menuVisible())
+        {
+            events.after(1.0, [this, target, item, onSelected] { selectItem(target, item, onSelected); });
+            return;
+        }
+        if (sim::nowMicros() - menuSinceUs < MENU_SETTLE_US)
+        {
+            events.after(0.1, [this, target, item, onSelected] { selectItem(target, item, onSelected); });
+            return;
+        }
+
+        // A dim or dark kiosk takes one press to wake
+        if (!sim::lcdBacklight())
+        {
+            press(selectButton);
+            events.after(0.6, [this, target, item, onSelected] { selectItem(target, item, onSelected); });
+            return;
+        }
+
+        int &position = cursor[target];
+        if (position != item)
+        {
+            position = (position + 1) % MENU_ITEMS[target];
+            press(downButton);
+            events.after(0.6, [this, target, item, onSelected] { selectItem(target, item, onSelected); });
+            return;
+        }
+        press(selectButton);
+        events.after(0.5, [this, onSelected] {
+            actionPending = false;
+            onSelected();
+        });
+    }
+
+    // -- intake -------------------------------------------------------------
+
+    Item makeItem()
+    {
+        Item item;
+        item.kind = ITEM_BOTTLE;
+        item.grams = (float)std::min(64.0, std::max(9.0, normal(28, 9)));
+        item.capacitive = (int)normal(780, 70);
+
+        if (chance(config.invalidRate))
+        {
+            double pick = uniform(0, 1);
+            if (pick < 0.5)
+            {
+                item.kind = ITEM_METAL;
+                item.grams = (float)normal(15, 3);
+            }
+            else if (pick < 0.8)
+            {
+                item.kind = ITEM_HEAVY;
+                item.grams = (float)uniform(80, 300);
+            }
+            else
+            {
+                item.kind = ITEM_OPAQUE;
+            }
+        }
+        return item;
+    }
+
+    void placeItem(const Item &item)
+    {
+        placedItem = item;
+        itemOnPlatform = true;
+        sim::setAnalogInput(CAPACITIVE_SENSOR_PIN, item.capacitive + humidityOffset());
+        sim::setDigitalInput(inductiveSensorPin, item.kind == ITEM_METAL ? LOW : HIGH);
+        sim::setDigitalInput(LDR_PIN, item.kind == ITEM_OPAQUE ? HIGH : LOW);
+        sim::loadCell().grams = item.grams;
+    }
+
+    void clearPlatform()
+    {
+        itemOnPlatform = false;
+        sim::setAnalogInput(CAPACITIVE_SENSOR_PIN, CAPACITIVE_BASELINE + humidityOffset());
+        sim::setDigitalInput(inductiveSensorPin, LOW);
+        sim::setDigitalInput(LDR_PIN, LOW);
+        sim::loadCell().grams = 0;
+    }
+
+    // Capacitive offset, swinging up and down with the humidity
+    int humidityOffset() const
+    {
+        double hours = sim::nowMicros() / 3600e6;
+        return (int)(config.humidityCounts * sin(2 * M_PI * hours / HUMIDITY_PERIOD_HOURS));
+    }
+
+    // Moves the empty-platform readings with time
+    void drift()
+    {
+        double grams = config.driftGramsPerHour * sim::nowMicros() / 3600e6;
+        sim::loadCell().zeroCounts = zeroCounts + (long)(grams * sim::loadCell().countsPerGram);
+        if (config.humidityCounts != 0 && !itemOnPlatform)
+        {
+            sim::setAnalogInput(CAPACITIVE_SENSOR_PIN, CAPACITIVE_BASELINE + humidityOffset());
+        }
+        events.after(DRIFT_STEP_SECONDS, [this] { drift(); });
+    }
+
+    void updateBinLevel()
+    {
+        float level = std::min(1.0f, (float)binFill / config.binCapacity);
+        sim::setSonarDistanceCm(SONAR_EMPTY_CM - level * (SONAR_EMPTY_CM - SONAR_FULL_CM));
+    }
+
+    // -- customers ----------------------------------------------------------
+
+    void scheduleArrival()
+    {
+        events.after(exponential(3600.0 / config.arrivalsPerHour), [this] {
+            auto customer = std::make_unique<Customer>();
+            customer->arrivalUs = sim::nowMicros();
+            customer->usesCard = chance(config.cardRate);
+            int count = 1 + (int)floor(log(uniform(1e-9, 1)) / log(1.0 - 1.0 / config.bottlesPerCustomer));
+            for (int i = 0; i < count; i++)
+            {
+                customer->items.push_back(makeItem());
+            }
+            queue.push_back(std::move(customer));
+            stats.arrived++;
+            scheduleArrival();
+        });
+    }
+
+    void nextCustomer()
+    {
+        uint64_t now = sim::nowMicros();
+        while (!queue.empty())
+        {
+            std::unique_ptr<Customer> customer = std::move(queue.front());
+            queue.pop_front();
+            double wait = (now - customer->arrivalUs) / 1e6;
+            if (wait > config.patienceMinutes * 60)
+            {
+                stats.abandoned++;
+                continue;
+            }
+            stats.queueWait.add(wait);
+            current = std::move(customer);
+            sessionStartUs = now;
+            pointsEarned = 0;
+            startItem(MENU_MAIN);
+            return;
+        }
+    }
+
+    void finishCustomer()
+    {
+        stats.served++;
+        stats.sessionTime.add((sim::nowMicros() - sessionStartUs) / 1e6);
+        current.reset();
+        setState(AGENT_IDLE);
+    }
+
+    void startItem(MenuId from)
+    {
+        itemStartUs = sim::nowMicros();
+        setState(AGENT_WAIT_PROMPT);
+        if (from == MENU_MAIN && config.tapFirst && current->usesCard)
+        {
+            // The card stays on the reader for the whole session
+            current->inBatch = true;
+            current->inCardSession = true;
+            tapCard();
+            return;
+        }
+        bool batch = from == MENU_MAIN && config.batchMin > 0 && (int)current->items.size() >= config.batchMin;
+        current->inBatch = batch;
+        selectItem(from, batch ? MAIN_BATCH : MAIN_DEPOSIT, [] {}); // Insert is the first item too
+    }
+
+    void tapCard()
+    {
+        actionPending = true;
+        if (!menuVisible() || sim::nowMicros() - menuSinceUs < MENU_SETTLE_US)
+        {
+            events.after(0.2, [this] { tapCard(); });
+            return;
+        }
+        sim::presentCard(&current->card);
+        actionPending = false;
+    }
+
+    // A card session is over once the menu is back
+    void finishCardSession()
+    {
+        sim::removeCard();
+        current->inCardSession = false;
+        stats.cardStores++;
+        stats.cardPayoutTime.add((sim::nowMicros() - payoutStartUs) / 1e6);
+    }
+
+    void finishItem(bool accepted)
+    {
+        Item item = placedItem;
+        current->items.pop_front();
+        stats.perBottleTime.add((sim::nowMicros() - itemStartUs) / 1e6);
+
+        bool valid = item.kind == ITEM_BOTTLE;
+        if (accepted)
+        {
+            stats.accepted++;
+            pointsEarned++;
+            stats.falseAccepts += valid ? 0 : 1;
+            menu = current->inCardSession ? MENU_MAIN : MENU_POST_DEPOSIT;
+        }
+        else
+        {
+            stats.rejected++;
+            stats.falseRejects += valid ? 1 : 0;
+        }
+
+        // A batch session stays open for the next bottle
+        if (current->inBatch)
+        {
+            itemStartUs = sim::nowMicros();
+            setState(current->items.empty() ? AGENT_BATCH_END : AGENT_WAIT_PROMPT);
+            return;
+        }
+        setState(AGENT_WAIT_MENU);
+    }
+
+    // What to do once the menu is back after an item
+    void decideNext()
+    {
+        if (current->inCardSession)
+        {
+            finishCardSession();
+        }
+        if (!current->items.empty())
+        {
+            startItem(menu);
+            return;
+        }
+
+        if (menu == MENU_POST_DEPOSIT && pointsEarned > 0)
+        {
+            payoutByCard = current->usesCard;
+            payoutStartUs = sim::nowMicros();
+            payoutShown = false;
+            setState(AGENT_WAIT_PAYOUT);
+            selectItem(MENU_POST_DEPOSIT, payoutByCard ? 2 : 1, [] {});
+            menu = MENU_MAIN;
+            return;
+        }
+
+        finishCustomer();
+    }
+
+    // -- per-tick behaviour -------------------------------------------------
+
+    void tick()
+    {
+        events.after(0.05, [this] { tick(); });
+        serviceHopper();
+        serviceBin();
+
+        bool visible = menuVisible();
+        if (visible && !menuWasVisible)
+        {
+            menuSinceUs = sim::nowMicros();
+        }
+        menuWasVisible = visible;
+        if (state == AGENT_WAIT_PAYOUT && !visible)
+        {
+            payoutShown = true;
+        }
+
+        if (actionPending)
+        {
+            return;
+        }
+
+        bool atMenu = menuVisible();
+        if (state != AGENT_IDLE && atMenu && secondsInState() > 120)
+        {
+            // Nothing happened for two minutes; the customer walks away
+            stats.stuckSessions++;
+            sim::removeCard();
+            clearPlatform();
+            current.reset();
+            setState(AGENT_IDLE);
+            return;
+        }
+        switch (state)
+        {
+        case AGENT_IDLE:
+            if (current == nullptr && atMenu)
+            {
+                nextCustomer();
+            }
+            break;
+
+        case AGENT_WAIT_PROMPT:
+            if (lcdStartsWith(0, "Insert Bottle") && sim::servoAngle(servoPin1) >= 90)
+            {
+                actionPending = true;
+                events.after(reaction(), [this] {
+                    actionPending = false;
+                    stats.inserted++;
+                    placeItem(current->items.front());
+                    setState(AGENT_ITEM_PLACED);
+                });
+            }
+            else if (atMenu && secondsInState() > 5)
+            {
+                // The press was missed, the kiosk went into maintenance or a
+                // batch session timed out; try again
+                startItem(menu);
+            }
+            break;
+
+        case AGENT_BATCH_END:
+            if (lcdStartsWith(0, "Insert Bottle") && sim::servoAngle(servoPin1) >= 90)
+            {
+                actionPending = true;
+                events.after(reaction(), [this] {
+                    actionPending = false;
+                    press(selectButton);
+                    current->inBatch = false;
+                    payoutStartUs = sim::nowMicros();
+                    setState(AGENT_WAIT_MENU);
+                });
+            }
+            else if (atMenu)
+            {
+                current->inBatch = false;
+                payoutStartUs = sim::nowMicros();
+                setState(AGENT_WAIT_MENU);
+            }
+            break;
+
+        case AGENT_ITEM_PLACED:
+            if (sim::servoAngle(servoPin2) >= 90)
+            {
+                // Flap opened: the bottle drops into the bin
+                clearPlatform();
+                binFill++;
+                updateBinLevel();
+                finishItem(true);
+            }
+            else if (lcdStartsWith(0, "Remove Bottle") && sim::servoAngle(servoPin1) >= 90)
+            {
+                actionPending = true;
+                events.after(reaction(), [this] {
+                    actionPending = false;
+                    clearPlatform();
+                    finishItem(false);
+                });
+            }
+            else if (lcdStartsWith(0, "No bottle") || (current->inBatch && atMenu))
+            {
+                // Inserted too late or too weak a signal; take it back and retry once
+                stats.detectTimeouts++;
+                clearPlatform();
+                Item &item = current->items.front();
+                if (++item.retries > 1)
+                {
+                    current->items.pop_front();
+                }
+                current->inBatch = false;
+                payoutStartUs = sim::nowMicros();
+                setState(AGENT_WAIT_MENU);
+            }
+            break;
+
+        case AGENT_WAIT_MENU:
+            if (atMenu)
+            {
+                decideNext();
+            }
+            break;
+
+        case AGENT_WAIT_PAYOUT:
+            if (payoutByCard && lcdStartsWith(0, "Present RFID"))
+            {
+                actionPending = true;
+                events.after(reaction(), [this] {
+                    actionPending = false;
+                    sim::presentCard(&current->card);
+                    setState(AGENT_CARD_TAPPED);
+                });
+            }
+            else if (!payoutByCard && atMenu && payoutShown)
+            {
+                stats.coinPayoutTime.add((sim::nowMicros() - payoutStartUs) / 1e6);
+                finishCustomer();
+            }
+            break;
+
+        case AGENT_CARD_TAPPED:
+            if (atMenu)
+            {
+                sim::removeCard();
+                stats.cardStores++;
+                stats.cardPayoutTime.add((sim::nowMicros() - payoutStartUs) / 1e6);
+                finishCustomer();
+            }
+            break;
+        }
+    }
+
+    // Coin hopper: pulses the exit sensor while the relay is on
+    void serviceHopper()
+    {
+        relayOn = sim::digitalOutput(relayPin);
+        if (!relayOn || coinPulseActive)
+        {
+            return;
+        }
+
+        coinPulseActive = true;
+        events.after(1.0 / config.hopperCoinsPerSecond, [this] {
+            if (!sim::digitalOutput(relayPin))
+            {
+                coinPulseActive = false;
+                return;
+            }
+            sim::setDigitalInput(coinHopperSensor_PIN, LOW);
+            stats.coinsPaid++;
+            events.after(0.03, [this] {
+                sim::setDigitalInput(coinHopperSensor_PIN, HIGH);
+                coinPulseActive = false;
+            });
+        });
+    }
+
+    // Bin level, full and pickup alerts and the collection crew
+    void serviceBin()
+    {
+        size_t sent = sim::modem().sentMessages.size();
+        stats.smsSent = (int)sent;
+        for (; smsSeen < sent; smsSeen++)
+        {
+            const std::string &message = sim::modem().sentMessages[smsSeen];
+            if (message.rfind("PB", 0) == 0)
+            {
+                continue; // Telemetry digest, base64 that may spell anything
+            }
+            if (message.find("Pickup") != std::string::npos)
+            {
+                stats.pickupAlerts++;
+                callCrew();
+            }
+            else if (message.find("full") != std::string::npos && !binFull &&
+                     sim::nowMicros() - binEmptiedUs > 60000000ULL)
+            {
+                binFull = true;
+                binFullSinceUs = sim::nowMicros();
+                stats.binFullEvents++;
+                callCrew();
+            }
+        }
+    }
+
+    void callCrew()
+    {
+        if (crewCalled)
+        {
+            return;
+        }
+        crewCalled = true;
+        events.after(config.staffResponseMinutes * 60, [this] {
+            binFill = 0;
+            updateBinLevel();
+            crewCalled = false;
+            binEmptiedUs = sim::nowMicros();
+            if (binFull)
+            {
+                binFull = false;
+                stats.downtimeSeconds += (sim::nowMicros() - binFullSinceUs) / 1e6;
+            }
+        });
+    }
+};
+
+void KioskSim::report(FILE *out) const
+{
+    const double hours = sim::nowMicros() / 3600e6;
+    const double rejectRate = stats.inserted > 0 ? (double)stats.rejected / stats.inserted : 0;
+
+    if (config.json)
+    {
+        fprintf(out,
+                "{\"hours\":%.3f,\"arrived\":%d,\"served\":%d,\"abandoned\":%d,\"stuck\":%d,"
+                "\"inserted\":%d,\"accepted\":%d,\"rejected\":%d,\"false_rejects\":%d,\"false_accepts\":%d,"
+                "\"detect_timeouts\":%d,\"bottles_per_hour\":%.2f,\"reject_rate\":%.4f,"
+                "\"queue_wait_mean_s\":%.1f,\"queue_wait_p95_s\":%.1f,\"session_mean_s\":%.1f,"
+                "\"per_bottle_mean_s\":%.1f,\"coin_payout_mean_s\":%.1f,\"card_payout_mean_s\":%.1f,"
+                "\"coins_paid\":%d,\"card_stores\":%d,\"bin_full_events\":%d,\"pickup_alerts\":%d,\"downtime_s\":%.0f,\"sms_sent\":%d}\n",
+                hours, stats.arrived, stats.served, stats.abandoned, stats.stuckSessions,
+                stats.inserted, stats.accepted, stats.rejected, stats.falseRejects, stats.falseAccepts,
+                stats.detectTimeouts, stats.accepted / hours, rejectRate,
+                stats.queueWait.mean(), stats.queueWait.percentile(0.95), stats.sessionTime.mean(),
+                stats.perBottleTime.mean(), stats.coinPayoutTime.mean(), stats.cardPayoutTime.mean(),
+                stats.coinsPaid, stats.cardStores, stats.binFullEvents, stats.pickupAlerts, stats.downtimeSeconds,
+                stats.smsSent);
+        return;
+    }
+
+    fprintf(out, "=== Kiosk simulation: %.1f virtual hours ===\n", hours);
+    fprintf(out, "customers    arrived %d  served %d  abandoned %d  gave up %d\n",
+            stats.arrived, stats.served, stats.abandoned, stats.stuckSessions);
+    fprintf(out, "items        inserted %d  accepted %d  rejected %d  detect timeouts %d\n",
+            stats.inserted, stats.accepted, stats.rejected, stats.detectTimeouts);
+    fprintf(out, "quality      reject rate %.1f%%  false rejects %d  false accepts %d\n",
+            rejectRate * 100, stats.falseRejects, stats.falseAccepts);
+    fprintf(out, "throughput   %.1f bottles/hour  %.1f s per bottle\n", stats.accepted / hours, stats.perBottleTime.mean());
+    fprintf(out, "queue wait   mean %.0f s  p95 %.0f s  max %.0f s\n",
+            stats.queueWait.mean(), stats.queueWait.percentile(0.95), stats.queueWait.max());
+    fprintf(out, "session      mean %.0f s\n", stats.sessionTime.mean());
+    fprintf(out, "payout       coins mean %.1f s (%zu)  card mean %.1f s (%zu)  coins paid %d\n",
+            stats.coinPayoutTime.mean(), stats.coinPayoutTime.count(),
+            stats.cardPayoutTime.mean(), stats.cardPayoutTime.count(), stats.coinsPaid);
+    fprintf(out, "bin          full %d times  pickup alerts %d  downtime %.0f min  SMS sent %d\n",
+            stats.binFullEvents, stats.pickupAlerts, stats.downtimeSeconds / 60, stats.smsSent);
+}
+
+// ---------------------------------------------------------------------------
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [options]\n"
+            "  --hours H            virtual hours to simulate (24)\n"
+            "  --arrivals R         customers per hour (12)\n"
+            "  --bottles N          mean bottles per customer (5)\n"
+            "  --invalid P          share of items that should be rejected (0.10)\n"
+            "  --card P             share of customers storing points on a card (0.5)\n"
+            "  --batch N            customers with N or more bottles use Batch (0: never)\n"
+            "  --tap-first          card customers start by tapping their card\n"
+            "  --hopper R           coins per second (4)\n"
+            "  --modem-latency MS   SMS network time (3000)\n"
+            "  --bin-capacity N     bottles per bin (400)\n"
+            "  --staff-response M   minutes to empty a full bin (90)\n"
+            "  --drift G            load cell zero drift in grams per hour (0)\n"
+            "  --humidity C         capacitive baseline swing in ADC counts (0)\n"
+            "  --seed S             random seed (1)\n"
+            "  --json               machine-readable report\n"
+            "  --serial FILE        save the firmware's serial output\n"
+            "  --trace              capture a sensor trace (with --serial)\n",
+            program);
+}
+
+int main(int argc, char **argv)
+{
+    SimConfig config;
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        const char *value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (strcmp(arg, "--json") == 0)
+        {
+            config.json = true;
+            continue;
+        }
+        if (strcmp(arg, "--trace") == 0)
+        {
+            config.trace = true;
+            continue;
+        }
+        if (strcmp(arg, "--tap-first") == 0)
+        {
+            config.tapFirst = true;
+            continue;
+        }
+        if (value == nullptr)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+        i++;
+        if (strcmp(arg, "--hours") == 0)
+            config.hours = atof(value);
+        else if (strcmp(arg, "--arrivals") == 0)
+            config.arrivalsPerHour = atof(value);
+        else if (strcmp(arg, "--bottles") == 0)
+            config.bottlesPerCustomer = std::max(1.01, atof(value));
+        else if (strcmp(arg, "--invalid") == 0)
+            config.invalidRate = atof(value);
+        else if (strcmp(arg, "--card") == 0)
+            config.cardRate = atof(value);
+        else if (strcmp(arg, "--batch") == 0)
+            config.batchMin = atoi(value);
+        else if (strcmp(arg, "--hopper") == 0)
+            config.hopperCoinsPerSecond = atof(value);
+        else if (strcmp(arg, "--modem-latency") == 0)
+            config.modemLatencyMs = strtoul(value, nullptr, 10);
+        else if (strcmp(arg, "--bin-capacity") == 0)
+            config.binCapacity = atoi(value);
+        else if (strcmp(arg, "--staff-response") == 0)
+            config.staffResponseMinutes = atof(value);
+        else if (strcmp(arg, "--drift") == 0)
+            config.driftGramsPerHour = atof(value);
+        else if (strcmp(arg, "--humidity") == 0)
+            config.humidityCounts = atoi(value);
+        else if (strcmp(arg, "--seed") == 0)
+            config.seed = strtoul(value, nullptr, 10);
+        else if (strcmp(arg, "--serial") == 0)
+            config.serialPath = value;
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    randomSeed(config.seed);
+    KioskSim kiosk(config);
+    kiosk.start();
+
+    setup();
+    while (!sim::stopRequested())
+    {
+        loop();
+    }
+
+    kiosk.report(stdout);
+    return 0;
+}
@@ -0,0 +1,151 @@
+#!/usr/bin/env python3
+"""Decode PISO-BOTE binary log records.
+
+Reads the raw serial stream (a capture file or a serial device) and prints
+decoded log records interleaved with the plain text the firmware writes.
+Record ids and formats are read from include/LogEvents.h, so the decoder
+always matches the firmware it was checked out with.
+
+Sensor trace packets (see include/SensorTrace.h) are checked and, with
+--trace, appended to a file for tools/tracereplay.
+
+Usage:
+    tools/logdecode.py capture.bin
+    tools/logdecode.py /dev/ttyACM0 --baud 9600
+    tools/logdecode.py /dev/ttyACM0 --trace bottles.trc
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+SYNC_BYTE = 0xA5
+RECORD_SIZE = 13
+TRACE_SYNC_BYTE = 0xB6
+TRACE_HEADER_SIZE = 7
+TRACE_PAYLOAD_SIZE = 40
+CONVERSION = re.compile(r"%[-0-9.]*l?([dxXu])")
+SCHEMA = os.path.join(os.path.dirname(__file__), "..", "include", "LogEvents.h")
+
+
+def load_schema(path):
+    events = []
+    with open(path) as f:
+        for match in re.finditer(r'X\((\w+),\s*"((?:[^"\\]|\\.)*)"\)', f.read()):
+            events.append((match.group(1), match.group(2)))
+    return events
+
+
+def format_record(events, record_id, time_ms, a, b):
+    if record_id >= len(events):
+        return "[%5u] unknown record %d (%d, %d)" % (time_ms, record_id, a, b)
+
+    name, fmt = events[record_id]
+    args = []
+    for spec, value in zip(CONVERSION.findall(fmt), (a, b)):
+        # Hex and unsigned conversions print the raw 32-bit pattern
+        args.append(value & 0xFFFFFFFF if spec in "xXu" else value)
+    text = fmt % tuple(args)
+    return "[%5u] %s: %s" % (time_ms, name, text)
+
+
+def trace_packet_size(buffer):
+    """Size of the trace packet at the start of buffer, 0 if invalid, None if incomplete."""
+    if len(buffer) < 2:
+        return None
+    if buffer[1] > TRACE_PAYLOAD_SIZE:
+        return 0
+    size = TRACE_HEADER_SIZE + buffer[1] + 1
+    if len(buffer) < size:
+        return None
+    if sum(buffer[1:size - 1]) & 0xFF != buffer[size - 1]:
+        return 0
+    return size
+
+
+def decode(stream, events, out, follow=False, trace=None):
+    buffer = bytearray()
+    text = bytearray()
+    trace_packets = 0
+
+    def flush_text():
+        if text:
+            out.write(text.decode("ascii", "replace"))
+            text.clear()
+
+    while True:
+        chunk = stream.read(256)
+        if not chunk:
+            if follow:
+                continue
+            break
+        buffer.extend(chunk)
+
+        while buffer:
+            if buffer[0] == TRACE_SYNC_BYTE:
+                size = trace_packet_size(buffer)
+                if size is None:
+                    break
+                if size:
+                    if trace is not None:
+                        trace.write(bytes(buffer[:size]))
+                        trace.flush()
+                    trace_packets += 1
+                    del buffer[:size]
+                    continue
+
+            if buffer[0] != SYNC_BYTE:
+                text.append(buffer.pop(0))
+                if text[-1:] == b"\n":
+                    flush_text()
+                continue
+
+            if len(buffer) < RECORD_SIZE:
+                break
+
+            record = bytes(buffer[:RECORD_SIZE])
+            if sum(record[1:RECORD_SIZE - 1]) & 0xFF != record[RECORD_SIZE - 1]:
+                # Not a record, treat the byte as noise
+                buffer.pop(0)
+                continue
+
+            del buffer[:RECORD_SIZE]
+            record_id, time_ms, a, b = struct.unpack("<BHii", record[1:RECORD_SIZE - 1])
+            flush_text()
+            out.write(format_record(events, record_id, time_ms, a, b) + "\n")
+
+    flush_text()
+    if trace_packets:
+        sys.stderr.write("%d trace packets\n" % trace_packets)
+
+
+def open_source(path, baud):
+    if not path.startswith("/dev/"):
+        return open(path, "rb"), False
+
+    import serial  # pyserial is installed alongside PlatformIO
+
+    return serial.Serial(path, baud, timeout=1), True
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", help="capture file or serial device")
+    parser.add_argument("--baud", type=int, default=9600)
+    parser.add_argument("--schema", default=SCHEMA)
+    parser.add_argument("--trace", help="append sensor trace packets to this file")
+    args = parser.parse_args()
+
+    events = load_schema(args.schema)
+    stream, follow = open_source(args.source, args.baud)
+    trace = open(args.trace, "ab") if args.trace else None
+    with stream:
+        decode(stream, events, sys.stdout, follow, trace)
+    if trace:
+        trace.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,91 @@
+#!/usr/bin/env python3
+"""Static SRAM report for a PISO-BOTE firmware image.
+
+Lists how much of the ATmega2560's 8 KB goes to .data, .bss and .noinit,
+what is left for the heap and stack, and the largest RAM symbols. The
+runtime side (heap and stack peaks) is the "mem" console command, see
+include/MemoryStats.h.
+
+Also runs after every Mega build when listed in extra_scripts.
+
+Usage:
+    tools/memreport.py .pio/build/megaatmega2560/firmware.elf
+    tools/memreport.py firmware.elf --top 40 --max-static 6144
+"""
+
+import argparse
+import subprocess
+import sys
+
+RAM_SIZE = 8192
+SECTIONS = (".data", ".bss", ".noinit")
+
+
+def read_symbols(nm, elf):
+    out = subprocess.run([nm, "--format=sysv", "-C", elf], check=True,
+                         capture_output=True, text=True).stdout
+    symbols = []
+    for line in out.splitlines():
+        fields = [f.strip() for f in line.split("|")]
+        if len(fields) < 7 or fields[6] not in SECTIONS or not fields[4]:
+            continue
+        size = int(fields[4], 16)
+        if size:
+            symbols.append((size, fields[6], fields[0]))
+    return symbols
+
+
+def section_sizes(size_tool, elf):
+    out = subprocess.run([size_tool, "-A", elf], check=True,
+                         capture_output=True, text=True).stdout
+    sizes = dict.fromkeys(SECTIONS, 0)
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) >= 3 and fields[0] in sizes:
+            sizes[fields[0]] = int(fields[1])
+    return sizes
+
+
+def report(elf, nm="avr-nm", size_tool="avr-size", top=20, max_static=None):
+    sizes = section_sizes(size_tool, elf)
+    static = sum(sizes.values())
+    print(f"SRAM {RAM_SIZE} bytes")
+    for name in SECTIONS:
+        print(f"  {name:8} {sizes[name]:5}")
+    print(f"  {'static':8} {static:5}  ({100.0 * static / RAM_SIZE:.1f}%)")
+    print(f"  {'free':8} {RAM_SIZE - static:5}  heap and stack")
+
+    symbols = sorted(read_symbols(nm, elf), reverse=True)[:top]
+    if symbols:
+        print("largest RAM symbols")
+        for size, section, name in symbols:
+            print(f"  {size:5} {section:8} {name}")
+
+    if max_static is not None and static > max_static:
+        print(f"static RAM {static} exceeds budget {max_static}", file=sys.stderr)
+        return 1
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf")
+    parser.add_argument("--nm", default="avr-nm")
+    parser.add_argument("--size", default="avr-size")
+    parser.add_argument("--top", type=int, default=20)
+    parser.add_argument("--max-static", type=int,
+                        help="exit with status 1 above this many static bytes")
+    args = parser.parse_args()
+    sys.exit(report(args.elf, args.nm, args.size, args.top, args.max_static))
+
+
+try:
+    Import("env")  # noqa: F821 - defined when PlatformIO runs this script
+except NameError:
+    if __name__ == "__main__":
+        main()
+else:
+    def after_build(source, target, env):
+        report(str(target[0]), nm="avr-nm", size_tool="avr-size")
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", after_build)  # noqa: F821
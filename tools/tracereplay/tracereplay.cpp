@@ -0,0 +1,527 @@
+// Replays recorded sensor traces through the firmware's verification logic.
+//
+// Traces come from the kiosk's "trace on" console command and are pulled off
+// the serial stream with tools/logdecode.py --trace. Every recorded deposit is
+// run through the real depositAction() on the native build, with the sensor
+// inputs played back from the trace in virtual time, so thresholds can be
+// tried against real bottles far faster than real time.
+//
+// With --features, the classifier inputs of every deposit are written as
+// CSV for tools/trainmodel.py, labelled with --expect or the recorded verdict.
+//
+// Build and run:
+//   pio run -e tracereplay
+//   .pio/build/tracereplay/program bottles.trc --detect 620 --expect accept
+//   .pio/build/tracereplay/program bottles.trc --expect accept --features bottles.csv
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <utility>
+#include <string>
+#include <vector>
+
+#include <Arduino.h>
+#include <HX711.h>
+#include <SimHarness.h>
+#include "BottleClassifier.h"
+#include "CapacitiveBaseline.h"
+#include "Journal.h"
+#include "LoadCell.h"
+#include "PinMap.h"
+#include "SensorTrace.h"
+#include "ZeroTracker.h"
+
+// Firmware state and entry points (src/main.cpp)
+extern int detectionThreshold;
+extern int noBottleThreshold;
+extern HX711 scale;
+void depositAction();
+
+struct TraceSample
+{
+    uint32_t timeMs;
+    uint8_t channel;
+    int32_t value;
+};
+
+struct TraceFile
+{
+    std::vector<TraceSample> samples;
+    unsigned packets = 0;
+    unsigned lostPackets = 0; // From sequence gaps
+    unsigned badBytes = 0;
+};
+
+enum Verdict
+{
+    VERDICT_NONE,
+    VERDICT_ACCEPTED,
+    VERDICT_REJECTED,
+    VERDICT_NO_OBJECT,
+    VERDICT_COUNT
+};
+
+static const char *const verdictNames[VERDICT_COUNT] = {"unknown", "accepted", "rejected", "no object"};
+
+// Settle time after the recorded flow before the platform is emptied
+static const uint32_t SEGMENT_TAIL_MS = 2000;
+
+// ---------------------------------------------------------------------------
+// Trace decoding, see include/SensorTrace.h for the wire format
+
+static bool decodePacket(const uint8_t *packet, std::vector<TraceSample> &out)
+{
+    uint8_t length = packet[1];
+    uint32_t time = 0;
+    for (int i = 0; i < 4; i++)
+    {
+        time |= (uint32_t)packet[3 + i] << (8 * i);
+    }
+
+    int32_t lastValues[TRACE_CHANNEL_COUNT] = {};
+    const uint8_t *p = packet + TRACE_HEADER_SIZE;
+    const uint8_t *end = p + length;
+
+    while (p < end)
+    {
+        uint8_t channel = *p >> 5;
+        uint32_t dt = *p & 0x1F;
+        p++;
+        if (dt == TRACE_DT_ESCAPE)
+        {
+            if (end - p < 2)
+            {
+                return false;
+            }
+            dt = p[0] | (p[1] << 8);
+            p += 2;
+        }
+
+        uint32_t zigzag = 0;
+        int shift = 0;
+        do
+        {
+            if (p >= end || shift > 28)
+            {
+                return false;
+            }
+            zigzag |= (uint32_t)(*p & 0x7F) << shift;
+            shift += 7;
+        } while (*p++ & 0x80);
+
+        if (channel >= TRACE_CHANNEL_COUNT)
+        {
+            return false;
+        }
+        int32_t delta = (int32_t)(zigzag >> 1) ^ -(int32_t)(zigzag & 1);
+        time += dt;
+        lastValues[channel] += delta;
+        out.push_back({time, channel, lastValues[channel]});
+    }
+    return true;
+}
+
+static bool loadTrace(const char *path, TraceFile &trace)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == nullptr)
+    {
+        return false;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0)
+    {
+        data.insert(data.end(), chunk, chunk + n);
+    }
+    fclose(f);
+
+    int lastSequence = -1;
+    size_t i = 0;
+    while (i + TRACE_HEADER_SIZE + 1 <= data.size())
+    {
+        uint8_t length = data[i + 1];
+        size_t size = TRACE_HEADER_SIZE + length + 1;
+        if (data[i] != TRACE_SYNC_BYTE || length > TRACE_PAYLOAD_SIZE || i + size > data.size())
+        {
+            trace.badBytes++;
+            i++;
+            continue;
+        }
+
+        uint8_t checksum = 0;
+        for (size_t k = 1; k < size - 1; k++)
+        {
+            checksum += data[i + k];
+        }
+        if (checksum != data[i + size - 1] || !decodePacket(&data[i], trace.samples))
+        {
+            trace.badBytes++;
+            i++;
+            continue;
+        }
+
+        uint8_t sequence = data[i + 2];
+        if (lastSequence >= 0)
+        {
+            trace.lostPackets += (uint8_t)(sequence - lastSequence - 1);
+        }
+        lastSequence = sequence;
+        trace.packets++;
+        i += size;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// Playback into the simulated sensors
+
+static void applySample(const TraceSample &sample)
+{
+    switch (sample.channel)
+    {
+    case TRACE_CAPACITIVE:
+        sim::setAnalogInput(CAPACITIVE_SENSOR_PIN, sample.value);
+        break;
+    case TRACE_LOADCELL:
+        sim::loadCell().zeroCounts = sample.value;
+        break;
+    case TRACE_INDUCTIVE:
+        sim::setDigitalInput(inductiveSensorPin, sample.value != 0);
+        break;
+    case TRACE_LDR:
+        sim::setDigitalInput(LDR_PIN, sample.value != 0);
+        break;
+    case TRACE_TARE:
+        scale.set_offset(sample.value);
+        break;
+    case TRACE_SCALE:
+        // Replay with the recording unit's slope
+        loadCellResetCalibration();
+        loadCellCalibrate(sample.value / 10, 1000);
+        classifierCalibrationChanged();
+        zeroTrackCalibrationChanged();
+        break;
+    default:
+        break;
+    }
+}
+
+static void emptyPlatform()
+{
+    sim::setAnalogInput(CAPACITIVE_SENSOR_PIN, 0);
+    sim::loadCell().zeroCounts = scale.get_offset();
+    sim::setDigitalInput(inductiveSensorPin, LOW);
+    sim::setDigitalInput(LDR_PIN, LOW);
+}
+
+static Verdict journalVerdict()
+{
+    Verdict verdict = VERDICT_NO_OBJECT;
+    JournalEntry entry;
+    for (uint8_t i = 0; journalGet(i, entry); i++)
+    {
+        if (entry.event == JOURNAL_DEPOSIT_ACCEPTED)
+        {
+            verdict = VERDICT_ACCEPTED;
+        }
+        else if (entry.event == JOURNAL_DEPOSIT_REJECTED)
+        {
+            verdict = VERDICT_REJECTED;
+        }
+    }
+    return verdict;
+}
+
+static Verdict markVerdict(int32_t mark)
+{
+    switch (mark)
+    {
+    case TRACE_MARK_ACCEPTED:
+        return VERDICT_ACCEPTED;
+    case TRACE_MARK_REJECTED:
+        return VERDICT_REJECTED;
+    case TRACE_MARK_NO_OBJECT:
+        return VERDICT_NO_OBJECT;
+    default:
+        return VERDICT_NONE;
+    }
+}
+
+// ---------------------------------------------------------------------------
+
+static void usage(const char *program)
+{
+    fprintf(stderr,
+            "usage: %s [options] trace.trc...\n"
+            "  --detect N       capacitive detection threshold\n"
+            "  --nobottle N     capacitive removal threshold\n"
+            "  --model P=N      set a classifier parameter (see the model command)\n"
+            "  --expect V       ground truth for every deposit: accept or reject\n"
+            "  --features FILE  write classifier inputs per deposit as CSV\n"
+            "  --dump           print decoded samples as CSV and exit\n"
+            "  -v               one line per deposit\n",
+            program);
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<const char *> paths;
+    int detect = -1, noBottle = -1;
+    std::vector<std::pair<std::string, int>> modelOverrides;
+    Verdict expected = VERDICT_NONE;
+    const char *featuresPath = nullptr;
+    bool dump = false;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char *arg = argv[i];
+        if (strcmp(arg, "--dump") == 0)
+        {
+            dump = true;
+            continue;
+        }
+        if (strcmp(arg, "-v") == 0)
+        {
+            verbose = true;
+            continue;
+        }
+        if (arg[0] != '-')
+        {
+            paths.push_back(arg);
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            usage(argv[0]);
+            return 2;
+        }
+
+        const char *value = argv[++i];
+        if (strcmp(arg, "--detect") == 0)
+            detect = atoi(value);
+        else if (strcmp(arg, "--nobottle") == 0)
+            noBottle = atoi(value);
+        else if (strcmp(arg, "--model") == 0 && strchr(value, '='))
+            modelOverrides.emplace_back(std::string(value, strchr(value, '=')), atoi(strchr(value, '=') + 1));
+        else if (strcmp(arg, "--features") == 0)
+            featuresPath = value;
+        else if (strcmp(arg, "--expect") == 0)
+            expected = strcmp(value, "accept") == 0 ? VERDICT_ACCEPTED : VERDICT_REJECTED;
+        else
+        {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (paths.empty())
+    {
+        usage(argv[0]);
+        return 2;
+    }
+
+    TraceFile trace;
+    for (const char *path : paths)
+    {
+        if (!loadTrace(path, trace))
+        {
+            fprintf(stderr, "cannot read %s\n", path);
+            return 1;
+        }
+    }
+
+    if (dump)
+    {
+        printf("time_ms,channel,value\n");
+        for (const TraceSample &sample : trace.samples)
+        {
+            printf("%u,%u,%d\n", sample.timeMs, sample.channel, sample.value);
+        }
+        return 0;
+    }
+
+    // Boot the firmware once, then apply the overrides on top of its defaults
+    sim::setSerialOutput(nullptr);
+    sim::setAnalogNoise(0);
+    sim::loadCell().noiseCounts = 0;
+    sim::loadCell().grams = 0;
+    setup();
+
+    if (detect >= 0)
+        detectionThreshold = detect;
+    if (noBottle >= 0)
+        noBottleThreshold = noBottle;
+    capBaselineSetFixed(detectionThreshold, noBottleThreshold);
+    for (const auto &entry : modelOverrides)
+    {
+        uint8_t param = 0;
+        while (param < CLASSIFIER_PARAM_COUNT && entry.first != (const char *)classifierParamName(param))
+            param++;
+        if (param == CLASSIFIER_PARAM_COUNT)
+        {
+            fprintf(stderr, "unknown model parameter %s\n", entry.first.c_str());
+            return 2;
+        }
+        classifierSet(param, entry.second);
+    }
+
+    FILE *features = nullptr;
+    if (featuresPath != nullptr)
+    {
+        features = fopen(featuresPath, "w");
+        if (features == nullptr)
+        {
+            fprintf(stderr, "cannot write %s\n", featuresPath);
+            return 1;
+        }
+        fprintf(features, "label,recorded,replayed,capacitive,weight_dg,spread_dg,inductive,ldr\n");
+    }
+
+    unsigned counts[VERDICT_COUNT][VERDICT_COUNT] = {}; // [recorded][replayed]
+    unsigned deposits = 0;
+    uint64_t replayedMs = 0;
+    auto wallStart = std::chrono::steady_clock::now();
+
+    size_t cursor = 0;
+    while (cursor < trace.samples.size())
+    {
+        // Everything before the next deposit only sets the starting state
+        const TraceSample &sample = trace.samples[cursor];
+        if (!(sample.channel == TRACE_MARK && sample.value == TRACE_MARK_DEPOSIT))
+        {
+            applySample(sample);
+            cursor++;
+            continue;
+        }
+
+        const uint32_t startMs = sample.timeMs;
+        size_t end = cursor + 1;
+        Verdict recorded = VERDICT_NONE;
+        while (end < trace.samples.size())
+        {
+            const TraceSample &next = trace.samples[end];
+            if (next.channel == TRACE_MARK)
+            {
+                if (next.value == TRACE_MARK_DEPOSIT)
+                {
+                    break;
+                }
+                recorded = markVerdict(next.value);
+            }
+            end++;
+        }
+        const uint32_t lastMs = trace.samples[end - 1].timeMs;
+
+        size_t playback = cursor + 1;
+        bool emptied = false;
+        const uint32_t replayStart = millis();
+        sim::setTimeListener([&](uint64_t nowUs) {
+            // A sample is stamped when its read finished, so it takes effect
+            // as soon as the previous read is done rather than at its stamp
+            uint32_t elapsed = (uint32_t)(nowUs / 1000) - replayStart;
+            while (playback < end && trace.samples[playback - 1].timeMs - startMs <= elapsed)
+            {
+                applySample(trace.samples[playback++]);
+            }
+            if (playback >= end && !emptied && elapsed > lastMs - startMs + SEGMENT_TAIL_MS)
+            {
+                emptied = true;
+                emptyPlatform();
+            }
+        });
+
+        journalClear();
+        depositAction();
+        sim::setTimeListener(nullptr);
+
+        Verdict replayed = journalVerdict();
+        counts[recorded][replayed]++;
+        Verdict label = expected != VERDICT_NONE ? expected : recorded;
+        if (features != nullptr && classifierReady() &&
+            (replayed == VERDICT_ACCEPTED || replayed == VERDICT_REJECTED) &&
+            (label == VERDICT_ACCEPTED || label == VERDICT_REJECTED))
+        {
+            // The classifier keeps its samples until the next verification
+            ClassifierResult result;
+            classifierDecide(result);
+            fprintf(features, "%s,%s,%s,%d,%d,%d,%d,%d\n", label == VERDICT_ACCEPTED ? "accept" : "reject",
+                    verdictNames[recorded], verdictNames[replayed], result.capacitive, result.weightDg,
+                    result.spreadDg, result.inductiveShare, result.ldrShare);
+        }
+        deposits++;
+        replayedMs += millis() - replayStart;
+        if (verbose)
+        {
+            printf("#%-4u t=%-9u recorded %-9s replayed %-9s%s\n", deposits, startMs,
+                   verdictNames[recorded], verdictNames[replayed], recorded != replayed ? "  CHANGED" : "");
+        }
+
+        emptyPlatform();
+        cursor = end;
+    }
+
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    if (features != nullptr)
+    {
+        fclose(features);
+    }
+
+    printf("trace      %u packets, %u lost, %u bad bytes, %zu samples\n",
+           trace.packets, trace.lostPackets, trace.badBytes, trace.samples.size());
+    printf("settings   detect %d  nobottle %d\nmodel     ", detectionThreshold, noBottleThreshold);
+    for (uint8_t param = 0; param < CLASSIFIER_PARAM_COUNT; param++)
+        printf(" %s %d", (const char *)classifierParamName(param), classifierGet(param));
+    printf("\n");
+    printf("deposits   %u\n", deposits);
+    printf("%-10s %9s %9s\n", "", "recorded", "replayed");
+    for (int v = VERDICT_ACCEPTED; v < VERDICT_COUNT; v++)
+    {
+        unsigned recordedTotal = 0, replayedTotal = 0;
+        for (int k = 0; k < VERDICT_COUNT; k++)
+        {
+            recordedTotal += counts[v][k];
+            replayedTotal += counts[k][v];
+        }
+        printf("%-10s %9u %9u\n", verdictNames[v], recordedTotal, replayedTotal);
+    }
+
+    unsigned changed = 0;
+    for (int r = 0; r < VERDICT_COUNT; r++)
+    {
+        for (int k = 0; k < VERDICT_COUNT; k++)
+        {
+            if (r != k && r != VERDICT_NONE)
+            {
+                changed += counts[r][k];
+            }
+        }
+    }
+    printf("changed    %u (accepted->rejected %u, rejected->accepted %u)\n", changed,
+           counts[VERDICT_ACCEPTED][VERDICT_REJECTED], counts[VERDICT_REJECTED][VERDICT_ACCEPTED]);
+
+    if (expected != VERDICT_NONE)
+    {
+        unsigned recordedWrong = 0, replayedWrong = 0;
+        for (int k = 0; k < VERDICT_COUNT; k++)
+        {
+            for (int r = 0; r < VERDICT_COUNT; r++)
+            {
+                if (r != expected && r != VERDICT_NONE)
+                    recordedWrong += counts[r][k];
+                if (k != expected)
+                    replayedWrong += counts[r][k];
+            }
+        }
+        printf("%s   recorded %u, replayed %u\n",
+               expected == VERDICT_ACCEPTED ? "false rejects" : "false accepts", recordedWrong, replayedWrong);
+    }
+
+    printf("speed      %.0f s of kiosk time in %.2f s (%.0fx)\n", replayedMs / 1000.0, wallSeconds,
+           wallSeconds > 0 ? replayedMs / 1000.0 / wallSeconds : 0.0);
+    return 0;
+}
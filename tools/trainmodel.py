@@ -0,0 +1,277 @@
+#!/usr/bin/env python3
+"""Fit the bottle classifier to labelled deposits and emit its model header.
+
+Input is the per-deposit CSV written by tools/tracereplay --features, one
+file per labelled batch of traces (known bottles with --expect accept, known
+junk with --expect reject). Each sensor gets a cut point: the weight a
+plateau between two cuts, the others a lower cut. Cuts start at the loosest
+values that keep every bottle, are tightened greedily (most false accepts
+removed per bottle lost) until the false accept rate meets the target, and
+are then centred in the gap to the nearest junk they still separate. A cut
+with no junk beyond it keeps the current header's margin.
+
+The feature weights, accept score and ramp widths are kept from the current
+header, so a cut maps to the ramp whose pass point it is. The result is
+checked with the same integer scoring as src/BottleClassifier.cpp and
+written as include/ClassifierModel.h; rebuild the firmware to ship it.
+
+Usage:
+    tracereplay good.trc --expect accept --features good.csv
+    tracereplay junk.trc --expect reject --features junk.csv
+    tools/trainmodel.py good.csv junk.csv --max-false-accept 0.01 -o include/ClassifierModel.h
+"""
+
+import argparse
+import csv
+import os
+import re
+import sys
+
+HEADER = os.path.join(os.path.dirname(__file__), "..", "include", "ClassifierModel.h")
+CONSTANT = re.compile(r"constexpr\s+\w+\s+(\w+)\s*=\s*(-?\d+);")
+FEATURE_FULL = 256
+
+# Gate name, CSV column, cut direction
+GATES = [
+    ("capacitive", "capacitive", +1),
+    ("weight min", "weight_dg", +1),
+    ("weight max", "weight_dg", -1),
+    ("inductive", "inductive", +1),
+    ("ldr", "ldr", +1),
+]
+
+
+def load_header(path):
+    with open(path) as f:
+        return {name: int(value) for name, value in CONSTANT.findall(f.read())}
+
+
+def load_samples(paths):
+    samples = []
+    for path in paths:
+        with open(path) as f:
+            for row in csv.DictReader(f):
+                sample = {key: int(row[key]) for key in ("capacitive", "weight_dg", "inductive", "ldr")}
+                sample["bottle"] = row["label"] == "accept"
+                samples.append(sample)
+    return samples
+
+
+def ramp(x, low, high):
+    if x <= low:
+        return 0
+    if x >= high:
+        return FEATURE_FULL
+    return ((x - low) << 8) // (high - low)
+
+
+def score(model, sample):
+    """Integer score as computed by classifierDecide()."""
+    weight = sample["weight_dg"]
+    rising = ramp(weight, model["MODEL_WEIGHT_MIN"] - model["MODEL_WEIGHT_RAMP"], model["MODEL_WEIGHT_MIN"])
+    falling = FEATURE_FULL - ramp(weight, model["MODEL_WEIGHT_MAX"], model["MODEL_WEIGHT_MAX"] + model["MODEL_WEIGHT_RAMP"])
+    features = [
+        (model["MODEL_CAPACITIVE_WEIGHT"], ramp(sample["capacitive"], model["MODEL_CAPACITIVE_LOW"], model["MODEL_CAPACITIVE_HIGH"])),
+        (model["MODEL_WEIGHT_WEIGHT"], min(rising, falling)),
+        (model["MODEL_INDUCTIVE_WEIGHT"], ramp(sample["inductive"], model["MODEL_INDUCTIVE_LOW"], model["MODEL_INDUCTIVE_HIGH"])),
+        (model["MODEL_LDR_WEIGHT"], ramp(sample["ldr"], model["MODEL_LDR_LOW"], model["MODEL_LDR_HIGH"])),
+    ]
+    return sum(w * f for w, f in features) >> 8
+
+
+def evaluate(model, samples):
+    """(false rejects, bottles, false accepts, junk) under the exact scoring."""
+    false_rejects = bottles = false_accepts = junk = 0
+    for sample in samples:
+        accepted = score(model, sample) >= model["MODEL_ACCEPT_SCORE"]
+        if sample["bottle"]:
+            bottles += 1
+            false_rejects += not accepted
+        else:
+            junk += 1
+            false_accepts += accepted
+    return false_rejects, bottles, false_accepts, junk
+
+
+def passes(cuts, sample, skip=None):
+    """Hard-gate approximation used while searching."""
+    for i, (_, column, direction) in enumerate(GATES):
+        if i != skip and (sample[column] - cuts[i]) * direction < 0:
+            return False
+    return True
+
+
+def count_errors(cuts, samples):
+    false_rejects = sum(1 for s in samples if s["bottle"] and not passes(cuts, s))
+    false_accepts = sum(1 for s in samples if not s["bottle"] and passes(cuts, s))
+    return false_rejects, false_accepts
+
+
+def fit_cuts(samples, max_false_accepts, current):
+    bottles = [s for s in samples if s["bottle"]]
+    cuts = []
+    for _, column, direction in GATES:
+        values = [s[column] for s in bottles]
+        cuts.append(min(values) if direction > 0 else max(values))
+
+    # Tighten one gate at a time until few enough junk items get through
+    false_rejects, false_accepts = count_errors(cuts, samples)
+    while false_accepts > max_false_accepts:
+        best = None
+        for i, (_, column, direction) in enumerate(GATES):
+            # Next bottle value past the cut, moving inwards
+            inward = sorted({s[column] for s in bottles if (s[column] - cuts[i]) * direction > 0},
+                            key=lambda v: v * direction)
+            if not inward:
+                continue
+            trial = list(cuts)
+            trial[i] = inward[0]
+            fr, fa = count_errors(trial, samples)
+            gain = (false_accepts - fa) / (fr - false_rejects + 0.5)
+            if fa < false_accepts and (best is None or gain > best[0]):
+                best = (gain, trial, fr, fa)
+        if best is None:
+            break
+        _, cuts, false_rejects, false_accepts = best
+
+    # Centre each cut between the bottles it keeps and the junk it stops
+    for i, (_, column, direction) in enumerate(GATES):
+        kept = [s[column] for s in samples if s["bottle"] and passes(cuts, s)]
+        stopped = [s[column] for s in samples if not s["bottle"] and passes(cuts, s, skip=i)
+                   and (s[column] - cuts[i]) * direction < 0]
+        if not kept:
+            continue
+        edge = min(kept) if direction > 0 else max(kept)
+        if stopped:
+            barrier = max(stopped) if direction > 0 else min(stopped)
+            cuts[i] = (edge + barrier + (1 if direction > 0 else 0)) // 2
+        else:
+            # Nothing to separate on this side; keep the current margin
+            cuts[i] = min(edge, current[i]) if direction > 0 else max(edge, current[i])
+    return cuts
+
+
+def needed(model, weight_key):
+    """Feature value at which this sensor alone uses up the score allowance."""
+    total = sum(model[k] for k in ("MODEL_CAPACITIVE_WEIGHT", "MODEL_WEIGHT_WEIGHT",
+                                   "MODEL_INDUCTIVE_WEIGHT", "MODEL_LDR_WEIGHT"))
+    allowance = total - model["MODEL_ACCEPT_SCORE"]
+    w = model[weight_key]
+    return max(1, min(FEATURE_FULL, FEATURE_FULL - allowance * FEATURE_FULL // w)) if w > 0 else 1
+
+
+def cuts_from_model(model):
+    """Pass points of the current ramps, the inverse of model_from_cuts()."""
+    def lower_cut(prefix):
+        low, high = model[prefix + "_LOW"], model[prefix + "_HIGH"]
+        return low + (high - low) * needed(model, prefix + "_WEIGHT") // FEATURE_FULL
+
+    inset = model["MODEL_WEIGHT_RAMP"] * (FEATURE_FULL - needed(model, "MODEL_WEIGHT_WEIGHT")) // FEATURE_FULL
+    return [lower_cut("MODEL_CAPACITIVE"), model["MODEL_WEIGHT_MIN"] - inset,
+            model["MODEL_WEIGHT_MAX"] + inset, lower_cut("MODEL_INDUCTIVE"), lower_cut("MODEL_LDR")]
+
+
+def model_from_cuts(base, cuts):
+    """Place each ramp so a feature alone at its cut just reaches the accept score."""
+    model = dict(base)
+
+    def lower_ramp(prefix, cut, limit=None):
+        width = model[prefix + "_HIGH"] - model[prefix + "_LOW"]
+        low = cut - width * needed(model, prefix + "_WEIGHT") // FEATURE_FULL
+        high = low + width
+        if limit is not None and high > limit:
+            low, high = low - (high - limit), limit
+        model[prefix + "_LOW"], model[prefix + "_HIGH"] = low, high
+
+    lower_ramp("MODEL_CAPACITIVE", cuts[0])
+    lower_ramp("MODEL_INDUCTIVE", cuts[3], FEATURE_FULL)
+    lower_ramp("MODEL_LDR", cuts[4], FEATURE_FULL)
+
+    width = model["MODEL_WEIGHT_RAMP"]
+    inset = width * (FEATURE_FULL - needed(model, "MODEL_WEIGHT_WEIGHT")) // FEATURE_FULL
+    model["MODEL_WEIGHT_MIN"] = cuts[1] + inset
+    model["MODEL_WEIGHT_MAX"] = max(cuts[2] - inset, model["MODEL_WEIGHT_MIN"])
+    return model
+
+
+def write_header(out, model, sources, result):
+    false_rejects, bottles, false_accepts, junk = result
+    out.write("""#pragma once
+
+// Bottle classifier model, loaded into the BottleClassifier at boot.
+// Generated by tools/trainmodel.py; retrain and rebuild instead of editing.
+//
+// Trained on: %s
+// Training result: %d/%d bottles rejected, %d/%d junk accepted
+
+#include <stdint.h>
+
+// Capacitive presence thresholds used while waiting for an object, and the
+// empty-platform level they and the model were tuned at
+constexpr int DETECTION_THRESHOLD = %d;
+constexpr int NO_BOTTLE_THRESHOLD = %d;
+constexpr int CAPACITIVE_NOMINAL_BASELINE = %d;
+
+// Feature ramps
+constexpr int16_t MODEL_CAPACITIVE_LOW = %d;  // ADC counts
+constexpr int16_t MODEL_CAPACITIVE_HIGH = %d;
+constexpr int16_t MODEL_WEIGHT_MIN = %d; // Decigrams
+constexpr int16_t MODEL_WEIGHT_MAX = %d;
+constexpr int16_t MODEL_WEIGHT_RAMP = %d;
+constexpr int16_t MODEL_INDUCTIVE_LOW = %d; // Share of readings, /256
+constexpr int16_t MODEL_INDUCTIVE_HIGH = %d;
+constexpr int16_t MODEL_LDR_LOW = %d;
+constexpr int16_t MODEL_LDR_HIGH = %d;
+
+// Feature weights and the score needed to accept
+constexpr int16_t MODEL_CAPACITIVE_WEIGHT = %d;
+constexpr int16_t MODEL_WEIGHT_WEIGHT = %d;
+constexpr int16_t MODEL_INDUCTIVE_WEIGHT = %d;
+constexpr int16_t MODEL_LDR_WEIGHT = %d;
+constexpr int16_t MODEL_ACCEPT_SCORE = %d;
+""" % (", ".join(os.path.basename(p) for p in sources), false_rejects, bottles, false_accepts, junk,
+       model["DETECTION_THRESHOLD"], model["NO_BOTTLE_THRESHOLD"], model["CAPACITIVE_NOMINAL_BASELINE"],
+       model["MODEL_CAPACITIVE_LOW"], model["MODEL_CAPACITIVE_HIGH"],
+       model["MODEL_WEIGHT_MIN"], model["MODEL_WEIGHT_MAX"], model["MODEL_WEIGHT_RAMP"],
+       model["MODEL_INDUCTIVE_LOW"], model["MODEL_INDUCTIVE_HIGH"],
+       model["MODEL_LDR_LOW"], model["MODEL_LDR_HIGH"],
+       model["MODEL_CAPACITIVE_WEIGHT"], model["MODEL_WEIGHT_WEIGHT"],
+       model["MODEL_INDUCTIVE_WEIGHT"], model["MODEL_LDR_WEIGHT"], model["MODEL_ACCEPT_SCORE"]))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("features", nargs="+", help="CSV files from tracereplay --features")
+    parser.add_argument("--max-false-accept", type=float, default=0.01,
+                        help="highest share of junk that may be accepted (default 0.01)")
+    parser.add_argument("--base", default=HEADER, help="header to take weights and ramp widths from")
+    parser.add_argument("-o", "--output", help="header to write (default stdout)")
+    args = parser.parse_args()
+
+    base = load_header(args.base)
+    samples = load_samples(args.features)
+    bottles = sum(1 for s in samples if s["bottle"])
+    junk = len(samples) - bottles
+    if bottles == 0:
+        sys.exit("no bottles in the training data")
+
+    cuts = fit_cuts(samples, int(args.max_false_accept * junk), cuts_from_model(base))
+    model = model_from_cuts(base, cuts)
+
+    before = evaluate(base, samples)
+    after = evaluate(model, samples)
+    sys.stderr.write("%d bottles, %d junk\n" % (bottles, junk))
+    for (name, _, _), cut in zip(GATES, cuts):
+        sys.stderr.write("  %-11s cut %d\n" % (name, cut))
+    sys.stderr.write("current  %d false rejects, %d false accepts\n" % (before[0], before[2]))
+    sys.stderr.write("trained  %d false rejects, %d false accepts\n" % (after[0], after[2]))
+
+    if args.output:
+        with open(args.output, "w") as out:
+            write_header(out, model, args.features, after)
+    else:
+        write_header(sys.stdout, model, args.features, after)
+
+
+if __name__ == "__main__":
+    main()